@@ -60,12 +60,19 @@
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 #include <netcdf.h>
+#include <pthread.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define CODENAME				"moirai"				// name of the compiled program
 #define VERSION         		"3.0"           			// current version
 #define MAXCHAR					1000						// maximum string length
 #define MAXRECSIZE				10000						// maximum record (csv line) length in characters
+#define CSVOUT_BUFSIZE			4194304						// output buffer size in bytes for the csv writer
 
 // year of HYDE data to read in for calculating potential vegetation area (for carbon and forest land rent) and pasture animal land rent
 #define REF_YEAR               2000
@@ -76,7 +83,8 @@
 #define MIN_SAGE_FOREST_CODE    1
 
 // counts of useful variables
-#define NUM_IN_ARGS							54							// number of input variables in the input file
+#define NUM_IN_ARGS							54							// number of required input variables in the input file
+#define NUM_IN_ARGS_OPT						13							// number of optional input variables that may follow the required ones
 #define NUM_ORIG_AEZ						18							// number of original GTAP/GCAM AEZs
 
 // necessary FAO input data info
@@ -126,18 +134,33 @@
 #define NOMATCH					-1				// if there isn't a matching country across data sets
 #define NA_TEXT                  "-"            // if there is no iso3 or name for a country/territory
 #define FAOCTRY2GCAMCTRYAEZID   10000           // the gcam country+aez id is fao country id * 10000 + aez id; this is also used for the region-glu image
+                                                // this is the minimum; ctryglu_id_mult grows it by powers of 10 for larger glu codes (see glu_index.c)
+#define ZONE_ID(zone,glu)       ((long long) (zone) * ctryglu_id_mult + (glu))   // 64-bit country (or region) + glu id
+#define ZONE_ID_INT64_TAG       "_int64"                                          // name tag of a zone id raster written as 64-bit
 #define ZERO_THRESH				1/1000000.0		// if a landtype area value is less than this, it is zero
 
-// working resolution is 5 arcmin (2160x4320), WGS84 spherical earth, lat-lon projection
+// working resolution is set at run time (see working_grid.c); the default is 5 arcmin (2160x4320)
+// WGS84 spherical earth, lat-lon projection
 // the origin is the upper left corner at 90 Lat and -180 Lon
 // the lat/lon dimensions need to have an even number of cells
-#define NUM_LAT					2160						// number of lats in working grids
-#define NUM_LON					4320						// number of lons in working grids
-#define NUM_CELLS				(NUM_LAT * NUM_LON)			// number of grid cells in working grids
-#define GRID_RES				(5.0/60.0)					// working grid resolution; decimal degree
-#define GRID_RES_SEC			300.0						// workding grid resolution; arc-seconds
+#define GRID_RES_SEC_DEFAULT	300.0						// default working grid resolution; arc-seconds
 #define NODATA					-9999						// nodata value
 
+// thematic (code) rasters are stored at their narrowest width (thematic_grid.c)
+// the largest value of each width is the nodata sentinel, which is widened back to the nodata value of the source data
+#define THM8_NODATA				255							// nodata sentinel of an 8-bit thematic raster; values are 0 to 254
+#define THM8_VAL(grid,i,nodata)		((grid)[i] == THM8_NODATA ? (nodata) : (int) (grid)[i])		// widened value of cell i
+#define THM8_FITS(val,nodata)		((val) == (nodata) || ((val) >= 0 && (val) < THM8_NODATA))	// 1 if val can be stored
+#define THM8_CODE(val,nodata)		((val) == (nodata) ? THM8_NODATA : (uint8_t) (val))			// stored value of val
+
+// diagnostic groups; with in_args.diagnostics on, in_args.diag_select selects the groups whose arrays are allocated, filled and written
+// the other diagnostic outputs depend only on in_args.diagnostics
+#define DIAG_LAND_CELLS			1							// land area tracking, masks and area difference rasters of get_land_cells()
+#define DIAG_HARVPROD			2							// sage harvested area, production and pasture cubes of calc_harvarea_prod_out_crop_aez()
+#define DIAG_RENT				4							// land rent cubes and tables of calc_rent_ag_use_aez()
+#define DIAG_ALL				(DIAG_LAND_CELLS | DIAG_HARVPROD | DIAG_RENT)
+#define DIAG_ON(args,group)		((args).diagnostics && ((args).diag_select & (group)))		// 1 if the group is on
+
 // LULC input grid; the origin corner is 0 lon and -90 lat
 #define NUM_LAT_LULC			360							// number of lats in input lulc data
 #define NUM_LON_LULC			720							// number of lons in input lulc
@@ -165,16 +188,34 @@ int NUM_FAO_CTRY;                       // number of FAO/VMAP0 countries, includ
 int NUM_GTAP_CTRY87;					// number of 87 GTAP countries (ctry87) for land rent data (see GTAP_GCAM_ctry87.csv)
 int NUM_GCAM_RGN;						// number of GCAM regions (see GCAM_region_names_32reg.csv; or 14reg)
 int NUM_GCAM_ISO_CTRY;                  // number of GCAM ISO countries for region mapping (see iso_GCAM_regID_32reg.csv; or 14reg)
-int NUM_NEW_AEZ;						// number of unique global climate AEZs (or other delineated areas) up to 9999; must be >= NUM_ORIG_AEZ=18 for the land rent calculation to work (see Global235_CLM_0125_dissolve.csv)
+int NUM_NEW_AEZ;						// number of unique global climate AEZs (or other delineated areas); codes above 9999 widen the zone ids (see glu_index.c); must be >= NUM_ORIG_AEZ=18 for the land rent calculation to work (see Global235_CLM_0125_dissolve.csv)
 int NUM_GTAP_USE;						// number of GTAP uses (GTAP_use) (see GTAP_use.csv)
 int NUM_SAGE_PVLT;						// number of SAGE potential vegetation land types (see SAGE_PVLT.csv)
 int NUM_SAGE_CROP;						// number of SAGE crops (SAGE_crop) (see SAGE_gtap_fao_crop2use.csv)
 int NUM_HYDE_TYPES;						// number of hyde land use types/files; the first 3 describe the total land use state
 int NUM_LULC_TYPES;						// number of input lulc types
 
+// working grid dimensions; set from in_args.grid_res_sec by set_working_grid()
+int NUM_LAT;							// number of lats in working grids
+int NUM_LON;							// number of lons in working grids
+int NUM_CELLS;							// number of grid cells in working grids
+double GRID_RES;						// working grid resolution; decimal degree
+double GRID_RES_SEC;					// working grid resolution; arc-seconds
+
+// processing window; set from in_args.window_bbox, window_ctry and window_glu by set_window(); the whole grid by default
+int win_row_min;						// first working grid row in the window
+int win_row_max;						// last working grid row in the window
+int win_col_min;						// first working grid column in the window
+int win_col_max;						// last working grid column in the window
+int win_num_ctry;						// number of fao country codes in the window; 0 = all countries
+int *win_ctry_codes;					// sorted fao country codes in the window
+int win_num_glu;						// number of glu codes in the window; 0 = all glus
+int *win_glu_codes;						// sorted glu codes in the window
+
 // useful utility variables
 char systime[MAXCHAR];					// array to store current time
 FILE *fplog;							// file pointer to log file for runtime output
+int log_sample_max;						// number of messages written per rate-limited log site before a stage summary; <= 0 writes all (in_args.log_sample)
 
 // area and production arrays: now 3d arrays, dim1=country[NUM_FAO_CTRY], dim2=aez[ctry_aez_num], dim3=crop[NUM_SAGE_CROP]
 //  so the second dimension is variable, and it matches the aez list arrays below
@@ -205,6 +246,11 @@ int *reggcam_aez_num;                   // number of AEZs for each gcam region
 // list of land type category mappings for the land type area and potveg carbon csv outputs
 int num_lt_cats;        // the number of categories
 int *lt_cats;           // the list of categories
+// direct lookups of the category index and the sage land type index, made with lt_cats in write_glu_mapping()
+int max_lt_cat;         // the largest category
+int *lt_cat_index;      // index in lt_cats of each category, or NOMATCH [max_lt_cat + 1]
+int max_potveg_code;    // the largest sage land type code
+int *potveg_index;      // index in landtypecodes_sage of each sage land type code, or NOMATCH [max_potveg_code + 1]
 
 // aggregated output data arrays; aez varies fastest, then crop/use, then gcam region
 // these two only in aggregate crop to gcam
@@ -218,26 +264,26 @@ int *lt_cats;           // the list of categories
 // they are all 1d arrays of size NUM_CELLS, which is currently hardcoded for the 5 arcmin resolution
 float *harvestarea_in;                  // input harvest area (km^2), reused by each individual crop
 float *yield_in;                        // input yield (metric tonnes / km^2), reused by each individual crop
-int *aez_bounds_new;                    // new aez boundaries (integers 1 to NUM_NEW_AEZ)
-int *aez_bounds_orig;                   // original aez boundaries (integers 1 to NUM_ORIG_AEZ)
+int *aez_bounds_new;                    // new aez boundaries (glu codes); aez_new_nodata for none
+uint8_t *aez_bounds_orig;               // original aez boundaries (integers 1 to NUM_ORIG_AEZ); THM8_VAL() with aez_orig_nodata
 float *cropland_area_sage;              // sage cropland area for normalizing sage crop data (km^2)
 float *cropland_area;                   // cropland area for ref veg area calc for forest land rent (km^2)
 float *pasture_area;                    // pasture area for ref veg area calc and animal land rent calc (km^2)
 float *urban_area;                      // urban area for ref veg area calc for forest land rent calc (km^2)
 float **lu_detail_area;					// additional hyde data files with more detailed area (km^2); d1=hyde types
 float *refveg_area;                     // reference vegetation area for forest land rent calc (km^2)
-int *potveg_thematic;                   // potential vegetation thematic data (integers 1 to NUM_SAGE_PVLT)
-int *refveg_thematic;                   // reference vegetation thematic data (integers 1 to NUM_SAGE_PVLT)
+uint8_t *potveg_thematic;               // potential vegetation thematic data (integers 1 to NUM_SAGE_PVLT); THM8_VAL() with potveg_nodata
+uint8_t *refveg_thematic;               // reference vegetation thematic data (integers 1 to NUM_SAGE_PVLT); THM8_VAL() with potveg_nodata
 short *country_fao;                     // fao country codes (integer fao code values)
 float *cell_area;                       // total area of grid cell; calculated based on spherical earth (km^2)
 float *cell_area_hyde;                  // total area of hyde land grid cells; from hyde data set (km^2)
 float *land_area_sage;                  // max land area of sage working grid cell (km^2)
 float *land_area_hyde;                  // max land area of hyde data cells (km^2)
 float *sage_minus_hyde_land_area;       // difference between the sage and hyde land area (km^2)
-int *country87_gtap;                    // map of gtap87 countries found
+uint8_t *country87_gtap;                // map of gtap87 countries found; THM8_VAL() with NODATA
 int *land_mask_ctryaez;                 // 1=used for output; 0=not used for output
 int *missing_aez_mask;                  // 1=no new aez value for land sage cell haveing crop data; 0=ok
-int *region_gcam;                       // gcam gis region codes, based on iso mapping and fao country raster
+uint8_t *region_gcam;                   // gcam gis region codes, based on iso mapping and fao country raster; THM8_VAL() with NODATA
 float *glacier_water_area_hyde;         // difference (residual) between the hyde total cell area and hyde land area for hyde land cells (km^2)
 int *land_mask_aez_orig;                // 1=land; 0=no land
 int *land_mask_aez_new;                 // 1=land; 0=no land
@@ -248,7 +294,7 @@ int *land_mask_fao;                     // 1=land; 0=no land
 int *land_mask_potveg;                  // 1=land; 0=no land
 int *land_mask_refveg;                  // 1=land; 0=no land
 int *land_mask_forest;                  // 1=forest; 0=no forest
-short *protected_thematic;              // 1=protected; 2=unprotected (after conversion from file value of 255); no other values
+uint8_t *protected_thematic;            // 1=protected; 2=unprotected (after conversion from file value of 255); no other values
 
 // raster arrays for inputs with different resolution
 // these are also stored starting at upper left corner with lon varying fastest
@@ -307,6 +353,10 @@ char **landtypenames_sage;                                  // SAGE land type na
 int *landtypecodes_sage;                                    // SAGE land type codes
 char **aez_names_new;                                       // names of the new AEZs
 int *aez_codes_new;                                         // integer id codes of the new AEZs; corresponds with the input raster
+int max_glu_code;                                           // the largest new aez code
+int *glu_codes_sorted;                                      // the new aez codes in increasing order [NUM_NEW_AEZ]
+int *glu_index_sorted;                                      // index in aez_codes_new of each code in glu_codes_sorted [NUM_NEW_AEZ]
+long long ctryglu_id_mult;                                  // multiplier of the country (or region) code in the zone ids; see ZONE_ID()
 char **lutypenames_hyde;									// hyde land use type names
 int *lutypecodes_hyde;										// hyde land use type integer codes
 char **lulcnames;											// lulc type names
@@ -534,8 +584,192 @@ typedef struct {
     char wf_fname[MAXCHAR];                 // file name for water footprint output
     char iso_map_fname[MAXCHAR];            // file name for mapping the raaster fao country codes to iso
     char lt_map_fname[MAXCHAR];             // file name for mapping the land type category codes to descriptions
+    
+    // optional settings; these may be omitted from the end of the input file, and the defaults are set in init_moirai()
+    int out_columnar;                       // 1=also write each output table as a columnar netcdf file; 0=csv only (default)
+    int out_nc_grids;                       // 1=write the raster outputs as compressed netcdf files; 0=raw binary .bil files (default)
+    double grid_res_sec;                    // working grid resolution in arc-seconds; 300 = 5 arcmin (default)
+    int band_rows;                          // rows per latitude band; >0 pages the working grids through scratch files (grid_store.c); 0=whole grid in memory (default)
+    char window_bbox[MAXCHAR];              // processing window lon_min,lon_max,lat_min,lat_max (degrees); 0=whole globe (default)
+    char window_ctry[MAXRECSIZE];           // processing window fao country codes, comma separated; 0=all countries (default)
+    char window_glu[MAXRECSIZE];            // processing window glu codes, comma separated; 0=all glus (default)
+    char sage_store_fname[MAXCHAR];         // consolidated sage crop store in sagepath, built by the first run that uses it; 0=read the crop files (default)
+    int readahead_mb;                       // memory ceiling (MB) for reading later hyde/lulc years in the background; 0=no read-ahead (default)
+    int hyde_block_major;                   // 1=reorder the hyde grids by lulc cell for land type area processing; 0=row-major (default)
+    int log_sample;                         // number of messages written per repeated log message before the stage summary; 0=all; 20 (default)
+    int diag_select;                        // sum of the DIAG_* groups to output when diagnostics=1; DIAG_ALL=7 (default)
+    int io_uring;                           // 1=read the water footprint bands through io_uring, if built with USE_IO_URING; 0=pread (default)
 } args_struct;
 
+// data structures for the single-pass csv reader (csv_reader.c)
+// a field is a span within the file buffer; bracketing quotes and surrounding whitespace are not included
+typedef struct {
+	const char *ptr;			// first character of the field within the file buffer
+	int len;					// number of characters in the field
+	int quoted;					// 1=field was enclosed in double quotes; 0=not quoted
+} csvfield_struct;
+
+typedef struct {
+	char fname[MAXCHAR];		// file name with path, for messages
+	char delim;					// the delimiting character
+	char *buf;					// the whole file; mapped read-only when possible
+	size_t buflen;				// number of bytes in buf
+	int is_mapped;				// 1=buf is mapped; 0=buf is allocated
+	long num_recs;				// number of non-blank data records after the header lines
+	size_t *rec_start;			// offset in buf of each data record [num_recs]
+	long cur_rec;				// index of the tokenized record; -1 if none
+	csvfield_struct *fields;	// field spans of the tokenized record [max_fields]
+	int num_fields;				// number of fields in the tokenized record
+	int max_fields;				// allocated length of fields
+} csvfile_struct;
+
+// data structure for the buffered csv writer (csv_writer.c)
+// a file writer flushes buf to fp when it fills; a chunk has no file and grows buf instead
+typedef struct {
+	char fname[MAXCHAR];		// file name with path (or chunk name), for messages
+	FILE *fp;					// the output file; NULL for an in-memory chunk
+	char *buf;					// formatted characters not yet written
+	size_t len;					// number of characters in buf
+	size_t cap;					// allocated length of buf
+	int err;					// first error code from any operation on this writer
+} csvout_struct;
+
+// data structure for the optional columnar netcdf copy of an output table (columnar_table.c)
+#define COLTAB_MAX_KEYS			6			// maximum number of key columns in a table
+typedef struct {
+	char fname[MAXCHAR];					// netcdf file name with path
+	char descr[MAXCHAR];					// table description
+	char value_name[MAXCHAR];				// name of the value column
+	char value_units[MAXCHAR];				// units of the value column
+	int num_keys;							// number of key columns
+	char key_names[COLTAB_MAX_KEYS][MAXCHAR];	// name of each key column
+	char **dict[COLTAB_MAX_KEYS];			// names indexed by a text key column; NULL for an integer key
+	int dict_len[COLTAB_MAX_KEYS];			// number of names in each dictionary
+	int *keys[COLTAB_MAX_KEYS];				// key values (or dictionary indices) [max_recs]
+	float *values;							// record values [max_recs]
+	long num_recs;							// number of records added
+	long max_recs;							// allocated number of records
+	int err;								// first error code from adding records
+} coltab_struct;
+
+// data structure for a sparse glu-indexed diagnostic cube (glu_cube.c)
+// only the glus in each row's glu list are stored, instead of all NUM_NEW_AEZ glus; glu varies fastest, then dim2, then row
+// the row glu lists are not copied, so they must outlast the cube
+typedef struct {
+	int d1_length;				// number of rows (countries or regions)
+	int d2_length;				// number of values per row and glu (crops or uses); 1 for a 2d cube
+	int *glu_num;				// number of glus in each row [d1_length], e.g. ctry_aez_num
+	int **glu_list;				// glu codes of each row [d1_length][glu_num], e.g. ctry_aez_list
+	long *row_start;			// index in values of the first value of each row [d1_length]
+	float *values;				// the stored values
+	long num_values;			// length of values
+} glucube_struct;
+
+// index in lt_cats of a land type category, and index in landtypecodes_sage of a sage land type code; NOMATCH if none
+#define LT_CAT_IND(cat)			(((cat) >= 0 && (cat) <= max_lt_cat) ? lt_cat_index[cat] : NOMATCH)
+#define POTVEG_IND(code)		(((code) >= 0 && (code) <= max_potveg_code) ? potveg_index[code] : NOMATCH)
+
+// index in values of row i, dim2 index j, and glu index k in the glu list of row i
+#define GLUCUBE_IND(cube, i, j, k)	((cube)->row_start[i] + (long) (j) * (cube)->glu_num[i] + (k))
+
+// data structure for the consolidated sage crop store (sage_store.c)
+// the store holds the four crop fields in file units for the sage land cells only: crop X field X cell, chunked by tiles of cells
+#define SAGE_CROP_NODATA		9E20		// nodata value of the sage crop files
+#define SAGE_STORE_NFIELDS		4			// harvested area fraction, yield, area quality, yield quality
+typedef struct {
+	char fname[MAXCHAR];		// store file name with path
+	int ncid;					// netcdf file id; -1 if the store is not used
+	int varid;					// crop data variable id
+	int num_cells;				// number of sage land cells in the store
+	int *cells;					// working grid index of each store cell [num_cells]; ascending
+	int cell_start;				// first store cell in the processing window rows
+	int cell_count;				// number of store cells in the processing window rows
+	float *buf;					// the window cells of one crop [SAGE_STORE_NFIELDS][cell_count]
+	float *qual_yield;			// working grid quality field for yield
+	float *qual_harv;			// working grid quality field for area
+} sagestore_struct;
+
+// data structures for the hyde and lulc read-ahead of proc_land_type_area() (lu_readahead.c)
+#define LU_READAHEAD_MAX		2			// max number of years read ahead of the year in use
+typedef struct {
+	int year_ind;				// index in the year list of the data in this slot; -1 if none
+	int lulc_year;				// lulc year read for this hyde year
+	int err;					// error code from reading this year
+	int block_major;			// 1 if the hyde grids are in block-major order (lureadahead_struct block_cells); 0 if row-major
+	float *crop_grid;			// hyde cropland area; working grid
+	float *pasture_grid;		// hyde pasture area; working grid
+	float *urban_grid;			// hyde urban area; working grid
+	float **lu_detail_grid;		// the rest of the hyde types; dim1=hyde types, dim2=working grid cells
+	float **lulc_grid;			// lulc input area (km^2); dim1=lulc types, dim2=lulc grid cells
+} luyear_struct;
+
+typedef struct {
+	args_struct in_args;		// copy of the input arguments for the reader
+	rinfo_struct raster_info;	// the reader's copy of the raster info; read_hyde32() sets the lu fields
+	int *years;					// hyde years to read, in order
+	int num_years;				// number of years
+	int num_slots;				// number of year buffers; 1 = no read-ahead, read in the calling thread
+	luyear_struct *slots;		// year index i is in slot i % num_slots
+	int *block_cells;			// working grid index of each position of the block-major hyde grids; NULL for row-major grids
+	float *block_buf;			// the spare grid that the reader reorders each hyde grid into; it then swaps it with the grid
+	int num_read;				// number of years read into the slots
+	int num_released;			// number of years released by the caller
+	int has_thread;				// 1 if the background reader was started
+	int stop;					// 1 tells the background reader to stop
+	pthread_t thread;			// background reader
+	pthread_mutex_t lock;		// protects the slots, num_read and num_released
+	pthread_cond_t cond;		// signals a read or a release
+} lureadahead_struct;
+
+// data structure for the parallel accumulation of land cell values into country X glu zones (zone_accum.c)
+// zone zone_start[ctry_ind] + glu_ind is the glu at glu_ind in ctry_aez_list[ctry_ind]
+typedef struct {
+	int num_cells;				// number of cells in the land cell list
+	int num_zones;				// number of zones
+	int *zone_start;			// first zone of each country [NUM_FAO_CTRY + 1]
+	int *cell_zone;				// zone of each cell of the list; NOMATCH if the cell is not accumulated [num_cells]
+	int *zone_first;			// first position of each zone in zone_cells, for the current range [num_zones + 1]
+	int *zone_next;				// next free position of each zone in zone_cells [num_zones]
+	int *zone_cells;			// list positions of the cells of the current range, grouped by zone [num_cells]
+} zonemap_struct;
+
+// data structure for a walk over working grid cells in grid order, which releases each band when it is done (grid_store.c)
+typedef struct {
+	int band_rows;				// rows per latitude band
+	int row_start;				// first row of the current band
+	long next_cell;				// first cell of the next band
+} band_walk_struct;
+
+// data structure for a rate-limited log message site (log_utils.c)
+// declare one static logsite_struct per message, with the message name, a zero count and a NULL next
+#define LOG_BUFSIZE				1048576		// bytes of stdio buffer for the log file
+typedef struct logsite_struct {
+	const char *name;				// name of the message, for the stage summary
+	long count;						// number of occurrences since the last summary
+	struct logsite_struct *next;	// next site hit since the last summary
+} logsite_struct;
+
+// data structure for batched binary raster reads (raster_io.c)
+#define RIO_MAX_READS			16			// max number of queued reads, and of buffers
+#define RIO_PENDING				-1000000	// result of a read that is still in the io_uring
+typedef struct {
+	int num_bufs;					// number of buffers
+	size_t buf_bytes;				// size of each buffer, in bytes
+	void **bufs;					// the read buffers [num_bufs]
+	void *uring;					// the io_uring (raster_io.c); NULL to read with pread
+	int num_queued;					// number of reads queued since the last rio_wait()
+	int num_lost;					// reads left in the io_uring after it failed; their buffers are not freed
+	int fd[RIO_MAX_READS];			// file of each queued read
+	long offset[RIO_MAX_READS];		// file offset of each queued read
+	size_t nbytes[RIO_MAX_READS];	// bytes to read for each queued read
+	int buf_ind[RIO_MAX_READS];		// buffer of each queued read
+	long result[RIO_MAX_READS];		// bytes read, -errno, or RIO_PENDING
+	char fname[RIO_MAX_READS][MAXCHAR];	// file name of each queued read
+} rio_struct;
+
+// gets the values of the cell at list position pos, and their offset within the zone; returns an error code
+typedef int (*zone_value_fn)(int pos, void *ctx, int *offset, double *vals);
+
 // function declarations
 
 // read raster file functions
@@ -553,7 +787,10 @@ int read_country_fao(args_struct in_args, rinfo_struct *raster_info);
 int read_country_gcam(args_struct in_args, rinfo_struct *raster_info);
 int read_region_gcam(args_struct in_args, rinfo_struct *raster_info);
 int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_struct raster_info);
-int read_mirca(char *fname, float *mirca_grid);
+int read_sage_crop_raw(char *fname, char *sagepath, char *cropfilebase_sage, float *qual_yield, float *qual_harv);
+int convert_sage_crop(char *fname, float *qual_yield, float *qual_harv, rinfo_struct raster_info);
+int open_mirca(char *fname, FILE **fpin);
+int read_mirca(FILE *fpin, char *fname, int ncells, float *mirca_grid);
 int read_nfert(char *fname, float *nfert_grid, args_struct in_args);
 int read_protected(args_struct in_args, rinfo_struct *raster_info);
 int read_lu_hyde(args_struct in_args, int year, float *crop_grid, float *pasture_grid, float *urban_grid);
@@ -575,13 +812,13 @@ int read_yield_fao(args_struct in_args);
 int read_harvestarea_fao(args_struct in_args);
 int read_prodprice_fao(args_struct in_args);
 int read_veg_carbon(char *fname, float *veg_carbon_sage);
-int read_water_footprint(char *fname, float *wf_grid);
+int read_water_footprint(char *fname, int row_start, int nrows, rio_struct *rio, int buf_ind);
 int read_soil_carbon(char *fname, float *soil_carbon_sage, args_struct in_args);
 
 // raster processing functions
 int get_land_cells(args_struct in_args, rinfo_struct raster_info);
 int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info);
-int get_aez_val(int aez_array[], int index, int nrows, int ncols, int nodata_val, int *value);
+int get_aez_val(int aez_val, int index, int nodata_val, int *value);
 int proc_water_footprint(args_struct in_args, rinfo_struct raster_info);
 
 // additional spatial data processing functions
@@ -600,6 +837,109 @@ int rm_whitesp(char *cln_field,char *str_field);
 int rm_quotes(char *cln_field,char *str_field);
 int is_num(char *str_field);
 
+// single-pass csv reader functions (csv_reader.c)
+int csv_open(char *fname, const char *delim, int nhead, csvfile_struct *csv);
+int csv_get_record(csvfile_struct *csv, long rec_ind);
+int csv_get_int(csvfile_struct *csv, int findex, int *intval);
+int csv_get_float(csvfile_struct *csv, int findex, float *fltval);
+int csv_get_text(csvfile_struct *csv, int findex, char *str_field);
+int csv_close(csvfile_struct *csv);
+
+// buffered csv writer functions (csv_writer.c)
+int csvout_open(char *fname, csvout_struct *out);
+void csvout_chunk(csvout_struct *out, char *name);
+void csvout_str(csvout_struct *out, const char *str);
+void csvout_int(csvout_struct *out, long long val);
+void csvout_float(csvout_struct *out, double val, int ndec);
+void csvout_printf(csvout_struct *out, const char *fmt, ...);
+int csvout_append(csvout_struct *out, csvout_struct *chunk);
+int csvout_close(csvout_struct *out);
+
+// columnar output table functions (columnar_table.c)
+int coltab_init(coltab_struct *tab, char *csv_fname, char *descr, char *value_name, char *value_units, int num_keys);
+void coltab_key(coltab_struct *tab, int key_ind, char *name, char **dict, int dict_len);
+void coltab_add(coltab_struct *tab, const int *keys, float value);
+int coltab_write(coltab_struct *tab);
+void coltab_free(coltab_struct *tab);
+
+// directory and file publishing functions (file_utils.c)
+int make_path(char *path);
+int publish_file(char *src_fname, char *destpath);
+
+// sparse glu-indexed diagnostic cube functions (glu_cube.c)
+int glucube_init(glucube_struct *cube, int d1_length, int d2_length, int *glu_num, int **glu_list);
+void glucube_zero(glucube_struct *cube);
+void glucube_free(glucube_struct *cube);
+int write_csv_glucube(glucube_struct *cube, int d1[], int d2[], char *out_name, args_struct in_args);
+
+// consolidated sage crop store functions (sage_store.c)
+int sagestore_open(sagestore_struct *store, args_struct in_args, rinfo_struct raster_info);
+int sagestore_read_crop(sagestore_struct *store, int cropind, rinfo_struct raster_info);
+void sagestore_close(sagestore_struct *store);
+
+// hyde and lulc read-ahead functions (lu_readahead.c)
+int lureadahead_init(lureadahead_struct *ra, args_struct in_args, rinfo_struct raster_info, int *years, int num_years, int *block_cells);
+int lureadahead_get(lureadahead_struct *ra, int year_ind, luyear_struct **lu_year);
+void lureadahead_release(lureadahead_struct *ra, int year_ind);
+void lureadahead_free(lureadahead_struct *ra);
+
+// rate-limited log functions (log_utils.c)
+FILE *log_open(char *fname);
+int log_sample(logsite_struct *site);
+void log_summary(char *stage);
+
+// netcdf library lock functions (nc_lock.c)
+void nc_lock(void);
+void nc_unlock(void);
+
+// batched raster read functions (raster_io.c)
+int rio_init(rio_struct *rio, int use_uring, int num_bufs, size_t buf_bytes);
+int rio_read(rio_struct *rio, char *fname, long offset, size_t nbytes, int buf_ind);
+int rio_wait(rio_struct *rio);
+void rio_free(rio_struct *rio);
+
+// working grid storage functions (grid_store.c)
+int grid_store_init(args_struct in_args);
+void *grid_calloc(size_t nmemb, size_t size);
+void *grid_calloc_list(size_t nmemb, size_t size);
+void grid_free(void *ptr);
+void grid_release_rows(int row_start, int nrows);
+void band_walk_init(band_walk_struct *walk, args_struct in_args);
+void band_walk_cell(band_walk_struct *walk, int cell);
+void band_walk_end(band_walk_struct *walk);
+
+// zone accumulation functions (zone_accum.c)
+int zonemap_init(zonemap_struct *map, args_struct in_args, int *cells, int num_cells, rinfo_struct raster_info);
+int zone_accum(zonemap_struct *map, int pos_start, int pos_end, int width, int nvals, zone_value_fn value, void *ctx, double *acc);
+void zonemap_free(zonemap_struct *map);
+
+// working grid functions (working_grid.c)
+int set_working_grid(args_struct in_args);
+int check_grid_dims(char *fname, int nrows, int ncols);
+int check_grid_file(char *fname, int insize);
+int check_grid_nc(char *fname, int ncid, int varid);
+int get_band_rows(args_struct in_args);
+int set_window(args_struct in_args);
+int load_static_inputs(args_struct in_args, rinfo_struct *raster_info);
+int in_window(int cell, int ctry_code, int glu_code);
+int window_overlaps(int row_ul, int col_ul, int nrows, int ncols);
+int window_is_full(void);
+int window_box_is_full(void);
+void window_spread_float(float *grid, float fill);
+void free_window(void);
+
+// glu code and zone id functions (glu_index.c)
+int init_glu_index(void);
+int glu_index(int glu_code);
+int glu_list_index(int *glu_list, int glu_num, int glu_code);
+int write_raster_zone_id(int zone_codes[], int glu_codes[], int out_length, char *out_name, args_struct in_args);
+
+// narrow thematic raster functions (thematic_grid.c)
+int thm8_narrow(int in_array[], int length, int nodata, uint8_t out_array[], char *name);
+void thm8_widen(uint8_t in_array[], int length, int nodata, int out_array[]);
+int read_raster_thm8(char *fname, int length, int nodata, uint8_t out_array[]);
+int write_raster_thm8(uint8_t out_array[], int length, int nodata, char *out_name, args_struct in_args);
+
 // calculation functions
 int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_info);
 int aggregate_crop2gcam(args_struct in_args);
@@ -617,6 +957,7 @@ int write_glu_mapping(args_struct in_args, rinfo_struct raster_info);
 int write_raster_float(float out_array[], int out_length, char *out_name, args_struct in_args);
 int write_raster_int(int out_array[], int out_length, char *out_name, args_struct in_args);
 int write_raster_short(short out_array[], int out_length, char *out_name, args_struct in_args);
+int write_raster_nc(void *out_array, nc_type out_type, int out_length, char *out_name, args_struct in_args);
 int write_text_int(int out_array[], int out_length, char *out_name, args_struct in_args);
 int write_text_char(char **out_array, int out_length, char *out_name, args_struct in_args);
 int write_csv_float3d(float out_array[], int d1[], int d2[], int d1_length, int d2_length, int d3_length,
@@ -52,18 +52,16 @@ int aggregate_crop2gcam(args_struct in_args) {
 	int ctry_index = NOMATCH;		// fao ctry index (to get region code)
     int aez_index = NOMATCH;        // aez index for current ctry index
     int reg_aez_index = NOMATCH;    // aez index for current reg index
-    int all_aez_index = NOMATCH;    // aez index in the list of all new aezs
-    int diag_index = NOMATCH;       // index of old-format 1d array for diagnostic output
+    long diag_index;                // index in the diagnostic output cubes
 	int err = OK;			// error code for called functions
 	
     float ***harvestarea_crop_aez_gcam;			// array to output aggregated harvested area in ha
     float ***production_crop_aez_gcam;          // array to output aggregated produciton in metric tonnes
     
-    // to do: deal with this for gridded new aez input
-    // for now, fill an old-format 1d array for diagnostic output
+    // the old-format diagnostic outputs are sparse cubes that store only the aezs of each gcam region (see glu_cube.c)
     // aez varies fastest, then crop, then gcam region
-    float *diag_harvestarea_crop_aez_gcam;          // array to output aggregated harvested area in ha
-    float *diag_production_crop_aez_gcam;          // array to output aggregated produciton in metric tonnes
+    glucube_struct diag_harvestarea_crop_aez_gcam;          // array to output aggregated harvested area in ha
+    glucube_struct diag_production_crop_aez_gcam;          // array to output aggregated produciton in metric tonnes
     
     // allocate memory for the diagnostic output
     harvestarea_crop_aez_gcam = calloc(NUM_GCAM_RGN, sizeof(float**));
@@ -106,14 +104,12 @@ int aggregate_crop2gcam(args_struct in_args) {
         } // end for j loop over aezs
     } // end for i loop over fao country
 
-    // allocate the 1d arrays
-    diag_harvestarea_crop_aez_gcam = calloc(NUM_GCAM_RGN * NUM_SAGE_CROP * NUM_NEW_AEZ, sizeof(float));
-    if(diag_harvestarea_crop_aez_gcam == NULL) {
+    // allocate the diagnostic cubes
+    if(glucube_init(&diag_harvestarea_crop_aez_gcam, NUM_GCAM_RGN, NUM_SAGE_CROP, reggcam_aez_num, reggcam_aez_list) != OK) {
         fprintf(fplog,"Failed to allocate memory for diag_harvestarea_crop_aez_gcam:  aggregate_crop2gcam()\n");
         return ERROR_MEM;
     }
-    diag_production_crop_aez_gcam = calloc(NUM_GCAM_RGN * NUM_SAGE_CROP * NUM_NEW_AEZ, sizeof(float));
-    if(diag_production_crop_aez_gcam == NULL) {
+    if(glucube_init(&diag_production_crop_aez_gcam, NUM_GCAM_RGN, NUM_SAGE_CROP, reggcam_aez_num, reggcam_aez_list) != OK) {
         fprintf(fplog,"Failed to allocate memory for diag_production_crop_aez_gcam:  aggregate_crop2gcam()\n");
         return ERROR_MEM;
     }
@@ -139,13 +135,7 @@ int aggregate_crop2gcam(args_struct in_args) {
             // loop over the country aezs
             for (aez_index = 0; aez_index < ctry_aez_num[ctry_index]; aez_index++) {
                 // determine the region aez index
-                reg_aez_index = NOMATCH;
-                for (i = 0; i < reggcam_aez_num[reg_index]; i++) {
-                    if (ctry_aez_list[ctry_index][aez_index] == reggcam_aez_list[reg_index][i]) {
-                        reg_aez_index = i;
-                        break;
-                    }
-                }
+                reg_aez_index = glu_list_index(reggcam_aez_list[reg_index], reggcam_aez_num[reg_index], ctry_aez_list[ctry_index][aez_index]);
                 if (reg_aez_index == NOMATCH) {
                     // this shouldn't happen because the gcam region list was made from the country list (see write_glu_mapping())
                     fprintf(fplog,"Error finding gcam region index: aggregate_crop2gcam(); country=%i region=%i aez=%i\n",
@@ -161,27 +151,13 @@ int aggregate_crop2gcam(args_struct in_args) {
                         harvestarea_crop_aez_gcam[reg_index][reg_aez_index][crop_index] +
                         harvestarea_crop_aez[ctry_index][aez_index][crop_index];
                     
-                    // get the aez index in the complete aez list
-                    all_aez_index = NOMATCH;
-                    for (i = 0; i < NUM_NEW_AEZ; i++) {
-                        if (aez_codes_new[i] == reggcam_aez_list[reg_index][reg_aez_index]) {
-                            all_aez_index = i;
-                            break;
-                        }
-                    }
-                    if (all_aez_index == NOMATCH) {
-                        // this shouldn't happen
-                        fprintf(fplog,"Error finding all aez index: aggregate_crop2gcam(); country=%i region=%i aez=%i\n",
-                                countrycodes_fao[ctry_index], regioncodes_gcam[reg_index], reggcam_aez_list[reg_index][reg_aez_index]);
-                        return ERROR_FILE;
-                    }
-                    // fill the 1d arrays
-                    diag_index = reg_index * NUM_SAGE_CROP * NUM_NEW_AEZ + crop_index * NUM_NEW_AEZ + all_aez_index;
-                    diag_harvestarea_crop_aez_gcam[diag_index] =
-                        diag_harvestarea_crop_aez_gcam[diag_index] +
+                    // fill the diagnostic cubes
+                    diag_index = GLUCUBE_IND(&diag_harvestarea_crop_aez_gcam, reg_index, crop_index, reg_aez_index);
+                    diag_harvestarea_crop_aez_gcam.values[diag_index] =
+                        diag_harvestarea_crop_aez_gcam.values[diag_index] +
                         harvestarea_crop_aez[ctry_index][aez_index][crop_index];
-                    diag_production_crop_aez_gcam[diag_index] =
-                        diag_production_crop_aez_gcam[diag_index] +
+                    diag_production_crop_aez_gcam.values[diag_index] =
+                        diag_production_crop_aez_gcam.values[diag_index] +
                         production_crop_aez[ctry_index][aez_index][crop_index];
                     
                 } // end for crop loop
@@ -191,14 +167,14 @@ int aggregate_crop2gcam(args_struct in_args) {
 	
 	if (in_args.diagnostics) {
 		// production
-		if ((err = write_csv_float3d(diag_production_crop_aez_gcam, regioncodes_gcam, cropcodes_sage, NUM_GCAM_RGN,
-									 NUM_SAGE_CROP, NUM_NEW_AEZ, "production_crop_aez_gcam.csv", in_args))) {
+		if ((err = write_csv_glucube(&diag_production_crop_aez_gcam, regioncodes_gcam, cropcodes_sage,
+									 "production_crop_aez_gcam.csv", in_args))) {
 			fprintf(fplog, "Error writing file %s: aggregate_crop2gam()\n", "production_crop_aez_gcam.csv");
 			return err;
 		}
 		// harvested area
-		if ((err = write_csv_float3d(diag_harvestarea_crop_aez_gcam, regioncodes_gcam, cropcodes_sage, NUM_GCAM_RGN,
-									 NUM_SAGE_CROP,NUM_NEW_AEZ, "harvestarea_crop_aez_gcam.csv", in_args))) {
+		if ((err = write_csv_glucube(&diag_harvestarea_crop_aez_gcam, regioncodes_gcam, cropcodes_sage,
+									 "harvestarea_crop_aez_gcam.csv", in_args))) {
 			fprintf(fplog, "Error writing file %s: aggregate_crop2gam()\n", "harvestarea_crop_aez_gcam.csv");
 			return err;
 		}
@@ -215,8 +191,8 @@ int aggregate_crop2gcam(args_struct in_args) {
     free(harvestarea_crop_aez_gcam);
     free(production_crop_aez_gcam);
     
-    free(diag_harvestarea_crop_aez_gcam);
-    free(diag_production_crop_aez_gcam);
+    glucube_free(&diag_harvestarea_crop_aez_gcam);
+    glucube_free(&diag_production_crop_aez_gcam);
     
 	return OK;
 }
\ No newline at end of file
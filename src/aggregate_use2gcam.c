@@ -55,16 +55,14 @@ int aggregate_use2gcam(args_struct in_args) {
     int reglr_aez_index = NOMATCH;      // land rent region aez index
     int reggcam_aez_index = NOMATCH;    // gcam region aez index
     int use_index = NOMATCH;            // gtap index of use
-    int all_aez_index = NOMATCH;        // aez index in the list of all new aezs
-    int diag_index = NOMATCH;           // index of old-format 1d array for diagnostic output
+    long diag_index;                    // index in the diagnostic output cube
 	int err = OK;			// error code for called functions
 	
 	float ***rent_use_aez_gcam;			// array to output diagnostics in USD
     
-    // for now, use the old-format 1d array for diagnostic output
+    // the old-format diagnostic output is a sparse cube that stores only the aezs of each gcam region (see glu_cube.c)
     // aez varies fastest, then use, then gcam region
-    // to do: check for gridded new aez input
-    float *diag_rent_use_aez_gcam;
+    glucube_struct diag_rent_use_aez_gcam;
 	    
 	// allocate memory for the diagnostic output
 	rent_use_aez_gcam = calloc(NUM_GCAM_RGN, sizeof(float**));
@@ -87,9 +85,8 @@ int aggregate_use2gcam(args_struct in_args) {
         } // end for j loop over aezs
     } // end for i loop over fao country
 	
-    // allocate the 1d diagnostic array
-    diag_rent_use_aez_gcam = calloc(NUM_GCAM_RGN * NUM_GTAP_USE * NUM_NEW_AEZ, sizeof(float));
-    if(diag_rent_use_aez_gcam == NULL) {
+    // allocate the diagnostic cube
+    if(glucube_init(&diag_rent_use_aez_gcam, NUM_GCAM_RGN, NUM_GTAP_USE, reggcam_aez_num, reggcam_aez_list) != OK) {
         fprintf(fplog,"Failed to allocate memory for diag_rent_use_aez_gcam:  aggregate_use2gcam()\n");
         return ERROR_MEM;
     }
@@ -124,12 +121,8 @@ int aggregate_use2gcam(args_struct in_args) {
             // just select the first one that matches
             reggcam_aez_index = NOMATCH;
             for (j = 0; j < num_reggcam_index; j++) {
-                for (i = 0; i < reggcam_aez_num[reggcam_index[j]]; i++) {
-                    if (reglr_aez_list[reglr_index][reglr_aez_index] == reggcam_aez_list[reggcam_index[j]][i]) {
-                        reggcam_aez_index = i;
-                        break;
-                    }
-                }
+                reggcam_aez_index = glu_list_index(reggcam_aez_list[reggcam_index[j]], reggcam_aez_num[reggcam_index[j]],
+                                                   reglr_aez_list[reglr_index][reglr_aez_index]);
                 if (reggcam_aez_index != NOMATCH) {
                     reggcam_out_ind = j;
                     break;
@@ -151,26 +144,10 @@ int aggregate_use2gcam(args_struct in_args) {
                 rent_use_aez_gcam[reggcam_index[reggcam_out_ind]][reggcam_aez_index][use_index] +
                 rent_use_aez[reglr_index][reglr_aez_index][use_index] * MIL2ONE;
                 
-                // get the aez index in the complete aez list
-                all_aez_index = NOMATCH;
-                for (i = 0; i < NUM_NEW_AEZ; i++) {
-                    if (aez_codes_new[i] == reggcam_aez_list[reggcam_index[reggcam_out_ind]][reggcam_aez_index]) {
-                        all_aez_index = i;
-                        break;
-                    }
-                }
-                if (all_aez_index == NOMATCH) {
-                    // this shouldn't happen
-                    fprintf(fplog,"Error finding all aez index: aggregate_use2gcam(); land rent region=%i gcam region=%i aez=%i\n",
-                            country87codes_gtap[reglr_index], regioncodes_gcam[reggcam_index[reggcam_out_ind]],
-                            reggcam_aez_list[reggcam_index[reggcam_out_ind]][reggcam_aez_index]);
-                    return ERROR_FILE;
-                }
-                // fill the 1d arrays
-                diag_index =
-                    reggcam_index[reggcam_out_ind] * NUM_GTAP_USE * NUM_NEW_AEZ + use_index * NUM_NEW_AEZ + all_aez_index;
-                diag_rent_use_aez_gcam[diag_index] =
-                diag_rent_use_aez_gcam[diag_index] +
+                // fill the diagnostic cube
+                diag_index = GLUCUBE_IND(&diag_rent_use_aez_gcam, reggcam_index[reggcam_out_ind], use_index, reggcam_aez_index);
+                diag_rent_use_aez_gcam.values[diag_index] =
+                diag_rent_use_aez_gcam.values[diag_index] +
                 rent_use_aez[reglr_index][reglr_aez_index][use_index] * MIL2ONE;
                 
             } // end for loop over the use sectors
@@ -179,8 +156,8 @@ int aggregate_use2gcam(args_struct in_args) {
 
 	if (in_args.diagnostics) {
 		// land rent
-		if ((err = write_csv_float3d(diag_rent_use_aez_gcam, regioncodes_gcam, usecodes_gtap, NUM_GCAM_RGN,
-									 NUM_GTAP_USE, NUM_NEW_AEZ, "land_rent_aez_gcam.csv", in_args))) {
+		if ((err = write_csv_glucube(&diag_rent_use_aez_gcam, regioncodes_gcam, usecodes_gtap,
+									 "land_rent_aez_gcam.csv", in_args))) {
 			fprintf(fplog, "Error writing file %s: aggregate_use2gam()\n", "land_rent_aez_gcam.csv");
 			return err;
 		}
@@ -194,7 +171,7 @@ int aggregate_use2gcam(args_struct in_args) {
     }
 	free(rent_use_aez_gcam);
     
-    free(diag_rent_use_aez_gcam);
+    glucube_free(&diag_rent_use_aez_gcam);
 	
 	return OK;
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
  also aggregate pasture area to fao ctry and aez
  
  calibrate yields to a different reference year if desired (calibrate to fao production and harv area)
+
+each loop over the sage land cells is in grid order, and releases the latitude bands of the working grids behind it
+   (see grid_store.c), so with band_rows only about a band of each grid is in memory
  the recalibration year is determined by the available fao data and must be consistent with prodprice_fao
   (see read_yield_fao(), read_harvestarea_fao(), read_production_fao(), and read_prodprice_fao())
  
@@ -67,8 +70,7 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 	int land_cell;					// the current land cell
 	char fname[MAXCHAR];			// file name to open
 	
-    int all_aez_index;              // for the 1d old-format diagnostic output arrays
-    int diag_index;                 // for the 1d old-format diagnostic output arrays
+    long diag_index;                // for the old-format diagnostic output cubes
     
 	int serbia_code = 272;			// for merging serbia (272, srb) into serbia and montenegro (186, scg)
 	int montenegro_code = 273;		// for merging montenegro (273, mne) into serbia and montenegro (186, scg)
@@ -89,6 +91,11 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 	int fao_start_year_index;		// the fao year index of the starting year for averaging
 	
 	int err = OK;								// store error code from the write functions
+	// per-cell recalibration warnings are rate-limited (log_utils.c)
+	static logsite_struct bad_ctry_harvarea_site = {"Recalibrate: Bad country_harvarea: calc_harvarea_prod_out_aez()", 0, NULL};
+	static logsite_struct bad_harvarea_site = {"Recalibrate: Bad harvestarea_crop_aez: calc_harvarea_prod_out_aez()", 0, NULL};
+	static logsite_struct bad_ctry_prod_site = {"Recalibrate: Bad country_prod: calc_harvarea_prod_out_aez()", 0, NULL};
+	static logsite_struct bad_prod_site = {"Recalibrate: Bad production_crop_aez: calc_harvarea_prod_out_aez()", 0, NULL};
 	int ncells = NUM_CELLS;						// the number of cells in the aez mask array
 	char out_name[] = "missing_aez_mask.bil";	// diagnositic output raster file name
 	char bildir[] = "sage/";					// the sage bil subdirectory of the outptus directory
@@ -105,14 +112,18 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
     
 	float *yield_recalib;				// the recalibrated yield for a single crop, if needed
 	float *area_recalib;				// the recalibrated area for a single crop, if needed
+	band_walk_struct walk;				// releases the bands of the working grids behind a loop over the land cells
 	
-    // for now, use the old-format 1d arrays for the diagnostic outputs
+    // the old-format diagnostic outputs are sparse cubes that store only the glus of each country (see glu_cube.c)
+    // they are allocated and filled only if DIAG_HARVPROD is on
     // glu variest fastest, then crop, then country
-    // will this work if the glus are individual cells?
-    float *diag_harvestarea_crop_aez;            // harvested area output (ha), output to nearest integer
-    float *diag_production_crop_aez;             // production output (metric tonnes), output to nearest integer
+    int diag_harvprod = DIAG_ON(in_args, DIAG_HARVPROD);
+    glucube_struct diag_harvestarea_crop_aez;    // harvested area output (ha), output to nearest integer
+    glucube_struct diag_production_crop_aez;     // production output (metric tonnes), output to nearest integer
     // glu varies faster, then country
-    float *diag_pasturearea_aez;                 // pasture area (ha)
+    glucube_struct diag_pasturearea_aez;         // pasture area (ha)
+    
+    sagestore_struct sage_store;                 // the consolidated sage crop store, if used (see sage_store.c)
     
     
 	// initialize some local arrays for recalibration
@@ -121,32 +132,45 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 		country_harvarea[i] = 0;
 	}
     
-    // allocate 1d arrays for diagnostic output
-    diag_harvestarea_crop_aez = calloc(NUM_FAO_CTRY * NUM_SAGE_CROP * NUM_NEW_AEZ, sizeof(float));
-    if(diag_harvestarea_crop_aez == NULL) {
-        fprintf(fplog,"Failed to allocate memory for diag_harvestarea_crop_aez:  calc_harvarea_prod_out_aez()\n");
-        return ERROR_MEM;
-    }
-    diag_production_crop_aez = calloc(NUM_FAO_CTRY * NUM_SAGE_CROP * NUM_NEW_AEZ, sizeof(float));
-    if(diag_production_crop_aez == NULL) {
-        fprintf(fplog,"Failed to allocate memory for diag_production_crop_aez:  calc_harvarea_prod_out_aez()\n");
-        return ERROR_MEM;
+    // allocate the cubes for diagnostic output; an unused cube stays empty so that it can still be freed
+    memset(&diag_harvestarea_crop_aez, 0, sizeof(glucube_struct));
+    memset(&diag_production_crop_aez, 0, sizeof(glucube_struct));
+    memset(&diag_pasturearea_aez, 0, sizeof(glucube_struct));
+    if (diag_harvprod) {
+        if(glucube_init(&diag_harvestarea_crop_aez, NUM_FAO_CTRY, NUM_SAGE_CROP, ctry_aez_num, ctry_aez_list) != OK) {
+            fprintf(fplog,"Failed to allocate memory for diag_harvestarea_crop_aez:  calc_harvarea_prod_out_aez()\n");
+            return ERROR_MEM;
+        }
+        if(glucube_init(&diag_production_crop_aez, NUM_FAO_CTRY, NUM_SAGE_CROP, ctry_aez_num, ctry_aez_list) != OK) {
+            fprintf(fplog,"Failed to allocate memory for diag_production_crop_aez:  calc_harvarea_prod_out_aez()\n");
+            return ERROR_MEM;
+        }
+        if(glucube_init(&diag_pasturearea_aez, NUM_FAO_CTRY, 1, ctry_aez_num, ctry_aez_list) != OK) {
+            fprintf(fplog,"Failed to allocate memory for diag_pasturearea_aez:  calc_harvarea_prod_out_aez()\n");
+            return ERROR_MEM;
+        }
     }
-    diag_pasturearea_aez = calloc(NUM_FAO_CTRY * NUM_NEW_AEZ, sizeof(float));
-    if(diag_pasturearea_aez == NULL) {
-        fprintf(fplog,"Failed to allocate memory for diag_pasturearea_aez:  calc_harvarea_prod_out_aez()\n");
-        return ERROR_MEM;
+	
+    // open (or build) the consolidated sage crop store, if one is named in the input file
+    if ((err = sagestore_open(&sage_store, in_args, raster_info)) != OK) {
+        fprintf(fplog,"Failed to open the sage crop store: calc_harvarea_prod_out_aez()\n");
+        return err;
     }
 	
 	// loop over SAGE crops
 	for (cropind = 0; cropind < NUM_SAGE_CROP; cropind++) {
 		
-		// read in yield and harvest area
+		// read in yield and harvest area, from the store or from the crop file
 		// file units are converted from t/ha to t/km^2 and from fraction of land area to km^2
 		// this function ensures that valid yield and area values exist for sage land cells
 		strcpy(fname, in_args.sagepath);
 		strcat(fname, &cropfilebase_sage[cropind][0]); // the read function will determine whether the file is zipped or not
-		if ((err = read_sage_crop(fname, in_args.sagepath, &cropfilebase_sage[cropind][0], raster_info))) {
+		if (sage_store.ncid >= 0) {
+			err = sagestore_read_crop(&sage_store, cropind, raster_info);
+		} else {
+			err = read_sage_crop(fname, in_args.sagepath, &cropfilebase_sage[cropind][0], raster_info);
+		}
+		if (err) {
 			fprintf(fplog, "Failed to read yield and area for crop %s: calc_harvarea_prod_out_aez()\n", fname);
 			return err;
 		}
@@ -182,8 +206,10 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 		// determine fao country, skip if fao country not found
 		// aggregate to fao country for optional calibration
 		// aggregate to land unit (aez within each fao country)
+		band_walk_init(&walk, in_args);
 		for (cellind = 0; cellind < num_land_cells_sage; cellind++) {
 			land_cell = land_cells_sage[cellind];
+			band_walk_cell(&walk, land_cell);
 			// fao country index
 			if ((int) country_fao[land_cell] != raster_info.country_fao_nodata) {
 				ctry_index = NOMATCH;
@@ -207,8 +233,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                 
 				// get the glu number; this function retrieves the nodata value if no associated glu is found
 				// do not use this cell data if there is no associated aez
-				if ((err = get_aez_val(aez_bounds_new, land_cell, raster_info.aez_new_nrows,
-									  raster_info.aez_new_ncols, raster_info.aez_new_nodata, &aez_val))) {
+				if ((err = get_aez_val(aez_bounds_new[land_cell], land_cell,
+									  raster_info.aez_new_nodata, &aez_val))) {
 					fprintf(fplog, "Failed to get aez_val for crop %s: calc_harvarea_prod_out_aez()\n", fname);
 					return err;
 				}
@@ -226,28 +252,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                         }
                     }
                     
-                    // get the current glu index in the complete glu list
-                    all_aez_index = NOMATCH;
-                    for (i = 0; i < NUM_NEW_AEZ ; i++) {
-                        if (aez_codes_new[i] == aez_val) {
-                            all_aez_index = i;
-                            break;
-                        }
-                    }
-                    if (all_aez_index == NOMATCH) {
-                        fprintf(fplog, "Failed to get all_aez_index for crop %s in cellind = %i: calc_harvarea_prod_out_aez()\n",
-                                fname, cellind);
-                        return err;
-                    }
-                    
                     // get the current glu index in the country list
-                    aez_index = NOMATCH;
-                    for (i = 0; i < ctry_aez_num[ctry_index]; i++) {
-                        if (ctry_aez_list[ctry_index][i] == aez_val) {
-                            aez_index = i;
-                            break;
-                        }
-                    }
+                    aez_index = glu_list_index(ctry_aez_list[ctry_index], ctry_aez_num[ctry_index], aez_val);
                     if (aez_index == NOMATCH) {
                         fprintf(fplog, "Failed to get aez_index for crop %s in cellind = %i: calc_harvarea_prod_out_aez()\n",
                                 fname, cellind);
@@ -263,12 +269,14 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                             production_crop_aez[ctry_index][aez_index][cropind] +
                             harvestarea_in[land_cell] * yield_in[land_cell];
                         
-                        // fill the 1d arrays
-                        diag_index = ctry_index * NUM_SAGE_CROP * NUM_NEW_AEZ + cropind * NUM_NEW_AEZ + all_aez_index;
-                        diag_harvestarea_crop_aez[diag_index] = diag_harvestarea_crop_aez[diag_index] +
-                            KMSQ2HA * harvestarea_in[land_cell];
-                        diag_production_crop_aez[diag_index] = diag_production_crop_aez[diag_index] +
-                            harvestarea_in[land_cell] * yield_in[land_cell];
+                        // fill the diagnostic cubes
+                        if (diag_harvprod) {
+                            diag_index = GLUCUBE_IND(&diag_harvestarea_crop_aez, ctry_index, cropind, aez_index);
+                            diag_harvestarea_crop_aez.values[diag_index] = diag_harvestarea_crop_aez.values[diag_index] +
+                                KMSQ2HA * harvestarea_in[land_cell];
+                            diag_production_crop_aez.values[diag_index] = diag_production_crop_aez.values[diag_index] +
+                                harvestarea_in[land_cell] * yield_in[land_cell];
+                        }
                         
                         // aggregate to fao countries by sage crop, for recalibration; only area is needed here
                         // do this only for data that will be included in the ctryXglu pixel output
@@ -310,10 +318,12 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 						pasturearea_aez[ctry_index][aez_index] = pasturearea_aez[ctry_index][aez_index] +
 							KMSQ2HA * pasture_area[land_cell];
                         
-                        // fill the 1d array
-                        diag_index = ctry_index * NUM_NEW_AEZ + all_aez_index;
-                        diag_pasturearea_aez[diag_index] = diag_pasturearea_aez[diag_index] +
-                            KMSQ2HA * pasture_area[land_cell];
+                        // fill the diagnostic cube
+                        if (diag_harvprod) {
+                            diag_index = GLUCUBE_IND(&diag_pasturearea_aez, ctry_index, 0, aez_index);
+                            diag_pasturearea_aez.values[diag_index] = diag_pasturearea_aez.values[diag_index] +
+                                KMSQ2HA * pasture_area[land_cell];
+                        }
 						
 						// store the output countryXaez land mask
 						land_mask_ctryaez[land_cell] = 1;
@@ -322,6 +332,7 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 			}	// end if aggregating to fao country values
 			
 		}	// end for cellind loop over sage land cells
+		band_walk_end(&walk);
 		
 	}	// end for cropind loop over sage crops
     
@@ -352,12 +363,12 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 		}
 		
 		// allocate recalib area and yield arrays
-		area_recalib = calloc(NUM_CELLS, sizeof(float));
+		area_recalib = grid_calloc(NUM_CELLS, sizeof(float));
 		if(area_recalib == NULL) {
 			fprintf(fplog,"Recalibrate: Failed to allocate memory for area_recalib:  calc_harvarea_prod_out_aez()\n");
 			return ERROR_MEM;
 		}
-		yield_recalib = calloc(NUM_CELLS, sizeof(float));
+		yield_recalib = grid_calloc(NUM_CELLS, sizeof(float));
 		if(yield_recalib == NULL) {
 			fprintf(fplog,"Recalibrate: Failed to allocate memory for yield_recalib:  calc_harvarea_prod_out_aez()\n");
 			return ERROR_MEM;
@@ -373,10 +384,10 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 			}
 		}
 		
-		// need to zero the diagnostic production and harvest area arrays
-		for (i = 0; i < NUM_FAO_CTRY * NUM_SAGE_CROP * NUM_NEW_AEZ; i++) {
-			diag_production_crop_aez[i] = 0;
-			diag_harvestarea_crop_aez[i] = 0;
+		// need to zero the diagnostic production and harvest area cubes
+		if (diag_harvprod) {
+			glucube_zero(&diag_production_crop_aez);
+			glucube_zero(&diag_harvestarea_crop_aez);
 		}
 		
 		// loop over crops, then cells, so that only two raster loops are needed per crop
@@ -388,14 +399,21 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 			// this function ensures that valid yield and area values exist for sage land cells
 			strcpy(fname, in_args.sagepath);
 			strcat(fname, &cropfilebase_sage[cropind][0]); // the read function will determine whether the file is zipped or not
-			if ((err = read_sage_crop(fname, in_args.sagepath, &cropfilebase_sage[cropind][0], raster_info))) {
+			if (sage_store.ncid >= 0) {
+				err = sagestore_read_crop(&sage_store, cropind, raster_info);
+			} else {
+				err = read_sage_crop(fname, in_args.sagepath, &cropfilebase_sage[cropind][0], raster_info);
+			}
+			if (err) {
 				fprintf(fplog, "Failed to read yield and area for crop %s: calc_harvarea_prod_out_aez()\n", fname);
 				return err;
 			}
 			
 			// area recalibration loop
+			band_walk_init(&walk, in_args);
 			for (cellind = 0; cellind < num_land_cells_sage; cellind++) {
 				land_cell = land_cells_sage[cellind];
+				band_walk_cell(&walk, land_cell);
 				area_recalib[land_cell] = 0;
 				// fao country index
 				if ((int) country_fao[land_cell] != raster_info.country_fao_nodata) {
@@ -419,8 +437,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                     
 					// get the glu number; this function retrieves the nodata value if no associated glu is found
 					// do not use this cell data if there is no associated glu
-					if ((err = get_aez_val(aez_bounds_new, land_cell, raster_info.aez_new_nrows,
-										   raster_info.aez_new_ncols, raster_info.aez_new_nodata, &aez_val))) {
+					if ((err = get_aez_val(aez_bounds_new[land_cell], land_cell,
+										   raster_info.aez_new_nodata, &aez_val))) {
 						fprintf(fplog, "Recalibrate: Failed to get aez_val for crop %s: calc_harvarea_prod_out_aez()\n", fname);
 						return err;
 					}
@@ -488,8 +506,10 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                             // but first check the denominator for abnormally low values (< 100 m^2)
                             if (country_harvarea[recal_index] != 0) {
                                 if (country_harvarea[recal_index] < 0.0001) {
-                                    fprintf(fplog, "Recalibrate: Bad country_harvarea[%i] = %e value at ctry_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
-                                            recal_index, country_harvarea[recal_index], ctry_index, cropind);
+                                    if (log_sample(&bad_ctry_harvarea_site)) {
+                                        fprintf(fplog, "Recalibrate: Bad country_harvarea[%i] = %e value at ctry_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
+                                                recal_index, country_harvarea[recal_index], ctry_index, cropind);
+                                    }
                                     area_recalib[land_cell] = 0;
                                 } else {
                                     area_recalib[land_cell] = harvestarea_in[land_cell] * harvest_val_fao / country_harvarea[recal_index];
@@ -500,27 +520,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                                 area_recalib[land_cell] = 0;
                             }
                             
-                            // get the current aez index in the complete aez list
-                            all_aez_index = NOMATCH;
-                            for (i = 0; i < NUM_NEW_AEZ ; i++) {
-                                if (aez_codes_new[i] == aez_val) {
-                                    all_aez_index = i;
-                                    break;
-                                }
-                            }
-                            if (all_aez_index == NOMATCH) {
-                                fprintf(fplog, "Failed to get all_aez_index for crop %s for area recalib: calc_harvarea_prod_out_aez()\n", fname);
-                                return err;
-                            }
-                            
                             // get the current aez index in the country aez list
-                            aez_index = NOMATCH;
-                            for (i = 0; i < ctry_aez_num[ctry_index]; i++) {
-                                if (ctry_aez_list[ctry_index][i] == aez_val) {
-                                    aez_index = i;
-                                    break;
-                                }
-                            }
+                            aez_index = glu_list_index(ctry_aez_list[ctry_index], ctry_aez_num[ctry_index], aez_val);
                             if (aez_index == NOMATCH) {
                                 fprintf(fplog, "Failed to get aez_index for crop %s for area recalib: calc_harvarea_prod_out_aez()\n", fname);
                                 return err;
@@ -534,14 +535,18 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                             
                             if (harvestarea_crop_aez[ctry_index][aez_index][cropind] < 0 ||
                                 harvestarea_crop_aez[ctry_index][aez_index][cropind] > 30000000) {
-                                fprintf(fplog, "Recalibrate: Bad harvestarea_crop_aez = %f output at ctry_index = %i and aez_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
-                                        harvestarea_crop_aez[ctry_index][aez_index][cropind], ctry_index, aez_index, cropind);
+                                if (log_sample(&bad_harvarea_site)) {
+                                    fprintf(fplog, "Recalibrate: Bad harvestarea_crop_aez = %f output at ctry_index = %i and aez_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
+                                            harvestarea_crop_aez[ctry_index][aez_index][cropind], ctry_index, aez_index, cropind);
+                                }
                             }
                             
-                            // fill the 1d array
-                            diag_index = ctry_index * NUM_SAGE_CROP * NUM_NEW_AEZ + cropind * NUM_NEW_AEZ + all_aez_index;
-                            diag_harvestarea_crop_aez[diag_index] = diag_harvestarea_crop_aez[diag_index] +
-                            KMSQ2HA * area_recalib[land_cell];
+                            // fill the diagnostic cube
+                            if (diag_harvprod) {
+                                diag_index = GLUCUBE_IND(&diag_harvestarea_crop_aez, ctry_index, cropind, aez_index);
+                                diag_harvestarea_crop_aez.values[diag_index] = diag_harvestarea_crop_aez.values[diag_index] +
+                                KMSQ2HA * area_recalib[land_cell];
+                            }
                             
                         } // end if area and yield are both positve values for this cell
 						
@@ -550,10 +555,13 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 				}	// end if fao country for recalibration of area
 				
 			}	// end for cellind loop to recalibrate area
+			band_walk_end(&walk);
 			
 			// now loop again to recalibrate the yields and calculate the output production
+			band_walk_init(&walk, in_args);
 			for (cellind = 0; cellind < num_land_cells_sage; cellind++) {
 				land_cell = land_cells_sage[cellind];
+				band_walk_cell(&walk, land_cell);
 				yield_recalib[land_cell] = 0;
 				// fao country index
 				if ((int) country_fao[land_cell] != raster_info.country_fao_nodata) {
@@ -575,8 +583,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
                 } else {
 					// get the aez number; this function retrieves the nodata value if no associated aez is found
 					// do not use this cell data if there is no associated aez
-					if ((err = get_aez_val(aez_bounds_new, land_cell, raster_info.aez_new_nrows,
-										   raster_info.aez_new_ncols, raster_info.aez_new_nodata, &aez_val))) {
+					if ((err = get_aez_val(aez_bounds_new[land_cell], land_cell,
+										   raster_info.aez_new_nodata, &aez_val))) {
 						fprintf(fplog, "Recalibrate: Failed to get aez_val for crop %s: calc_harvarea_prod_out_aez()\n", fname);
 						return err;
 					}
@@ -644,8 +652,10 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 							// so it is 0.1 t / km^2 * 1 km^2 (which is the ~ size of one grid cell at 89deglat) = 0.1 t
 							if (country_prod[recal_index] != 0) {
 								if (country_prod[recal_index] < 0.1) {
-									fprintf(fplog, "Recalibrate: Bad country_prod[recal_index][%i] = %e value at ctry_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
-											recal_index, country_prod[recal_index], ctry_index, cropind);
+									if (log_sample(&bad_ctry_prod_site)) {
+										fprintf(fplog, "Recalibrate: Bad country_prod[recal_index][%i] = %e value at ctry_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
+												recal_index, country_prod[recal_index], ctry_index, cropind);
+									}
 									yield_recalib[land_cell] = 0;
 								} else {
 									yield_recalib[land_cell] = yield_in[land_cell] * prod_val_fao / country_prod[recal_index];
@@ -654,27 +664,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 								yield_recalib[land_cell] = 0;
 							}
 							
-							// get the current aez index in the complete aez list
-							all_aez_index = NOMATCH;
-							for (i = 0; i < NUM_NEW_AEZ ; i++) {
-								if (aez_codes_new[i] == aez_val) {
-									all_aez_index = i;
-									break;
-								}
-							}
-							if (all_aez_index == NOMATCH) {
-								fprintf(fplog, "Failed to get all_aez_index for crop %s for area recalib: calc_harvarea_prod_out_aez()\n", fname);
-								return err;
-							}
-							
 							// get the current aez index in the country aez list
-							aez_index = NOMATCH;
-							for (i = 0; i < ctry_aez_num[ctry_index]; i++) {
-								if (ctry_aez_list[ctry_index][i] == aez_val) {
-									aez_index = i;
-									break;
-								}
-							}
+							aez_index = glu_list_index(ctry_aez_list[ctry_index], ctry_aez_num[ctry_index], aez_val);
 							if (aez_index == NOMATCH) {
 								fprintf(fplog, "Failed to get aez_index for crop %s for area recalib: calc_harvarea_prod_out_aez()\n", fname);
 								return err;
@@ -691,14 +682,18 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 							// even without the preceding filter
 							if (production_crop_aez[ctry_index][aez_index][cropind] < 0 ||
 								production_crop_aez[ctry_index][aez_index][cropind] > 200000000) {
-								fprintf(fplog, "Recalibrate: Bad production_crop_aez = %f output at ctry_index = %i and aez_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
-										production_crop_aez[ctry_index][aez_index][cropind], ctry_index, aez_index, cropind);
+								if (log_sample(&bad_prod_site)) {
+									fprintf(fplog, "Recalibrate: Bad production_crop_aez = %f output at ctry_index = %i and aez_index = %i and cropind = %i: calc_harvarea_prod_out_aez()\n",
+											production_crop_aez[ctry_index][aez_index][cropind], ctry_index, aez_index, cropind);
+								}
 							}
 							
-							// fill the 1d array
-							diag_index = ctry_index * NUM_SAGE_CROP * NUM_NEW_AEZ + cropind * NUM_NEW_AEZ + all_aez_index;
-							diag_production_crop_aez[diag_index] = diag_production_crop_aez[diag_index] +
-							area_recalib[land_cell] * yield_recalib[land_cell];
+							// fill the diagnostic cube
+							if (diag_harvprod) {
+								diag_index = GLUCUBE_IND(&diag_production_crop_aez, ctry_index, cropind, aez_index);
+								diag_production_crop_aez.values[diag_index] = diag_production_crop_aez.values[diag_index] +
+								area_recalib[land_cell] * yield_recalib[land_cell];
+							}
 							
 						} // end if area and yield are both positive for this cell
 						
@@ -707,6 +702,7 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 				}	// end if fao country for recalibration of production/yield
 				
 			}	// end for cellind loop to recalibrate production/yield
+			band_walk_end(&walk);
 			
 			
 			// to do: this is where each recalibrated crop harvested area and yield can be written
@@ -716,8 +712,8 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 			}
 		}	// end for cropind for area and production recalibration
 		
-		free(area_recalib);
-		free(yield_recalib);
+		grid_free(area_recalib);
+		grid_free(yield_recalib);
 	}	// end if recalibrate
 	
     // write the lost info to the log file
@@ -736,18 +732,15 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 		}
 		
 		// write the sage production and harvest area and pasture area by fao country, crop, and aez
-		if ((err = write_csv_float3d(diag_production_crop_aez, countrycodes_fao, cropcodes_sage,
-									 NUM_FAO_CTRY, NUM_SAGE_CROP, NUM_NEW_AEZ, out_name_prod, in_args))) {
+		if (diag_harvprod && (err = write_csv_glucube(&diag_production_crop_aez, countrycodes_fao, cropcodes_sage, out_name_prod, in_args))) {
 			fprintf(fplog, "Error writing file %s: calc_harvarea_prod_out_crop_aez()\n", out_name_prod);
 			return err;
 		}
-		if ((err = write_csv_float3d(diag_harvestarea_crop_aez, countrycodes_fao, cropcodes_sage,
-									 NUM_FAO_CTRY, NUM_SAGE_CROP, NUM_NEW_AEZ, out_name_harv, in_args))) {
+		if (diag_harvprod && (err = write_csv_glucube(&diag_harvestarea_crop_aez, countrycodes_fao, cropcodes_sage, out_name_harv, in_args))) {
 			fprintf(fplog, "Error writing file %s: calc_harvarea_prod_out_crop_aez()\n", out_name_harv);
 			return err;
 		}
-		if ((err = write_csv_float2d(diag_pasturearea_aez, countrycodes_fao,
-									 NUM_FAO_CTRY, NUM_NEW_AEZ, out_name_past, in_args))) {
+		if (diag_harvprod && (err = write_csv_glucube(&diag_pasturearea_aez, countrycodes_fao, NULL, out_name_past, in_args))) {
 			fprintf(fplog, "Error writing file %s: calc_harvarea_prod_out_crop_aez()\n", out_name_past);
 			return err;
 		}
@@ -759,9 +752,10 @@ int calc_harvarea_prod_out_crop_aez(args_struct in_args, rinfo_struct raster_inf
 		}
 	}
 	
-    free(diag_production_crop_aez);
-    free(diag_harvestarea_crop_aez);
-    free(diag_pasturearea_aez);
+    sagestore_close(&sage_store);
+    glucube_free(&diag_production_crop_aez);
+    glucube_free(&diag_harvestarea_crop_aez);
+    glucube_free(&diag_pasturearea_aez);
     
 	return OK;
 }
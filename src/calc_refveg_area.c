@@ -78,6 +78,7 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 	int i, j, m, n;
 	int err = OK;			// store error code from the write function
 	int count = 0;			// counting the working grid cells
+	int block_land;			// 1 if the current lulc cell has a hyde land cell in the processing window
 	
 	// should probably retrieve these from the info arrays
 	int urban_ind = 0;		// index in lu_area of urban values
@@ -104,6 +105,7 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 	int *lu_indices;		// array for the working grid indices for the lu cells for a single lulc cell
 	float *refveg_area_out;		// array for the reference veg areas in each working grid cell, for a single lulc cell
 	int *refveg_them;		// array for the reference veg tyep values in each working grid cell, for a single lulc cell
+	band_walk_struct walk;	// releases the bands of the working grids behind the loop over the lulc cells
 	
 	// first read in the appropriate hyde land use area data
 	// this is needed to get num_lu_cells
@@ -165,6 +167,8 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 	}
 	
 	// loop over the coarse lulc data
+	// the lulc cells are in grid order, so each latitude band of the working grids is released when the loop leaves it
+	band_walk_init(&walk, in_args);
 	for (i = 0; i < ncells_lulc; i++) {
 		
 		//if (in_args.diagnostics) {
@@ -182,6 +186,11 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 		modf((double) (i / ncols_lulc), &int_dbl);
 		grid_y_ul = (int) int_dbl * (num_split);
 		grid_x_ul = (int) rem_dbl * (num_split);
+		band_walk_cell(&walk, grid_y_ul * NUM_LON);
+		// skip the lulc cells outside the processing window box; their working grid cells are not land cells
+		if (!window_overlaps(grid_y_ul, grid_x_ul, num_split, num_split)) {
+			continue;
+		}
 		// now loop over the working grid cells to store the 1d indices and input areas, and initialize the ref veg values
 		count = 0;
 		for (m = grid_y_ul; m < grid_y_ul + num_split; m++) {
@@ -203,18 +212,26 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 			return err;
 		}
 		
-		// calculate the areas for this lulc cell
+		// calculate the areas for this lulc cell, if it has land in the window
 		// this keeps the hyde land use (but checks it for land consistency), and disaggregates the lc data to the non-lu cell area
-		if ((err = proc_lulc_area(in_args, *raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them, num_lu_cells)) != OK)
+		// a cell without window land skips this, and all of its working grid cells are set to nodata below
+		block_land = 0;
+		for (j = 0; j < num_lu_cells; j++) {
+			if (land_mask_hyde[lu_indices[j]] == 1) {
+				block_land = 1;
+				break;
+			}
+		}
+		if (block_land && (err = proc_lulc_area(in_args, *raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them, num_lu_cells)) != OK)
 		{
 			fprintf(fplog, "Failed to process lulc cell %i for reference year: calc_refveg_area()\n", i);
 			return err;
 		}
 		
 		// store the areas in the appropriate places
-		// set cell to nodata if it is not a land cell
+		// set cell to nodata if it is not a land cell in the window
 		for (j = 0; j < num_lu_cells; j++) {
-			if (land_area_hyde[lu_indices[j]] != raster_info->land_area_hyde_nodata) {
+			if (land_mask_hyde[lu_indices[j]] == 1) {
 				cropland_area[lu_indices[j]] = lu_area[j][crop_ind];
 				pasture_area[lu_indices[j]] = lu_area[j][pasture_ind];
 				urban_area[lu_indices[j]] = lu_area[j][urban_ind];
@@ -222,15 +239,22 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 					lu_detail_area[m-NUM_HYDE_TYPES_MAIN][lu_indices[j]] = lu_area[j][m];
 				}
 				refveg_area[lu_indices[j]] = refveg_area_out[j];
-				refveg_thematic[lu_indices[j]] = refveg_them[j];
+				if (!THM8_FITS(refveg_them[j], raster_info->potveg_nodata)) {
+					fprintf(fplog, "Error: ref veg code %i of cell %i does not fit 8 bits: calc_refveg_area()\n", refveg_them[j], lu_indices[j]);
+					return ERROR_IND;
+				}
+				refveg_thematic[lu_indices[j]] = THM8_CODE(refveg_them[j], raster_info->potveg_nodata);
 				
 				// if ref veg, then add cell index to land_mask_refveg and forest cells as appropriate
-				if (refveg_thematic[lu_indices[j]] != raster_info->potveg_nodata) {
+				if (refveg_them[j] != raster_info->potveg_nodata) {
 					land_mask_refveg[lu_indices[j]] = 1;
 					// store the indices of the forest cells
-					if (refveg_thematic[lu_indices[j]] <= MAX_SAGE_FOREST_CODE && refveg_thematic[lu_indices[j]] >= MIN_SAGE_FOREST_CODE) {
+					if (refveg_them[j] <= MAX_SAGE_FOREST_CODE && refveg_them[j] >= MIN_SAGE_FOREST_CODE) {
 						forest_cells[num_forest_cells++] = lu_indices[j];
-						land_mask_forest[lu_indices[j]] = 1;
+						// the forest mask is only for diagnostics (DIAG_LAND_CELLS)
+						if (land_mask_forest != NULL) {
+							land_mask_forest[lu_indices[j]] = 1;
+						}
 					}
 				} // end if valid ref veg and land area; forest will be checked in calc_rent_frs_use_aez for valid country/glu
 				
@@ -242,10 +266,11 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 					lu_detail_area[m-NUM_HYDE_TYPES_MAIN][lu_indices[j]] = NODATA;
 				}
 				refveg_area[lu_indices[j]] = NODATA;
-				refveg_thematic[lu_indices[j]] = raster_info->potveg_nodata;
+				refveg_thematic[lu_indices[j]] = THM8_NODATA;
 			}
 		} // end for j loop over the lu cells to store
 	} // end for i loop over the lulc cells
+	band_walk_end(&walk);
 	
 	 
 	if (in_args.diagnostics) {
@@ -270,7 +295,7 @@ int calc_refveg_area(args_struct in_args, rinfo_struct *raster_info) {
 			return err;
 		}
 		// reference vegetation types
-		if ((err = write_raster_int(refveg_thematic, NUM_CELLS, "refveg_thematic.bil", in_args))) {
+		if ((err = write_raster_thm8(refveg_thematic, NUM_CELLS, raster_info->potveg_nodata, "refveg_thematic.bil", in_args))) {
 			fprintf(fplog, "Error writing file %s: calc_refveg_area()\n", "refveg_thematic.bil");
 			return err;
 		}
@@ -61,7 +61,7 @@
 int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
     
     int i,j,k,m;
-    int aez_ind, aez_ind_reglr, crop_ind, use_ind, sum_index, ctry_ind, reglr_ind, out_index, all_aez_index;	// loop and placement indices
+    int aez_ind, aez_ind_reglr, crop_ind, use_ind, sum_index, ctry_ind, reglr_ind, out_index;	// loop and placement indices
     // find these based on the codes below
     int vnm_ind = NOMATCH;		// vietnam land rent region index
     int hkg_ind = NOMATCH;		// hong kong land rent region index
@@ -73,7 +73,7 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
     int twn_code = 60;		// taiwan ctry87 index  (code minus 1)
     
     int vnm_sum_ind;        // for holding the vietnam indices
-    int diag_index;         // for a couple of 1d output diagnostic arrays
+    long diag_index;        // for the diagnostic output cubes
     int gro_sect = 3;		// the use code for the grain sector
     int ctl_sect = 9;		// the use code for the cattle, sheep, etc sector
     int rmk_sect = 11;		// the use code for the dairy sector
@@ -86,15 +86,16 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
     float *newrent87;		// store the new rent summed across aezs (i.e. per ctry87, per use sector)
     float **harvestsum;		// sum for averaging yield and price to gro sector and land rent region per aez (ha)
     float **pasture87_aez;	// pasture area per aez per land rent region (ha)
-    float *lrout;			// for diagnostic output in USD
+    glucube_struct lrout;	// for diagnostic output in USD; use varies faster than region
     float *orout;			// for diagnostic output in USD
     float *nrout;			// for diagnostic output in USD
     
-    // for now, use old-format 1d arrays for these diagnostic outputs
+    // these old-format diagnostic outputs are sparse cubes that store only the aezs of each land rent region (see glu_cube.c)
+    // they, lrout, orout and nrout are allocated and filled only if DIAG_RENT is on
     // aez varies faster, then land rent region
-    // to do: check for gridded new aez input
-    float *diag_harvestsum;		// sum for averaging yield and price to gro sector and land rent region per aez (ha)
-    float *diag_pasture87_aez;	// pasture area per aez per land rent region (ha)
+    int diag_rent = DIAG_ON(in_args, DIAG_RENT);
+    glucube_struct diag_harvestsum;		// sum for averaging yield and price to gro sector and land rent region per aez (ha)
+    glucube_struct diag_pasture87_aez;	// pasture area per aez per land rent region (ha)
     
     char out_name[] = "rent_use_aez_ag.csv";				// diagnostic output csv file name
     char out_name_past[] = "pasturearea87_aez.csv";		// diagnostic output for the aggregated pasture area
@@ -138,31 +139,35 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
             return ERROR_MEM;
         }
     }
-    // allocate memory for the diagnostic output
-    lrout = calloc(NUM_GTAP_CTRY87 * NUM_GTAP_USE * NUM_NEW_AEZ, sizeof(float));
-    if(lrout == NULL) {
-        fprintf(fplog,"Failed to allocate memory for lrout:  calc_rent_ag_use_aez()\n");
-        return ERROR_MEM;
-    }
-    orout = calloc(NUM_GTAP_CTRY87 * NUM_GTAP_USE, sizeof(float));
-    if(orout == NULL) {
-        fprintf(fplog,"Failed to allocate memory for orout:  calc_rent_ag_use_aez()\n");
-        return ERROR_MEM;
-    }
-    nrout = calloc(NUM_GTAP_CTRY87 * NUM_GTAP_USE, sizeof(float));
-    if(nrout == NULL) {
-        fprintf(fplog,"Failed to allocate memory for nrout:  calc_rent_ag_use_aez()\n");
-        return ERROR_MEM;
-    }
-    diag_harvestsum = calloc(NUM_GTAP_CTRY87 * NUM_NEW_AEZ, sizeof(float));
-    if(diag_harvestsum == NULL) {
-        fprintf(fplog,"Failed to allocate memory for diag_harvestsum:  calc_rent_ag_use_aez()\n");
-        return ERROR_MEM;
-    }
-    diag_pasture87_aez = calloc(NUM_GTAP_CTRY87 * NUM_NEW_AEZ, sizeof(float));
-    if(diag_pasture87_aez == NULL) {
-        fprintf(fplog,"Failed to allocate memory for diag_pasture87_aez:  calc_rent_ag_use_aez()\n");
-        return ERROR_MEM;
+    // allocate memory for the diagnostic output; an unused cube stays empty so that it can still be freed
+    memset(&lrout, 0, sizeof(glucube_struct));
+    memset(&diag_harvestsum, 0, sizeof(glucube_struct));
+    memset(&diag_pasture87_aez, 0, sizeof(glucube_struct));
+    orout = NULL;
+    nrout = NULL;
+    if (diag_rent) {
+        if(glucube_init(&lrout, NUM_GTAP_CTRY87, NUM_GTAP_USE, reglr_aez_num, reglr_aez_list) != OK) {
+            fprintf(fplog,"Failed to allocate memory for lrout:  calc_rent_ag_use_aez()\n");
+            return ERROR_MEM;
+        }
+        orout = calloc(NUM_GTAP_CTRY87 * NUM_GTAP_USE, sizeof(float));
+        if(orout == NULL) {
+            fprintf(fplog,"Failed to allocate memory for orout:  calc_rent_ag_use_aez()\n");
+            return ERROR_MEM;
+        }
+        nrout = calloc(NUM_GTAP_CTRY87 * NUM_GTAP_USE, sizeof(float));
+        if(nrout == NULL) {
+            fprintf(fplog,"Failed to allocate memory for nrout:  calc_rent_ag_use_aez()\n");
+            return ERROR_MEM;
+        }
+        if(glucube_init(&diag_harvestsum, NUM_GTAP_CTRY87, 1, reglr_aez_num, reglr_aez_list) != OK) {
+            fprintf(fplog,"Failed to allocate memory for diag_harvestsum:  calc_rent_ag_use_aez()\n");
+            return ERROR_MEM;
+        }
+        if(glucube_init(&diag_pasture87_aez, NUM_GTAP_CTRY87, 1, reglr_aez_num, reglr_aez_list) != OK) {
+            fprintf(fplog,"Failed to allocate memory for diag_pasture87_aez:  calc_rent_ag_use_aez()\n");
+            return ERROR_MEM;
+        }
     }
     
     // get the indices of vietnam, hong kong, and taiwan
@@ -221,13 +226,7 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
             for (aez_ind = 0; aez_ind < ctry_aez_num[ctry_ind]; aez_ind++) {
                 
                 // get the index for this aez in the land rent region
-                aez_ind_reglr = NOMATCH;
-                for (i = 0; i < reglr_aez_num[reglr_ind]; i++) {
-                    if (ctry_aez_list[ctry_ind][aez_ind] == reglr_aez_list[reglr_ind][i]) {
-                        aez_ind_reglr = i;
-                        break;
-                    }
-                }	// end for i loop to get aez_ind_reglr
+                aez_ind_reglr = glu_list_index(reglr_aez_list[reglr_ind], reglr_aez_num[reglr_ind], ctry_aez_list[ctry_ind][aez_ind]);
                 
                 // this should not happen
                 if(aez_ind_reglr == NOMATCH) {
@@ -261,20 +260,6 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
                  }
                  */
                 
-                // get the aez index in the complete aez list
-                all_aez_index = NOMATCH;
-                for (i = 0; i < NUM_NEW_AEZ; i++) {
-                    if (aez_codes_new[i] == reglr_aez_list[reglr_ind][aez_ind_reglr]) {
-                        all_aez_index = i;
-                        break;
-                    }
-                }
-                if (all_aez_index == NOMATCH) {
-                    // this shouldn't happen
-                    fprintf(fplog,"Error finding all aez index: calc_rent_frs_use_aez(); land rent region=%i aez=%i\n",
-                            country87codes_gtap[reglr_ind], reglr_aez_list[reglr_ind][aez_ind_reglr]);
-                    return ERROR_FILE;
-                }
                 
                 // ruminant sectors (ctl, rmk, wol)
                 // get the average grain sector (gro) yield from production / harvested area - area weighted!
@@ -286,10 +271,12 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
                         harvestsum[reglr_ind][aez_ind_reglr] =
                         harvestsum[reglr_ind][aez_ind_reglr] + harvestarea_crop_aez[ctry_ind][aez_ind][crop_ind];
                         
-                        // fill the 1d array
-                        diag_index = reglr_ind * NUM_NEW_AEZ + all_aez_index;
-                        diag_harvestsum[diag_index] = diag_harvestsum[diag_index] +
-                            harvestarea_crop_aez[ctry_ind][aez_ind][crop_ind];
+                        // fill the diagnostic cube
+                        if (diag_rent) {
+                            diag_index = GLUCUBE_IND(&diag_harvestsum, reglr_ind, 0, aez_ind_reglr);
+                            diag_harvestsum.values[diag_index] = diag_harvestsum.values[diag_index] +
+                                harvestarea_crop_aez[ctry_ind][aez_ind][crop_ind];
+                        }
                     }
                 } // end if gro sector
                 
@@ -298,10 +285,12 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
                     pasture87_aez[reglr_ind][aez_ind_reglr] =
                     pasture87_aez[reglr_ind][aez_ind_reglr] + pasturearea_aez[ctry_ind][aez_ind];
                     
-                    // fill the 1d array
-                    diag_index = reglr_ind * NUM_NEW_AEZ + all_aez_index;
-                    diag_pasture87_aez[diag_index] = diag_pasture87_aez[diag_index] +
-                        pasturearea_aez[ctry_ind][aez_ind];
+                    // fill the diagnostic cube
+                    if (diag_rent) {
+                        diag_index = GLUCUBE_IND(&diag_pasture87_aez, reglr_ind, 0, aez_ind_reglr);
+                        diag_pasture87_aez.values[diag_index] = diag_pasture87_aez.values[diag_index] +
+                            pasturearea_aez[ctry_ind][aez_ind];
+                    }
                 }
                 
             }	// end for loop over country aezs
@@ -391,39 +380,25 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
                 // add up the new rent across aez to land rent region for diagnostics
                 newrent87[j] = newrent87[j] + rent_use_aez[reglr_ind][aez_ind_reglr][use_ind];
                 
-                // get the aez index in the complete aez list
-                all_aez_index = NOMATCH;
-                for (i = 0; i < NUM_NEW_AEZ; i++) {
-                    if (aez_codes_new[i] == reglr_aez_list[reglr_ind][aez_ind_reglr]) {
-                        all_aez_index = i;
-                        break;
-                    }
-                }
-                if (all_aez_index == NOMATCH) {
-                    // this shouldn't happen
-                    fprintf(fplog,"Error finding all aez index: calc_rent_frs_use_aez(); land rent region=%i aez=%i\n",
-                            country87codes_gtap[reglr_ind], reglr_aez_list[reglr_ind][aez_ind_reglr]);
-                    return ERROR_FILE;
-                }
                 
                 // convert origrent87, newrent87, and rent_use_aez to USD for diagnostic output
-                out_index = reglr_ind * NUM_GTAP_USE * NUM_NEW_AEZ + use_ind * NUM_NEW_AEZ + all_aez_index;
-                lrout[out_index] = MIL2ONE * rent_use_aez[reglr_ind][aez_ind_reglr][use_ind];
-                nrout[j] = MIL2ONE * newrent87[j];
-                orout[j] = MIL2ONE * origrent87[j];
+                if (diag_rent) {
+                    diag_index = GLUCUBE_IND(&lrout, reglr_ind, use_ind, aez_ind_reglr);
+                    lrout.values[diag_index] = MIL2ONE * rent_use_aez[reglr_ind][aez_ind_reglr][use_ind];
+                    nrout[j] = MIL2ONE * newrent87[j];
+                    orout[j] = MIL2ONE * origrent87[j];
+                }
                 
             }	// end for aez_ind_reglr loop to calculate final land rent values
         }	// end for use_ind loop to calculate final land rent values
     }	// end for reglr_ind loop to calculate final land rent values
     
-    if (in_args.diagnostics) {
-        if ((err = write_csv_float3d(lrout, country87codes_gtap, usecodes_gtap,
-                                     NUM_GTAP_CTRY87, NUM_GTAP_USE, NUM_NEW_AEZ, out_name, in_args))) {
+    if (diag_rent) {
+        if ((err = write_csv_glucube(&lrout, country87codes_gtap, usecodes_gtap, out_name, in_args))) {
             fprintf(fplog, "Error writing file %s: calc_rent_ag_use_aez()\n", out_name);
             return err;
         }
-        if ((err = write_csv_float2d(diag_pasture87_aez, country87codes_gtap,
-                                     NUM_GTAP_CTRY87, NUM_NEW_AEZ, out_name_past, in_args))) {
+        if ((err = write_csv_glucube(&diag_pasture87_aez, country87codes_gtap, NULL, out_name_past, in_args))) {
             fprintf(fplog, "Error writing file %s: calc_rent_ag_use_aez()\n", out_name_past);
             return err;
         }
@@ -442,8 +417,7 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
             fprintf(fplog, "Error writing file %s: calc_rent_ag_use_aez()\n", "value_sum.csv");
             return err;
         }
-        if ((err = write_csv_float2d(diag_harvestsum, country87codes_gtap,
-                                     NUM_GTAP_CTRY87, NUM_NEW_AEZ, "harvestsum.csv", in_args))) {
+        if ((err = write_csv_glucube(&diag_harvestsum, country87codes_gtap, NULL, "harvestsum.csv", in_args))) {
             fprintf(fplog, "Error writing file %s: calc_rent_ag_use_aez()\n", "harvestsum.csv");
             return err;
         }
@@ -458,12 +432,12 @@ int calc_rent_ag_use_aez(args_struct in_args, rinfo_struct raster_info) {
     }
     free(harvestsum);
     free(pasture87_aez);
-    free(lrout);
+    glucube_free(&lrout);
     free(orout);
     free(nrout);
     
-    free(diag_harvestsum);
-    free(diag_pasture87_aez);
+    glucube_free(&diag_harvestsum);
+    glucube_free(&diag_pasture87_aez);
     
     return OK;
 }
\ No newline at end of file
@@ -49,22 +49,29 @@
 
 int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 	
-	int i, j;
-	int aez_ind_orig, aez_ind_reglr, use_ind, fa_ind, roa_ind, reglr_ind, out_index, all_aez_index;	// loop and placement indices
+	int i;
+	int aez_ind_orig, aez_ind_reglr, use_ind, fa_ind, roa_ind, reglr_ind;	// loop and placement indices
 	int forest_cell_ind;	// index for looping over forest_cells
 	
 	int aez_val;			// the aez number for current cell
+	int ctry87_code;		// the ctry87 code of the current cell
 	int frs_sect = 13;		// the use index for the forest sector
 	int err = OK;
 	
 	float *forest_area;         // forest area per original aez per land rent region (aez vaeries faster) (km^2)
 	float *rent_orig_per_area;	// original rent per forest area per aez per land rent region (aez vaeries faster) (million USD/km^2)
-	int *temp_indices;			// temp array for storing the forest cell indices when lengthening the forest_indices dim2
 	int **forest_indices;		// the forest cell indices per original aez per land rent region (aez vaeries faster); cell indices in dim2
+								//  dim2 points into forest_index_list, where the cells of each dim1 index are contiguous
 	int *num_forest_indices;	// the number of forest cell indices per original aez per land rent region (aez vaeries faster)
+	int *forest_index_list;		// the forest cell indices of all dim1 indices of forest_indices, in dim1 order
+	int *forest_cell_fa;		// the forest_indices dim1 index of each forest cell; NOMATCH if the cell is not used
+	band_walk_struct walk;		// releases the bands of the working grids behind the loop over forest_cells
+	int *reglr_of_code;			// the land rent region index of each ctry87 code; NOMATCH if the code is not a region
+	int max_code = 0;			// the largest ctry87 code
+	int num_list = 0;			// the number of forest cell indices in forest_index_list
 	
 	float *newvorigrent87;		// store the new forest rent summed across aezs in USD (i.e. per ctry87, first dim is new, second dim is orig)
-	float *lrout;				// for diagnostic output in USD
+	glucube_struct lrout;		// for diagnostic output in USD; use varies faster than region
 	
 	char out_name[] = "rent_use_aez_all.csv";			// diagnostic output csv file name for entire table
 	char out_comp_name[] = "newvorigrent87.csv";		// diagnostic output csv file name for ctry87 forest rent comparison
@@ -86,23 +93,34 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 		fprintf(fplog,"Failed to allocate memory for num_forest_indices:  calc_rent_frs_use_aez()\n");
 		return ERROR_MEM;
 	}
-	temp_indices = calloc(NUM_CELLS, sizeof(int));
-	if(temp_indices == NULL) {
-		fprintf(fplog,"Failed to allocate memory for temp_indices:  calc_rent_frs_use_aez()\n");
-		return ERROR_MEM;
-	}
 	forest_indices = calloc(NUM_GTAP_CTRY87 * NUM_ORIG_AEZ, sizeof(int *));
 	if(forest_indices == NULL) {
 		fprintf(fplog,"Failed to allocate memory for dim1 of forest_indices:  calc_rent_frs_use_aez()\n");
 		return ERROR_MEM;
 	}
-	// the second dimension will be dynamically reallocated for each dim1 index as needed
-	// but put initial allocation here
-	for (i = 0; i < NUM_GTAP_CTRY87 * NUM_ORIG_AEZ; i++) {
-		forest_indices[i] = calloc(1, sizeof(int));
-		if(forest_indices[i] == NULL) {
-			fprintf(fplog,"Failed to allocate initial dummy memory for forest_indices[i]; i=%i:  calc_rent_frs_use_aez()\n", i);
-			return ERROR_MEM;
+	forest_cell_fa = calloc(num_forest_cells + 1, sizeof(int));
+	if(forest_cell_fa == NULL) {
+		fprintf(fplog,"Failed to allocate memory for forest_cell_fa:  calc_rent_frs_use_aez()\n");
+		return ERROR_MEM;
+	}
+	// direct lookup of the land rent region index from the ctry87 code of a cell
+	for (i = 0; i < NUM_GTAP_CTRY87; i++) {
+		if (country87codes_gtap[i] > max_code) {
+			max_code = country87codes_gtap[i];
+		}
+	}
+	reglr_of_code = calloc(max_code + 1, sizeof(int));
+	if(reglr_of_code == NULL) {
+		fprintf(fplog,"Failed to allocate memory for reglr_of_code:  calc_rent_frs_use_aez()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i <= max_code; i++) {
+		reglr_of_code[i] = NOMATCH;
+	}
+	// use the first index of a repeated code, as the search did
+	for (i = NUM_GTAP_CTRY87 - 1; i >= 0; i--) {
+		if (country87codes_gtap[i] >= 0) {
+			reglr_of_code[country87codes_gtap[i]] = i;
 		}
 	}
 	// allocate memory for the diagnostic output
@@ -111,34 +129,38 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 		fprintf(fplog,"Failed to allocate memory for newvorigrent87:  calc_rent_frs_use_aez()\n");
 		return ERROR_MEM;
 	}
-	lrout = calloc(NUM_GTAP_CTRY87 * NUM_GTAP_USE * NUM_NEW_AEZ, sizeof(float));
-	if(lrout == NULL) {
+	if(glucube_init(&lrout, NUM_GTAP_CTRY87, NUM_GTAP_USE, reglr_aez_num, reglr_aez_list) != OK) {
 		fprintf(fplog,"Failed to allocate memory for lrout:  calc_rent_frs_use_aez()\n");
 		return ERROR_MEM;
 	}
 	
 	// loop over forest_cells to calculate forest area per cell and to assign forest cells to reglrxorigaez
+	// the cells are bucketed by counting sort: this pass counts the cells of each reglrxorigaez,
+	//  and the cell indices are then placed contiguously in forest cell order
+	// forest_cells follows the lulc cells in grid order, so the bands of the working grids are released behind the loop
+	band_walk_init(&walk, in_args);
 	for (forest_cell_ind = 0; forest_cell_ind < num_forest_cells; forest_cell_ind++) {
 		
+		band_walk_cell(&walk, forest_cells[forest_cell_ind]);
+		forest_cell_fa[forest_cell_ind] = NOMATCH;
+		
 		// get the orig aez id; this function retrieves the nodata value if no associated aez is found
 		// do not use this cell data if there is no associated aez
-		if ((err = get_aez_val(aez_bounds_orig, forest_cells[forest_cell_ind], raster_info.aez_orig_nrows,
-							   raster_info.aez_orig_ncols, raster_info.aez_orig_nodata, &aez_val))) {
+		if ((err = get_aez_val(THM8_VAL(aez_bounds_orig, forest_cells[forest_cell_ind], raster_info.aez_orig_nodata), forest_cells[forest_cell_ind],
+							   raster_info.aez_orig_nodata, &aez_val))) {
 			fprintf(fplog, "Failed to get orig aez_val for grid cell %i: calc_rent_frs_use_aez()\n", forest_cells[forest_cell_ind]);
 			return err;
 		}
 		
 		// process this cell only if there is a valid aez id and a valid land rent region code
-		if (aez_val != raster_info.aez_orig_nodata && country87_gtap[forest_cells[forest_cell_ind]] != NODATA) {
+		ctry87_code = THM8_VAL(country87_gtap, forest_cells[forest_cell_ind], NODATA);
+		if (aez_val != raster_info.aez_orig_nodata && ctry87_code != NODATA) {
 			
 			// get reglr index of this cell
 			reglr_ind = NOMATCH;
-			for (i = 0; i < NUM_GTAP_CTRY87; i++) {
-				if (country87codes_gtap[i] == country87_gtap[forest_cells[forest_cell_ind]]) {
-					reglr_ind = i;
-					break;
-				}
-			}	// end for i loop to get reglr_ind
+			if (ctry87_code >= 0 && ctry87_code <= max_code) {
+				reglr_ind = reglr_of_code[ctry87_code];
+			}
 			if(reglr_ind == NOMATCH) {	// now this should not happen
 				fprintf(fplog,"Failed to find land rent region index:  calc_rent_frs_use_aez()\n");
 				return ERROR_IND;
@@ -151,23 +173,33 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 			fa_ind = reglr_ind * NUM_ORIG_AEZ + aez_ind_orig; // index of the 2d forest_area array
 			forest_area[fa_ind] = forest_area[fa_ind] + refveg_area[forest_cells[forest_cell_ind]];
 			
-			// grow the dim2 as needed, per orig aez and ctry87
-			for (i = 0; i < num_forest_indices[fa_ind]; i++) {
-				temp_indices[i] = forest_indices[fa_ind][i];
-			}
-			free(forest_indices[fa_ind]);
-			forest_indices[fa_ind] = calloc(num_forest_indices[fa_ind] + 1, sizeof(int));
-			if(forest_indices[fa_ind] == NULL) {
-				fprintf(fplog,"Failed to allocate memory for forest_indices[i]; i=%i:  calc_rent_frs_use_aez()\n", i);
-				return ERROR_MEM;
-			}
-			for (i = 0; i < num_forest_indices[fa_ind]; i++) {
-				forest_indices[fa_ind][i] = temp_indices[i];
-			}
-			forest_indices[fa_ind][num_forest_indices[fa_ind]++] = forest_cells[forest_cell_ind];
+			// count the cell for its orig aez and ctry87
+			forest_cell_fa[forest_cell_ind] = fa_ind;
+			num_forest_indices[fa_ind]++;
+			num_list++;
 		
 		}	// end if valid aez cell
 	} // end for forest_cell_ind loop over forest cells
+	band_walk_end(&walk);
+	
+	// set the start of each dim2 in the contiguous list, then fill the lists in forest cell order
+	forest_index_list = calloc(num_list + 1, sizeof(int));
+	if(forest_index_list == NULL) {
+		fprintf(fplog,"Failed to allocate memory for forest_index_list:  calc_rent_frs_use_aez()\n");
+		return ERROR_MEM;
+	}
+	num_list = 0;
+	for (i = 0; i < NUM_GTAP_CTRY87 * NUM_ORIG_AEZ; i++) {
+		forest_indices[i] = &forest_index_list[num_list];
+		num_list = num_list + num_forest_indices[i];
+		num_forest_indices[i] = 0;
+	}
+	for (forest_cell_ind = 0; forest_cell_ind < num_forest_cells; forest_cell_ind++) {
+		fa_ind = forest_cell_fa[forest_cell_ind];
+		if (fa_ind != NOMATCH) {
+			forest_indices[fa_ind][num_forest_indices[fa_ind]++] = forest_cells[forest_cell_ind];
+		}
+	}
 	
 	// loop over reglrxorigaez to calculate the land rent per unit of forest area for reglrxorigaez:
 	//	rent_orig_per_area[reglrxorig_aez]=rent_orig_aez[reglrxusexorig_aez] / forest_area[reglrxorig_aez]
@@ -200,20 +232,14 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 			for (i = 0; i < num_forest_indices[fa_ind]; i++) {
 				// get the new aez id; this function retrieves the nodata value if no associated aez is found
 				// do not use this cell data if there is no associated new aez
-				if ((err = get_aez_val(aez_bounds_new, forest_indices[fa_ind][i], raster_info.aez_new_nrows,
-									   raster_info.aez_new_ncols, raster_info.aez_new_nodata, &aez_val))) {
+				if ((err = get_aez_val(aez_bounds_new[forest_indices[fa_ind][i]], forest_indices[fa_ind][i],
+									   raster_info.aez_new_nodata, &aez_val))) {
 					fprintf(fplog, "Failed to get new aez_val for forest_indices[%i][%i]: calc_rent_frs_use_aez()\n", fa_ind, i);
 					return err;
 				}
 				if (aez_val != raster_info.aez_new_nodata) {
                     // get the new aez index in this land rent region for this cell
-                    aez_ind_reglr = NOMATCH;
-                    for (j = 0; j < reglr_aez_num[reglr_ind]; j++) {
-                        if (reglr_aez_list[reglr_ind][j] == aez_val) {
-                            aez_ind_reglr = j;
-                            break;
-                        }
-                    }	// end for i loop to get reglr_ind
+                    aez_ind_reglr = glu_list_index(reglr_aez_list[reglr_ind], reglr_aez_num[reglr_ind], aez_val);
                     if(aez_ind_reglr == NOMATCH) {	// now this should not happen
                         fprintf(fplog,"Failed to find aez index for land rent region index %i:  calc_rent_frs_use_aez()\n",
                                 reglr_ind);
@@ -246,25 +272,8 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
         
         // loop over the new aezs in this land rent region
         for (aez_ind_reglr = 0; aez_ind_reglr < reglr_aez_num[reglr_ind]; aez_ind_reglr++) {
-            
-            // get the new aez index in the complete aez list
-            all_aez_index = NOMATCH;
-            for (i = 0; i < NUM_NEW_AEZ; i++) {
-                if (aez_codes_new[i] == reglr_aez_list[reglr_ind][aez_ind_reglr]) {
-                    all_aez_index = i;
-                    break;
-                }
-            }
-            if (all_aez_index == NOMATCH) {
-                // this shouldn't happen
-                fprintf(fplog,"Error finding all aez index: calc_rent_frs_use_aez(); land rent region=%i aez=%i\n",
-                        country87codes_gtap[reglr_ind], reglr_aez_list[reglr_ind][aez_ind_reglr]);
-                return ERROR_IND;
-            }
-            
             for (i = 0; i < NUM_GTAP_USE; i++) {
-                out_index = reglr_ind * NUM_GTAP_USE * NUM_NEW_AEZ + i * NUM_NEW_AEZ + all_aez_index;
-                lrout[out_index] = MIL2ONE * rent_use_aez[reglr_ind][aez_ind_reglr][i];
+                lrout.values[GLUCUBE_IND(&lrout, reglr_ind, i, aez_ind_reglr)] = MIL2ONE * rent_use_aez[reglr_ind][aez_ind_reglr][i];
             }
             
         } // end for loop over the new aezs in this land rent region to fill the diagnostic array
@@ -273,8 +282,7 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 
 
 	if (in_args.diagnostics) {
-		if ((err = write_csv_float3d(lrout, country87codes_gtap, usecodes_gtap,
-									 NUM_GTAP_CTRY87, NUM_GTAP_USE, NUM_NEW_AEZ, out_name, in_args))) {
+		if ((err = write_csv_glucube(&lrout, country87codes_gtap, usecodes_gtap, out_name, in_args))) {
 			fprintf(fplog, "Error writing file %s: calc_rent_frs_use_aez()\n", out_name);
 			return err;
 		}
@@ -292,13 +300,12 @@ int calc_rent_frs_use_aez(args_struct in_args, rinfo_struct raster_info) {
 	
 	free(newvorigrent87);
 	free(forest_area);
-	for (i = 0; i < NUM_GTAP_CTRY87 * NUM_ORIG_AEZ; i++) {
-		free(forest_indices[i]);
-	}
 	free(forest_indices);
-	free(temp_indices);
+	free(forest_index_list);
+	free(forest_cell_fa);
+	free(reglr_of_code);
 	free(num_forest_indices);
-	free(lrout);
+	glucube_free(&lrout);
     free(rent_orig_per_area);
 	
 	return OK;
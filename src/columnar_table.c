@@ -0,0 +1,309 @@
+/**********
+ columnar_table.c
+
+ contains the following functions for writing an output table as a columnar netcdf-4 file:
+	coltab_init()
+	coltab_key()
+	coltab_add()
+	coltab_write()
+	coltab_free()
+
+ this is the optional columnar copy of a csv output table (in_args.out_columnar = 1)
+ the records are collected in memory as they are written to the csv file:
+	one integer column per key (type) column of the csv table, and one float value column
+	a text key column (e.g., iso, crop name) is dictionary encoded: the column holds the 0-based index
+	 into a string variable named <key>_dict that holds the full list of names
+	an integer key column (e.g., glu code, year) holds the value itself
+ the file is self-describing: each key variable names its dictionary in the "dictionary" attribute,
+  and the value variable has "units" and "long_name" attributes
+ each numeric column is chunked along the record dimension and deflate compressed with the shuffle filter
+  (netcdf does not compress the variable length string dictionaries, which are small)
+ the file name is the csv file name with the extension replaced by ".nc"
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+#define COLTAB_INIT_RECS	65536		// initial number of records to allocate
+#define COLTAB_CHUNK		65536		// number of records in one compressed chunk
+#define COLTAB_DEFLATE		4			// deflate level (1-9)
+
+/********
+ int coltab_init(coltab_struct *tab, char *csv_fname, char *descr, char *value_name, char *value_units, int num_keys)
+ csv_fname:		the csv file name with path; the netcdf file name is derived from this
+ descr:			description of the table, for the title attribute
+ value_name:	name of the value column
+ value_units:	units of the value column
+ num_keys:		number of key columns; set each one with coltab_key()
+ return:		error code
+ ********/
+int coltab_init(coltab_struct *tab, char *csv_fname, char *descr, char *value_name, char *value_units, int num_keys)
+{
+	char *ext;
+	int i;
+
+	memset(tab, 0, sizeof(coltab_struct));
+	tab->err = OK;
+
+	if (num_keys < 1 || num_keys > COLTAB_MAX_KEYS) {
+		fprintf(fplog, "Error: num_keys=%i is not in 1 to %i for %s: coltab_init()\n", num_keys, COLTAB_MAX_KEYS, csv_fname);
+		return ERROR_IND;
+	}
+	tab->num_keys = num_keys;
+
+	strcpy(tab->fname, csv_fname);
+	ext = strrchr(tab->fname, '.');
+	if (ext != NULL && strchr(ext, '/') == NULL) {
+		*ext = '\0';
+	}
+	strcat(tab->fname, ".nc");
+	strcpy(tab->descr, descr);
+	strcpy(tab->value_name, value_name);
+	strcpy(tab->value_units, value_units);
+
+	tab->max_recs = COLTAB_INIT_RECS;
+	tab->values = malloc(tab->max_recs * sizeof(float));
+	if (tab->values == NULL) {
+		fprintf(fplog, "Failed to allocate memory for values of %s: coltab_init()\n", tab->fname);
+		return ERROR_MEM;
+	}
+	for (i = 0; i < num_keys; i++) {
+		tab->keys[i] = malloc(tab->max_recs * sizeof(int));
+		if (tab->keys[i] == NULL) {
+			fprintf(fplog, "Failed to allocate memory for key %i of %s: coltab_init()\n", i, tab->fname);
+			return ERROR_MEM;
+		}
+	}
+
+	return OK;
+}
+
+/********
+ void coltab_key(coltab_struct *tab, int key_ind, char *name, char **dict, int dict_len)
+ key_ind:	index of the key column; columns are in the same order as in the csv file
+ name:		column name, as in the csv header
+ dict:		the names that the key indexes; NULL for an integer key column
+ dict_len:	number of names in dict
+ ********/
+void coltab_key(coltab_struct *tab, int key_ind, char *name, char **dict, int dict_len)
+{
+	strcpy(tab->key_names[key_ind], name);
+	tab->dict[key_ind] = dict;
+	tab->dict_len[key_ind] = (dict == NULL) ? 0 : dict_len;
+}
+
+/********
+ void coltab_add(coltab_struct *tab, const int *keys, float value)
+ keys:		one value per key column; a dictionary index for a text key
+ value:		the record value
+ an allocation error is kept in tab->err and returned by coltab_write()
+ ********/
+void coltab_add(coltab_struct *tab, const int *keys, float value)
+{
+	int i;
+	long new_max;
+	float *new_values;
+	int *new_keys;
+
+	if (tab->err != OK) {
+		return;
+	}
+
+	if (tab->num_recs == tab->max_recs) {
+		new_max = 2 * tab->max_recs;
+		new_values = realloc(tab->values, new_max * sizeof(float));
+		if (new_values == NULL) {
+			fprintf(fplog, "Failed to allocate memory for values of %s: coltab_add()\n", tab->fname);
+			tab->err = ERROR_MEM;
+			return;
+		}
+		tab->values = new_values;
+		for (i = 0; i < tab->num_keys; i++) {
+			new_keys = realloc(tab->keys[i], new_max * sizeof(int));
+			if (new_keys == NULL) {
+				fprintf(fplog, "Failed to allocate memory for key %i of %s: coltab_add()\n", i, tab->fname);
+				tab->err = ERROR_MEM;
+				return;
+			}
+			tab->keys[i] = new_keys;
+		}
+		tab->max_recs = new_max;
+	}
+
+	for (i = 0; i < tab->num_keys; i++) {
+		tab->keys[i][tab->num_recs] = keys[i];
+	}
+	tab->values[tab->num_recs++] = value;
+}
+
+/********
+ int coltab_write(coltab_struct *tab)
+ write the collected records to the netcdf file, then free the table
+ return:	error code
+ ********/
+int coltab_write(coltab_struct *tab)
+{
+	int ncid;						// netcdf file id
+	int ncerr;						// netcdf error code
+	int rec_dimid;					// record dimension id
+	int dict_dimid;					// dictionary dimension id
+	int key_varid[COLTAB_MAX_KEYS];	// key variable ids
+	int dict_varid[COLTAB_MAX_KEYS];	// dictionary variable ids
+	int value_varid;				// value variable id
+	size_t chunk;					// records per chunk
+	char name[MAXCHAR];				// dictionary variable name
+	char source[MAXCHAR];			// source attribute
+	char history[MAXCHAR];			// history attribute: the creation time
+	long i;
+	int k;
+	int err = OK;
+
+	if (tab->err != OK) {
+		err = tab->err;
+		coltab_free(tab);
+		return err;
+	}
+
+	// the netcdf library is not thread safe, so its calls are serialized (nc_lock.c)
+	nc_lock();
+	if ((ncerr = nc_create(tab->fname, NC_CLOBBER | NC_NETCDF4, &ncid))) {
+		fprintf(fplog, "Failed to create %s: coltab_write(); %s\n", tab->fname, nc_strerror(ncerr));
+		nc_unlock();
+		coltab_free(tab);
+		return ERROR_FILE;
+	}
+
+	// a zero record table gets an unlimited dimension, which has zero length
+	chunk = (tab->num_recs < COLTAB_CHUNK) ? (size_t) tab->num_recs : COLTAB_CHUNK;
+	if (chunk == 0) {
+		chunk = 1;
+	}
+
+	if ((ncerr = nc_def_dim(ncid, "record", (size_t) tab->num_recs, &rec_dimid))) {
+		err = ERROR_FILE;
+	}
+
+	// global attributes
+	sprintf(source, "%s %s", CODENAME, VERSION);
+	strcpy(history, get_systime());
+	history[strcspn(history, "\n")] = '\0';
+	if (err == OK && ((ncerr = nc_put_att_text(ncid, NC_GLOBAL, "title", strlen(tab->descr), tab->descr)) ||
+					  (ncerr = nc_put_att_text(ncid, NC_GLOBAL, "source", strlen(source), source)) ||
+					  (ncerr = nc_put_att_text(ncid, NC_GLOBAL, "history", strlen(history), history)))) {
+		err = ERROR_FILE;
+	}
+
+	// the key columns, and the dictionaries for text keys
+	for (k = 0; k < tab->num_keys && err == OK; k++) {
+		if ((ncerr = nc_def_var(ncid, tab->key_names[k], (tab->dict[k] != NULL && tab->dict_len[k] <= 32767) ? NC_SHORT : NC_INT,
+								1, &rec_dimid, &key_varid[k])) ||
+			(ncerr = nc_def_var_chunking(ncid, key_varid[k], NC_CHUNKED, &chunk)) ||
+			(ncerr = nc_def_var_deflate(ncid, key_varid[k], 1, 1, COLTAB_DEFLATE))) {
+			err = ERROR_FILE;
+			break;
+		}
+		if (tab->dict[k] != NULL) {
+			sprintf(name, "%s_dict", tab->key_names[k]);
+			if ((ncerr = nc_def_dim(ncid, name, (size_t) tab->dict_len[k], &dict_dimid)) ||
+				(ncerr = nc_def_var(ncid, name, NC_STRING, 1, &dict_dimid, &dict_varid[k])) ||
+				(ncerr = nc_put_att_text(ncid, key_varid[k], "dictionary", strlen(name), name)) ||
+				(ncerr = nc_put_att_text(ncid, key_varid[k], "comment", strlen("0-based index into the dictionary"),
+										 "0-based index into the dictionary"))) {
+				err = ERROR_FILE;
+			}
+		}
+	}
+
+	// the value column
+	if (err == OK && ((ncerr = nc_def_var(ncid, tab->value_name, NC_FLOAT, 1, &rec_dimid, &value_varid)) ||
+					  (ncerr = nc_def_var_chunking(ncid, value_varid, NC_CHUNKED, &chunk)) ||
+					  (ncerr = nc_def_var_deflate(ncid, value_varid, 1, 1, COLTAB_DEFLATE)) ||
+					  (ncerr = nc_put_att_text(ncid, value_varid, "units", strlen(tab->value_units), tab->value_units)) ||
+					  (ncerr = nc_put_att_text(ncid, value_varid, "long_name", strlen(tab->descr), tab->descr)))) {
+		err = ERROR_FILE;
+	}
+
+	if (err == OK && (ncerr = nc_enddef(ncid))) {
+		err = ERROR_FILE;
+	}
+
+	// the data; a short key column is converted in place, which is safe because the table is freed next
+	for (k = 0; k < tab->num_keys && err == OK && tab->num_recs > 0; k++) {
+		if (tab->dict[k] != NULL && tab->dict_len[k] <= 32767) {
+			for (i = 0; i < tab->num_recs; i++) {
+				((short *) tab->keys[k])[i] = (short) tab->keys[k][i];
+			}
+			ncerr = nc_put_var_short(ncid, key_varid[k], (short *) tab->keys[k]);
+		} else {
+			ncerr = nc_put_var_int(ncid, key_varid[k], tab->keys[k]);
+		}
+		if (ncerr) {
+			err = ERROR_FILE;
+		}
+	}
+	for (k = 0; k < tab->num_keys && err == OK; k++) {
+		if (tab->dict[k] != NULL && tab->dict_len[k] > 0) {
+			if ((ncerr = nc_put_var_string(ncid, dict_varid[k], (const char **) tab->dict[k]))) {
+				err = ERROR_FILE;
+			}
+		}
+	}
+	if (err == OK && tab->num_recs > 0 && (ncerr = nc_put_var_float(ncid, value_varid, tab->values))) {
+		err = ERROR_FILE;
+	}
+
+	if (err != OK) {
+		fprintf(fplog, "Error writing %s: coltab_write(); %s\n", tab->fname, nc_strerror(ncerr));
+		nc_close(ncid);
+	} else if ((ncerr = nc_close(ncid))) {
+		fprintf(fplog, "Error closing %s: coltab_write(); %s\n", tab->fname, nc_strerror(ncerr));
+		err = ERROR_FILE;
+	} else {
+		fprintf(fplog, "Wrote file %s: coltab_write(); records written=%li\n", tab->fname, tab->num_recs);
+	}
+	nc_unlock();
+
+	coltab_free(tab);
+	return err;
+}
+
+/********
+ void coltab_free(coltab_struct *tab)
+ free the collected records
+ ********/
+void coltab_free(coltab_struct *tab)
+{
+	int i;
+
+	for (i = 0; i < COLTAB_MAX_KEYS; i++) {
+		free(tab->keys[i]);
+		tab->keys[i] = NULL;
+	}
+	free(tab->values);
+	tab->values = NULL;
+	tab->num_recs = 0;
+	tab->max_recs = 0;
+}
@@ -10,6 +10,8 @@
  the names of these files are set in the lds_input.txt file
  
  NOTE: this call automatically overwrites any file of the same name
+ each file is published in-process (see file_utils.c): it is linked or copied to a temporary name in the
+    destination directory and then renamed, so the gcam data system never reads a partially written file
  
  there are currenlty 9, and there will be one more
  
@@ -52,19 +54,11 @@ int copy_to_destpath(args_struct in_args) {
     
     int err = OK;
     char fname[MAXCHAR];            // full path to filename
-    char sys_string[MAXCHAR];       // string to pass to system()
-    
-    char cp_str[] = "cp -f ";
-    char space_str[] = " ";
     
     // harvested area
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.harvestarea_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -72,11 +66,7 @@ int copy_to_destpath(args_struct in_args) {
     // production
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.production_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -84,11 +74,7 @@ int copy_to_destpath(args_struct in_args) {
     // land rent
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.rent_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -96,11 +82,7 @@ int copy_to_destpath(args_struct in_args) {
     // irrigated harvested area
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.mirca_irr_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -108,11 +90,7 @@ int copy_to_destpath(args_struct in_args) {
     // rainfed harvested area
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.mirca_rfd_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -120,11 +98,7 @@ int copy_to_destpath(args_struct in_args) {
     // land type area
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.land_type_area_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -132,11 +106,7 @@ int copy_to_destpath(args_struct in_args) {
     // reference vegetation carbon
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.refveg_carbon_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -144,11 +114,7 @@ int copy_to_destpath(args_struct in_args) {
     // water footprint file
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.wf_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.ldsdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.ldsdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.ldsdestpath);
         return ERROR_COPY;
     }
@@ -156,11 +122,7 @@ int copy_to_destpath(args_struct in_args) {
     // iso mapping file
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.iso_map_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.mapdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.mapdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.mapdestpath);
         return ERROR_COPY;
     }
@@ -168,11 +130,7 @@ int copy_to_destpath(args_struct in_args) {
     // land type mapping file
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.lt_map_fname);
-    strcpy(sys_string, cp_str);
-    strcat(sys_string, fname);
-    strcat(sys_string, space_str);
-    strcat(sys_string, in_args.mapdestpath);
-    if((err = system(sys_string)) == -1) {
+    if((err = publish_file(fname, in_args.mapdestpath)) != OK) {
         fprintf(fplog, "\nError copying file %s to %s\n", fname, in_args.mapdestpath);
         return ERROR_COPY;
     }
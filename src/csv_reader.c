@@ -0,0 +1,436 @@
+/**********
+ csv_reader.c
+
+ contains the following functions for reading csv files in a single pass:
+	csv_open()
+	csv_get_record()
+	csv_get_int()
+	csv_get_float()
+	csv_get_text()
+	csv_close()
+
+ the whole file is mapped into memory (or read with a single fread() if mapping fails)
+ the record boundaries are indexed once when the file is opened, so the number of records
+  is known before any output arrays are allocated and the file never needs to be rewound
+ each record is tokenized once into (pointer, length) spans that point into the file buffer
+  so fields are not copied until a value is actually retrieved
+ there is no limit on the record length
+
+ record and field rules:
+	blank (whitespace only) lines are skipped and are not counted as header lines or records
+	records end at '\n', '\r', or "\r\n" that is not inside a quoted field
+	leading and trailing whitespace is not part of a field
+	a field that starts with a double quote ends at the matching double quote, so it may contain
+	 the delimiter and line breaks; a doubled quote ("") within a quoted field is a literal quote
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+// mmap() and friends are POSIX, not ISO C99
+#define _POSIX_C_SOURCE 200809L
+
+#include "moirai.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define CSV_INIT_RECS		1024		// initial length of the record index; doubled as needed
+#define CSV_INIT_FIELDS		32			// initial length of the field span array; doubled as needed
+
+/********
+ static size_t csv_skip_blank(csvfile_struct *csv, size_t pos)
+ return:	the offset of the first non-whitespace character at or after pos (buflen if none)
+ ********/
+static size_t csv_skip_blank(csvfile_struct *csv, size_t pos)
+{
+	while (pos < csv->buflen && isspace((int) (unsigned char) csv->buf[pos])) {
+		pos++;
+	}
+	return pos;
+}
+
+/********
+ static size_t csv_end_of_record(csvfile_struct *csv, size_t pos)
+ return:	the offset of the line break that ends the record starting at pos (buflen if none)
+ note:		line breaks within quoted fields do not end the record
+ ********/
+static size_t csv_end_of_record(csvfile_struct *csv, size_t pos)
+{
+	int in_quotes = 0;
+	char c;
+
+	while (pos < csv->buflen) {
+		c = csv->buf[pos];
+		if (c == '\"') {
+			in_quotes = !in_quotes;
+		} else if (!in_quotes && (c == '\n' || c == '\r')) {
+			break;
+		}
+		pos++;
+	}
+	return pos;
+}
+
+/********
+ int csv_open(char *fname, const char *delim, int nhead, csvfile_struct *csv)
+ fname:		file name with path
+ delim:		the delimiting character
+ nhead:		number of non-blank header lines to skip
+ csv:		the csv file structure to fill; num_recs is the number of data records
+ return:	error code
+ ********/
+int csv_open(char *fname, const char *delim, int nhead, csvfile_struct *csv)
+{
+	int fd;							// file descriptor
+	struct stat fstats;				// for the file size
+	FILE *fpin;						// fallback file pointer
+	size_t pos = 0;					// current offset in the file buffer
+	size_t end;						// end of the current record
+	long count_lines = 0;			// count the non-blank lines to skip the header
+	long max_recs = CSV_INIT_RECS;	// allocated length of rec_start
+	size_t *temp_start;				// for growing the record index
+
+	memset(csv, 0, sizeof(csvfile_struct));
+	strcpy(csv->fname, fname);
+	csv->delim = delim[0];
+	csv->cur_rec = -1;
+
+	// the error returns release what is set up so far: the fd, then with csv_close() the buffer and record index
+	if ((fd = open(fname, O_RDONLY)) == -1) {
+		fprintf(fplog,"Failed to open file %s:  csv_open()\n", fname);
+		return ERROR_FILE;
+	}
+	if (fstat(fd, &fstats) == -1) {
+		fprintf(fplog,"Failed to get the size of file %s:  csv_open()\n", fname);
+		close(fd);
+		return ERROR_FILE;
+	}
+	csv->buflen = (size_t) fstats.st_size;
+
+	// map the file; an empty file cannot be mapped, and some file systems do not support mapping
+	if (csv->buflen > 0) {
+		csv->buf = mmap(NULL, csv->buflen, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (csv->buf != MAP_FAILED) {
+			csv->is_mapped = 1;
+		} else {
+			csv->buf = NULL;
+		}
+	}
+	close(fd);
+
+	if (!csv->is_mapped) {
+		csv->buf = calloc(csv->buflen + 1, sizeof(char));
+		if (csv->buf == NULL) {
+			fprintf(fplog,"Failed to allocate memory for file %s:  csv_open()\n", fname);
+			csv_close(csv);
+			return ERROR_MEM;
+		}
+		if ((fpin = fopen(fname, "rb")) == NULL) {
+			fprintf(fplog,"Failed to open file %s:  csv_open()\n", fname);
+			csv_close(csv);
+			return ERROR_FILE;
+		}
+		if (fread(csv->buf, 1, csv->buflen, fpin) != csv->buflen) {
+			fprintf(fplog,"Failed to read file %s:  csv_open()\n", fname);
+			fclose(fpin);
+			csv_close(csv);
+			return ERROR_FILE;
+		}
+		fclose(fpin);
+	}
+
+	// index the record starts in one pass over the buffer
+	csv->rec_start = calloc(max_recs, sizeof(size_t));
+	if (csv->rec_start == NULL) {
+		fprintf(fplog,"Failed to allocate memory for rec_start of file %s:  csv_open()\n", fname);
+		csv_close(csv);
+		return ERROR_MEM;
+	}
+	while ((pos = csv_skip_blank(csv, pos)) < csv->buflen) {
+		end = csv_end_of_record(csv, pos);
+		if (count_lines++ >= nhead) {
+			if (csv->num_recs == max_recs) {
+				max_recs = 2 * max_recs;
+				temp_start = realloc(csv->rec_start, max_recs * sizeof(size_t));
+				if (temp_start == NULL) {
+					fprintf(fplog,"Failed to grow rec_start to %li for file %s:  csv_open()\n", max_recs, fname);
+					csv_close(csv);
+					return ERROR_MEM;
+				}
+				csv->rec_start = temp_start;
+			}
+			csv->rec_start[csv->num_recs++] = pos;
+		}
+		pos = end;
+	}
+
+	if (count_lines < nhead) {
+		fprintf(fplog,"Failed to scan over file %s header:  csv_open()\n", fname);
+		csv_close(csv);
+		return ERROR_FILE;
+	}
+
+	csv->max_fields = CSV_INIT_FIELDS;
+	csv->fields = calloc(csv->max_fields, sizeof(csvfield_struct));
+	if (csv->fields == NULL) {
+		fprintf(fplog,"Failed to allocate memory for fields of file %s:  csv_open()\n", fname);
+		csv_close(csv);
+		return ERROR_MEM;
+	}
+
+	return OK;
+}
+
+/********
+ int csv_get_record(csvfile_struct *csv, long rec_ind)
+ csv:		an open csv file structure
+ rec_ind:	index of the data record to tokenize; this must start at zero
+ return:	error code
+ note:		the field spans of the record are stored in csv->fields, and num_fields is set
+ ********/
+int csv_get_record(csvfile_struct *csv, long rec_ind)
+{
+	size_t pos;					// current offset in the file buffer
+	size_t end;					// end of the record
+	size_t fend;				// end of the current field
+	csvfield_struct *fld;		// current field
+	csvfield_struct *temp_fields;	// for growing the field array
+
+	if (rec_ind < 0 || rec_ind >= csv->num_recs) {
+		fprintf(fplog, "Error processing file %s: csv_get_record(); record=%li not in 1-%li\n",
+				csv->fname, rec_ind + 1, csv->num_recs);
+		return ERROR_FILE;
+	}
+
+	pos = csv->rec_start[rec_ind];
+	end = csv_end_of_record(csv, pos);
+	csv->cur_rec = rec_ind;
+	csv->num_fields = 0;
+
+	// one field per delimiter, plus one
+	while (1) {
+		if (csv->num_fields == csv->max_fields) {
+			csv->max_fields = 2 * csv->max_fields;
+			temp_fields = realloc(csv->fields, csv->max_fields * sizeof(csvfield_struct));
+			if (temp_fields == NULL) {
+				fprintf(fplog,"Failed to grow fields to %i for file %s:  csv_get_record()\n", csv->max_fields, csv->fname);
+				return ERROR_MEM;
+			}
+			csv->fields = temp_fields;
+		}
+		fld = &csv->fields[csv->num_fields++];
+
+		// leading whitespace
+		while (pos < end && csv->buf[pos] != csv->delim && isspace((int) (unsigned char) csv->buf[pos])) {
+			pos++;
+		}
+
+		if (pos < end && csv->buf[pos] == '\"') {
+			// quoted field: the span is the text between the quotes
+			fld->quoted = 1;
+			fld->ptr = &csv->buf[++pos];
+			while (pos < end) {
+				if (csv->buf[pos] == '\"') {
+					if (pos + 1 < end && csv->buf[pos + 1] == '\"') {
+						pos += 2;	// escaped quote
+						continue;
+					}
+					break;
+				}
+				pos++;
+			}
+			fld->len = (int) (&csv->buf[pos] - fld->ptr);
+			// skip the closing quote and anything else up to the delimiter
+			while (pos < end && csv->buf[pos] != csv->delim) {
+				pos++;
+			}
+		} else {
+			fld->quoted = 0;
+			fld->ptr = &csv->buf[pos];
+			while (pos < end && csv->buf[pos] != csv->delim) {
+				pos++;
+			}
+			// trailing whitespace
+			fend = pos;
+			while (fend > (size_t) (fld->ptr - csv->buf) && isspace((int) (unsigned char) csv->buf[fend - 1])) {
+				fend--;
+			}
+			fld->len = (int) (&csv->buf[fend] - fld->ptr);
+		}
+
+		if (pos >= end) {
+			break;
+		}
+		pos++;	// advance past the delimiter
+	} // end while loop over fields
+
+	return OK;
+}
+
+/********
+ static int csv_copy_field(csvfile_struct *csv, int findex, char *str_field, const char *caller)
+ copies field findex (starting at one) of the current record, with all whitespace removed
+  and escaped quotes collapsed; bracketing quotes are not copied
+ return:	error code
+ ********/
+static int csv_copy_field(csvfile_struct *csv, int findex, char *str_field, const char *caller)
+{
+	int i;
+	int nchar = 0;				// characters copied
+	csvfield_struct *fld;		// the requested field
+
+	if (findex < 1 || findex > csv->num_fields) {
+		fprintf(fplog, "Error processing file %s: %s(); record=%li, field=%i not in 1-%i\n",
+				csv->fname, caller, csv->cur_rec + 1, findex, csv->num_fields);
+		return ERROR_FILE;
+	}
+	fld = &csv->fields[findex - 1];
+
+	for (i = 0; i < fld->len; i++) {
+		if (isspace((int) (unsigned char) fld->ptr[i])) {
+			continue;
+		}
+		if (fld->ptr[i] == '\"' && i + 1 < fld->len && fld->ptr[i + 1] == '\"') {
+			i++;
+		}
+		if (nchar == MAXCHAR - 3) {
+			fprintf(fplog, "Error parsing file %s: %s(); record=%li, field=%i longer than %i characters\n",
+					csv->fname, caller, csv->cur_rec + 1, findex, MAXCHAR - 3);
+			return ERROR_STR;
+		}
+		str_field[nchar++] = fld->ptr[i];
+	}
+	str_field[nchar] = '\0';
+
+	return OK;
+}
+
+/********
+ int csv_get_int(csvfile_struct *csv, int findex, int *intval)
+ csv:		csv file structure with a current record
+ findex:	index of the desired field--this must start at one
+ intval:	the address for storing the retrieved integer value
+ return:	error code; the value is 0 if the field is empty; ERROR_STR if field is not numeric
+ ********/
+int csv_get_int(csvfile_struct *csv, int findex, int *intval)
+{
+	int err = OK;
+	char tmp[MAXCHAR];
+
+	if ((err = csv_copy_field(csv, findex, tmp, "csv_get_int")) != OK) {
+		return err;
+	}
+
+	// same rules as get_int_field(): atoi() only on strings made of numeric characters
+	if (is_num(tmp)) {
+		*intval = atoi(tmp);
+	} else {
+		fprintf(fplog, "Error parsing file %s: csv_get_int(); record=%li, non-numeric field %i\n",
+				csv->fname, csv->cur_rec + 1, findex);
+		return ERROR_STR;
+	}
+
+	return OK;
+}
+
+/********
+ int csv_get_float(csvfile_struct *csv, int findex, float *fltval)
+ csv:		csv file structure with a current record
+ findex:	index of the desired field--this must start at one
+ fltval:	the address for storing the retrieved float value
+ return:	error code; the value is 0 if the field is empty; ERROR_STR if field is not numeric
+ ********/
+int csv_get_float(csvfile_struct *csv, int findex, float *fltval)
+{
+	int err = OK;
+	char tmp[MAXCHAR];
+
+	if ((err = csv_copy_field(csv, findex, tmp, "csv_get_float")) != OK) {
+		return err;
+	}
+
+	// same rules as get_float_field(): atof() only on strings made of numeric characters
+	if (is_num(tmp)) {
+		*fltval = (float) atof(tmp);
+	} else {
+		fprintf(fplog, "Error parsing file %s: csv_get_float(); record=%li, non-numeric field %i\n",
+				csv->fname, csv->cur_rec + 1, findex);
+		return ERROR_STR;
+	}
+
+	return OK;
+}
+
+/********
+ int csv_get_text(csvfile_struct *csv, int findex, char *str_field)
+ csv:		csv file structure with a current record
+ findex:	index of the desired field--this must start at one
+ str_field:	address of character string (at least MAXCHAR long) for storing the field:
+			whitespace removed; "" if empty field
+ return:	error code
+ note:		as with get_text_field(), quoted fields keep their bracketing quotes
+			 so that text with embedded delimiters can be written to csv outputs as is
+ ********/
+int csv_get_text(csvfile_struct *csv, int findex, char *str_field)
+{
+	int err = OK;
+
+	if (findex >= 1 && findex <= csv->num_fields && csv->fields[findex - 1].quoted) {
+		str_field[0] = '\"';
+		if ((err = csv_copy_field(csv, findex, &str_field[1], "csv_get_text")) != OK) {
+			return err;
+		}
+		strcat(str_field, "\"");
+	} else if ((err = csv_copy_field(csv, findex, str_field, "csv_get_text")) != OK) {
+		return err;
+	}
+
+	return OK;
+}
+
+/********
+ int csv_close(csvfile_struct *csv)
+ csv:		the csv file structure to release
+ return:	error code
+ ********/
+int csv_close(csvfile_struct *csv)
+{
+	if (csv->is_mapped) {
+		munmap(csv->buf, csv->buflen);
+	} else {
+		free(csv->buf);
+	}
+	free(csv->rec_start);
+	free(csv->fields);
+	csv->buf = NULL;
+	csv->rec_start = NULL;
+	csv->fields = NULL;
+	csv->num_recs = 0;
+	csv->num_fields = 0;
+
+	return OK;
+}
@@ -0,0 +1,342 @@
+/**********
+ csv_writer.c
+
+ contains the following functions for writing csv output tables through a large buffer:
+	csvout_open()
+	csvout_chunk()
+	csvout_str()
+	csvout_int()
+	csvout_float()
+	csvout_printf()
+	csvout_append()
+	csvout_close()
+
+ records are formatted directly into a user-space buffer that is written with one fwrite()
+  each time it fills, instead of one fprintf() call per value
+ integers and fixed point values are formatted without the printf machinery;
+  the fixed point digits are identical to those of printf("%.<ndec>f") for float values
+ a chunk is an in-memory writer with no file; it grows as needed so that separate parts of
+  a table can be formatted in parallel and then appended to the file writer in order
+
+ the append functions do not return an error code; the first error is kept in the writer
+  and is returned (and logged) by csvout_close(), or by csvout_append() for the file writer
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+#include <stdarg.h>
+
+#define CSVOUT_CHUNK_INIT	65536		// initial size of an in-memory chunk, in bytes
+#define CSVOUT_MAX_DEC		8			// max decimals for the exact fixed point path (float * 10^8 is exact in a double)
+#define CSVOUT_MAX_INT		9.0e18		// magnitude limit for converting a rounded value to long long
+
+/********
+ static int csvout_flush(csvout_struct *out)
+ write the buffered bytes of a file writer; a chunk is never flushed
+ ********/
+static int csvout_flush(csvout_struct *out)
+{
+	if (out->fp != NULL && out->len > 0) {
+		if (fwrite(out->buf, 1, out->len, out->fp) != out->len) {
+			if (out->err == OK) {
+				fprintf(fplog, "Error writing file %s: csvout_flush()\n", out->fname);
+				out->err = ERROR_FILE;
+			}
+		}
+		out->len = 0;
+	}
+	return out->err;
+}
+
+/********
+ static char *csvout_reserve(csvout_struct *out, size_t nbytes)
+ make room for nbytes more characters: flush a file writer, or grow a chunk
+ return:	pointer to the first free byte; NULL after an error
+ ********/
+static char *csvout_reserve(csvout_struct *out, size_t nbytes)
+{
+	size_t new_cap;
+	char *new_buf;
+
+	if (out->err != OK) {
+		return NULL;
+	}
+
+	if (out->len + nbytes > out->cap) {
+		if (out->fp != NULL) {
+			if (csvout_flush(out) != OK) {
+				return NULL;
+			}
+		}
+		if (out->len + nbytes > out->cap) {
+			new_cap = (out->cap > 0) ? out->cap : CSVOUT_CHUNK_INIT;
+			while (out->len + nbytes > new_cap) {
+				new_cap = 2 * new_cap;
+			}
+			new_buf = realloc(out->buf, new_cap);
+			if (new_buf == NULL) {
+				fprintf(fplog, "Failed to allocate memory for output buffer of %s: csvout_reserve()\n", out->fname);
+				out->err = ERROR_MEM;
+				return NULL;
+			}
+			out->buf = new_buf;
+			out->cap = new_cap;
+		}
+	}
+
+	return out->buf + out->len;
+}
+
+/********
+ int csvout_open(char *fname, csvout_struct *out)
+ fname:		the file name with path
+ out:		the writer to initialize
+ return:	error code
+ ********/
+int csvout_open(char *fname, csvout_struct *out)
+{
+	memset(out, 0, sizeof(csvout_struct));
+	strcpy(out->fname, fname);
+	out->err = OK;
+
+	// remove an existing file rather than truncating it, in case it was published as a hard link (publish_file())
+	remove(fname);
+	if ((out->fp = fopen(fname, "w")) == NULL) {
+		fprintf(fplog, "Failed to open file %s: csvout_open()\n", fname);
+		return ERROR_FILE;
+	}
+
+	out->cap = CSVOUT_BUFSIZE;
+	out->buf = malloc(out->cap);
+	if (out->buf == NULL) {
+		fprintf(fplog, "Failed to allocate memory for output buffer of %s: csvout_open()\n", fname);
+		fclose(out->fp);
+		out->fp = NULL;
+		return ERROR_MEM;
+	}
+
+	return OK;
+}
+
+/********
+ void csvout_chunk(csvout_struct *out, char *name)
+ initialize an in-memory chunk; the buffer is allocated on first use
+ name:		the name used in messages, usually the file the chunk will be appended to
+ ********/
+void csvout_chunk(csvout_struct *out, char *name)
+{
+	memset(out, 0, sizeof(csvout_struct));
+	strcpy(out->fname, name);
+	out->err = OK;
+}
+
+/********
+ void csvout_str(csvout_struct *out, const char *str)
+ append a string
+ ********/
+void csvout_str(csvout_struct *out, const char *str)
+{
+	size_t slen = strlen(str);
+	char *dest;
+
+	if ((dest = csvout_reserve(out, slen)) != NULL) {
+		memcpy(dest, str, slen);
+		out->len += slen;
+	}
+}
+
+/********
+ void csvout_int(csvout_struct *out, long long val)
+ append an integer; same characters as printf("%lli")
+ ********/
+void csvout_int(csvout_struct *out, long long val)
+{
+	char digits[24];
+	int ndig = 0;
+	unsigned long long uval;
+	char *dest;
+
+	uval = (val < 0) ? 0ULL - (unsigned long long) val : (unsigned long long) val;
+	do {
+		digits[ndig++] = (char) ('0' + uval % 10);
+		uval = uval / 10;
+	} while (uval > 0);
+
+	if ((dest = csvout_reserve(out, ndig + 1)) != NULL) {
+		if (val < 0) {
+			*dest++ = '-';
+			out->len++;
+		}
+		out->len += ndig;
+		while (ndig > 0) {
+			*dest++ = digits[--ndig];
+		}
+	}
+}
+
+/********
+ void csvout_float(csvout_struct *out, double val, int ndec)
+ append a fixed point value with ndec decimals; same characters as printf("%.<ndec>f")
+ values that are exactly floats (all of the moirai output arrays) are scaled and rounded exactly
+  with the same round-half-even rule as printf; anything else goes through snprintf()
+ ********/
+void csvout_float(csvout_struct *out, double val, int ndec)
+{
+	double scale = 1.0;
+	double scaled;
+	long long ival;
+	long long pow10 = 1;
+	int i;
+	char *dest;
+	char tmp[MAXCHAR];
+
+	for (i = 0; i < ndec && i < CSVOUT_MAX_DEC; i++) {
+		scale = scale * 10.0;
+		pow10 = pow10 * 10;
+	}
+	scaled = nearbyint(val * scale);
+
+	if (ndec < 0 || ndec > CSVOUT_MAX_DEC || (double) (float) val != val ||
+		!(scaled > -CSVOUT_MAX_INT && scaled < CSVOUT_MAX_INT)) {
+		csvout_printf(out, "%.*f", ndec, val);
+		return;
+	}
+
+	// the sign of a negative value that rounds to zero is kept, as printf does
+	if (signbit(val)) {
+		if ((dest = csvout_reserve(out, 1)) == NULL) {
+			return;
+		}
+		*dest = '-';
+		out->len++;
+		scaled = -scaled;
+	}
+	ival = (long long) scaled;
+
+	csvout_int(out, ival / pow10);
+	if (ndec > 0) {
+		ival = ival % pow10;
+		tmp[0] = '.';
+		for (i = ndec; i > 0; i--) {
+			tmp[i] = (char) ('0' + ival % 10);
+			ival = ival / 10;
+		}
+		tmp[ndec + 1] = '\0';
+		csvout_str(out, tmp);
+	}
+}
+
+/********
+ void csvout_printf(csvout_struct *out, const char *fmt, ...)
+ append printf formatted text; for header lines and formats without a fast path
+ ********/
+void csvout_printf(csvout_struct *out, const char *fmt, ...)
+{
+	va_list ap;
+	int nchar;
+	char *dest;
+
+	va_start(ap, fmt);
+	nchar = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	if (nchar < 0) {
+		if (out->err == OK) {
+			fprintf(fplog, "Error formatting output for file %s: csvout_printf()\n", out->fname);
+			out->err = ERROR_STR;
+		}
+		return;
+	}
+
+	// reserve one more byte for the terminating character written by vsnprintf
+	if ((dest = csvout_reserve(out, nchar + 1)) != NULL) {
+		va_start(ap, fmt);
+		vsnprintf(dest, nchar + 1, fmt, ap);
+		va_end(ap);
+		out->len += nchar;
+	}
+}
+
+/********
+ int csvout_append(csvout_struct *out, csvout_struct *chunk)
+ append the contents of a chunk and empty the chunk so it can be reused
+ return:	error code of either writer
+ ********/
+int csvout_append(csvout_struct *out, csvout_struct *chunk)
+{
+	char *dest;
+
+	if (chunk->err != OK) {
+		if (out->err == OK) {
+			out->err = chunk->err;
+		}
+		return out->err;
+	}
+
+	if (chunk->len > 0) {
+		if (out->fp != NULL && chunk->len > out->cap) {
+			// write a large chunk directly rather than copying it through the buffer
+			if (csvout_flush(out) == OK && fwrite(chunk->buf, 1, chunk->len, out->fp) != chunk->len) {
+				fprintf(fplog, "Error writing file %s: csvout_append()\n", out->fname);
+				out->err = ERROR_FILE;
+			}
+		} else if ((dest = csvout_reserve(out, chunk->len)) != NULL) {
+			memcpy(dest, chunk->buf, chunk->len);
+			out->len += chunk->len;
+		}
+		chunk->len = 0;
+	}
+
+	return out->err;
+}
+
+/********
+ int csvout_close(csvout_struct *out)
+ flush and close a file writer, or release a chunk
+ return:	the first error code from any operation on this writer
+ ********/
+int csvout_close(csvout_struct *out)
+{
+	int err;
+
+	csvout_flush(out);
+	if (out->fp != NULL) {
+		if (fclose(out->fp) != 0 && out->err == OK) {
+			fprintf(fplog, "Error closing file %s: csvout_close()\n", out->fname);
+			out->err = ERROR_FILE;
+		}
+		out->fp = NULL;
+	}
+	free(out->buf);
+	out->buf = NULL;
+	out->len = 0;
+	out->cap = 0;
+
+	err = out->err;
+	if (err != OK) {
+		fprintf(fplog, "Failed to write file %s: csvout_close()\n", out->fname);
+	}
+	return err;
+}
@@ -0,0 +1,224 @@
+/**********
+ file_utils.c
+
+ contains the following functions for creating output directories and publishing output files in-process,
+  without running shell commands through system():
+	make_path()
+	publish_file()
+
+ a published file is first placed under a temporary name in the destination directory and then renamed over
+  the destination file, so a reader never sees a partially written file
+ the temporary file is, in order of preference, a copy-on-write clone (reflink) of the source,
+  a hard link to the source, or a buffered copy that is flushed to disk with fsync()
+ a hard link is safe because the output writers remove an existing file before writing a new one,
+  so a later run never rewrites a published file in place
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "moirai.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#define COPY_BUFSIZE	1048576		// buffer size for copying a file, in bytes
+
+/********
+ int make_path(char *path)
+ create a directory and any missing parent directories, like mkdir -p
+ nothing is written to the log file, because this is also used before the log file is open
+ path:		the directory path; a trailing '/' is allowed
+ return:	error code
+ ********/
+int make_path(char *path)
+{
+	char dir[MAXCHAR];		// the path up to the current component
+	char *sep;				// the current separator
+	struct stat st;
+
+	if (strlen(path) == 0) {
+		return OK;
+	}
+	strcpy(dir, path);
+
+	// create each parent in turn, skipping a leading '/'
+	for (sep = strchr(dir + 1, '/'); sep != NULL; sep = strchr(sep + 1, '/')) {
+		*sep = '\0';
+		if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+			return ERROR_FILE;
+		}
+		*sep = '/';
+	}
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+		return ERROR_FILE;
+	}
+
+	// an existing name must be a directory
+	if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+		return ERROR_FILE;
+	}
+
+	return OK;
+}
+
+/********
+ static int copy_fd(int fd_in, int fd_out)
+ buffered copy of the rest of fd_in to fd_out
+ return:	error code
+ ********/
+static int copy_fd(int fd_in, int fd_out)
+{
+	char *buf;
+	ssize_t nread;
+	ssize_t nwritten;
+	ssize_t off;
+	int err = OK;
+
+	buf = malloc(COPY_BUFSIZE);
+	if (buf == NULL) {
+		return ERROR_MEM;
+	}
+
+	while (err == OK && (nread = read(fd_in, buf, COPY_BUFSIZE)) != 0) {
+		if (nread < 0) {
+			if (errno != EINTR) {
+				err = ERROR_FILE;
+			}
+			continue;
+		}
+		for (off = 0; off < nread; off = off + nwritten) {
+			nwritten = write(fd_out, buf + off, nread - off);
+			if (nwritten < 0) {
+				if (errno == EINTR) {
+					nwritten = 0;
+					continue;
+				}
+				err = ERROR_FILE;
+				break;
+			}
+		}
+	}
+
+	free(buf);
+	return err;
+}
+
+/********
+ int publish_file(char *src_fname, char *destpath)
+ atomically place a copy of a file in a directory; an existing file of the same name is replaced
+ src_fname:	the file name with path
+ destpath:	the destination directory, with a trailing '/'
+ return:	error code
+ ********/
+int publish_file(char *src_fname, char *destpath)
+{
+	char dest_fname[MAXCHAR];	// the destination file name
+	char tmp_fname[MAXCHAR];	// the temporary file name in the destination directory
+	char *base;					// the source file name without its path
+	int fd_in;					// source file
+	int fd_out;					// temporary file
+	int fd_dir;					// destination directory, for flushing the rename
+	int linked = 0;				// 1 if the temporary file is a hard link to the source
+	int err = OK;
+
+	base = strrchr(src_fname, '/');
+	base = (base == NULL) ? src_fname : base + 1;
+	// the process id keeps overlapping jobs from sharing a temporary file
+	if (snprintf(dest_fname, MAXCHAR, "%s%s", destpath, base) >= MAXCHAR ||
+		snprintf(tmp_fname, MAXCHAR, "%s.%li.tmp", dest_fname, (long) getpid()) >= MAXCHAR) {
+		fprintf(fplog, "Error: the destination name of %s in %s is longer than %i characters: publish_file()\n",
+				base, destpath, MAXCHAR - 1);
+		return ERROR_FILE;
+	}
+	unlink(tmp_fname);
+
+	if ((fd_in = open(src_fname, O_RDONLY)) < 0) {
+		fprintf(fplog, "Failed to open file %s: publish_file()\n", src_fname);
+		return ERROR_FILE;
+	}
+	if ((fd_out = open(tmp_fname, O_WRONLY | O_CREAT | O_EXCL, 0666)) < 0) {
+		fprintf(fplog, "Failed to create file %s: publish_file()\n", tmp_fname);
+		close(fd_in);
+		return ERROR_FILE;
+	}
+
+#ifdef FICLONE
+	// a reflink shares the data blocks until one of the files changes
+	if (ioctl(fd_out, FICLONE, fd_in) != 0)
+#endif
+	{
+		// a hard link shares the file itself, if both paths are on the same file system
+		close(fd_out);
+		unlink(tmp_fname);
+		if (link(src_fname, tmp_fname) == 0) {
+			linked = 1;
+			fd_out = -1;
+		} else if ((fd_out = open(tmp_fname, O_WRONLY | O_CREAT | O_EXCL, 0666)) < 0) {
+			err = ERROR_FILE;
+		} else {
+			err = copy_fd(fd_in, fd_out);
+		}
+	}
+	close(fd_in);
+
+	if (!linked && fd_out >= 0) {
+		if (err == OK && fsync(fd_out) != 0) {
+			err = ERROR_FILE;
+		}
+		if (close(fd_out) != 0 && err == OK) {
+			err = ERROR_FILE;
+		}
+	}
+
+	if (err == OK && rename(tmp_fname, dest_fname) != 0) {
+		err = ERROR_FILE;
+	}
+	if (err != OK) {
+		fprintf(fplog, "Failed to publish file %s as %s: publish_file(); %s\n", src_fname, dest_fname, strerror(errno));
+		unlink(tmp_fname);
+		return err;
+	}
+
+	// rename() leaves both names when the destination is already a link to the same file
+	if (linked) {
+		unlink(tmp_fname);
+	}
+
+	// flush the directory entry so the rename survives a crash
+	if ((fd_dir = open(destpath, O_RDONLY)) >= 0) {
+		fsync(fd_dir);
+		close(fd_dir);
+	}
+
+	return OK;
+}
@@ -69,12 +69,12 @@ int get_cell_area(args_struct in_args, rinfo_struct *raster_info) {
 	// working units are km^2
 	
 	int i;
-	int nrows = 2160;				// num input lats
-	int ncols = 4320;				// num input lons
+	int nrows = NUM_LAT;				// num input lats
+	int ncols = NUM_LON;				// num input lons
 	int ncells = nrows * ncols;		// number of input grid cells
 	float nodata = -9999;			// nodata value
     int insize = 4;                 // 4 byte float
-	double res = 5.0 / 60.0;		// resolution
+	double res = GRID_RES;		// resolution
 	double xmin = -180.0;			// longitude min grid boundary
 	double xmax = 180.0;			// longitude max grid boundary
 	double ymin = -90.0;			// latitude min grid boundary
@@ -117,6 +117,12 @@ int get_cell_area(args_struct in_args, rinfo_struct *raster_info) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.cell_area_fname);
 	
+    // the file must be on the working grid
+    if (check_grid_file(fname, insize) != OK) {
+        fprintf(fplog,"Input file %s is not on the working grid:  get_cell_area()\n", fname);
+        return ERROR_FILE;
+    }
+    
     if((fpin = fopen(fname, "rb")) == NULL)
     {
         fprintf(fplog,"Failed to open file %s:  get_cell_area()\n", fname);
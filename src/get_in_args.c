@@ -236,6 +236,46 @@ int get_in_args(const char *fname, args_struct *in_args) {
                     break;
                 case 54:
                     strcpy(in_args->lt_map_fname, fld_str);
+                    break;
+                // optional settings
+                case 55:
+                    in_args->out_columnar = atoi(fld_str);
+                    break;
+                case 56:
+                    in_args->out_nc_grids = atoi(fld_str);
+                    break;
+                case 57:
+                    in_args->grid_res_sec = atof(fld_str);
+                    break;
+                case 58:
+                    in_args->band_rows = atoi(fld_str);
+                    break;
+                case 59:
+                    strcpy(in_args->window_bbox, fld_str);
+                    break;
+                case 60:
+                    strcpy(in_args->window_ctry, fld_str);
+                    break;
+                case 61:
+                    strcpy(in_args->window_glu, fld_str);
+                    break;
+                case 62:
+                    strcpy(in_args->sage_store_fname, fld_str);
+                    break;
+                case 63:
+                    in_args->readahead_mb = atoi(fld_str);
+                    break;
+                case 64:
+                    in_args->hyde_block_major = atoi(fld_str);
+                    break;
+                case 65:
+                    in_args->log_sample = atoi(fld_str);
+                    break;
+                case 66:
+                    in_args->diag_select = atoi(fld_str);
+                    break;
+                case 67:
+                    in_args->io_uring = atoi(fld_str);
                     break;
                     
 				default:
@@ -246,10 +286,11 @@ int get_in_args(const char *fname, args_struct *in_args) {
 	
 	fclose(fpin);
 	
-	if(count != nrecords)
+	// the optional settings at the end may be omitted
+	if(count < nrecords || count > nrecords + NUM_IN_ARGS_OPT)
 	{
-		fprintf(stderr, "Error reading file %s: get_in_args(); records read=%i != nrecords=%i\n",
-				fname, count, nrecords);
+		fprintf(stderr, "Error reading file %s: get_in_args(); records read=%i not in nrecords=%i to %i\n",
+				fname, count, nrecords, nrecords + NUM_IN_ARGS_OPT);
 		return ERROR_FILE;
 	}
 	
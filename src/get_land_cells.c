@@ -25,9 +25,10 @@
     so the main land area base is from HYDE
     but calculations using the SAGE crop data will be based on the sage land cells
  
- generate land masks for diagnostics
+ generate land masks for diagnostics, if DIAG_LAND_CELLS is on (see DIAG_ON())
 
  spatial grid initializations happen here because it is the first time that there is a loop over the working grid
+ the loop releases each latitude band of the working grids when it is done with it (see grid_store.c)
  
  also initialize the area and calibration arrays to NODATA
  
@@ -96,15 +97,21 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
 	int i, j, k = 0;
 	int err = OK;				// store error code from the write functions
 	int fao_index;				// store the fao country index
+	int win;					// 1 if the cell is in the processing window
+	int in_aez_orig;			// 1 if the cell is in the window and has a value in each data set
+	int in_aez_new;
+	int in_sage;
+	int in_hyde;
+	int in_fao;
+	int in_potveg;
+	int diag_land = DIAG_ON(in_args, DIAG_LAND_CELLS);	// the land masks, area tracking and area difference rasters are only diagnostics
 	
     int scg_code = 186;         // fao code for serbia and montenegro
     int srb_code = 272;         // fao code for serbia
     int mne_code = 273;         // fao code for montenegro
     int scg_index;              // the index in the fao country info arrays of merged serbia and montenegro
     
-    float temp_float;
-    
-    // for tracking land area
+    // for tracking land area, if diag_land
     double total_sage_land_area = 0;        // global sage land area
     double extra_sage_area = 0;             // sage land cells not covered by hyde land cells
     double new_aez_sage_area_lost = 0;      // sage cells not covered by new aez data
@@ -126,145 +133,144 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
 	char out_name_ctryglu[] = "ctryglu_raster.bil"; // output name for new country/glu raster map
 	char out_name_regionglu[] = "regionglu_raster.bil"; // output name for new region/glu raster map
 	
-	int *ctryaez_raster;    // store the ctry+aez values as a raster file
-	int *regionaez_raster;    // store the gcam region+aez values as a raster file
 	int *country_out;    // store the output country codes as a raster file
+	int *region_out;     // the widened region codes, for the region/glu raster
+	band_walk_struct walk;	// releases the bands of the working grids behind the loop
 	
 	// allocate the raster arrays
-	ctryaez_raster = calloc(NUM_CELLS, sizeof(int));
-	if(ctryaez_raster == NULL) {
-		fprintf(fplog,"Failed to allocate memory for ctryaez_raster:  get_land_cells()\n");
-		return ERROR_MEM;
-	}
-	regionaez_raster = calloc(NUM_CELLS, sizeof(int));
-	if(regionaez_raster == NULL) {
-		fprintf(fplog,"Failed to allocate memory for regionaez_raster:  get_land_cells()\n");
-		return ERROR_MEM;
-	}
-	country_out = calloc(NUM_CELLS, sizeof(int));
+	country_out = grid_calloc(NUM_CELLS, sizeof(int));
 	if(country_out == NULL) {
 		fprintf(fplog,"Failed to allocate memory for country_out:  get_land_cells()\n");
 		return ERROR_MEM;
 	}
 	
+	// country87_gtap and region_gcam store the codes in 8 bits
+	for (j = 0; j < NUM_FAO_CTRY; j++) {
+		if ((ctry2ctry87codes_gtap[j] != NOMATCH && !THM8_FITS(ctry2ctry87codes_gtap[j], NODATA)) ||
+			(ctry2regioncodes_gcam[j] != NOMATCH && !THM8_FITS(ctry2regioncodes_gcam[j], NODATA))) {
+			fprintf(fplog, "Error: ctry87 code %i or region code %i of fao country %i does not fit 8 bits: get_land_cells()\n",
+					ctry2ctry87codes_gtap[j], ctry2regioncodes_gcam[j], countrycodes_fao[j]);
+			grid_free(country_out);
+			return ERROR_IND;
+		}
+	}
+	
 	// loop over the all grid cells
+	band_walk_init(&walk, in_args);
 	for (i = 0; i < NUM_CELLS; i++) {
+		band_walk_cell(&walk, i);
+		
 		// initialize the land masks and country maps
-		land_mask_aez_orig[i] = 0;
-		land_mask_aez_new[i] = 0;
-		land_mask_sage[i] = 0;
 		land_mask_hyde[i] = 0;
-		land_mask_fao[i] = 0;
-		land_mask_potveg[i] = 0;
-		land_mask_forest[i] = 0;
-		land_mask_forest[i] = 0;
         land_mask_ctryaez[i] = 0;
-		country87_gtap[i] = NODATA;
-        glacier_water_area_hyde[i] = NODATA;
-        region_gcam[i] = NODATA;
-		ctryaez_raster[i] = NODATA;
-		regionaez_raster[i] = NODATA;
+		country87_gtap[i] = THM8_NODATA;
+        region_gcam[i] = THM8_NODATA;
 		country_out[i] = NODATA;
 		
-		// if valid original aez id value, then add cell index to land_mask_aez_orig
-		if (aez_bounds_orig[i] != raster_info.aez_orig_nodata) {
-			land_mask_aez_orig[i] = 1;
-		}
+		// a cell outside the processing window is not a land cell for any data set, so no stage uses it
+		win = in_window(i, (int) country_fao[i], aez_bounds_new[i]);
+		
+		// valid original aez id value
+		in_aez_orig = (win && aez_bounds_orig[i] != THM8_NODATA);
 		// if valid new aez id value, then add cell index to land_cells_aez_new array
-		if (aez_bounds_new[i] != raster_info.aez_new_nodata) {
+		in_aez_new = (win && aez_bounds_new[i] != raster_info.aez_new_nodata);
+		if (in_aez_new) {
 			land_cells_aez_new[num_land_cells_aez_new++] = i;
-			land_mask_aez_new[i] = 1;
 		}
-		// if sage land area, then add cell index to land_cells_sage array and land_mask_sage
-		if (land_area_sage[i] != raster_info.land_area_sage_nodata) {
+		// if sage land area, then add cell index to land_cells_sage array
+		in_sage = (win && land_area_sage[i] != raster_info.land_area_sage_nodata);
+		if (in_sage) {
 			land_cells_sage[num_land_cells_sage++] = i;
-			land_mask_sage[i] = 1;
 		}
 		// if hyde land area, then add cell index to land_cells_hyde array and land_mask_hyde
-        // also keep track of residual water/ice area
-		if (land_area_hyde[i] != raster_info.land_area_hyde_nodata) {
-            temp_float = land_area_hyde[i];
+		in_hyde = (win && land_area_hyde[i] != raster_info.land_area_hyde_nodata);
+		if (in_hyde) {
             land_cells_hyde[num_land_cells_hyde++] = i;
 			land_mask_hyde[i] = 1;
-            if (cell_area_hyde[i] != raster_info.cell_area_hyde_nodata) {
-                temp_float = cell_area_hyde[i];
-                glacier_water_area_hyde[i] = cell_area_hyde[i] - land_area_hyde[i];
-            }
 		}
-		// if fao country, then add cell index to land_mask_fao
-        // and update gcam region image, only if a hyde land cell
+		// valid fao country
         // valid fao/vmap0 territories with no iso3 or gcam region or gtap ctry87 will have values == NOMATCH for ctry87 and gcam regions
         // serbia and montenegro are also not assigned to a gcam region by the ctry87 file, but they need to be counted here
 		//		they are, however, assigned to a region based on the iso to gcam region file
         // so leave the NOMATCH regions as the NODATA value in the gcam region image
-		if ((int) country_fao[i] != raster_info.country_fao_nodata) {
-			land_mask_fao[i] = 1;
-		} // end if valid country fao
-		// if sage pot veg, then add cell index to land_mask_potveg
-		if (potveg_thematic[i] != raster_info.potveg_nodata) {
-			land_mask_potveg[i] = 1;
-		}
+		in_fao = (win && (int) country_fao[i] != raster_info.country_fao_nodata);
+		// valid sage pot veg
+		in_potveg = (win && potveg_thematic[i] != THM8_NODATA);
 		
-        // track some area differences
-        if (land_mask_sage[i] == 1) {
-            total_sage_land_area = total_sage_land_area + land_area_sage[i];
-            if (land_mask_hyde[i] == 0) {
-                extra_sage_area = extra_sage_area + land_area_sage[i];
-            }
-            if (land_mask_aez_new[i] == 0) {
-                new_aez_sage_area_lost = new_aez_sage_area_lost + land_area_sage[i];
-            }
-            if (land_mask_aez_orig[i] == 0) {
-                orig_aez_sage_area_lost = orig_aez_sage_area_lost + land_area_sage[i];
-            }
-            if (land_mask_potveg[i] == 0) {
-                potveg_sage_area_lost = potveg_sage_area_lost + land_area_sage[i];
-            }
-            if (land_mask_fao[i] == 0) {
-                fao_sage_area_lost = fao_sage_area_lost + land_area_sage[i];
-            }
-            // this is the actual area not used because either there is no country or no aez
-            if (land_mask_fao[i] == 0 || land_mask_aez_new[i] == 0) {
-                fao_new_aez_sage_area_lost = fao_new_aez_sage_area_lost + land_area_sage[i];
-            }
-        }
-        if (land_mask_hyde[i] == 1) {
-            total_hyde_land_area = total_hyde_land_area + land_area_hyde[i];
-            if (land_mask_sage[i] == 0) {
-                extra_hyde_area = extra_hyde_area + land_area_hyde[i];
-            }
-            if (land_mask_aez_new[i] == 0) {
-                new_aez_hyde_area_lost = new_aez_hyde_area_lost + land_area_hyde[i];
-            }
-            if (land_mask_aez_orig[i] == 0) {
-                orig_aez_hyde_area_lost = orig_aez_hyde_area_lost + land_area_hyde[i];
-            }
-            if (land_mask_potveg[i] == 0) {
-                potveg_hyde_area_lost = potveg_hyde_area_lost + land_area_hyde[i];
-            }
-            if (land_mask_fao[i] == 0) {
-                fao_hyde_area_lost = fao_hyde_area_lost + land_area_hyde[i];
-            }
-            // this is the actual area not used because either there is no country or no aez
-            if (land_mask_fao[i] == 0 || land_mask_aez_new[i] == 0) {
-                fao_new_aez_hyde_area_lost = fao_new_aez_hyde_area_lost + land_area_hyde[i];
-            }
-        }
-        
-        // the sage cell area is within 0.000229 km^2 against the available hyde cell area
-        // the land areas are not directly comprable because original hyde does not include all glacier area
-        //  the updated hyde land area does include much of the glacial area, but it is not perfect
-        // this raster shows only where they overlap
-        if (land_area_hyde[i] != raster_info.land_area_hyde_nodata && land_area_sage[i] != raster_info.land_area_sage_nodata) {
-            sage_minus_hyde_land_area[i] = land_area_sage[i] - land_area_hyde[i];
-        }
+		// the diagnostic land masks, residual water/ice area and area differences
+		if (diag_land) {
+			land_mask_aez_orig[i] = in_aez_orig;
+			land_mask_aez_new[i] = in_aez_new;
+			land_mask_sage[i] = in_sage;
+			land_mask_fao[i] = in_fao;
+			land_mask_potveg[i] = in_potveg;
+			land_mask_forest[i] = 0;
+			glacier_water_area_hyde[i] = NODATA;
+			if (in_hyde && cell_area_hyde[i] != raster_info.cell_area_hyde_nodata) {
+				glacier_water_area_hyde[i] = cell_area_hyde[i] - land_area_hyde[i];
+			}
+			
+			// track some area differences
+			if (in_sage) {
+				total_sage_land_area = total_sage_land_area + land_area_sage[i];
+				if (!in_hyde) {
+					extra_sage_area = extra_sage_area + land_area_sage[i];
+				}
+				if (!in_aez_new) {
+					new_aez_sage_area_lost = new_aez_sage_area_lost + land_area_sage[i];
+				}
+				if (!in_aez_orig) {
+					orig_aez_sage_area_lost = orig_aez_sage_area_lost + land_area_sage[i];
+				}
+				if (!in_potveg) {
+					potveg_sage_area_lost = potveg_sage_area_lost + land_area_sage[i];
+				}
+				if (!in_fao) {
+					fao_sage_area_lost = fao_sage_area_lost + land_area_sage[i];
+				}
+				// this is the actual area not used because either there is no country or no aez
+				if (!in_fao || !in_aez_new) {
+					fao_new_aez_sage_area_lost = fao_new_aez_sage_area_lost + land_area_sage[i];
+				}
+			}
+			if (in_hyde) {
+				total_hyde_land_area = total_hyde_land_area + land_area_hyde[i];
+				if (!in_sage) {
+					extra_hyde_area = extra_hyde_area + land_area_hyde[i];
+				}
+				if (!in_aez_new) {
+					new_aez_hyde_area_lost = new_aez_hyde_area_lost + land_area_hyde[i];
+				}
+				if (!in_aez_orig) {
+					orig_aez_hyde_area_lost = orig_aez_hyde_area_lost + land_area_hyde[i];
+				}
+				if (!in_potveg) {
+					potveg_hyde_area_lost = potveg_hyde_area_lost + land_area_hyde[i];
+				}
+				if (!in_fao) {
+					fao_hyde_area_lost = fao_hyde_area_lost + land_area_hyde[i];
+				}
+				// this is the actual area not used because either there is no country or no aez
+				if (!in_fao || !in_aez_new) {
+					fao_new_aez_hyde_area_lost = fao_new_aez_hyde_area_lost + land_area_hyde[i];
+				}
+			}
+			
+			// the sage cell area is within 0.000229 km^2 against the available hyde cell area
+			// the land areas are not directly comprable because original hyde does not include all glacier area
+			//  the updated hyde land area does include much of the glacial area, but it is not perfect
+			// this raster shows only where they overlap
+			sage_minus_hyde_land_area[i] = NODATA;
+			if (land_area_hyde[i] != raster_info.land_area_hyde_nodata && land_area_sage[i] != raster_info.land_area_sage_nodata) {
+				sage_minus_hyde_land_area[i] = land_area_sage[i] - land_area_hyde[i];
+			}
+		}	// end if diagnostics
         
 		// initialize the working area arrays
 		cropland_area[i] = NODATA;
 		pasture_area[i] = NODATA;
 		urban_area[i] = NODATA;
 		refveg_area[i] = NODATA;
-		sage_minus_hyde_land_area[i] = NODATA;
 		for (k = 0; k < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; k++) {
 			lu_detail_area[k][i] = NODATA;
 		}
@@ -276,7 +282,7 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
 		// only if this is a hyde land cell, valid glu, valid country, valid ctry87
         // valid fao/vmap0 territories with no iso3 or gcam region or gtap ctry87 will have values == NOMATCH for ctry87 and gcam region
 		// serbia and montenegro are also not assigned to a gcam region by the ctry87 file, but they need to be counted here
-		if (land_mask_hyde[i] == 1 && land_mask_aez_new[i] == 1) {
+		if (in_hyde && in_aez_new) {
 			// fao country index
 			if ((int) country_fao[i] != raster_info.country_fao_nodata) {
 				fao_index = NOMATCH;
@@ -297,19 +303,15 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
 			}	// end if fao country else if gcam gis country else no country
 			
             // store the ctry87 code and gcam region code and country out code in a raster
-			// also store the country code, the country/glu, and the region/glu
+			// the country/glu and region/glu ids are made from these and aez_bounds_new when they are written
             // leave the NOMATCH regions as the NODATA value
 			// the gcam region codes have already been restricted to valid ctry87 codes, but leave the check anyway
             if (ctry2ctry87codes_gtap[fao_index] != NOMATCH) {
-                country87_gtap[i] = ctry2ctry87codes_gtap[fao_index];
+                country87_gtap[i] = (uint8_t) ctry2ctry87codes_gtap[fao_index];
 				if (ctry2regioncodes_gcam[fao_index] != NOMATCH) {
-					region_gcam[i] = ctry2regioncodes_gcam[fao_index];
+					region_gcam[i] = (uint8_t) ctry2regioncodes_gcam[fao_index];
 				}
 				country_out[i] = country_fao[i];
-				// fill the ctry+aez image here
-				ctryaez_raster[i] = (int) country_fao[i] * FAOCTRY2GCAMCTRYAEZID + aez_bounds_new[i];
-				// fill the region+aez image here
-				regionaez_raster[i] = ctry2regioncodes_gcam[fao_index] * FAOCTRY2GCAMCTRYAEZID + aez_bounds_new[i];
             } else {
 				// check for serbia and montenegro
 				if (countrycodes_fao[fao_index] == srb_code || countrycodes_fao[fao_index] == mne_code) {
@@ -320,29 +322,30 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
 							break;
 						}
 					}
-					country87_gtap[i] = ctry2ctry87codes_gtap[scg_index];
-					region_gcam[i] = ctry2regioncodes_gcam[scg_index];
+					if (ctry2ctry87codes_gtap[scg_index] != NOMATCH) {
+						country87_gtap[i] = (uint8_t) ctry2ctry87codes_gtap[scg_index];
+					}
+					if (ctry2regioncodes_gcam[scg_index] != NOMATCH) {
+						region_gcam[i] = (uint8_t) ctry2regioncodes_gcam[scg_index];
+					}
 					country_out[i] = scg_code;
-					// fill the ctry+aez image here
-					ctryaez_raster[i] = country_out[i] * FAOCTRY2GCAMCTRYAEZID + aez_bounds_new[i];
-					// fill the region+aez image here
-					regionaez_raster[i] = region_gcam[i] * FAOCTRY2GCAMCTRYAEZID + aez_bounds_new[i];
 				} // end if serbia or montenegro
 			} // end else check for serbia or montenegro
 
 		}	// end if hyde and new glu land cell (if working land cell)
 
 	}	// end for i loop over all cells
+	band_walk_end(&walk);
 	
 	// write the relevant maps with the overall land mask constraints
 	
     // write the new gcam region raster map
-    if ((err = write_raster_int(region_gcam, NUM_CELLS, out_name_region, in_args))) {
+    if ((err = write_raster_thm8(region_gcam, NUM_CELLS, NODATA, out_name_region, in_args))) {
         fprintf(fplog, "Error writing file %s: get_land_cells()\n", out_name_region);
         return err;
     }
 	// this is the map of found gtap 87 countries
-	if ((err = write_raster_int(country87_gtap, NUM_CELLS, out_name_ctry87, in_args))) {
+	if ((err = write_raster_thm8(country87_gtap, NUM_CELLS, NODATA, out_name_ctry87, in_args))) {
 		fprintf(fplog, "Error writing file %s: get_land_cells()\n", out_name_ctry87);
 		return err;
 	}
@@ -352,35 +355,44 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
 		return err;
 	}
 	
-	// country+aez raster file
-	if ((err = write_raster_int(ctryaez_raster, NUM_CELLS, out_name_ctryglu, in_args))) {
+	// the zone id rasters are made from the widened region codes and the glu codes
+	region_out = grid_calloc(NUM_CELLS, sizeof(int));
+	if(region_out == NULL) {
+		fprintf(fplog,"Failed to allocate memory for region_out:  get_land_cells()\n");
+		return ERROR_MEM;
+	}
+	thm8_widen(region_gcam, NUM_CELLS, NODATA, region_out);
+	
+	// country+aez raster file; 64-bit if the ids do not fit in an int
+	if ((err = write_raster_zone_id(country_out, aez_bounds_new, NUM_CELLS, out_name_ctryglu, in_args))) {
 		fprintf(fplog, "Error writing file %s: get_land_cells()\n", out_name_ctryglu);
 		return err;
 	}
-	// region+aez raster file
-	if ((err = write_raster_int(regionaez_raster, NUM_CELLS, out_name_regionglu, in_args))) {
+	// region+aez raster file; 64-bit if the ids do not fit in an int
+	if ((err = write_raster_zone_id(region_out, aez_bounds_new, NUM_CELLS, out_name_regionglu, in_args))) {
 		fprintf(fplog, "Error writing file %s: get_land_cells()\n", out_name_regionglu);
 		return err;
 	}
+	grid_free(region_out);
 	
-    // write the global area tracking values to the log file
-    fprintf(fplog, "\nGlobal land area tracking (km^2): get_land_cells():\n");
-    fprintf(fplog, "total_sage_land_area = %f\n", total_sage_land_area);
-    fprintf(fplog, "extra_sage_area = %f\n", extra_sage_area);
-    fprintf(fplog, "new_aez_sage_area_lost = %f\n", new_aez_sage_area_lost);
-    fprintf(fplog, "orig_aez_sage_area_lost = %f\n", orig_aez_sage_area_lost);
-    fprintf(fplog, "potveg_sage_area_lost = %f\n", potveg_sage_area_lost);
-    fprintf(fplog, "fao_sage_area_lost = %f\n", fao_sage_area_lost);
-    fprintf(fplog, "sage area not used due to no fao country or no new aez = %f\n\n", fao_new_aez_sage_area_lost);
-    fprintf(fplog, "total_hyde_land_area = %f\n", total_hyde_land_area);
-    fprintf(fplog, "extra_hyde_area = %f\n", extra_hyde_area);
-    fprintf(fplog, "new_aez_hyde_area_lost = %f\n", new_aez_hyde_area_lost);
-    fprintf(fplog, "orig_aez_hyde_area_lost = %f\n", orig_aez_hyde_area_lost);
-    fprintf(fplog, "potveg_hyde_area_lost = %f\n", potveg_hyde_area_lost);
-    fprintf(fplog, "fao_hyde_area_lost = %f\n", fao_hyde_area_lost);
-    fprintf(fplog, "hyde area not used due to no fao country or no new aez = %f\n\n", fao_new_aez_hyde_area_lost);
-    
-	if (in_args.diagnostics) {
+	if (diag_land) {
+        // write the global area tracking values to the log file
+        fprintf(fplog, "\nGlobal land area tracking (km^2): get_land_cells():\n");
+        fprintf(fplog, "total_sage_land_area = %f\n", total_sage_land_area);
+        fprintf(fplog, "extra_sage_area = %f\n", extra_sage_area);
+        fprintf(fplog, "new_aez_sage_area_lost = %f\n", new_aez_sage_area_lost);
+        fprintf(fplog, "orig_aez_sage_area_lost = %f\n", orig_aez_sage_area_lost);
+        fprintf(fplog, "potveg_sage_area_lost = %f\n", potveg_sage_area_lost);
+        fprintf(fplog, "fao_sage_area_lost = %f\n", fao_sage_area_lost);
+        fprintf(fplog, "sage area not used due to no fao country or no new aez = %f\n\n", fao_new_aez_sage_area_lost);
+        fprintf(fplog, "total_hyde_land_area = %f\n", total_hyde_land_area);
+        fprintf(fplog, "extra_hyde_area = %f\n", extra_hyde_area);
+        fprintf(fplog, "new_aez_hyde_area_lost = %f\n", new_aez_hyde_area_lost);
+        fprintf(fplog, "orig_aez_hyde_area_lost = %f\n", orig_aez_hyde_area_lost);
+        fprintf(fplog, "potveg_hyde_area_lost = %f\n", potveg_hyde_area_lost);
+        fprintf(fplog, "fao_hyde_area_lost = %f\n", fao_hyde_area_lost);
+        fprintf(fplog, "hyde area not used due to no fao country or no new aez = %f\n\n", fao_new_aez_hyde_area_lost);
+		
 		// aez orig land mask
 		if ((err = write_raster_int(land_mask_aez_orig, NUM_CELLS, "land_mask_aez_orig.bil", in_args))) {
 			fprintf(fplog, "Error writing file %s: get_land_cells()\n", "land_mask_aez_orig.bil");
@@ -428,9 +440,7 @@ int get_land_cells(args_struct in_args, rinfo_struct raster_info) {
         }
 	}	// end if diagnostics
 	
-	free(ctryaez_raster);
-	free(regionaez_raster);
-	free(country_out);
+	grid_free(country_out);
 	
 	return OK;
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+/**********
+ glu_cube.c
+
+ contains the following functions for the sparse glu-indexed diagnostic cubes:
+	glucube_init()
+	glucube_zero()
+	glucube_free()
+	write_csv_glucube()
+
+ the diagnostic cubes are country (or region) X crop (or use) X glu, but each row has values only for the glus
+  in its glu list (ctry_aez_list, reglr_aez_list or reggcam_aez_list), so only those are stored
+ use GLUCUBE_IND() (moirai.h) with the glu index in the row list to address a value
+ the csv writer expands each row to all NUM_NEW_AEZ glus, in aez_codes_new order, with zeroes for the glus not in the row,
+  so the files are the same as those written from the dense arrays by write_csv_float3d() and write_csv_float2d()
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+/********
+ int glucube_init(glucube_struct *cube, int d1_length, int d2_length, int *glu_num, int **glu_list)
+ allocate a zeroed cube
+ d1_length:	number of rows
+ d2_length:	number of values per row and glu; 1 for a 2d (row X glu) cube
+ glu_num:	number of glus in each row
+ glu_list:	glu codes of each row
+ return:	error code
+ ********/
+int glucube_init(glucube_struct *cube, int d1_length, int d2_length, int *glu_num, int **glu_list)
+{
+	int i;
+
+	memset(cube, 0, sizeof(glucube_struct));
+	cube->d1_length = d1_length;
+	cube->d2_length = d2_length;
+	cube->glu_num = glu_num;
+	cube->glu_list = glu_list;
+
+	cube->row_start = calloc(d1_length + 1, sizeof(long));
+	if (cube->row_start == NULL) {
+		fprintf(fplog, "Failed to allocate memory for row_start: glucube_init()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i < d1_length; i++) {
+		cube->row_start[i] = cube->num_values;
+		cube->num_values = cube->num_values + (long) d2_length * glu_num[i];
+	}
+	cube->row_start[d1_length] = cube->num_values;
+
+	cube->values = calloc(cube->num_values + 1, sizeof(float));
+	if (cube->values == NULL) {
+		fprintf(fplog, "Failed to allocate memory for values: glucube_init(); num_values=%li\n", cube->num_values);
+		return ERROR_MEM;
+	}
+
+	return OK;
+}
+
+/********
+ void glucube_zero(glucube_struct *cube)
+ set all values to zero
+ ********/
+void glucube_zero(glucube_struct *cube)
+{
+	memset(cube->values, 0, cube->num_values * sizeof(float));
+}
+
+/********
+ void glucube_free(glucube_struct *cube)
+ free the cube; the row glu lists are not freed
+ ********/
+void glucube_free(glucube_struct *cube)
+{
+	free(cube->row_start);
+	free(cube->values);
+	cube->row_start = NULL;
+	cube->values = NULL;
+	cube->num_values = 0;
+}
+
+/********
+ int write_csv_glucube(glucube_struct *cube, int d1[], int d2[], char *out_name, args_struct in_args)
+ write a cube in the old 1d diagnostic csv format: one record per row (and dim2 index) with a value for every glu
+ d1:		numeric codes to write for the rows
+ d2:		numeric codes to write for dim2; NULL for a 2d cube, which has no dim2 column (see write_csv_float2d())
+ out_name:	name of output file
+ in_args:	the input argument structure
+ return:	error code
+ ********/
+int write_csv_glucube(glucube_struct *cube, int d1[], int d2[], char *out_name, args_struct in_args)
+{
+	int i, j, k;
+	char fname[MAXCHAR];			// file name to open
+	csvout_struct out;				// buffered output file
+	int err = OK;					// error code
+	int *row_cols;					// the output column of each glu in the current row
+	float *out_row;					// the values of one record, for all glus
+
+	// the glus of a row are placed by their index in the complete glu list (glu_index())
+	row_cols = calloc(NUM_NEW_AEZ + 1, sizeof(int));
+	out_row = calloc(NUM_NEW_AEZ + 1, sizeof(float));
+	if (row_cols == NULL || out_row == NULL) {
+		fprintf(fplog, "Failed to allocate memory for %s: write_csv_glucube()\n", out_name);
+		free(row_cols);
+		free(out_row);
+		return ERROR_MEM;
+	}
+
+	// create file name and open it
+	strcpy(fname, in_args.outpath);
+	strcat(fname, out_name);
+
+	if ((err = csvout_open(fname, &out)) != OK) {
+		fprintf(fplog, "Failed to open file %s: write_csv_glucube()\n", fname);
+		free(row_cols);
+		free(out_row);
+		return err;
+	}
+
+	for (i = 0; i < cube->d1_length; i++) {
+		for (k = 0; k < cube->glu_num[i]; k++) {
+			if ((row_cols[k] = glu_index(cube->glu_list[i][k])) == NOMATCH) {
+				fprintf(fplog, "Error finding all aez index: write_csv_glucube(); row=%i aez=%i\n", d1[i], cube->glu_list[i][k]);
+				csvout_close(&out);
+				free(row_cols);
+				free(out_row);
+				return ERROR_IND;
+			}
+		}
+		for (j = 0; j < cube->d2_length; j++) {
+			memset(out_row, 0, NUM_NEW_AEZ * sizeof(float));
+			for (k = 0; k < cube->glu_num[i]; k++) {
+				out_row[row_cols[k]] = cube->values[GLUCUBE_IND(cube, i, j, k)];
+			}
+			csvout_int(&out, d1[i]);
+			if (d2 != NULL) {
+				csvout_str(&out, ",");
+				csvout_int(&out, d2[j]);
+			}
+			for (k = 0; k < NUM_NEW_AEZ; k++) {
+				csvout_str(&out, ",");
+				csvout_float(&out, out_row[k], 2);
+			}
+			csvout_str(&out, "\n");
+		}
+	}
+
+	free(row_cols);
+	free(out_row);
+
+	if ((err = csvout_close(&out)) != OK) {
+		fprintf(fplog, "Failed to write file %s: write_csv_glucube()\n", fname);
+		return err;
+	}
+
+	return OK;
+}
@@ -0,0 +1,246 @@
+/**********
+ glu_index.c
+
+ contains the following functions for the glu (new aez) codes and the country/region+glu zone ids:
+	init_glu_index()
+	glu_index()
+	glu_list_index()
+	write_raster_zone_id()
+
+ the glu codes do not need to be contiguous, so glu_index() maps a code to its compact index in aez_codes_new
+  by binary search of the sorted codes (glu_codes_sorted), which stays small however large the codes are
+ the glu lists of the countries and regions (ctry_aez_list, reglr_aez_list and reggcam_aez_list) are sorted by code
+  in write_glu_mapping(), so a glu is found in a list by binary search rather than a scan
+ the zone id of a country (or region) and glu is ZONE_ID(zone code, glu code) = zone code * ctryglu_id_mult + glu code
+ ctryglu_id_mult is FAOCTRY2GCAMCTRYAEZID (10000) unless a glu code needs more digits, so the ids do not change
+  for the standard glu sets; the ids are 64-bit and are written as 64-bit rasters only if they do not fit in an int
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+/********
+ static int compare_glu_pos(const void *a, const void *b)
+ qsort() comparison of two positions in aez_codes_new, by their glu codes
+ ********/
+static int compare_glu_pos(const void *a, const void *b)
+{
+	int code_a = aez_codes_new[*(const int *) a];
+	int code_b = aez_codes_new[*(const int *) b];
+
+	return (code_a > code_b) - (code_a < code_b);
+}
+
+/********
+ int init_glu_index(void)
+ build glu_codes_sorted and glu_index_sorted, and set max_glu_code and ctryglu_id_mult from aez_codes_new
+ the glu codes must be non-negative and unique
+ return:	error code
+ ********/
+int init_glu_index(void)
+{
+	int i;
+
+	max_glu_code = 0;
+	for (i = 0; i < NUM_NEW_AEZ; i++) {
+		if (aez_codes_new[i] < 0) {
+			fprintf(fplog, "Error: negative glu code %i: init_glu_index()\n", aez_codes_new[i]);
+			return ERROR_IND;
+		}
+		if (aez_codes_new[i] > max_glu_code) {
+			max_glu_code = aez_codes_new[i];
+		}
+	}
+
+	glu_codes_sorted = calloc(NUM_NEW_AEZ + 1, sizeof(int));
+	glu_index_sorted = calloc(NUM_NEW_AEZ + 1, sizeof(int));
+	if (glu_codes_sorted == NULL || glu_index_sorted == NULL) {
+		fprintf(fplog, "Failed to allocate memory for the sorted glu codes: init_glu_index(); NUM_NEW_AEZ=%i\n", NUM_NEW_AEZ);
+		return ERROR_MEM;
+	}
+	for (i = 0; i < NUM_NEW_AEZ; i++) {
+		glu_index_sorted[i] = i;
+	}
+	qsort(glu_index_sorted, NUM_NEW_AEZ, sizeof(int), compare_glu_pos);
+	for (i = 0; i < NUM_NEW_AEZ; i++) {
+		glu_codes_sorted[i] = aez_codes_new[glu_index_sorted[i]];
+		if (i > 0 && glu_codes_sorted[i] == glu_codes_sorted[i - 1]) {
+			fprintf(fplog, "Error: duplicate glu code %i: init_glu_index()\n", glu_codes_sorted[i]);
+			return ERROR_IND;
+		}
+	}
+
+	// the glu code takes the low digits of the zone id
+	ctryglu_id_mult = FAOCTRY2GCAMCTRYAEZID;
+	while (ctryglu_id_mult <= max_glu_code) {
+		ctryglu_id_mult = ctryglu_id_mult * 10;
+	}
+	if (ctryglu_id_mult != FAOCTRY2GCAMCTRYAEZID) {
+		fprintf(fplog, "Max glu code %i needs a zone id multiplier of %lli instead of %i: init_glu_index()\n",
+				max_glu_code, ctryglu_id_mult, FAOCTRY2GCAMCTRYAEZID);
+	}
+
+	return OK;
+}
+
+/********
+ int glu_index(int glu_code)
+ find the compact index of a glu code
+ glu_code:	the glu code to find
+ return:	the index of glu_code in aez_codes_new, or NOMATCH
+ ********/
+int glu_index(int glu_code)
+{
+	int pos = glu_list_index(glu_codes_sorted, NUM_NEW_AEZ, glu_code);
+
+	return (pos == NOMATCH) ? NOMATCH : glu_index_sorted[pos];
+}
+
+/********
+ int glu_list_index(int *glu_list, int glu_num, int glu_code)
+ find a glu in a sorted glu list, such as ctry_aez_list[ctry_ind]
+ glu_list:	glu codes, in increasing order
+ glu_num:	number of glus in the list
+ glu_code:	the glu code to find
+ return:	the index of glu_code in glu_list, or NOMATCH
+ ********/
+int glu_list_index(int *glu_list, int glu_num, int glu_code)
+{
+	int lo = 0;
+	int hi = glu_num - 1;
+	int mid;
+
+	while (lo <= hi) {
+		mid = lo + (hi - lo) / 2;
+		if (glu_list[mid] < glu_code) {
+			lo = mid + 1;
+		} else if (glu_list[mid] > glu_code) {
+			hi = mid - 1;
+		} else {
+			return mid;
+		}
+	}
+
+	return NOMATCH;
+}
+
+/********
+ int write_raster_zone_id(int zone_codes[], int glu_codes[], int out_length, char *out_name, args_struct in_args)
+ write a raster of zone ids (see ZONE_ID()) for the cells that have both a zone code and a glu code
+ the raster is int if all the ids fit, which is always so for glu codes below FAOCTRY2GCAMCTRYAEZID,
+  otherwise it is 64-bit (long long); other cells are NODATA
+ a 64-bit raster is written under out_name with ZONE_ID_INT64_TAG before the extension
+  (e.g. ctryglu_raster_int64.bil), so a reader can tell the element size from the file name
+ zone_codes:	country or region code of each cell; NODATA for none
+ glu_codes:		glu code of each cell
+ out_length:	number of cells
+ out_name:		name of output file
+ in_args:		the input argument structure
+ return:		error code
+ ********/
+int write_raster_zone_id(int zone_codes[], int glu_codes[], int out_length, char *out_name, args_struct in_args)
+{
+	int i;
+	int max_zone_code = 0;			// the largest zone code
+	int *id_int;					// int ids
+	long long *id_long;				// 64-bit ids
+	char fname[MAXCHAR];			// file name to open
+	char name64[MAXCHAR];			// output name of a 64-bit raster
+	char *ext;						// extension of out_name
+	int ext_len;					// length of the extension
+	FILE *fpout;					// file pointer
+	int num_out;					// store the number of elements written
+	int err = OK;
+
+	for (i = 0; i < out_length; i++) {
+		if (zone_codes[i] != NODATA && zone_codes[i] > max_zone_code) {
+			max_zone_code = zone_codes[i];
+		}
+	}
+
+	if (ZONE_ID(max_zone_code, max_glu_code) <= INT_MAX) {
+		id_int = grid_calloc(out_length, sizeof(int));
+		if (id_int == NULL) {
+			fprintf(fplog, "Failed to allocate memory for %s: write_raster_zone_id()\n", out_name);
+			return ERROR_MEM;
+		}
+		for (i = 0; i < out_length; i++) {
+			id_int[i] = (zone_codes[i] == NODATA) ? NODATA : (int) ZONE_ID(zone_codes[i], glu_codes[i]);
+		}
+		err = write_raster_int(id_int, out_length, out_name, in_args);
+		grid_free(id_int);
+		return err;
+	}
+
+	id_long = grid_calloc(out_length, sizeof(long long));
+	if (id_long == NULL) {
+		fprintf(fplog, "Failed to allocate memory for %s: write_raster_zone_id()\n", out_name);
+		return ERROR_MEM;
+	}
+	for (i = 0; i < out_length; i++) {
+		id_long[i] = (zone_codes[i] == NODATA) ? NODATA : ZONE_ID(zone_codes[i], glu_codes[i]);
+	}
+
+	// the 64-bit name: out_name with the tag before its extension
+	ext = strrchr(out_name, '.');
+	ext_len = (ext == NULL) ? 0 : (int) strlen(ext);
+	if (snprintf(name64, MAXCHAR, "%.*s%s%s", (int) strlen(out_name) - ext_len, out_name, ZONE_ID_INT64_TAG,
+				 (ext == NULL) ? "" : ext) >= MAXCHAR) {
+		fprintf(fplog, "Error: the 64-bit name of %s is longer than %i characters: write_raster_zone_id()\n", out_name, MAXCHAR - 1);
+		grid_free(id_long);
+		return ERROR_FILE;
+	}
+	fprintf(fplog, "Writing 64-bit zone ids to %s instead of %s: write_raster_zone_id()\n", name64, out_name);
+
+	if (in_args.out_nc_grids) {
+		err = write_raster_nc(id_long, NC_INT64, out_length, name64, in_args);
+		grid_free(id_long);
+		return err;
+	}
+
+	// create file name and open it
+	strcpy(fname, in_args.outpath);
+	strcat(fname, name64);
+
+	if ((fpout = fopen(fname, "wb")) == NULL) {
+		fprintf(fplog, "Failed to open file %s: write_raster_zone_id()\n", fname);
+		grid_free(id_long);
+		return ERROR_FILE;
+	}
+
+	num_out = fwrite(id_long, sizeof(long long), out_length, fpout);
+
+	fclose(fpout);
+	grid_free(id_long);
+
+	if (num_out != out_length) {
+		fprintf(fplog, "Error writing file %s: write_raster_zone_id(); records written=%i != out_length=%i\n",
+				fname, num_out, out_length);
+		return ERROR_FILE;
+	}
+
+	return OK;
+}
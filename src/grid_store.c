@@ -0,0 +1,307 @@
+/**********
+ grid_store.c
+
+ contains the following functions for the storage of the whole-grid working arrays:
+	grid_store_init()
+	grid_calloc()
+	grid_calloc_list()
+	grid_free()
+	grid_release_rows()
+	band_walk_init()
+	band_walk_cell()
+	band_walk_end()
+
+ the working grid arrays are global (NUM_CELLS), so a cell has the same index in every stage
+ with latitude bands (in_args.band_rows, see get_band_rows()) these arrays are not held in memory:
+  each one is a shared mapping of a scratch file in in_args.outpath, and the file is removed as soon as it is mapped,
+  so the system writes out the pages that are not in use and reads them back when they are used again
+ the cell-level stages visit the cells in grid order, a latitude band at a time, and release each band of every
+  grid array when they are done with it (grid_release_rows(), or band_walk_cell() in a loop over a cell list),
+  so about one band of each grid is in memory at a time and the peak memory scales with band_rows
+ the land cell lists and the other per-cell arrays that are not grids (grid_calloc_list()) are mapped the same way,
+  but they are not released by rows; the system pages them
+ a release only drops the pages from memory; the values stay in the scratch file, so a released band that is used
+  again is just read back
+ without bands the arrays are calloc() arrays and a release does nothing
+ the scratch files take as much disk space as the arrays they hold
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#define _DEFAULT_SOURCE
+
+#include "moirai.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// one mapped array
+typedef struct {
+	void *ptr;				// the mapped array
+	size_t bytes;			// mapped length
+	size_t row_bytes;		// bytes per working grid row; 0 if the array is not a grid
+} gridmap_struct;
+
+static int grid_store_on = 0;				// 1 if the arrays are mapped scratch files
+static char grid_store_path[MAXCHAR];		// scratch file directory, with the trailing separator
+static long grid_store_count = 0;			// number of scratch files made, for unique names
+static long grid_page = 4096;				// system page size
+static gridmap_struct *grid_maps = NULL;	// the mapped arrays
+static int grid_num_maps = 0;				// number of mapped arrays
+static int grid_max_maps = 0;				// allocated length of grid_maps
+
+/********
+ int grid_store_init(args_struct in_args)
+ turn on the mapped storage if the run uses latitude bands
+ this must be called after set_working_grid() and before any working grid array is allocated
+ return:	error code
+ ********/
+int grid_store_init(args_struct in_args)
+{
+	grid_store_on = (get_band_rows(in_args) < NUM_LAT);
+	if (!grid_store_on) {
+		return OK;
+	}
+
+	if (snprintf(grid_store_path, MAXCHAR, "%s", in_args.outpath) >= MAXCHAR) {
+		fprintf(fplog, "Error: the scratch path %s is longer than %i characters: grid_store_init()\n", in_args.outpath, MAXCHAR - 1);
+		return ERROR_FILE;
+	}
+	grid_page = sysconf(_SC_PAGESIZE);
+	if (grid_page <= 0) {
+		grid_page = 4096;
+	}
+
+	fprintf(fplog, "Working grids are paged through scratch files in %s, %.1f MB per float grid, in bands of %i rows: grid_store_init()\n",
+			grid_store_path, (double) NUM_CELLS * sizeof(float) / (1024.0 * 1024.0), get_band_rows(in_args));
+
+	return OK;
+}
+
+/********
+ static void *grid_map(size_t nmemb, size_t size, int by_rows)
+ map a zeroed array onto a new scratch file, or calloc() it without mapped storage
+ by_rows:	1 if the array is a working grid [NUM_CELLS], so it can be released by rows
+ return:	the array; NULL if it cannot be made
+ ********/
+static void *grid_map(size_t nmemb, size_t size, int by_rows)
+{
+	char fname[MAXCHAR];		// scratch file name
+	size_t bytes = nmemb * size;
+	gridmap_struct *new_maps;
+	void *ptr;
+	int fd;
+	int new_max;
+	long count;
+
+	if (!grid_store_on || bytes == 0) {
+		return calloc(nmemb, size);
+	}
+
+#pragma omp critical (grid_store)
+	{
+		count = grid_store_count++;
+	}
+	if (snprintf(fname, MAXCHAR, "%smoirai_grid_%li_%li.tmp", grid_store_path, (long) getpid(), count) >= MAXCHAR) {
+		fprintf(fplog, "Error: the scratch file name is longer than %i characters: grid_map()\n", MAXCHAR - 1);
+		return NULL;
+	}
+
+	// the new file is all zeros, and it is removed now so that it goes away with the mapping, even after an error
+	if ((fd = open(fname, O_RDWR | O_CREAT | O_EXCL, 0600)) < 0) {
+		fprintf(fplog, "Failed to create scratch file %s: grid_map()\n", fname);
+		return NULL;
+	}
+	unlink(fname);
+	if (ftruncate(fd, (off_t) bytes) != 0) {
+		fprintf(fplog, "Failed to size scratch file %s to %zu bytes: grid_map()\n", fname, bytes);
+		close(fd);
+		return NULL;
+	}
+	ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ptr == MAP_FAILED) {
+		fprintf(fplog, "Failed to map scratch file %s: grid_map()\n", fname);
+		return NULL;
+	}
+
+#pragma omp critical (grid_store)
+	{
+		if (grid_num_maps == grid_max_maps) {
+			new_max = (grid_max_maps == 0) ? 64 : 2 * grid_max_maps;
+			new_maps = realloc(grid_maps, new_max * sizeof(gridmap_struct));
+			if (new_maps == NULL) {
+				munmap(ptr, bytes);
+				ptr = NULL;
+			} else {
+				grid_maps = new_maps;
+				grid_max_maps = new_max;
+			}
+		}
+		if (ptr != NULL) {
+			grid_maps[grid_num_maps].ptr = ptr;
+			grid_maps[grid_num_maps].bytes = bytes;
+			grid_maps[grid_num_maps].row_bytes = (by_rows) ? bytes / NUM_LAT : 0;
+			grid_num_maps++;
+		}
+	}
+
+	return ptr;
+}
+
+/********
+ void *grid_calloc(size_t nmemb, size_t size)
+ allocate a zeroed working grid array; use it like calloc(), and free it with grid_free()
+ nmemb:		number of values; an array of NUM_CELLS values is a grid, and it is released by rows
+ size:		bytes per value
+ return:	the array; NULL if it cannot be made
+ ********/
+void *grid_calloc(size_t nmemb, size_t size)
+{
+	return grid_map(nmemb, size, (nmemb == (size_t) NUM_CELLS));
+}
+
+/********
+ void *grid_calloc_list(size_t nmemb, size_t size)
+ allocate a zeroed per-cell array that is not in grid order, such as a land cell list; free it with grid_free()
+ it is mapped like a grid, but it is not released by rows
+ return:	the array; NULL if it cannot be made
+ ********/
+void *grid_calloc_list(size_t nmemb, size_t size)
+{
+	return grid_map(nmemb, size, 0);
+}
+
+/********
+ void grid_free(void *ptr)
+ free an array from grid_calloc() or grid_calloc_list(); NULL is ok
+ ********/
+void grid_free(void *ptr)
+{
+	int i;
+	int found = NOMATCH;
+	size_t bytes = 0;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+#pragma omp critical (grid_store)
+	{
+		for (i = 0; i < grid_num_maps; i++) {
+			if (grid_maps[i].ptr == ptr) {
+				found = i;
+				bytes = grid_maps[i].bytes;
+				grid_maps[i] = grid_maps[--grid_num_maps];
+				break;
+			}
+		}
+		if (grid_num_maps == 0) {
+			free(grid_maps);
+			grid_maps = NULL;
+			grid_max_maps = 0;
+		}
+	}
+
+	if (found == NOMATCH) {
+		free(ptr);
+	} else {
+		munmap(ptr, bytes);
+	}
+}
+
+/********
+ void grid_release_rows(int row_start, int nrows)
+ drop rows row_start to row_start + nrows - 1 of every mapped working grid from memory
+ only the whole pages in the rows are dropped, so the neighbouring rows stay in memory
+ call it from one thread; the values stay in the scratch files
+ ********/
+void grid_release_rows(int row_start, int nrows)
+{
+	int i;
+	size_t start;			// first byte of the rows
+	size_t end;				// byte after the rows
+	size_t page = (size_t) grid_page;
+
+	if (grid_num_maps == 0 || nrows <= 0) {
+		return;
+	}
+
+	for (i = 0; i < grid_num_maps; i++) {
+		if (grid_maps[i].row_bytes == 0) {
+			continue;
+		}
+		start = (size_t) row_start * grid_maps[i].row_bytes;
+		end = (size_t) (row_start + nrows) * grid_maps[i].row_bytes;
+		end = (end > grid_maps[i].bytes) ? grid_maps[i].bytes : end;
+		start = (start + page - 1) / page * page;
+		end = end / page * page;
+		if (end > start) {
+			madvise((char *) grid_maps[i].ptr + start, end - start, MADV_DONTNEED);
+		}
+	}
+}
+
+/********
+ void band_walk_init(band_walk_struct *walk, args_struct in_args)
+ start a walk over working grid cells in grid order; see band_walk_cell()
+ ********/
+void band_walk_init(band_walk_struct *walk, args_struct in_args)
+{
+	walk->band_rows = get_band_rows(in_args);
+	walk->row_start = 0;
+	walk->next_cell = (long) walk->band_rows * NUM_LON;
+}
+
+/********
+ void band_walk_cell(band_walk_struct *walk, int cell)
+ the walk has reached cell; if it is past the current band, release the bands before the band of cell
+ the cells must be visited in ascending order, as in the land cell lists; an earlier cell does nothing
+ ********/
+void band_walk_cell(band_walk_struct *walk, int cell)
+{
+	int row;
+	int new_start;		// first row of the band of cell
+
+	if (cell < walk->next_cell) {
+		return;
+	}
+	row = cell / NUM_LON;
+	new_start = row - row % walk->band_rows;
+	grid_release_rows(walk->row_start, new_start - walk->row_start);
+	walk->row_start = new_start;
+	walk->next_cell = (long) (new_start + walk->band_rows) * NUM_LON;
+}
+
+/********
+ void band_walk_end(band_walk_struct *walk)
+ release the rest of the grid at the end of a walk
+ ********/
+void band_walk_end(band_walk_struct *walk)
+{
+	grid_release_rows(walk->row_start, NUM_LAT - walk->row_start);
+	walk->row_start = NUM_LAT;
+	walk->next_cell = NUM_CELLS;
+}
@@ -109,6 +109,20 @@ int init_moirai(args_struct *in_args) {
     memset(in_args->wf_fname, '\0', MAXCHAR);
     memset(in_args->iso_map_fname, '\0', MAXCHAR);
     memset(in_args->lt_map_fname, '\0', MAXCHAR);
+    // optional settings
+    in_args->out_columnar = 0;
+    in_args->out_nc_grids = 0;
+    in_args->grid_res_sec = GRID_RES_SEC_DEFAULT;
+    in_args->band_rows = 0;
+    strcpy(in_args->window_bbox, "0");
+    strcpy(in_args->window_ctry, "0");
+    strcpy(in_args->window_glu, "0");
+    strcpy(in_args->sage_store_fname, "0");
+    in_args->readahead_mb = 0;
+    in_args->hyde_block_major = 0;
+    in_args->log_sample = 20;
+    in_args->diag_select = DIAG_ALL;
+    in_args->io_uring = 0;
 	
 	// number of land cells
 	num_land_cells_aez_new = 0;			// the actual number of land cell indices in land_cells_aez_new[]
@@ -0,0 +1,263 @@
+/**********
+ load_static_inputs.c
+
+ read the static input tables and rasters at startup, with independent reads running at the same time
+ these are the info (csv) files that determine the mappings and the numbers of aezs, crops, countries and regions,
+  and the base rasters: cell area, land area, aez boundaries, potential vegetation, fao countries, and the lulc land mask
+
+ the reads are openmp tasks; a read waits only for the data that it uses (in a serial build they run in order):
+	read_country87_info() uses the fao country list from read_country_info_all()
+	read_region_info_gcam() uses the ctry87 mapping from read_country87_info()
+	read_land_area_sage() uses cell_area from get_cell_area()
+ the other reads are independent, and each raster read sets only its own fields of raster_info
+ the netcdf reads and writes are serialized by the netcdf lock (nc_lock.c)
+
+ the raster arrays must be allocated before this is called
+ when all of the reads are done, the start and end time of each read, and the thread that ran it, are written to the log
+  as a startup timeline; the first error of the reads, in the order listed in load_names, is returned
+
+ arguments:
+ args_struct in_args:		the input argument structure
+ rinfo_struct *raster_info:	information about input raster data
+
+ return value:
+ integer error code: OK = 0, otherwise a non-zero error code
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "moirai.h"
+#include <time.h>
+
+// the startup reads, in the order that they were done before they were run concurrently
+enum {
+	LOAD_COUNTRY_ALL,
+	LOAD_COUNTRY87,
+	LOAD_REGION_GCAM,
+	LOAD_AEZ_NEW_INFO,
+	LOAD_USE_GTAP,
+	LOAD_LULC_INFO,
+	LOAD_CROP_INFO,
+	LOAD_CELL_AREA,
+	LOAD_LAND_AREA_SAGE,
+	LOAD_LAND_AREA_HYDE,
+	LOAD_AEZ_NEW,
+	LOAD_AEZ_ORIG,
+	LOAD_POTVEG,
+	LOAD_COUNTRY_FAO,
+	LOAD_LULC_LAND,
+	NUM_LOADS
+};
+
+static const char *load_names[NUM_LOADS] = {
+	"read_country_info_all",
+	"read_country87_info",
+	"read_region_info_gcam",
+	"read_aez_new_info",
+	"read_use_info_gtap",
+	"read_lulc_info",
+	"read_crop_info",
+	"get_cell_area",
+	"read_land_area_sage",
+	"read_land_area_hyde",
+	"read_aez_new",
+	"read_aez_orig",
+	"read_potveg",
+	"read_country_fao",
+	"read_lulc_land"
+};
+
+/********
+ static double load_wtime(void)
+ wall clock time in seconds; a serial build (without openmp) uses the monotonic clock
+ ********/
+static double load_wtime(void)
+{
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+#endif
+}
+
+/********
+ static int run_load(int load, args_struct in_args, rinfo_struct *raster_info, double t0, double *start, double *end, int *thread)
+ do one read and record when it ran, in seconds since t0, and on which thread
+ return:	error code
+ ********/
+static int run_load(int load, args_struct in_args, rinfo_struct *raster_info, double t0, double *start, double *end, int *thread)
+{
+	int err = OK;
+
+	start[load] = load_wtime() - t0;
+#ifdef _OPENMP
+	thread[load] = omp_get_thread_num();
+#else
+	thread[load] = 0;
+#endif
+
+	switch (load) {
+		case LOAD_COUNTRY_ALL:
+			// one file includes the alphabetical FAO country list and the FAO, VMAP0, iso ctry mapping
+			err = read_country_info_all(in_args);
+			break;
+		case LOAD_COUNTRY87:
+			// the GCAM/GTAP ctry87 list in land rent output order and the mapping between FAO ctry and GCAM/GTAP ctry87
+			err = read_country87_info(in_args);
+			break;
+		case LOAD_REGION_GCAM:
+			err = read_region_info_gcam(in_args);
+			break;
+		case LOAD_AEZ_NEW_INFO:
+			err = read_aez_new_info(in_args);
+			break;
+		case LOAD_USE_GTAP:
+			// this is the list in output order for land rent
+			err = read_use_info_gtap(in_args);
+			break;
+		case LOAD_LULC_INFO:
+			err = read_lulc_info(in_args);
+			break;
+		case LOAD_CROP_INFO:
+			// one file includes FAO to SAGE crop and to GTAP use mapping
+			err = read_crop_info(in_args);
+			break;
+		case LOAD_CELL_AREA:
+			// total area of each working grid cell (spherical earth) and the cell area of the hyde land cells
+			err = get_cell_area(in_args, raster_info);
+			break;
+		case LOAD_LAND_AREA_SAGE:
+			err = read_land_area_sage(in_args, raster_info);
+			break;
+		case LOAD_LAND_AREA_HYDE:
+			err = read_land_area_hyde(in_args, raster_info);
+			break;
+		case LOAD_AEZ_NEW:
+			err = read_aez_new(in_args, raster_info);
+			break;
+		case LOAD_AEZ_ORIG:
+			err = read_aez_orig(in_args, raster_info);
+			break;
+		case LOAD_POTVEG:
+			err = read_potveg(in_args, raster_info);
+			break;
+		case LOAD_COUNTRY_FAO:
+			err = read_country_fao(in_args, raster_info);
+			break;
+		case LOAD_LULC_LAND:
+			err = read_lulc_land(in_args, REF_YEAR, raster_info, land_mask_lulc);
+			break;
+		default:
+			err = ERROR_IND;
+			break;
+	}
+
+	end[load] = load_wtime() - t0;
+
+	return err;
+}
+
+int load_static_inputs(args_struct in_args, rinfo_struct *raster_info) {
+
+	int i;
+	int err[NUM_LOADS];				// error code of each read
+	int thread[NUM_LOADS];			// thread that ran each read
+	double start[NUM_LOADS];		// start time of each read, in seconds since t0
+	double end[NUM_LOADS];			// end time of each read, in seconds since t0
+	double t0;						// start time of the startup reads
+	double t_all;					// elapsed time of the startup reads
+	double t_sum = 0;				// sum of the read times
+	int first_err = OK;				// the error code to return
+	int num_threads = 1;			// number of threads; 1 in a serial build
+
+	for (i = 0; i < NUM_LOADS; i++) {
+		err[i] = OK;
+		thread[i] = NOMATCH;
+		start[i] = 0;
+		end[i] = 0;
+	}
+
+	t0 = load_wtime();
+
+#pragma omp parallel
+#pragma omp single
+	{
+		// the country info chain; a read is skipped if the one before it failed
+#pragma omp task
+		{
+			if ((err[LOAD_COUNTRY_ALL] = run_load(LOAD_COUNTRY_ALL, in_args, raster_info, t0, start, end, thread)) == OK &&
+				(err[LOAD_COUNTRY87] = run_load(LOAD_COUNTRY87, in_args, raster_info, t0, start, end, thread)) == OK) {
+				err[LOAD_REGION_GCAM] = run_load(LOAD_REGION_GCAM, in_args, raster_info, t0, start, end, thread);
+			}
+		}
+
+		// the land area needs the cell area
+#pragma omp task
+		{
+			if ((err[LOAD_CELL_AREA] = run_load(LOAD_CELL_AREA, in_args, raster_info, t0, start, end, thread)) == OK) {
+				err[LOAD_LAND_AREA_SAGE] = run_load(LOAD_LAND_AREA_SAGE, in_args, raster_info, t0, start, end, thread);
+			}
+		}
+
+		// the independent reads, larger rasters first
+		for (i = NUM_LOADS - 1; i >= LOAD_AEZ_NEW_INFO; i--) {
+			if (i == LOAD_CELL_AREA || i == LOAD_LAND_AREA_SAGE) {
+				continue;
+			}
+#pragma omp task firstprivate(i)
+			err[i] = run_load(i, in_args, raster_info, t0, start, end, thread);
+		}
+	} // end parallel region; all tasks are done
+
+	t_all = load_wtime() - t0;
+#ifdef _OPENMP
+	num_threads = omp_get_max_threads();
+#endif
+
+	// the timeline
+	fprintf(fplog, "\nStartup load timeline (seconds since the start of the loads): load_static_inputs()\n");
+	fprintf(fplog, "%-24s%10s%10s%10s%8s%8s\n", "read", "start", "end", "time", "thread", "error");
+	for (i = 0; i < NUM_LOADS; i++) {
+		if (thread[i] == NOMATCH) {
+			fprintf(fplog, "%-24s%10s%10s%10s%8s%8s\n", load_names[i], "-", "-", "-", "-", "skip");
+			continue;
+		}
+		t_sum = t_sum + end[i] - start[i];
+		fprintf(fplog, "%-24s%10.3f%10.3f%10.3f%8i%8i\n", load_names[i], start[i], end[i], end[i] - start[i], thread[i], err[i]);
+		if (err[i] != OK && first_err == OK) {
+			first_err = err[i];
+		}
+	}
+	fprintf(fplog, "Startup loads took %.3f s on %i threads; the reads took %.3f s in total: load_static_inputs()\n\n",
+			t_all, num_threads, t_sum);
+	fflush(fplog);
+
+	return first_err;
+}
@@ -0,0 +1,111 @@
+/**********
+ log_utils.c
+
+ contains the following functions for rate-limited messages from loops that may repeat a message many times:
+	log_open()
+	log_sample()
+	log_summary()
+
+ each repeated message has a static logsite_struct at the point where it is written; log_sample() counts the
+  occurrences and lets only the first log_sample_max of them be written (in_args.log_sample)
+ log_summary() writes the number of messages that were not written for each site, and is called at the end
+  of a stage; each site then starts counting again
+ the log file itself has a large stdio buffer, so it is written in big blocks; it is flushed at each summary
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+static logsite_struct *logsite_head = NULL;		// the sites that have been hit since the last summary
+
+/********
+ FILE *log_open(char *fname)
+ open the log file with a LOG_BUFSIZE buffer
+ fname:		the file name with path
+ return:	the open file, or NULL
+ ********/
+FILE *log_open(char *fname)
+{
+	FILE *fp;
+
+	if ((fp = fopen(fname, "w")) == NULL) {
+		return NULL;
+	}
+	// keep the default buffer if this fails
+	setvbuf(fp, NULL, _IOFBF, LOG_BUFSIZE);
+
+	return fp;
+}
+
+/********
+ int log_sample(logsite_struct *site)
+ count one occurrence of a message
+ this is safe to call from several threads
+ site:		the message site; static, with a zero count and a NULL next at program start
+ return:	1 if the message is to be written; 0 if it is only counted
+ ********/
+int log_sample(logsite_struct *site)
+{
+	long count;
+
+#pragma omp atomic capture
+	count = site->count++;
+
+	// the first occurrence adds the site to the summary list
+	if (count == 0) {
+#pragma omp critical(logsite)
+		{
+			site->next = logsite_head;
+			logsite_head = site;
+		}
+	}
+
+	return (log_sample_max <= 0 || count < log_sample_max);
+}
+
+/********
+ void log_summary(char *stage)
+ write the number of occurrences of each message site that were not written, and reset the counts
+ call this outside of any parallel region
+ stage:		the name of the stage that is ending, for the log
+ ********/
+void log_summary(char *stage)
+{
+	logsite_struct *site;
+	logsite_struct *next;
+
+	for (site = logsite_head; site != NULL; site = next) {
+		next = site->next;
+		if (log_sample_max > 0 && site->count > log_sample_max) {
+			fprintf(fplog, "Suppressed %li of %li messages in %s: %s\n", site->count - log_sample_max, site->count, stage, site->name);
+		}
+		site->count = 0;
+		site->next = NULL;
+	}
+	logsite_head = NULL;
+
+	fflush(fplog);
+}
@@ -0,0 +1,337 @@
+/**********
+ lu_readahead.c
+
+ contains the following functions for reading the per-year hyde and lulc inputs of proc_land_type_area() ahead of use:
+	lureadahead_init()
+	lureadahead_get()
+	lureadahead_release()
+	lureadahead_free()
+
+ each year of proc_land_type_area() reads the hyde land use grids (read_hyde32()) and the lulc data (read_lulc_isam())
+  before it can disaggregate them, so without read-ahead the i/o and the computation never overlap
+ with read-ahead, a background thread reads the next years into a ring of year buffers while the current year is processed
+ the caller gets the years in order with lureadahead_get() and hands each buffer back with lureadahead_release()
+ in_args.readahead_mb caps the memory of the extra buffers; it allows up to LU_READAHEAD_MAX years ahead,
+  and 0 (the default) reads each year in the calling thread with a single buffer, as before
+ the reader has its own copy of raster_info, so read_hyde32() does not write the caller's copy
+ the netcdf calls of read_lulc_isam() take the netcdf lock (nc_lock.c), so the caller may write netcdf grids meanwhile
+ with a block_cells list (in_args.hyde_block_major) the reader also reorders each hyde grid into block-major order,
+  lulc cell by lulc cell, so the caller reads the cells of a lulc cell contiguously; this is done in the background with read-ahead
+ the lulc grids are not reordered
+ the hyde grids are working grid arrays (grid_calloc()), so with latitude bands they are paged like the other grids
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+/********
+ static int luyear_alloc(luyear_struct *slot)
+ allocate the grids of one year buffer
+ return:	error code
+ ********/
+static int luyear_alloc(luyear_struct *slot)
+{
+	int i;
+
+	slot->year_ind = -1;
+	slot->crop_grid = grid_calloc(NUM_CELLS, sizeof(float));
+	slot->pasture_grid = grid_calloc(NUM_CELLS, sizeof(float));
+	slot->urban_grid = grid_calloc(NUM_CELLS, sizeof(float));
+	slot->lu_detail_grid = calloc(NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN, sizeof(float*));
+	slot->lulc_grid = calloc(NUM_LULC_TYPES, sizeof(float*));
+	if (slot->crop_grid == NULL || slot->pasture_grid == NULL || slot->urban_grid == NULL ||
+		slot->lu_detail_grid == NULL || slot->lulc_grid == NULL) {
+		return ERROR_MEM;
+	}
+	for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
+		if ((slot->lu_detail_grid[i] = grid_calloc(NUM_CELLS, sizeof(float))) == NULL) {
+			return ERROR_MEM;
+		}
+	}
+	for (i = 0; i < NUM_LULC_TYPES; i++) {
+		if ((slot->lulc_grid[i] = calloc(NUM_CELLS_LULC, sizeof(float))) == NULL) {
+			return ERROR_MEM;
+		}
+	}
+
+	return OK;
+}
+
+/********
+ static void luyear_free(luyear_struct *slot)
+ free the grids of one year buffer
+ ********/
+static void luyear_free(luyear_struct *slot)
+{
+	int i;
+
+	if (slot->lu_detail_grid != NULL) {
+		for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
+			grid_free(slot->lu_detail_grid[i]);
+		}
+	}
+	if (slot->lulc_grid != NULL) {
+		for (i = 0; i < NUM_LULC_TYPES; i++) {
+			free(slot->lulc_grid[i]);
+		}
+	}
+	grid_free(slot->crop_grid);
+	grid_free(slot->pasture_grid);
+	grid_free(slot->urban_grid);
+	free(slot->lu_detail_grid);
+	free(slot->lulc_grid);
+}
+
+/********
+ static void luyear_to_blocks(lureadahead_struct *ra, float **grid)
+ reorder a hyde grid into block-major order, into the spare grid, and swap the two grids
+ ********/
+static void luyear_to_blocks(lureadahead_struct *ra, float **grid)
+{
+	float *blocks = ra->block_buf;
+	int p;
+
+	for (p = 0; p < NUM_CELLS; p++) {
+		blocks[p] = (*grid)[ra->block_cells[p]];
+	}
+	ra->block_buf = *grid;
+	*grid = blocks;
+}
+
+/********
+ static int luyear_read(lureadahead_struct *ra, int year_ind, luyear_struct *slot)
+ read the hyde and lulc data of one year into a year buffer
+ the lulc data start at LULC_START_YEAR, so earlier hyde years use the first lulc year
+ return:	error code
+ ********/
+static int luyear_read(lureadahead_struct *ra, int year_ind, luyear_struct *slot)
+{
+	int year = ra->years[year_ind];
+	int err = OK;
+	int i;
+
+	slot->lulc_year = (year < LULC_START_YEAR) ? LULC_START_YEAR : year;
+	if ((err = read_hyde32(ra->in_args, &ra->raster_info, year, slot->crop_grid, slot->pasture_grid, slot->urban_grid,
+						   slot->lu_detail_grid)) != OK) {
+		fprintf(fplog, "Failed to read lu hyde data for year %i: luyear_read()\n", year);
+	} else if ((err = read_lulc_isam(ra->in_args, slot->lulc_year, slot->lulc_grid)) != OK) {
+		fprintf(fplog, "Failed to read lulc data for year %i: luyear_read()\n", slot->lulc_year);
+	} else if (ra->block_cells != NULL) {
+		luyear_to_blocks(ra, &slot->crop_grid);
+		luyear_to_blocks(ra, &slot->pasture_grid);
+		luyear_to_blocks(ra, &slot->urban_grid);
+		for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
+			luyear_to_blocks(ra, &slot->lu_detail_grid[i]);
+		}
+	}
+	slot->block_major = (ra->block_cells != NULL);
+	slot->year_ind = year_ind;
+	slot->err = err;
+
+	return err;
+}
+
+/********
+ static void *lureadahead_run(void *arg)
+ the background reader: read the years in order, each into its slot once the caller has released the slot's previous year
+ it stops after a read error; the caller gets the error with that year
+ ********/
+static void *lureadahead_run(void *arg)
+{
+	lureadahead_struct *ra = (lureadahead_struct *) arg;
+	int i;
+	int err;
+
+	for (i = 0; i < ra->num_years; i++) {
+		pthread_mutex_lock(&ra->lock);
+		while (i - ra->num_released >= ra->num_slots && !ra->stop) {
+			pthread_cond_wait(&ra->cond, &ra->lock);
+		}
+		if (ra->stop) {
+			pthread_mutex_unlock(&ra->lock);
+			break;
+		}
+		pthread_mutex_unlock(&ra->lock);
+
+		err = luyear_read(ra, i, &ra->slots[i % ra->num_slots]);
+
+		pthread_mutex_lock(&ra->lock);
+		ra->num_read = i + 1;
+		pthread_cond_broadcast(&ra->cond);
+		pthread_mutex_unlock(&ra->lock);
+		if (err != OK) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/********
+ int lureadahead_init(lureadahead_struct *ra, args_struct in_args, rinfo_struct raster_info, int *years, int num_years, int *block_cells)
+ allocate the year buffers within in_args.readahead_mb and start the background reader if there is more than one
+ years:			the hyde years to read, in the order they will be used; this array must outlast ra
+ num_years:		number of years
+ block_cells:	the working grid index of each block-major position [NUM_CELLS], to deliver the hyde grids in that order;
+				 NULL to keep them row-major; this array must outlast ra
+ return:		error code
+ ********/
+int lureadahead_init(lureadahead_struct *ra, args_struct in_args, rinfo_struct raster_info, int *years, int num_years, int *block_cells)
+{
+	double year_mb;			// memory of one year buffer (MB)
+	int num_ahead;			// number of years read ahead
+	int i;
+
+	memset(ra, 0, sizeof(lureadahead_struct));
+	ra->in_args = in_args;
+	ra->raster_info = raster_info;
+	ra->years = years;
+	ra->num_years = num_years;
+	ra->block_cells = block_cells;
+
+	year_mb = ((double) NUM_HYDE_TYPES * NUM_CELLS + (double) NUM_LULC_TYPES * NUM_CELLS_LULC) * sizeof(float) / 1048576.0;
+	num_ahead = (in_args.readahead_mb > 0) ? (int) floor(in_args.readahead_mb / year_mb) : 0;
+	if (num_ahead > LU_READAHEAD_MAX) {
+		num_ahead = LU_READAHEAD_MAX;
+	}
+	if (num_ahead > num_years - 1) {
+		num_ahead = (num_years > 1) ? num_years - 1 : 0;
+	}
+	ra->num_slots = 1 + num_ahead;
+
+	ra->slots = calloc(ra->num_slots, sizeof(luyear_struct));
+	if (ra->slots == NULL) {
+		fprintf(fplog, "Failed to allocate memory for slots: lureadahead_init()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i < ra->num_slots; i++) {
+		if (luyear_alloc(&ra->slots[i]) != OK) {
+			fprintf(fplog, "Failed to allocate memory for year buffer %i: lureadahead_init()\n", i);
+			lureadahead_free(ra);
+			return ERROR_MEM;
+		}
+	}
+
+	if (block_cells != NULL) {
+		ra->block_buf = grid_calloc(NUM_CELLS, sizeof(float));
+		if (ra->block_buf == NULL) {
+			fprintf(fplog, "Failed to allocate memory for block_buf: lureadahead_init()\n");
+			lureadahead_free(ra);
+			return ERROR_MEM;
+		}
+	}
+
+	if (ra->num_slots > 1) {
+		pthread_mutex_init(&ra->lock, NULL);
+		pthread_cond_init(&ra->cond, NULL);
+		if (pthread_create(&ra->thread, NULL, lureadahead_run, ra) == 0) {
+			ra->has_thread = 1;
+			fprintf(fplog, "Reading %i hyde/lulc years ahead in the background (%.0f MB per year): lureadahead_init()\n",
+					num_ahead, year_mb);
+		} else {
+			pthread_mutex_destroy(&ra->lock);
+			pthread_cond_destroy(&ra->cond);
+			fprintf(fplog, "Warning: failed to start the read-ahead thread; reading each year in turn: lureadahead_init()\n");
+		}
+	}
+
+	return OK;
+}
+
+/********
+ int lureadahead_get(lureadahead_struct *ra, int year_ind, luyear_struct **lu_year)
+ get the data of the next year, waiting for the background reader if needed
+ the years must be taken in order, and each must be released before the one after the read-ahead window is available
+ year_ind:	index of the year in the year list
+ lu_year:	set to the year buffer
+ return:	error code from reading the year
+ ********/
+int lureadahead_get(lureadahead_struct *ra, int year_ind, luyear_struct **lu_year)
+{
+	if (!ra->has_thread) {
+		*lu_year = &ra->slots[0];
+		return luyear_read(ra, year_ind, *lu_year);
+	}
+
+	pthread_mutex_lock(&ra->lock);
+	while (ra->num_read <= year_ind) {
+		pthread_cond_wait(&ra->cond, &ra->lock);
+	}
+	pthread_mutex_unlock(&ra->lock);
+
+	*lu_year = &ra->slots[year_ind % ra->num_slots];
+	if ((*lu_year)->year_ind != year_ind) {
+		fprintf(fplog, "Error: year index %i is not in its read-ahead slot: lureadahead_get()\n", year_ind);
+		return ERROR_IND;
+	}
+
+	return (*lu_year)->err;
+}
+
+/********
+ void lureadahead_release(lureadahead_struct *ra, int year_ind)
+ hand the buffer of a year back to the reader; the data must not be used after this
+ ********/
+void lureadahead_release(lureadahead_struct *ra, int year_ind)
+{
+	if (!ra->has_thread) {
+		return;
+	}
+
+	pthread_mutex_lock(&ra->lock);
+	ra->num_released = year_ind + 1;
+	pthread_cond_broadcast(&ra->cond);
+	pthread_mutex_unlock(&ra->lock);
+}
+
+/********
+ void lureadahead_free(lureadahead_struct *ra)
+ stop the background reader and free the year buffers
+ ********/
+void lureadahead_free(lureadahead_struct *ra)
+{
+	int i;
+
+	if (ra->has_thread) {
+		pthread_mutex_lock(&ra->lock);
+		ra->stop = 1;
+		pthread_cond_broadcast(&ra->cond);
+		pthread_mutex_unlock(&ra->lock);
+		pthread_join(ra->thread, NULL);
+		pthread_mutex_destroy(&ra->lock);
+		pthread_cond_destroy(&ra->cond);
+		ra->has_thread = 0;
+	}
+	if (ra->slots != NULL) {
+		for (i = 0; i < ra->num_slots; i++) {
+			luyear_free(&ra->slots[i]);
+		}
+		free(ra->slots);
+		ra->slots = NULL;
+	}
+	grid_free(ra->block_buf);
+	ra->block_buf = NULL;
+}
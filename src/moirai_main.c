@@ -298,8 +298,6 @@ int main(int argc, const char * argv[]) {
 	char fname[MAXCHAR];		// used to open files
 	args_struct in_args;		// data structure for holding the control input file info
 	rinfo_struct raster_info;	// data structure for storing raster input file specific info
-    
-    char mkoutputpathcmd[MAXCHAR]; // used to create the output path
 	
 	// for code control
 	int error_code = OK;		// 0 = ok; non-zero = error
@@ -337,12 +335,13 @@ int main(int argc, const char * argv[]) {
 	strcat(fname, in_args.lds_logname);
     
     // create the output path
-    strcpy(mkoutputpathcmd, "mkdir -p ");
-    strcat(mkoutputpathcmd, in_args.outpath);
-    printf("%s",mkoutputpathcmd);
-    system(mkoutputpathcmd);
+    if ((error_code = make_path(in_args.outpath)) != OK) {
+        fprintf(stderr, "\nProgram terminated at %s with error_code = %i; could not create %s\n",
+                get_systime(), error_code, in_args.outpath);
+        return error_code;
+    }
     
-	if ((fplog = fopen(fname, "w")) == NULL) {
+	if ((fplog = log_open(fname)) == NULL) {
 		fprintf(stderr, "\nProgram terminated at %s with error_code = %i; could not open %s\n",
 					get_systime(), ERROR_FILE, fname);
 		return ERROR_FILE;
@@ -350,198 +349,120 @@ int main(int argc, const char * argv[]) {
 	
 	// create the paths for copying outputs to
 	// data files
-	strcpy(mkoutputpathcmd, "\nmkdir -p ");
-	strcat(mkoutputpathcmd, in_args.ldsdestpath);
-	printf("%s",mkoutputpathcmd);
-	system(mkoutputpathcmd);
+	if ((error_code = make_path(in_args.ldsdestpath)) != OK) {
+		fprintf(fplog, "\nProgram terminated at %s with error_code = %i; could not create %s\n",
+				get_systime(), error_code, in_args.ldsdestpath);
+		return error_code;
+	}
 	// mapping files
-	strcpy(mkoutputpathcmd, "\nmkdir -p ");
-	strcat(mkoutputpathcmd, in_args.mapdestpath);
-	printf("%s",mkoutputpathcmd);
-	system(mkoutputpathcmd);
+	if ((error_code = make_path(in_args.mapdestpath)) != OK) {
+		fprintf(fplog, "\nProgram terminated at %s with error_code = %i; could not create %s\n",
+				get_systime(), error_code, in_args.mapdestpath);
+		return error_code;
+	}
 	
 	fprintf(fplog, "\nProgram %s started at %s\n", CODENAME, get_systime());
+	log_sample_max = in_args.log_sample;
+	
+	// set the working grid dimensions; all working grid arrays depend on these
+	if((error_code = set_working_grid(in_args))) {
+		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
+		return error_code;
+	}
+	// set the processing window; the whole grid unless restricted in the input file
+	if((error_code = set_window(in_args))) {
+		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
+		return error_code;
+	}
+	// with latitude bands the working grid arrays are paged through scratch files; see grid_store.c
+	if((error_code = grid_store_init(in_args))) {
+		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
+		return error_code;
+	}
 
     //////////
-    // start with the text info data
-    // these are csv files that determine mappings and number of aezs, crops, counties, regions
-    
-    ////////// read GTAP87 and GCAM region and FAO country info text files
-    
-    // one file	includes the alphabetical FAO country list and the FAO, VMAP0, iso ctry mapping
-    // array length and allocation done within read_country_info_all()
-    if((error_code = read_country_info_all(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
-    
-    // this includes both the GCAM/GTAP ctry87 list in land rent output order and the mapping between FAO ctry and GCAM/GTAP ctry87
-    // array length and allocation done within read_country87_info()
-    if((error_code = read_country87_info(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
-    
-    // this includes GCAM region list
-    // array length and allocation done within read_region_info_gcam()
-    if((error_code = read_region_info_gcam(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
-    
-    ////////// read the list of new aez codes and names
-    
-    // this is the list of new aezs
-    // array length and allocation done within read_aez_new_info()
-    if((error_code = read_aez_new_info(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
-    
-    ////////// read crop and use and land info text files
-    
-    // read GTAP use info
-    // this is the list in output order for land rent
-    // array length and allocation done within read_use_info_gtap()
-    if((error_code = read_use_info_gtap(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
-    
-    // read SAGE land type info
-    // array length and allocation done within read_lt_info_sage()
-    if((error_code = read_lulc_info(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
+    // read the text info data and the raster data, except the SAGE crop data, lulc data, and hyde lu data
+    // the info data are csv files that determine mappings and number of aezs, crops, counties, regions
+    // the array lengths and allocations of the info data are done within their read functions
+    // the independent reads run at the same time; see load_static_inputs()
     
-    // one file includes FAO to SAGE crop and to GTAP use mapping
-    // array length and allocation done within read_crop_info()
-    if((error_code = read_crop_info(in_args))) {
-        fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-        return error_code;
-    }
-    
-	////////
-	// read the raster data, except the SAGE crop data, lulc data, and hyde lu data
-	
-	// calculate the total area of each working grid cell (spherical earth): cell_area[NUM_CELLS]
-    // and read in cell area of the hyde land cells (also spherical earth): cell_area_hyde[NUM_CELLS]
-    // first allocate the arrays
-    cell_area = calloc(NUM_CELLS, sizeof(float));
+    // first allocate the raster arrays (with grid_calloc(), so they are paged in latitude bands if band_rows is set):
+    // total area of each working grid cell (spherical earth): cell_area[NUM_CELLS]
+    // cell area of the hyde land cells (also spherical earth): cell_area_hyde[NUM_CELLS]
+    // sage working grid land area: land_area_sage[NUM_CELLS]
+    // hyde land area: land_area_hyde[NUM_CELLS]
+    // new and original AEZ boundaries: aez_bounds_new[NUM_CELLS], aez_bounds_orig[NUM_CELLS]
+    // potential vegetation data: potveg_thematic[NUM_CELLS]
+    // FAO country code data: country_fao[NUM_CELLS]
+    // lulc land mask: land_mask_lulc[NUM_CELLS]
+    cell_area = grid_calloc(NUM_CELLS, sizeof(float));
     if(cell_area == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for cell_area: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    cell_area_hyde = calloc(NUM_CELLS, sizeof(float));
+    cell_area_hyde = grid_calloc(NUM_CELLS, sizeof(float));
     if(cell_area_hyde == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for cell_area_hyde: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-	if((error_code = get_cell_area(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
-	
-	// read the sage working grid land fraction and convert it to land area: land_area_sage[NUM_CELLS]
-    // first allocate the arrays
-    land_area_sage = calloc(NUM_CELLS, sizeof(float));
+    land_area_sage = grid_calloc(NUM_CELLS, sizeof(float));
     if(land_area_sage == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_area_sage: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-	if((error_code = read_land_area_sage(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
-	
-	// read the hyde land area: land_area_hyde[NUM_CELLS]
-    // first allocate the arrays
-    land_area_hyde = calloc(NUM_CELLS, sizeof(float));
+    land_area_hyde = grid_calloc(NUM_CELLS, sizeof(float));
     if(land_area_hyde == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_area_hyde: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-	if((error_code = read_land_area_hyde(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
-	
-	// read new AEZ boundaries: aez_bounds_new[NUM_CELLS]
-    // first allocate the array
-    aez_bounds_new = calloc(NUM_CELLS, sizeof(int));
+    aez_bounds_new = grid_calloc(NUM_CELLS, sizeof(int));
     if(aez_bounds_new == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for aez_bounds_new: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    if((error_code = read_aez_new(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
-	
-	// read original AEZ boundaries:aez_bounds_orig[NUM_CELLS]
-    // first allocate the array
-    aez_bounds_orig = calloc(NUM_CELLS, sizeof(int));
+    aez_bounds_orig = grid_calloc(NUM_CELLS, sizeof(uint8_t));
     if(aez_bounds_orig == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for aez_bounds_orig: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-	if((error_code = read_aez_orig(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
-	
-	// read potential vegetation data: potveg_thematic[NUM_CELLS]
-    // first allocate the array
-    potveg_thematic = calloc(NUM_CELLS, sizeof(int));
+    potveg_thematic = grid_calloc(NUM_CELLS, sizeof(uint8_t));
     if(potveg_thematic == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for potveg_thematic: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-	if((error_code = read_potveg(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
-	
-	// read FAO country code data: country_fao[NUM_CELLS]
-    // first allocate array
-    country_fao = calloc(NUM_CELLS, sizeof(short));
+    country_fao = grid_calloc(NUM_CELLS, sizeof(short));
     if(country_fao == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for country_fao: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-	if((error_code = read_country_fao(in_args, &raster_info))) {
-		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
-		return error_code;
-	}
+    land_mask_lulc = grid_calloc(NUM_CELLS, sizeof(int));
+    if(land_mask_lulc == NULL) {
+        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_lulc: main()\n", get_systime(), ERROR_MEM);
+        return ERROR_MEM;
+    }
 	
-	// read lulc land mask: land_mask_lulc[NUM_CELLS]
-	// first allocate array
-	land_mask_lulc = calloc(NUM_CELLS, sizeof(int));
-	if(land_mask_lulc == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_lulc: main()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	if((error_code = read_lulc_land(in_args, REF_YEAR, &raster_info, land_mask_lulc))) {
+	if((error_code = load_static_inputs(in_args, &raster_info))) {
 		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
 		return error_code;
 	}
+	// the inputs are read whole; drop them from memory until the stages visit them band by band
+	grid_release_rows(0, NUM_LAT);
 	
     /////////
     // reconcile the raster data
 	
     // allocate some raster arrays
-    cropland_area = calloc(NUM_CELLS, sizeof(float));
+    cropland_area = grid_calloc(NUM_CELLS, sizeof(float));
     if(cropland_area == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for cropland_area: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    pasture_area = calloc(NUM_CELLS, sizeof(float));
+    pasture_area = grid_calloc(NUM_CELLS, sizeof(float));
     if(pasture_area == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for pasture_area: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    urban_area = calloc(NUM_CELLS, sizeof(float));
+    urban_area = grid_calloc(NUM_CELLS, sizeof(float));
     if(urban_area == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for urban_area: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
@@ -552,86 +473,89 @@ int main(int argc, const char * argv[]) {
 		return ERROR_MEM;
 	}
 	for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
-		lu_detail_area[i] = calloc(NUM_CELLS, sizeof(float));
+		lu_detail_area[i] = grid_calloc(NUM_CELLS, sizeof(float));
 		if(lu_detail_area[i] == NULL) {
 			fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lu_detail_area[%i]: main()\n", get_systime(), ERROR_MEM, i);
 			return ERROR_MEM;
 		}
 	}
-    refveg_area = calloc(NUM_CELLS, sizeof(float));
+    refveg_area = grid_calloc(NUM_CELLS, sizeof(float));
     if(refveg_area == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_area: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    region_gcam = calloc(NUM_CELLS, sizeof(int));
+    region_gcam = grid_calloc(NUM_CELLS, sizeof(uint8_t));
     if(region_gcam == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for region_gcam: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    sage_minus_hyde_land_area = calloc(NUM_CELLS, sizeof(float));
-    if(sage_minus_hyde_land_area == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for sage_minus_hyde_land_area: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-    glacier_water_area_hyde = calloc(NUM_CELLS, sizeof(float));
-    if(glacier_water_area_hyde == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for glacier_water_area_hyde: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-    country87_gtap = calloc(NUM_CELLS, sizeof(int));
+    country87_gtap = grid_calloc(NUM_CELLS, sizeof(uint8_t));
     if(country87_gtap == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for country87_gtap: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    missing_aez_mask = calloc(NUM_CELLS, sizeof(int));
+    missing_aez_mask = grid_calloc(NUM_CELLS, sizeof(int));
     if(missing_aez_mask == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for missing_aez_mask: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    land_mask_ctryaez = calloc(NUM_CELLS, sizeof(int));
+    land_mask_ctryaez = grid_calloc(NUM_CELLS, sizeof(int));
     if(land_mask_ctryaez == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_ctryaez: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    land_mask_aez_orig = calloc(NUM_CELLS, sizeof(int));
-    if(land_mask_aez_orig == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_aez_orig: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-    land_mask_aez_new = calloc(NUM_CELLS, sizeof(int));
-    if(land_mask_aez_new == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_aez_new: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-    land_mask_sage = calloc(NUM_CELLS, sizeof(int));
-    if(land_mask_sage == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_sage: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-    land_mask_hyde = calloc(NUM_CELLS, sizeof(int));
+    land_mask_hyde = grid_calloc(NUM_CELLS, sizeof(int));
     if(land_mask_hyde == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_hyde: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    land_mask_fao = calloc(NUM_CELLS, sizeof(int));
-    if(land_mask_fao == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_fao: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-    land_mask_potveg = calloc(NUM_CELLS, sizeof(int));
-    if(land_mask_potveg == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_potveg: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
-    }
-	land_mask_refveg = calloc(NUM_CELLS, sizeof(int));
+	land_mask_refveg = grid_calloc(NUM_CELLS, sizeof(int));
 	if(land_mask_refveg == NULL) {
 		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_refveg: main()\n", get_systime(), ERROR_MEM);
 		return ERROR_MEM;
 	}
-    land_mask_forest = calloc(NUM_CELLS, sizeof(int));
-    if(land_mask_forest == NULL) {
-        fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_forest: main()\n", get_systime(), ERROR_MEM);
-        return ERROR_MEM;
+    // the diagnostic land masks and area difference rasters of get_land_cells() are allocated only if used
+    if (DIAG_ON(in_args, DIAG_LAND_CELLS)) {
+        sage_minus_hyde_land_area = grid_calloc(NUM_CELLS, sizeof(float));
+        if(sage_minus_hyde_land_area == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for sage_minus_hyde_land_area: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        glacier_water_area_hyde = grid_calloc(NUM_CELLS, sizeof(float));
+        if(glacier_water_area_hyde == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for glacier_water_area_hyde: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        land_mask_aez_orig = grid_calloc(NUM_CELLS, sizeof(int));
+        if(land_mask_aez_orig == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_aez_orig: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        land_mask_aez_new = grid_calloc(NUM_CELLS, sizeof(int));
+        if(land_mask_aez_new == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_aez_new: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        land_mask_sage = grid_calloc(NUM_CELLS, sizeof(int));
+        if(land_mask_sage == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_sage: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        land_mask_fao = grid_calloc(NUM_CELLS, sizeof(int));
+        if(land_mask_fao == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_fao: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        land_mask_potveg = grid_calloc(NUM_CELLS, sizeof(int));
+        if(land_mask_potveg == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_potveg: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
+        land_mask_forest = grid_calloc(NUM_CELLS, sizeof(int));
+        if(land_mask_forest == NULL) {
+            fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_mask_forest: main()\n", get_systime(), ERROR_MEM);
+            return ERROR_MEM;
+        }
     }
 	lulc_input_grid = calloc(NUM_LULC_TYPES, sizeof(float*));
 	if(lulc_input_grid == NULL) {
@@ -645,29 +569,29 @@ int main(int argc, const char * argv[]) {
 			return ERROR_MEM;
 		}
 	}
-	refveg_thematic = calloc(NUM_CELLS, sizeof(int));
+	refveg_thematic = grid_calloc(NUM_CELLS, sizeof(uint8_t));
 	if(refveg_thematic == NULL) {
 		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_thematic: main()\n", get_systime(), ERROR_MEM);
 		return ERROR_MEM;
 	}
 	
     // allocate some arrays to keep track of valid raster cells
-    land_cells_aez_new = calloc(NUM_CELLS, sizeof(int));
+    land_cells_aez_new = grid_calloc_list(NUM_CELLS, sizeof(int));
     if(land_cells_aez_new == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_cells_aez_new: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    land_cells_sage = calloc(NUM_CELLS, sizeof(int));
+    land_cells_sage = grid_calloc_list(NUM_CELLS, sizeof(int));
     if(land_cells_sage == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_cells_sage: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    land_cells_hyde = calloc(NUM_CELLS, sizeof(int));
+    land_cells_hyde = grid_calloc_list(NUM_CELLS, sizeof(int));
     if(land_cells_hyde == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for land_cells_hyde: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    forest_cells = calloc(NUM_CELLS, sizeof(int));
+    forest_cells = grid_calloc_list(NUM_CELLS, sizeof(int));
     if(forest_cells == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for forest_cells: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
@@ -690,22 +614,23 @@ int main(int argc, const char * argv[]) {
 		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
 		return error_code;
 	}	
+	log_summary("calc_refveg_area()");
 
     // free some raster arrays
-    free(urban_area);
-    free(region_gcam);
-    free(cell_area_hyde);
-    free(sage_minus_hyde_land_area);
-    free(glacier_water_area_hyde);
-    free(land_mask_aez_orig);
-    free(land_mask_aez_new);
-    free(land_mask_sage);
-    free(land_mask_hyde);
-    free(land_mask_fao);
-    free(land_mask_potveg);
-	free(land_mask_refveg);
-    free(land_mask_forest);
-	free(land_mask_lulc);
+    grid_free(urban_area);
+    grid_free(region_gcam);
+    grid_free(cell_area_hyde);
+    grid_free(sage_minus_hyde_land_area);
+    grid_free(glacier_water_area_hyde);
+    grid_free(land_mask_aez_orig);
+    grid_free(land_mask_aez_new);
+    grid_free(land_mask_sage);
+    // land_mask_hyde is kept for proc_land_type_area(), which processes only the window land cells
+    grid_free(land_mask_fao);
+    grid_free(land_mask_potveg);
+	grid_free(land_mask_refveg);
+    grid_free(land_mask_forest);
+	grid_free(land_mask_lulc);
     
 	// store the country/land rent region + aez lists
     // the arrays are allocated within write_glu_mapping()
@@ -722,7 +647,7 @@ int main(int argc, const char * argv[]) {
     }
     
     // allocate and read the protected pixel data
-    protected_thematic = calloc(NUM_CELLS, sizeof(short));
+    protected_thematic = grid_calloc(NUM_CELLS, sizeof(uint8_t));
     if(protected_thematic == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for protected_thematic: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
@@ -747,6 +672,9 @@ int main(int argc, const char * argv[]) {
         fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
         return error_code;
     }
+    log_summary("proc_land_type_area()");
+    grid_free(land_mask_hyde);
+    land_mask_hyde = NULL;
     
     // process the potential vegetation carbon data
     //  needed arrays are allocated/freed within proc_potveg_carbon()
@@ -762,16 +690,18 @@ int main(int argc, const char * argv[]) {
         return error_code;
     }
     
-    // free the land type category array
+    // free the land type category arrays
     free(lt_cats);
+    free(lt_cat_index);
+    free(potveg_index);
     
     // free some rasters
-	free(cell_area);
-	free(land_area_hyde);
-    free(land_cells_aez_new);
-    free(protected_thematic);
-    free(potveg_thematic);
-	free(refveg_thematic);
+	grid_free(cell_area);
+	grid_free(land_area_hyde);
+    grid_free(land_cells_aez_new);
+    grid_free(protected_thematic);
+    grid_free(potveg_thematic);
+	grid_free(refveg_thematic);
 	for (i = 0; i < NUM_LULC_TYPES; i++) {
 		free(lulc_input_grid[i]);
 	}
@@ -807,6 +737,7 @@ int main(int argc, const char * argv[]) {
 		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
 		return error_code;
 	}
+	log_summary("read_yield_fao()");
 	
 	// read FAO harvested area: harvestarea_fao[NUM_FAO_CTRY * NUM_SAGE_CROP * NUM_FAO_YRS]
 	if((error_code = read_harvestarea_fao(in_args))) {
@@ -822,12 +753,12 @@ int main(int argc, const char * argv[]) {
 	}
 	
     // allocate the arrays for reading in the sage crops (initialized to zero)
-    harvestarea_in = calloc(NUM_CELLS, sizeof(float));
+    harvestarea_in = grid_calloc(NUM_CELLS, sizeof(float));
     if(harvestarea_in == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for harvestarea_in: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
     }
-    yield_in = calloc(NUM_CELLS, sizeof(float));
+    yield_in = grid_calloc(NUM_CELLS, sizeof(float));
     if(yield_in == NULL) {
         fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for yield_in: main()\n", get_systime(), ERROR_MEM);
         return ERROR_MEM;
@@ -890,7 +821,7 @@ int main(int argc, const char * argv[]) {
 	////
 	// get the sage physical cropland area for normalizing the crop inputs
 	// allocate the raster array
-	cropland_area_sage = calloc(NUM_CELLS, sizeof(float));
+	cropland_area_sage = grid_calloc(NUM_CELLS, sizeof(float));
 	if(cropland_area_sage == NULL) {
 		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for cropland_area_sage: main()\n", get_systime(), ERROR_MEM);
 		return ERROR_MEM;
@@ -915,19 +846,20 @@ int main(int argc, const char * argv[]) {
 		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
 		return error_code;
 	}
+	log_summary("calc_harvarea_prod_out_crop_aez()");
 	
     // free some raster arrays
-    free(harvestarea_in);
-    free(yield_in);
-    free(pasture_area);
-    free(country_fao);
-    free(land_area_sage);
-    free(land_mask_ctryaez);
-    free(land_cells_sage);
-	free(cropland_area);
-	free(cropland_area_sage);
+    grid_free(harvestarea_in);
+    grid_free(yield_in);
+    grid_free(pasture_area);
+    grid_free(country_fao);
+    grid_free(land_area_sage);
+    grid_free(land_mask_ctryaez);
+    grid_free(land_cells_sage);
+	grid_free(cropland_area);
+	grid_free(cropland_area_sage);
 	for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
-		free(lu_detail_area[i]);
+		grid_free(lu_detail_area[i]);
 	}
 	free(lu_detail_area);
 	
@@ -989,6 +921,7 @@ int main(int argc, const char * argv[]) {
 		fprintf(fplog, "\nProgram terminated at %s with error_code = %i\n", get_systime(), error_code);
 		return error_code;
 	}
+	log_summary("read_prodprice_fao()");
 	
 	// calculate agricultural (including livestock) land rent values for new AEZs by GTAP_use
 	//		current GTAP reference year is ca. 2000
@@ -1005,13 +938,13 @@ int main(int argc, const char * argv[]) {
 	}
 	 
     // free some raster arrays
-    free(aez_bounds_new);
-    free(aez_bounds_orig);
-    free(refveg_area);
-    free(country87_gtap);
-    free(forest_cells);
-    free(land_cells_hyde);
-    free(missing_aez_mask);
+    grid_free(aez_bounds_new);
+    grid_free(aez_bounds_orig);
+    grid_free(refveg_area);
+    grid_free(country87_gtap);
+    grid_free(forest_cells);
+    grid_free(land_cells_hyde);
+    grid_free(missing_aez_mask);
     
 	// write the land rent values
 	if((error_code = write_rent_use_aez(in_args))) {
@@ -1079,6 +1012,9 @@ int main(int argc, const char * argv[]) {
     }
     free(countryabbrs_gcam_iso);
     free(aez_codes_new);
+    free(glu_codes_sorted);
+    free(glu_index_sorted);
+    free_window();
     for (i = 0; i < NUM_NEW_AEZ; i++) {
         free(aez_names_new[i]);
     }
@@ -1157,6 +1093,7 @@ int main(int argc, const char * argv[]) {
     
     fprintf(stdout, "\nSuccessful completion of program %s at %s\n", CODENAME, get_systime());
     
+	log_summary("moirai_main()");
 	fprintf(fplog, "\nSuccessful completion of program %s at %s\n", CODENAME, get_systime());
 	fclose(fplog);
 	
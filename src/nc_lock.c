@@ -0,0 +1,77 @@
+/**********
+ nc_lock.c
+
+ contains the following functions for serializing the netcdf library calls:
+	nc_lock()
+	nc_unlock()
+
+ the netcdf-c library is not thread safe, and netcdf files are read and written from more than one thread:
+  the startup loads run as openmp tasks (load_static_inputs.c), and the lulc years are read by a background
+  pthread (lu_readahead.c) while the main thread may write netcdf grids
+ so every netcdf call is made between nc_lock() and nc_unlock(), which take one process-wide pthread mutex
+ the mutex is recursive, so a function that holds it can call another one that takes it
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#define _XOPEN_SOURCE 700
+
+#include "moirai.h"
+
+static pthread_mutex_t nc_mutex;				// the netcdf mutex
+static pthread_once_t nc_mutex_once = PTHREAD_ONCE_INIT;
+
+/********
+ static void nc_mutex_init(void)
+ make the recursive mutex, once
+ ********/
+static void nc_mutex_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&nc_mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+/********
+ void nc_lock(void)
+ wait for and take the netcdf mutex
+ ********/
+void nc_lock(void)
+{
+	pthread_once(&nc_mutex_once, nc_mutex_init);
+	pthread_mutex_lock(&nc_mutex);
+}
+
+/********
+ void nc_unlock(void)
+ release the netcdf mutex
+ ********/
+void nc_unlock(void)
+{
+	pthread_mutex_unlock(&nc_mutex);
+}
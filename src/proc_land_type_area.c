@@ -44,8 +44,20 @@
  input units are km^2
  output units are in ha - rounded to the nearest integer
  
+ only the area of the current year is kept in memory; when a year is done its positive rounded values are written
+    to a binary spill file next to the output table (<land_type_area_fname>.<year>.tmp)
+ after the last year the spill files are merged into the table, a block of countries at a time, and removed
+  the error returns remove the spill files written so far too, so a rerun and copy_to_destpath() do not see them
+ 
  process only valid hyde land cells, as these are the source for land type area
  
+ the working grid cells are visited in block-major order: lulc cell by lulc cell, and row by row within each lulc cell
+ the zone and protected status of each cell are found once, in this order, before the years are processed
+ a row of lulc cells covers whole working grid rows, so a block-major array holds the same rows at the same place
+    as a grid-order array, and each pass releases the latitude bands of the working grids behind it (see grid_store.c)
+ with in_args.hyde_block_major the reader also delivers the hyde grids in this order (see lu_readahead.c),
+    so the hyde areas of a lulc cell are contiguous instead of num_split rows apart
+ 
  serbia and montenegro data are merged
  
  arguments:
@@ -82,13 +94,242 @@
 
 #include "moirai.h"
 
+// one record of a year spill file
+typedef struct {
+	int key;			// zone * num_lt_cats + land type category index
+	float value;		// the rounded area (ha); always > 0
+} ltarea_rec_struct;
+
+/********
+ static int ltarea_block_cells(int ncols_lulc, int ncells_lulc, int num_split, int *block_cells)
+ the working grid index of each cell in block-major order; the cells of lulc cell i are at i * num_split^2
+ return:	error code; ERROR_IND if the lulc cells do not tile the working grid
+ ********/
+static int ltarea_block_cells(int ncols_lulc, int ncells_lulc, int num_split, int *block_cells)
+{
+	int i, m, n;
+	int count = 0;
+	int grid_y_ul;		// row of the upper left working grid cell of the lulc cell
+	int grid_x_ul;		// col of the upper left working grid cell of the lulc cell
+
+	if ((long) ncells_lulc * num_split * num_split != NUM_CELLS || ncols_lulc * num_split != NUM_LON) {
+		fprintf(fplog, "Error: the lulc cells (%i of %i working cells) do not tile the working grid: ltarea_block_cells()\n",
+				ncells_lulc, num_split * num_split);
+		return ERROR_IND;
+	}
+	for (i = 0; i < ncells_lulc; i++) {
+		grid_y_ul = (i / ncols_lulc) * num_split;
+		grid_x_ul = (i % ncols_lulc) * num_split;
+		for (m = grid_y_ul; m < grid_y_ul + num_split; m++) {
+			for (n = grid_x_ul; n < grid_x_ul + num_split; n++) {
+				block_cells[count++] = m * NUM_LON + n;
+			}
+		}
+	}
+
+	return OK;
+}
+
+/********
+ static int ltarea_block_zones(args_struct in_args, rinfo_struct raster_info, int *block_cells, int num_lu_cells,
+							   int **block_zone, uint8_t **block_protected)
+ the zone and protected code of each cell in block-major order
+ the zone is NOMATCH for a cell that adds no area: no hyde land area, no glu, or no economic country
+ num_lu_cells:		number of working grid cells in one lulc cell
+ block_zone:		set to the new zone array [NUM_CELLS]; the zones are those of zonemap_init()
+ block_protected:	set to the new protected code array [NUM_CELLS]
+ return:			error code
+ ********/
+static int ltarea_block_zones(args_struct in_args, rinfo_struct raster_info, int *block_cells, int num_lu_cells,
+							  int **block_zone, uint8_t **block_protected)
+{
+	int p, k;
+	int grid_ind;
+	int num_land = 0;			// number of cells with hyde land area
+	int *land_cells;			// working grid index of each cell with hyde land area, in block-major order
+	int *land_pos;				// block-major position of each cell in land_cells
+	zonemap_struct zones;		// finds the zone of each land cell
+	band_walk_struct walk;		// releases the bands of the working grids behind the loop
+	int err = OK;
+
+	*block_zone = grid_calloc(NUM_CELLS, sizeof(int));
+	*block_protected = grid_calloc(NUM_CELLS, sizeof(uint8_t));
+	land_cells = grid_calloc_list(NUM_CELLS, sizeof(int));
+	land_pos = grid_calloc_list(NUM_CELLS, sizeof(int));
+	if (*block_zone == NULL || *block_protected == NULL || land_cells == NULL || land_pos == NULL) {
+		fprintf(fplog, "Failed to allocate memory for the block-major zones: ltarea_block_zones()\n");
+		grid_free(land_cells);
+		grid_free(land_pos);
+		return ERROR_MEM;
+	}
+
+	// only the land cells are matched to zones, as the glu lists are made from the land cells
+	// land_mask_hyde is the hyde land in the processing window (see get_land_cells())
+	// the walk follows the top row of each lulc cell, so a band is released only when the whole row of lulc cells is done
+	band_walk_init(&walk, in_args);
+	for (p = 0; p < NUM_CELLS; p++) {
+		grid_ind = block_cells[p];
+		if (p % num_lu_cells == 0) {
+			band_walk_cell(&walk, grid_ind);
+		}
+		(*block_zone)[p] = NOMATCH;
+		(*block_protected)[p] = protected_thematic[grid_ind];
+		if (land_mask_hyde[grid_ind] == 1 && land_area_hyde[grid_ind] != 0) {
+			land_cells[num_land] = grid_ind;
+			land_pos[num_land++] = p;
+		}
+	}
+	band_walk_end(&walk);
+
+	if ((err = zonemap_init(&zones, in_args, land_cells, num_land, raster_info)) == OK) {
+		for (k = 0; k < num_land; k++) {
+			(*block_zone)[land_pos[k]] = zones.cell_zone[k];
+		}
+	} else {
+		fprintf(fplog, "Failed to find the zones of the land cells: ltarea_block_zones()\n");
+	}
+
+	zonemap_free(&zones);
+	grid_free(land_cells);
+	grid_free(land_pos);
+
+	return err;
+}
+
+/********
+ static int ltarea_spill_name(args_struct in_args, int year, char *fname)
+ the spill file name of a year: the output table name with the year and .tmp appended
+ fname:		set to the name; MAXCHAR long
+ return:	error code; a name that does not fit in MAXCHAR is an error
+ ********/
+static int ltarea_spill_name(args_struct in_args, int year, char *fname)
+{
+	if (snprintf(fname, MAXCHAR, "%s%s.%i.tmp", in_args.outpath, in_args.land_type_area_fname, year) >= MAXCHAR) {
+		fprintf(fplog, "Error: the spill file name of year %i is longer than %i characters: ltarea_spill_name()\n", year, MAXCHAR - 1);
+		return ERROR_FILE;
+	}
+	return OK;
+}
+
+/********
+ static int ltarea_spill_year(args_struct in_args, int year, float *year_area, int num_keys)
+ write the positive rounded values (ha) of one year to its spill file, in key order
+ year_area:	area (km^2) of each key
+ return:	error code
+ ********/
+static int ltarea_spill_year(args_struct in_args, int year, float *year_area, int num_keys)
+{
+	char fname[MAXCHAR];
+	FILE *fp;
+	ltarea_rec_struct rec;
+	int k;
+	int err = OK;
+	
+	if ((err = ltarea_spill_name(in_args, year, fname)) != OK) {
+		return err;
+	}
+	if ((fp = fopen(fname, "wb")) == NULL) {
+		fprintf(fplog, "Failed to open file %s: ltarea_spill_year()\n", fname);
+		return ERROR_FILE;
+	}
+	for (k = 0; k < num_keys; k++) {
+		rec.value = (float) floor((double) 0.5 + year_area[k] * KMSQ2HA);
+		if (rec.value > 0) {
+			rec.key = k;
+			fwrite(&rec, sizeof(ltarea_rec_struct), 1, fp);
+		}
+	}
+	if (ferror(fp)) {
+		err = ERROR_FILE;
+	}
+	if (fclose(fp) != 0 || err != OK) {
+		fprintf(fplog, "Failed to write file %s: ltarea_spill_year()\n", fname);
+		remove(fname);
+		return ERROR_FILE;
+	}
+	return OK;
+}
+
+/********
+ static int ltarea_open_spills(args_struct in_args, int *years, FILE **fp)
+ open the spill files of all years for reading
+ the files that are not open are NULL in fp, so ltarea_remove_spills() can close the open ones after an error
+ return:	error code
+ ********/
+static int ltarea_open_spills(args_struct in_args, int *years, FILE **fp)
+{
+	char fname[MAXCHAR];
+	int i;
+	
+	for (i = 0; i < NUM_HYDE_YEARS; i++) {
+		fp[i] = NULL;
+	}
+	for (i = 0; i < NUM_HYDE_YEARS; i++) {
+		if (ltarea_spill_name(in_args, years[i], fname) != OK) {
+			return ERROR_FILE;
+		}
+		if ((fp[i] = fopen(fname, "rb")) == NULL) {
+			fprintf(fplog, "Failed to open file %s: ltarea_open_spills()\n", fname);
+			return ERROR_FILE;
+		}
+	}
+	return OK;
+}
+
+/********
+ static int ltarea_read_block(FILE *fp, ltarea_rec_struct *head, int block_key, int num_keys, int year_ind, float *block_area)
+ read the records of one year for the keys block_key to block_key + num_keys - 1 into block_area
+ head:			the record read past the previous block, or key -1; set to the record read past this block
+ block_area:	dim1=key - block_key, dim2=year
+ return:		error code
+ ********/
+static int ltarea_read_block(FILE *fp, ltarea_rec_struct *head, int block_key, int num_keys, int year_ind, float *block_area)
+{
+	while (1) {
+		if (head->key < 0 && fread(head, sizeof(ltarea_rec_struct), 1, fp) != 1) {
+			head->key = -1;
+			return ferror(fp) ? ERROR_FILE : OK;
+		}
+		if (head->key >= block_key + num_keys) {
+			return OK;
+		}
+		if (head->key < block_key) {
+			fprintf(fplog, "Error: spill record %i is out of order: ltarea_read_block()\n", head->key);
+			return ERROR_IND;
+		}
+		block_area[(size_t) (head->key - block_key) * NUM_HYDE_YEARS + year_ind] = head->value;
+		head->key = -1;
+	}
+}
+
+/********
+ static void ltarea_remove_spills(args_struct in_args, int *years, int num_years, FILE **fp)
+ close and remove the spill files of the first num_years years
+ this is the cleanup after the merge, and after an error once a spill file has been written
+ fp:	the open spill files, or NULL if none are open; NULL entries are not open
+ ********/
+static void ltarea_remove_spills(args_struct in_args, int *years, int num_years, FILE **fp)
+{
+	char fname[MAXCHAR];
+	int i;
+	
+	for (i = 0; i < num_years; i++) {
+		if (fp != NULL && fp[i] != NULL) {
+			fclose(fp[i]);
+			fp[i] = NULL;
+		}
+		if (ltarea_spill_name(in_args, years[i], fname) == OK) {
+			remove(fname);
+		}
+	}
+}
+
 int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
     
     // valid values in the hyde land area data set determine the land cells to process
     
-    int i, j, k, m, n = 0;
+    int i, j, k, m = 0;
     int year_ind;               // the index for looping over the years
-    int grid_ind;               // the index within the 1d grid of the current land cell
     int rv_ind;                 // the index of the current reference veg land type
     int err = OK;				// store error code from the read/write functions
 	int count = 0;				// counting the working grid cells
@@ -98,10 +339,6 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 	int crop_ind = 1;		// index in lu_area of cropland values; may need to find these from an array
 	int pasture_ind = 2;	// index in lu_area of pasture values
 	
-    int scg_code = 186;         // fao code for serbia and montenegro
-    int srb_code = 272;         // fao code for serbia
-    int mne_code = 273;         // fao code for montenegro
-	
 	// hyde land use raster info
 	int ncols = raster_info.lu_ncols;				// num hyde lons
 	
@@ -114,28 +351,45 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
     float *urban_grid;  // 1d array to store current urban data; start up left corner, row by row; lon varies faster
 	float **lu_detail_grid;		// for the rest of the hyde types; dim1=hyde types, dim2=cells
 	float **lulc_temp_grid;		// lulc input area (km^2); dim 1 = land types; dim 2 = grid cells
+	lureadahead_struct lu_readahead;	// reads the hyde and lulc years, possibly ahead in the background (see lu_readahead.c)
+	luyear_struct *lu_year;		// the buffer of the current year; the grids above point into it
 	
 	// used to determine working grid cell indices
 	int num_split = 0;		// number of working grid cells in one dimension of one lulc cell
 	int num_lu_cells = 0;	// number of working grid cells in one lulc cell
-	int grid_y_ul;				// row for ul corner working grid cell in lulc cell
-	int grid_x_ul;				// col for ul corner working grid cell in lulc cell
-	double rem_dbl;				// used to get the remainder of a decimal number
-	double int_dbl;				// used to get the integer of a decimal number
+	int *block_cells;			// working grid index of each cell in block-major order (see ltarea_block_cells())
+	band_walk_struct walk;		// releases the bands of the working grids behind the loop over the lulc cells
+	int *block_zone;			// zone of each cell in block-major order; NOMATCH if the cell adds no area
+	uint8_t *block_protected;	// protected code of each cell in block-major order
+	uint8_t *block_land;		// 1 if the lulc cell has a hyde land cell in the processing window [ncells_lulc]
+	int block_base;				// block-major position of the first cell of the current lulc cell
+	int hyde_ind;				// index in the hyde grids of the current cell
+	int zone;					// zone of the current cell
+	int protected_code;			// protected code of the current cell
 	
 	float *lulc_area;		// array for the lulc areas per type for a single lulc cell
 	float **lu_area;		// array for the lu areas determined for each lulc cell; dim1=num_lu_cells, dim2 = NUM_HYDE_TYPES
-	int *lu_indices;		// array for the working grid indices for the lu cells for a single lulc cell
+	int *lu_indices;		// the working grid indices of the lu cells of the current lulc cell; points into block_cells
 	float *refveg_area_out;		// array for the reference veg areas in each working grid cell, for a single lulc cell
 	int *refveg_them;		// array for the reference veg tyep values in each working grid cell, for a single lulc cell
+	float *refveg_area_grid = NULL;	// working grid of refveg_area_out for the current year; diagnostic netcdf output only
+	int *refveg_them_grid = NULL;	// working grid of refveg_them for the current year; diagnostic netcdf output only
+	char diag_name[MAXCHAR];	// for diagnostic output names
     
-    float ****area_out;		// output table as 4-d array
+    int *zone_start;		// index of the first glu of each country in the zone list [NUM_FAO_CTRY + 1]
+    int num_zones;			// number of country X glu zones
+    int zone_base;			// index in year_area of the first land type of the current zone
+    float *year_area;		// the current year's area (km^2); dim1=zone, dim2=land type category
+    FILE *spill_fp[NUM_HYDE_YEARS];			// the spill file of each year
+    ltarea_rec_struct spill_head[NUM_HYDE_YEARS];	// the next unused record of each spill file; key -1 if none
+    float *block_area;		// rounded output values (ha) of a block of countries; dim1=zone X land type, dim2=year
+    int max_block_zones;	// the most zones in a block of countries
+    int block_key;			// the first zone X land type key of the current block
+    int block_num_keys;		// the number of keys in the current block
+    int ctry_end;			// the country index after the current block
     float outval;           // the integer value to output
     int rv_value;           // the reference veg value for the current land type category
 	
-	int lulc_year;			// current lulc year to read
-    int aez_val;            // current aez value
-    int ctry_code;          // current fao country code
     int aez_ind;            // current aez index in ctry_aez_list[ctry_ind]
     int ctry_ind;           // current country index in ctry_aez_list
     int cur_lt_cat;         // current land type category
@@ -151,9 +405,13 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
     int hyde_years[NUM_HYDE_YEARS]; // the years in the hyde historical lu files
    
     char fname[MAXCHAR];        // current file name to write
-    FILE *fpout;                // out file pointer
-    
-    double tmp_dbl;
+    csvout_struct out;          // buffered output file
+    csvout_struct *chunks;      // records formatted in parallel, one chunk per country in a block of countries
+    int num_chunks = 1;         // number of countries formatted at once
+    int chunk_ind;              // the index of the current chunk
+    int ctry_start;             // the first country index in the current block
+    coltab_struct tab;          // columnar copy of the table, if out_columnar
+    int tab_keys[4];            // keys of one record for the columnar copy
     
     // create the array of available years
     hyde_years[0] = HYDE_START_YEAR;
@@ -172,48 +430,6 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 	
     // allocate arrays
     
-    crop_grid = calloc(NUM_CELLS, sizeof(float));
-    if(crop_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for crop_grid: proc_land_type_area()\n");
-        return ERROR_MEM;
-    }
-    pasture_grid = calloc(NUM_CELLS, sizeof(float));
-    if(pasture_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for pasture_grid: proc_land_type_area()\n");
-        return ERROR_MEM;
-    }
-    urban_grid = calloc(NUM_CELLS, sizeof(float));
-    if(urban_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for urban_grid: proc_land_type_area()\n");
-        return ERROR_MEM;
-    }
-	
-	lu_detail_grid = calloc(NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN, sizeof(float*));
-	if(lu_detail_grid == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lu_detail_grid: proc_land_type_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
-		lu_detail_grid[i] = calloc(NUM_CELLS, sizeof(float));
-		if(lu_detail_grid[i] == NULL) {
-			fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lu_detail_grid[%i]: proc_land_type_area()\n", get_systime(), ERROR_MEM, i);
-			return ERROR_MEM;
-		}
-	}
-	
-	lulc_temp_grid = calloc(NUM_LULC_TYPES, sizeof(float*));
-	if(lulc_temp_grid == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lulc_temp_grid: proc_land_type_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	for (i = 0; i < NUM_LULC_TYPES; i++) {
-		lulc_temp_grid[i] = calloc(NUM_CELLS_LULC, sizeof(float));
-		if(lulc_temp_grid[i] == NULL) {
-			fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lulc_temp_grid[%i]: proc_land_type_area()\n", get_systime(), ERROR_MEM, i);
-			return ERROR_MEM;
-		}
-	}
-	
 	// for proc_lulc_area
 	lulc_area = calloc(NUM_LULC_TYPES, sizeof(float));
 	if(lulc_area == NULL) {
@@ -232,11 +448,15 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 			return ERROR_MEM;
 		}
 	}
-	lu_indices = calloc(num_lu_cells, sizeof(int));
-	if(lu_indices == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lu_indices: proc_land_type_area()\n", get_systime(), ERROR_MEM);
+	block_cells = grid_calloc(NUM_CELLS, sizeof(int));
+	if(block_cells == NULL) {
+		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for block_cells: proc_land_type_area()\n", get_systime(), ERROR_MEM);
 		return ERROR_MEM;
 	}
+	if ((err = ltarea_block_cells(ncols_lulc, ncells_lulc, num_split, block_cells)) != OK) {
+		fprintf(fplog, "Failed to order the working grid cells by lulc cell: proc_land_type_area()\n");
+		return err;
+	}
 	refveg_area_out = calloc(num_lu_cells, sizeof(float));
 	if(refveg_area_out == NULL) {
 		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_area_out: proc_land_type_area()\n", get_systime(), ERROR_MEM);
@@ -247,34 +467,56 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_them: proc_land_type_area()\n", get_systime(), ERROR_MEM);
 		return ERROR_MEM;
 	}
+	// the per-year ref veg grids are written only as compressed netcdf, because there is a pair for every hyde year
+	if (in_args.diagnostics && in_args.out_nc_grids) {
+		refveg_area_grid = grid_calloc(NUM_CELLS, sizeof(float));
+		if(refveg_area_grid == NULL) {
+			fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_area_grid: proc_land_type_area()\n", get_systime(), ERROR_MEM);
+			return ERROR_MEM;
+		}
+		refveg_them_grid = grid_calloc(NUM_CELLS, sizeof(int));
+		if(refveg_them_grid == NULL) {
+			fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_them_grid: proc_land_type_area()\n", get_systime(), ERROR_MEM);
+			return ERROR_MEM;
+		}
+	}
 	
 	// output
-    area_out = calloc(NUM_FAO_CTRY, sizeof(float***));
-    if(area_out == NULL) {
-        fprintf(fplog,"Failed to allocate memory for area_out: proc_land_type_area()\n");
-        return ERROR_MEM;
-    }
-    for (i = 0; i < NUM_FAO_CTRY; i++) {
-        area_out[i] = calloc(ctry_aez_num[i], sizeof(float**));
-        if(area_out[i] == NULL) {
-            fprintf(fplog,"Failed to allocate memory for area_out[%i]: proc_land_type_area()\n", i);
-            return ERROR_MEM;
-        }
-        for (j = 0; j < ctry_aez_num[i]; j++) {
-            area_out[i][j] = calloc(num_lt_cats, sizeof(float*));
-            if(area_out[i][j] == NULL) {
-                fprintf(fplog,"Failed to allocate memory for area_out[%i][%i]: proc_land_type_area()\n", i, j);
-                return ERROR_MEM;
-            }
-            for (k = 0; k < num_lt_cats; k++) {
-                area_out[i][j][k] = calloc(NUM_HYDE_YEARS, sizeof(float));
-                if(area_out[i][j][k] == NULL) {
-                    fprintf(fplog,"Failed to allocate memory for area_out[%i][%i][%i]: proc_land_type_area()\n", i, j, k);
-                    return ERROR_MEM;
-                }
-            } // end for k loop over land type categories
-        } // end for j loop over aezs
-    } // end for i loop over fao country
+	// only the current year is kept; each year's records go to a spill file when the year is done
+	//  and the spill files are merged into the output table after the last year
+	zone_start = calloc(NUM_FAO_CTRY + 1, sizeof(int));
+	if(zone_start == NULL) {
+		fprintf(fplog,"Failed to allocate memory for zone_start: proc_land_type_area()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i < NUM_FAO_CTRY; i++) {
+		zone_start[i + 1] = zone_start[i] + ctry_aez_num[i];
+	}
+	num_zones = zone_start[NUM_FAO_CTRY];
+	// the zones, land and protected status of the cells do not change with the year
+	if ((err = ltarea_block_zones(in_args, raster_info, block_cells, num_lu_cells, &block_zone, &block_protected)) != OK) {
+		fprintf(fplog, "Failed to find the zones of the working grid cells: proc_land_type_area()\n");
+		return err;
+	}
+	// the lulc cells without land in the window (land_mask_hyde) are skipped in every year
+	block_land = calloc(ncells_lulc, sizeof(uint8_t));
+	if(block_land == NULL) {
+		fprintf(fplog,"Failed to allocate memory for block_land: proc_land_type_area()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i < ncells_lulc; i++) {
+		for (j = i * num_lu_cells; j < (i + 1) * num_lu_cells; j++) {
+			if (land_mask_hyde[block_cells[j]] == 1) {
+				block_land[i] = 1;
+				break;
+			}
+		}
+	}
+	year_area = calloc((size_t) num_zones * num_lt_cats + 1, sizeof(float));
+	if(year_area == NULL) {
+		fprintf(fplog,"Failed to allocate memory for year_area: proc_land_type_area()\n");
+		return ERROR_MEM;
+	}
 	
 	// for tracking global area
 	global_lt_out = calloc(NUM_SAGE_PVLT + 1 + NUM_HYDE_TYPES, sizeof(float));
@@ -288,6 +530,17 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 		return ERROR_MEM;
 	}
 	
+	// the hyde land use and lulc data of each year; the next years may be read in the background
+	// every return from the year loop frees the reader, which stops the background thread,
+	//  and removes the spill files of the years before the current one
+	// with hyde_block_major the reader delivers the hyde grids in block-major order
+	if((err = lureadahead_init(&lu_readahead, in_args, raster_info, hyde_years, NUM_HYDE_YEARS,
+							   (in_args.hyde_block_major) ? block_cells : NULL)) != OK)
+	{
+		fprintf(fplog, "Failed to set up reading the hyde and lulc years: proc_land_type_area()\n");
+		return err;
+	}
+	
     // process each year
     for (year_ind = 0; year_ind < NUM_HYDE_YEARS; year_ind++) {
 
@@ -295,37 +548,43 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 			fprintf(fplog, "\nYear %i: proc_land_type_area()\n", hyde_years[year_ind]);
 		}
 		
-		// first read in the appropriate hyde land use area data
-		if((err = read_hyde32(in_args, &raster_info, hyde_years[year_ind], crop_grid, pasture_grid, urban_grid, lu_detail_grid)) != OK)
+		// get the appropriate hyde land use area data and lulc data
+		if((err = lureadahead_get(&lu_readahead, year_ind, &lu_year)) != OK)
 		{
-			fprintf(fplog, "Failed to read lu hyde data for year %i: proc_land_type_area()\n", hyde_years[year_ind]);
+			fprintf(fplog, "Failed to read lu hyde and lulc data for year %i: proc_land_type_area()\n", hyde_years[year_ind]);
+			lureadahead_free(&lu_readahead);
+			ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
 			return err;
 		}
+		crop_grid = lu_year->crop_grid;
+		pasture_grid = lu_year->pasture_grid;
+		urban_grid = lu_year->urban_grid;
+		lu_detail_grid = lu_year->lu_detail_grid;
+		lulc_temp_grid = lu_year->lulc_grid;
 		
-		// read the appropriate lulc data
-		if (hyde_years[year_ind] < LULC_START_YEAR) {
-			lulc_year = LULC_START_YEAR;
-		} else {
-			lulc_year = hyde_years[year_ind];
-		}
-		if((err = read_lulc_isam(in_args, lulc_year, lulc_temp_grid)) != OK)
-		{
-			fprintf(fplog, "Failed to read lulc data for year %i: proc_land_type_area()\n", lulc_year);
-			return err;
-		}
+		memset(year_area, 0, (size_t) num_zones * num_lt_cats * sizeof(float));
 		
 		// initialize the diagnostic tracking arrays
 		for (j = 0; j < NUM_SAGE_PVLT + 1 + NUM_HYDE_TYPES; j++) {
 			global_lt_out[j] = 0;
 			global_lulc_in[j] = 0;
 		}
+		if (refveg_area_grid != NULL) {
+			for (j = 0; j < NUM_CELLS; j++) {
+				refveg_area_grid[j] = NODATA;
+				refveg_them_grid[j] = NODATA;
+			}
+		}
 		
 		// loop over the coarse lulc data
+		// the walk follows the top row of each lulc cell and releases the bands of the working grids behind it
+		band_walk_init(&walk, in_args);
 		for (i = 0; i < ncells_lulc; i++) {
 			
 			//if (in_args.diagnostics) {
 			//	fprintf(fplog, "\nLULC cell %i: proc_land_type_area()\n", i);
 			//}
+			band_walk_cell(&walk, block_cells[i * num_lu_cells]);
 			
 			if (i == 58776) {
     			;
@@ -350,223 +609,146 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 				}
 			}
 			
-			// determine the working grid 1d indices of the lu cells in this lulc cell
-			// first get the upper left corner pixel in terms of rows and columns
-			rem_dbl = fmod((double) i, (double) ncols_lulc);
-			modf((double) (i / ncols_lulc), &int_dbl);
-			grid_y_ul = (int) int_dbl * (num_split);
-			grid_x_ul = (int) rem_dbl * (num_split);
-			// now loop over the working grid cells to store the 1d indices and input areas, and initialize ref veg values
-			count = 0;
-			for (m = grid_y_ul; m < grid_y_ul + num_split; m++) {
-				for (n = grid_x_ul; n < grid_x_ul + num_split; n++) {
-					if (m == 490 && n == 2740) {
-						;
-					}
-					lu_indices[count] = m * NUM_LON + n;
-					temp_flt = urban_grid[lu_indices[count]];
-					lu_area[count][urban_ind] = urban_grid[lu_indices[count]];
-					temp_flt = crop_grid[lu_indices[count]];
-					lu_area[count][crop_ind] = crop_grid[lu_indices[count]];
-					temp_flt = pasture_grid[lu_indices[count]];
-					lu_area[count][pasture_ind] = pasture_grid[lu_indices[count]];
-					for (j = NUM_HYDE_TYPES_MAIN; j < NUM_HYDE_TYPES; j++) {
-						temp_flt = lu_detail_grid[j-NUM_HYDE_TYPES_MAIN][lu_indices[count]];
-						lu_area[count][j] = lu_detail_grid[j-NUM_HYDE_TYPES_MAIN][lu_indices[count]];
-					}
-					refveg_area_out[count] = 0;
-					refveg_them[count] = 0;
-					count++;
-				} // end for n loop over the columns to set
-			} // end for m loop over the rows to set
-			if (count != num_lu_cells) {
-				fprintf(fplog, "Failed to get working grid indices for lulc cell %i for reference year: proc_land_type_area()\n", i);
-				return err;
+			// skip the lulc cells without land in the processing window; they add no area
+			if (!block_land[i]) {
+				continue;
 			}
+			// the working grid cells of this lulc cell, in block-major order
+			block_base = i * num_lu_cells;
+			lu_indices = &block_cells[block_base];
+			// now loop over the working grid cells to store the input areas, and initialize ref veg values
+			for (count = 0; count < num_lu_cells; count++) {
+				hyde_ind = (lu_year->block_major) ? block_base + count : lu_indices[count];
+				lu_area[count][urban_ind] = urban_grid[hyde_ind];
+				lu_area[count][crop_ind] = crop_grid[hyde_ind];
+				lu_area[count][pasture_ind] = pasture_grid[hyde_ind];
+				for (j = NUM_HYDE_TYPES_MAIN; j < NUM_HYDE_TYPES; j++) {
+					lu_area[count][j] = lu_detail_grid[j-NUM_HYDE_TYPES_MAIN][hyde_ind];
+				}
+				refveg_area_out[count] = 0;
+				refveg_them[count] = 0;
+			} // end for count loop over the working grid cells
 			
 			// calculate the areas for this lulc cell
 			// this keeps the hyde land use (but checks it for land consistency), and disaggregates the lc data to the non-lu cell area
 			if ((err = proc_lulc_area(in_args, raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them, num_lu_cells)) != OK)
 			{
 				fprintf(fplog, "Failed to process lulc cell %i for reference year: proc_land_type_area()\n", i);
+				lureadahead_free(&lu_readahead);
+				ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
 				return err;
 			}
+			if (refveg_area_grid != NULL) {
+				for (j = 0; j < num_lu_cells; j++) {
+					refveg_area_grid[lu_indices[j]] = refveg_area_out[j];
+					refveg_them_grid[lu_indices[j]] = refveg_them[j];
+				}
+			}
 			
 			// add data to output array as appropriate
 			// don't need to store the updated grid data at all in the read in grids
 			for (j = 0; j < num_lu_cells; j++) {
-				grid_ind = lu_indices[j];
-				// process only if there is land area
-				// also skip if not a valid economic country
-				if (land_area_hyde[grid_ind] != raster_info.land_area_hyde_nodata && land_area_hyde[grid_ind] != 0) {
+				// process only if there is land area, a glu, and a valid economic country (see ltarea_block_zones())
+				zone = block_zone[block_base + j];
+				if (zone != NOMATCH) {
 					
-					aez_val = aez_bounds_new[grid_ind];
-					ctry_code = country_fao[grid_ind];
+					protected_code = block_protected[block_base + j];
+					zone_base = zone * num_lt_cats;
 					
-					if (aez_val != raster_info.aez_new_nodata) {
-						// get the fao country index
-						ctry_ind = NOMATCH;
-						for (m = 0; m < NUM_FAO_CTRY; m++) {
-							if (countrycodes_fao[m] == ctry_code) {
-								ctry_ind = m;
-								break;
-							}
-						} // end for m loop to get ctry index
-						
-						// merge serbia and montenegro for scg record
-						if (ctry_code == mne_code || ctry_code == srb_code) {
-							ctry_code = scg_code;
-							ctry_ind = NOMATCH;
-							for (m = 0; m < NUM_FAO_CTRY; m++) {
-								if (countrycodes_fao[m] == ctry_code) {
-									ctry_ind = m;
-									break;
-								}
-							}
-							if (ctry_ind == NOMATCH) {
-								// this should never happen
-								fprintf(fplog, "Error finding scg ctry index: proc_land_type_area()\n");
-								return ERROR_IND;
-							}
-						} // end if serbia or montenegro
-						
-						// skip if not a valid economic country
-						if (ctry_ind == NOMATCH || ctry2ctry87codes_gtap[ctry_ind] == NOMATCH) {
-							continue;
-						}
-						
-						// get the glu index within the country aez list
-						aez_ind = NOMATCH;
-						for (m = 0; m < ctry_aez_num[ctry_ind]; m++) {
-							if (ctry_aez_list[ctry_ind][m] == aez_val) {
-								aez_ind = m;
-								break;
-							}
-						} // end for m loop to get aez index
-						
-						// this shouldn't happen because the countryXglu list has been made already
-						if (aez_ind == NOMATCH) {
-							fprintf(fplog, "Failed to match glu %i to country %i: proc_land_type_area()\n",aez_val,ctry_code);
-							return ERROR_IND;
-						}
-						
-						// generate the land type category and add/store the area
-						
-						// get index of ref veg to make sure it is valid
-						rv_ind = NOMATCH;
-						for (m = 0; m < NUM_SAGE_PVLT; m++) {
-							if (refveg_them[j] == landtypecodes_sage[m]) {
-								rv_ind = m;
-								break;
-							}
-						}
-						
-						// if no ref veg cat, then use the unknown value of 0, otherwise set it to the grid value
-						if (rv_ind == NOMATCH) {
-							rv_value = 0;
-						} else {
-							rv_value = refveg_them[j];
-						}
-						
-						// reference veg; i.e. non-crop, non-pasture, non-urban
-						cur_lt_cat = rv_value * SCALE_POTVEG + protected_thematic[grid_ind];
-						cur_lt_cat_ind = NOMATCH;
-						for (m = 0; m < num_lt_cats; m++) {
-							if (lt_cats[m] == cur_lt_cat) {
-								cur_lt_cat_ind = m;
-								break;
-							}
-						}
-						if (cur_lt_cat_ind == NOMATCH) {
-							fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
-							return ERROR_IND;
-						}
-						if (refveg_area_out[j] != NODATA) { // don't add if NODATA
-							temp_flt = refveg_area_out[j];
-							area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] = area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] +	refveg_area_out[j];
-							// sum the global out land type area
-							// use the rv values as the index to capture the unknown value of zero
-							global_lt_out[rv_value] = global_lt_out[rv_value] + refveg_area_out[j];
-						}
-						
-						// crop
-						cur_lt_cat = rv_value * SCALE_POTVEG + CROP_LT_CODE + protected_thematic[grid_ind];
-						cur_lt_cat_ind = NOMATCH;
-						for (m = 0; m < num_lt_cats; m++) {
-							if (lt_cats[m] == cur_lt_cat) {
-								cur_lt_cat_ind = m;
-								break;
-							}
-						}
-						if (cur_lt_cat_ind == NOMATCH) {
-							fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
-							return ERROR_IND;
-						}
-						if (lu_area[j][crop_ind] != raster_info.lu_nodata) { // don't add if nodata
-							temp_flt = lu_area[j][crop_ind];
-							area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] = area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] + lu_area[j][crop_ind];
-							// sum the global out land type area
-							// sage types plus one are first, then hyde types
-							global_lt_out[crop_ind + NUM_SAGE_PVLT + 1] = global_lt_out[crop_ind + NUM_SAGE_PVLT + 1] + lu_area[j][crop_ind];
-						}
-						
-						// pasture
-						cur_lt_cat = rv_value * SCALE_POTVEG + PASTURE_LT_CODE + protected_thematic[grid_ind];
-						cur_lt_cat_ind = NOMATCH;
-						for (m = 0; m < num_lt_cats; m++) {
-							if (lt_cats[m] == cur_lt_cat) {
-								cur_lt_cat_ind = m;
-								break;
-							}
-						}
-						if (cur_lt_cat_ind == NOMATCH) {
-							fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
-							return ERROR_IND;
-						}
-						if (lu_area[j][pasture_ind] != raster_info.lu_nodata) { // don't add if nodata
-							temp_flt = lu_area[j][pasture_ind];
-							area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] = area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] + lu_area[j][pasture_ind];
-							// sum the global out land type area
-							// sage types plus one are first, then hyde types
-							global_lt_out[pasture_ind + NUM_SAGE_PVLT + 1] = global_lt_out[pasture_ind + NUM_SAGE_PVLT + 1] + lu_area[j][pasture_ind];
-						}
-						
-						// urban
-						cur_lt_cat = rv_value * SCALE_POTVEG + URBAN_LT_CODE + protected_thematic[grid_ind];
-						cur_lt_cat_ind = NOMATCH;
-						for (m = 0; m < num_lt_cats; m++) {
-							if (lt_cats[m] == cur_lt_cat) {
-								cur_lt_cat_ind = m;
-								break;
-							}
-						}
-						if (cur_lt_cat_ind == NOMATCH) {
-							fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
-							return ERROR_IND;
-						}
-						if (lu_area[j][urban_ind] != raster_info.lu_nodata) { // don't add if nodata
-							temp_flt = lu_area[j][urban_ind];
-							area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] = area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] + lu_area[j][urban_ind];
-							// sum the global out land type area
-							// sage types plus one are first, then hyde types
-							global_lt_out[urban_ind + NUM_SAGE_PVLT + 1] = global_lt_out[urban_ind + NUM_SAGE_PVLT + 1] + lu_area[j][urban_ind];
-						}
-						
-						// sum the detailed lu categories also
-						for (m = NUM_HYDE_TYPES_MAIN; m < NUM_HYDE_TYPES; m++) {
-							temp_flt = lu_area[j][m];
-							if (lu_area[j][m] != raster_info.lu_nodata) { // don't add if nodata
-								global_lt_out[m + NUM_SAGE_PVLT + 1] = global_lt_out[m + NUM_SAGE_PVLT + 1] + lu_area[j][m];
-							}
+					// generate the land type category and add/store the area
+					
+					// get index of ref veg to make sure it is valid
+					rv_ind = POTVEG_IND(refveg_them[j]);
+					
+					// if no ref veg cat, then use the unknown value of 0, otherwise set it to the grid value
+					if (rv_ind == NOMATCH) {
+						rv_value = 0;
+					} else {
+						rv_value = refveg_them[j];
+					}
+					
+					// reference veg; i.e. non-crop, non-pasture, non-urban
+					cur_lt_cat = rv_value * SCALE_POTVEG + protected_code;
+					cur_lt_cat_ind = LT_CAT_IND(cur_lt_cat);
+					if (cur_lt_cat_ind == NOMATCH) {
+						fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
+						lureadahead_free(&lu_readahead);
+						ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+						return ERROR_IND;
+					}
+					if (refveg_area_out[j] != NODATA) { // don't add if NODATA
+						temp_flt = refveg_area_out[j];
+						year_area[zone_base + cur_lt_cat_ind] = year_area[zone_base + cur_lt_cat_ind] + refveg_area_out[j];
+						// sum the global out land type area
+						// use the rv values as the index to capture the unknown value of zero
+						global_lt_out[rv_value] = global_lt_out[rv_value] + refveg_area_out[j];
+					}
+					
+					// crop
+					cur_lt_cat = rv_value * SCALE_POTVEG + CROP_LT_CODE + protected_code;
+					cur_lt_cat_ind = LT_CAT_IND(cur_lt_cat);
+					if (cur_lt_cat_ind == NOMATCH) {
+						fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
+						lureadahead_free(&lu_readahead);
+						ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+						return ERROR_IND;
+					}
+					if (lu_area[j][crop_ind] != raster_info.lu_nodata) { // don't add if nodata
+						temp_flt = lu_area[j][crop_ind];
+						year_area[zone_base + cur_lt_cat_ind] = year_area[zone_base + cur_lt_cat_ind] + lu_area[j][crop_ind];
+						// sum the global out land type area
+						// sage types plus one are first, then hyde types
+						global_lt_out[crop_ind + NUM_SAGE_PVLT + 1] = global_lt_out[crop_ind + NUM_SAGE_PVLT + 1] + lu_area[j][crop_ind];
+					}
+					
+					// pasture
+					cur_lt_cat = rv_value * SCALE_POTVEG + PASTURE_LT_CODE + protected_code;
+					cur_lt_cat_ind = LT_CAT_IND(cur_lt_cat);
+					if (cur_lt_cat_ind == NOMATCH) {
+						fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
+						lureadahead_free(&lu_readahead);
+						ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+						return ERROR_IND;
+					}
+					if (lu_area[j][pasture_ind] != raster_info.lu_nodata) { // don't add if nodata
+						temp_flt = lu_area[j][pasture_ind];
+						year_area[zone_base + cur_lt_cat_ind] = year_area[zone_base + cur_lt_cat_ind] + lu_area[j][pasture_ind];
+						// sum the global out land type area
+						// sage types plus one are first, then hyde types
+						global_lt_out[pasture_ind + NUM_SAGE_PVLT + 1] = global_lt_out[pasture_ind + NUM_SAGE_PVLT + 1] + lu_area[j][pasture_ind];
+					}
+					
+					// urban
+					cur_lt_cat = rv_value * SCALE_POTVEG + URBAN_LT_CODE + protected_code;
+					cur_lt_cat_ind = LT_CAT_IND(cur_lt_cat);
+					if (cur_lt_cat_ind == NOMATCH) {
+						fprintf(fplog, "Failed to match lt_cat %i: proc_land_type_area()\n", cur_lt_cat);
+						lureadahead_free(&lu_readahead);
+						ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+						return ERROR_IND;
+					}
+					if (lu_area[j][urban_ind] != raster_info.lu_nodata) { // don't add if nodata
+						temp_flt = lu_area[j][urban_ind];
+						year_area[zone_base + cur_lt_cat_ind] = year_area[zone_base + cur_lt_cat_ind] + lu_area[j][urban_ind];
+						// sum the global out land type area
+						// sage types plus one are first, then hyde types
+						global_lt_out[urban_ind + NUM_SAGE_PVLT + 1] = global_lt_out[urban_ind + NUM_SAGE_PVLT + 1] + lu_area[j][urban_ind];
+					}
+					
+					// sum the detailed lu categories also
+					for (m = NUM_HYDE_TYPES_MAIN; m < NUM_HYDE_TYPES; m++) {
+						temp_flt = lu_area[j][m];
+						if (lu_area[j][m] != raster_info.lu_nodata) { // don't add if nodata
+							global_lt_out[m + NUM_SAGE_PVLT + 1] = global_lt_out[m + NUM_SAGE_PVLT + 1] + lu_area[j][m];
 						}
-						
-					} // end if valid glu cell
+					}
 					
-				} // end if valid land area
+				} // end if valid zone cell
 				
 			} // end for j loop over the lu cells to store
 			
 		} // end for i loop over the lulc cells
+		band_walk_end(&walk);
 		
 		if (in_args.diagnostics) {
 			// write the global area check to the log file
@@ -594,73 +776,210 @@ int proc_land_type_area(args_struct in_args, rinfo_struct raster_info) {
 			fprintf(fplog, "Global land area: out =\t%f;\tin =\t%f\n", global_area_out, global_area_in);
 		}
 		
+		if (refveg_area_grid != NULL) {
+			sprintf(diag_name, "refveg_area_%i.bil", hyde_years[year_ind]);
+			if ((err = write_raster_float(refveg_area_grid, NUM_CELLS, diag_name, in_args))) {
+				fprintf(fplog, "Error writing file %s: proc_land_type_area()\n", diag_name);
+				lureadahead_free(&lu_readahead);
+				ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+				return err;
+			}
+			sprintf(diag_name, "refveg_thematic_%i.bil", hyde_years[year_ind]);
+			if ((err = write_raster_int(refveg_them_grid, NUM_CELLS, diag_name, in_args))) {
+				fprintf(fplog, "Error writing file %s: proc_land_type_area()\n", diag_name);
+				lureadahead_free(&lu_readahead);
+				ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+				return err;
+			}
+		}
+		
+		// write this year's records (convert to ha and round to nearest integer)
+		if ((err = ltarea_spill_year(in_args, hyde_years[year_ind], year_area, num_zones * num_lt_cats)) != OK) {
+			fprintf(fplog, "Failed to write the records of year %i: proc_land_type_area()\n", hyde_years[year_ind]);
+			lureadahead_free(&lu_readahead);
+			ltarea_remove_spills(in_args, hyde_years, year_ind, NULL);
+			return err;
+		}
+		
+		// the reader can now use this year's buffer for a later year
+		lureadahead_release(&lu_readahead, year_ind);
+		
     } // end for year_ind loop over the years
     
+    lureadahead_free(&lu_readahead);
+    
     // write the output file
+    // the year spill files are merged a block of countries at a time, so the table has the same order as before:
+    //  iso, then glu, then land type, then year
+    
+    if ((err = ltarea_open_spills(in_args, hyde_years, spill_fp)) != OK) {
+        fprintf(fplog,"Failed to open the year records:  proc_land_type_area()\n");
+        ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+        return err;
+    }
+    for (year_ind = 0; year_ind < NUM_HYDE_YEARS; year_ind++) {
+        spill_head[year_ind].key = -1;
+    }
     
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.land_type_area_fname);
-    fpout = fopen(fname,"w"); //float
-    if(fpout == NULL)
+    if((err = csvout_open(fname, &out)) != OK)
     {
         fprintf(fplog,"Failed to open file  %s for write:  proc_land_type_area()\n", fname);
-        return ERROR_FILE;
+        ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+        return err;
     }
     // write header lines
-    fprintf(fpout,"# File: %s\n", fname);
-    fprintf(fpout,"# Author: %s\n", CODENAME);
-    fprintf(fpout,"# Description: area (ha) for land cells in country X glu X land type X protected category X year\n");
-    fprintf(fpout,"# Original source: hyde land use areas; reference veg; land cover; country raster; glu raster; hyde land area\n");
-    fprintf(fpout,"# ----------\n");
-    fprintf(fpout,"iso,glu_code,land_type,year,value");
+    csvout_printf(&out,"# File: %s\n", fname);
+    csvout_printf(&out,"# Author: %s\n", CODENAME);
+    csvout_str(&out,"# Description: area (ha) for land cells in country X glu X land type X protected category X year\n");
+    csvout_str(&out,"# Original source: hyde land use areas; reference veg; land cover; country raster; glu raster; hyde land area\n");
+    csvout_str(&out,"# ----------\n");
+    csvout_str(&out,"iso,glu_code,land_type,year,value");
     
-    // write the records (convert to ha and round to nearest integer)
-    for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY ; ctry_ind++) {
-        for (aez_ind = 0; aez_ind < ctry_aez_num[ctry_ind]; aez_ind++) {
-            for (cur_lt_cat_ind = 0; cur_lt_cat_ind < num_lt_cats; cur_lt_cat_ind++) {
-                for (year_ind = 0; year_ind < NUM_HYDE_YEARS; year_ind++) {
-                    tmp_dbl = area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind];
-                    outval = (float) floor((double) 0.5 + area_out[ctry_ind][aez_ind][cur_lt_cat_ind][year_ind] * KMSQ2HA);
-                    // output only positive values
-                    if (outval > 0) {
-                        fprintf(fpout,"\n%s,%i,%i,%i,%.0f", countryabbrs_iso[ctry_ind], ctry_aez_list[ctry_ind][aez_ind],
-                                lt_cats[cur_lt_cat_ind], hyde_years[year_ind], outval);
-                        nrecords++;
-                    } // end if value is positive
-                } // end for year loop
-            } // end for land type loop
-        } // end for aez loop
-    } // end for country loop
+    if (in_args.out_columnar) {
+        if ((err = coltab_init(&tab, fname, "area (ha) for land cells in country X glu X land type X protected category X year", "value", "ha", 4)) != OK) {
+            fprintf(fplog,"Failed to initialize columnar table for %s: proc_land_type_area()\n", fname);
+            ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+            return err;
+        }
+        coltab_key(&tab, 0, "iso", countryabbrs_iso, NUM_FAO_CTRY);
+        coltab_key(&tab, 1, "glu_code", NULL, 0);
+        coltab_key(&tab, 2, "land_type", NULL, 0);
+        coltab_key(&tab, 3, "year", NULL, 0);
+    }
     
-    fclose(fpout);
+    // this is the largest table, so the records of a block of countries are formatted in parallel
+    //  and the chunks are then appended in country order, so the file does not depend on the number of threads
+#ifdef _OPENMP
+    num_chunks = omp_get_max_threads();
+#endif
+    chunks = calloc(num_chunks, sizeof(csvout_struct));
+    if(chunks == NULL) {
+        fprintf(fplog,"Failed to allocate memory for chunks:  proc_land_type_area()\n");
+        ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+        return ERROR_MEM;
+    }
+    for (chunk_ind = 0; chunk_ind < num_chunks; chunk_ind++) {
+        csvout_chunk(&chunks[chunk_ind], fname);
+    }
+    // the rounded values of a block of countries, with year varying fastest
+    max_block_zones = 0;
+    for (ctry_start = 0; ctry_start < NUM_FAO_CTRY; ctry_start = ctry_start + num_chunks) {
+        ctry_end = (ctry_start + num_chunks < NUM_FAO_CTRY) ? ctry_start + num_chunks : NUM_FAO_CTRY;
+        if (zone_start[ctry_end] - zone_start[ctry_start] > max_block_zones) {
+            max_block_zones = zone_start[ctry_end] - zone_start[ctry_start];
+        }
+    }
+    block_area = calloc((size_t) max_block_zones * num_lt_cats * NUM_HYDE_YEARS + 1, sizeof(float));
+    if(block_area == NULL) {
+        fprintf(fplog,"Failed to allocate memory for block_area:  proc_land_type_area()\n");
+        ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+        return ERROR_MEM;
+    }
     
-    fprintf(fplog, "Wrote file %s: proc_land_type_area(); records written=%i\n", fname, nrecords);
-	
-    free(crop_grid);
-    free(pasture_grid);
-    free(urban_grid);
-    for (i = 0; i < NUM_FAO_CTRY; i++) {
-        for (j = 0; j < ctry_aez_num[i]; j++) {
-            for (k = 0; k < num_lt_cats; k++) {
-                free(area_out[i][j][k]);
+    // write the records
+    for (ctry_start = 0; ctry_start < NUM_FAO_CTRY; ctry_start = ctry_start + num_chunks) {
+        ctry_end = (ctry_start + num_chunks < NUM_FAO_CTRY) ? ctry_start + num_chunks : NUM_FAO_CTRY;
+        block_key = zone_start[ctry_start] * num_lt_cats;
+        block_num_keys = (zone_start[ctry_end] - zone_start[ctry_start]) * num_lt_cats;
+        memset(block_area, 0, (size_t) block_num_keys * NUM_HYDE_YEARS * sizeof(float));
+        for (year_ind = 0; year_ind < NUM_HYDE_YEARS; year_ind++) {
+            if ((err = ltarea_read_block(spill_fp[year_ind], &spill_head[year_ind], block_key, block_num_keys,
+                                         year_ind, block_area)) != OK) {
+                fprintf(fplog,"Failed to read the records of year %i:  proc_land_type_area()\n", hyde_years[year_ind]);
+                ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+                return err;
+            }
+        }
+        
+#pragma omp parallel for schedule(dynamic) private(ctry_ind, aez_ind, cur_lt_cat_ind, year_ind, outval, k) reduction(+:nrecords)
+        for (chunk_ind = 0; chunk_ind < num_chunks; chunk_ind++) {
+            ctry_ind = ctry_start + chunk_ind;
+            if (ctry_ind >= NUM_FAO_CTRY) {
+                continue;
             }
-            free(area_out[i][j]);
+            for (aez_ind = 0; aez_ind < ctry_aez_num[ctry_ind]; aez_ind++) {
+                for (cur_lt_cat_ind = 0; cur_lt_cat_ind < num_lt_cats; cur_lt_cat_ind++) {
+                    k = (zone_start[ctry_ind] + aez_ind) * num_lt_cats + cur_lt_cat_ind - block_key;
+                    for (year_ind = 0; year_ind < NUM_HYDE_YEARS; year_ind++) {
+                        outval = block_area[(size_t) k * NUM_HYDE_YEARS + year_ind];
+                        // output only positive values
+                        if (outval > 0) {
+                            csvout_str(&chunks[chunk_ind], "\n");
+                            csvout_str(&chunks[chunk_ind], countryabbrs_iso[ctry_ind]);
+                            csvout_str(&chunks[chunk_ind], ",");
+                            csvout_int(&chunks[chunk_ind], ctry_aez_list[ctry_ind][aez_ind]);
+                            csvout_str(&chunks[chunk_ind], ",");
+                            csvout_int(&chunks[chunk_ind], lt_cats[cur_lt_cat_ind]);
+                            csvout_str(&chunks[chunk_ind], ",");
+                            csvout_int(&chunks[chunk_ind], hyde_years[year_ind]);
+                            csvout_str(&chunks[chunk_ind], ",");
+                            csvout_float(&chunks[chunk_ind], outval, 0);
+                            nrecords++;
+                        } // end if value is positive
+                    } // end for year loop
+                } // end for land type loop
+            } // end for aez loop
+        } // end for chunk loop over the countries in this block
+        
+        for (chunk_ind = 0; chunk_ind < num_chunks; chunk_ind++) {
+            csvout_append(&out, &chunks[chunk_ind]);
         }
-        free(area_out[i]);
+        
+        // the parallel chunks hold only text, so the columnar copy is a serial pass over the same values
+        if (in_args.out_columnar) {
+            for (ctry_ind = ctry_start; ctry_ind < ctry_end; ctry_ind++) {
+                for (aez_ind = 0; aez_ind < ctry_aez_num[ctry_ind]; aez_ind++) {
+                    for (cur_lt_cat_ind = 0; cur_lt_cat_ind < num_lt_cats; cur_lt_cat_ind++) {
+                        k = (zone_start[ctry_ind] + aez_ind) * num_lt_cats + cur_lt_cat_ind - block_key;
+                        for (year_ind = 0; year_ind < NUM_HYDE_YEARS; year_ind++) {
+                            outval = block_area[(size_t) k * NUM_HYDE_YEARS + year_ind];
+                            if (outval > 0) {
+                                tab_keys[0] = ctry_ind;
+                                tab_keys[1] = ctry_aez_list[ctry_ind][aez_ind];
+                                tab_keys[2] = lt_cats[cur_lt_cat_ind];
+                                tab_keys[3] = hyde_years[year_ind];
+                                coltab_add(&tab, tab_keys, outval);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } // end for loop over country blocks
+    
+    for (chunk_ind = 0; chunk_ind < num_chunks; chunk_ind++) {
+        csvout_close(&chunks[chunk_ind]);
     }
-    free(area_out);
-	for (i = 0; i < NUM_HYDE_TYPES - NUM_HYDE_TYPES_MAIN; i++) {
-		free(lu_detail_grid[i]);
-	}
-	free(lu_detail_grid);
-	for (i = 0; i < NUM_LULC_TYPES; i++) {
-		free(lulc_temp_grid[i]);
-	}
-	free(lulc_temp_grid);
+    free(chunks);
+    free(block_area);
+    ltarea_remove_spills(in_args, hyde_years, NUM_HYDE_YEARS, spill_fp);
+    
+    if ((err = csvout_close(&out)) != OK) {
+        fprintf(fplog,"Failed to write file %s: proc_land_type_area()\n", fname);
+        return err;
+    }
+    
+    fprintf(fplog, "Wrote file %s: proc_land_type_area(); records written=%i\n", fname, nrecords);
+    
+    if (in_args.out_columnar && (err = coltab_write(&tab)) != OK) {
+        fprintf(fplog,"Failed to write columnar table for %s: proc_land_type_area()\n", fname);
+        return err;
+    }
+	
+	// the hyde grids belong to the read-ahead buffers, which lureadahead_free() has freed
+    free(year_area);
+    free(zone_start);
 	free(lulc_area);
 	free(refveg_area_out);
 	free(refveg_them);
-	free(lu_indices);
+	grid_free(refveg_area_grid);
+	grid_free(refveg_them_grid);
+	grid_free(block_cells);
+	grid_free(block_zone);
+	free(block_land);
+	grid_free(block_protected);
 	for (i = 0; i < num_lu_cells; i++) {
 		free(lu_area[i]);
 	}
@@ -22,6 +22,11 @@
  int *refveg_them;			array of refveg thematic out values for each lu cell
  int num_lu_cells:			number of lu cells in lulc cell
 
+ the work is done by lulc_area_kernel(), which is inlined into a wrapper for each split factor in use
+  (LULC_SPLIT_5MIN and LULC_SPLIT_30SEC working cells per lulc cell side), so that the cell count and the
+  search grid width are constants and the per-cell work arrays are fixed-size stack arrays
+ any other split goes through the generic wrapper, which sizes the work arrays at run time
+ all wrappers give the same results, including the rand() sequence of the cell shuffle
  
  return value:
  integer error code: OK = 0, otherwise a non-zero error code
@@ -53,32 +58,132 @@
 
 #include "moirai.h"
 
-int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them, int num_lu_cells) {
+#define LULC_SPLIT_5MIN		6		// working cells per lulc cell side for 5 arcmin hyde and 30 arcmin lulc
+#define LULC_SPLIT_30SEC	60		// working cells per lulc cell side for 30 arcsec hyde and 30 arcmin lulc
+
+// indices in lu_area of the hyde types; should probably retrieve these from the info arrays
+#define LU_URBAN		0		// urban
+#define LU_CROP			1		// cropland
+#define LU_PASTURE		2		// pasture
+#define LU_INTENSE		3		// intense pasture
+#define LU_RANGE		4		// range pasture
+#define LU_IR_NORICE	5		// irrigated non-rice; the first of the crop detail types
+#define LU_RF_NORICE	6		// rainfed non-rice
+#define LU_IR_RICE		7		// irrigated rice
+#define LU_RF_RICE		8		// rainfed rice
+#define LU_TOT_IRR		9		// total irrigated
+#define LU_TOT_RAIN		10		// total rainfed
+#define LU_TOT_RICE		11		// total rice; the last of the crop detail types
+
+// force the kernel into each wrapper so that its loop bounds are constants
+#ifdef __GNUC__
+#define LULC_KERNEL static inline __attribute__((always_inline))
+#else
+#define LULC_KERNEL static inline
+#endif
+
+/********
+ static float lulc_fix_cell(float *area, float land_area, float lu_nodata, int i)
+ make the land use areas of one lu cell with valid land consistent with its land area
+ nodata types are set to zero, and a land use excess is taken from urban, then pasture, then crop
+ the pasture and crop detail types are scaled with their totals
+ area:		the NUM_HYDE_TYPES areas of the cell
+ land_area:	hyde land area of the cell
+ lu_nodata:	the lu nodata value
+ i:			the lu cell index, for the log
+ return:	the reference veg area of the cell
+ ********/
+static float lulc_fix_cell(float *area, float land_area, float lu_nodata, int i)
+{
+	int j;
+	static logsite_struct neg_crop_site = {"Warning: negative crop area: proc_lulc_area()", 0, NULL};	// rate-limited (log_utils.c)
+	float refveg_area;		// land not used by crop, pasture or urban
+	float deficit;			// the negative area carried to the next type
+	float total;			// the adjusted total of the detail types
+	
+	// check for nodata values, and set them to zero
+#pragma omp simd
+	for (j = 0; j < NUM_HYDE_TYPES; j++) {
+		area[j] = (area[j] == lu_nodata) ? 0 : area[j];
+	}
+	
+	refveg_area = land_area - area[LU_CROP] - area[LU_PASTURE] - area[LU_URBAN];
+	// adjust urban area if not enough land
+	if (refveg_area < 0) {
+		area[LU_URBAN] = area[LU_URBAN] + refveg_area;
+		refveg_area = 0;
+	}
+	// double-check for enough land and adjust pasture
+	if (area[LU_URBAN] < 0) {
+		deficit = area[LU_URBAN];
+		area[LU_PASTURE] = area[LU_PASTURE] + deficit;
+		total = area[LU_PASTURE];
+		if (total != 0) {
+			area[LU_INTENSE] = area[LU_INTENSE] + deficit * area[LU_INTENSE] / total;
+			area[LU_RANGE] = area[LU_RANGE] + deficit * area[LU_RANGE] / total;
+		} else {
+			area[LU_INTENSE] = 0;
+			area[LU_RANGE] = 0;
+		}
+		area[LU_URBAN] = 0;
+	}
+	// final check for enough land and adjust crops; the crop detail types are contiguous
+	if (area[LU_PASTURE] < 0) {
+		deficit = area[LU_PASTURE];
+		area[LU_CROP] = area[LU_CROP] + deficit;
+		total = area[LU_CROP];
+		if (total != 0) {
+#pragma omp simd
+			for (j = LU_IR_NORICE; j <= LU_TOT_RICE; j++) {
+				area[j] = area[j] + deficit * area[j] / total;
+			}
+		} else {
+			for (j = LU_IR_NORICE; j <= LU_TOT_RICE; j++) {
+				area[j] = 0;
+			}
+		}
+		area[LU_PASTURE] = 0;
+		area[LU_INTENSE] = 0;
+		area[LU_RANGE] = 0;
+	}
+	// this shouldn't happen, but check anyway
+	if (area[LU_CROP] < 0) {
+		if (log_sample(&neg_crop_site)) {
+			fprintf(fplog, "Warning: negative crop area %lf at i %i: proc_lulc_area()\n", (double) area[LU_CROP], i);
+		}
+		area[LU_CROP] = 0;
+		for (j = LU_IR_NORICE; j <= LU_TOT_RICE; j++) {
+			area[j] = 0;
+		}
+		// some small (effectively zero) negative values appear here from time to time
+		//return ERROR_CALC;
+	}
+	
+	return refveg_area;
+}
+
+/********
+ LULC_KERNEL int lulc_area_kernel(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area,
+	float *refveg_area_out, int *refveg_them, const int num_lu_cells, const int ncols, int *rand_order, int *leftover_cell_inds, float *land_area)
+ the body of proc_lulc_area(); the arguments are as in proc_lulc_area(), plus:
+ ncols:					number of lu cells per lulc cell side
+ rand_order:			work array of num_lu_cells; the randomized order for selecting the lu cell to process
+ leftover_cell_inds:	work array of num_lu_cells; the indices of the output cells not assigned a ref veg in the first pass
+ land_area:				work array of num_lu_cells; the hyde land area of each lu cell
+ ********/
+LULC_KERNEL int lulc_area_kernel(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area,
+	float *refveg_area_out, int *refveg_them, const int num_lu_cells, const int ncols, int *rand_order, int *leftover_cell_inds, float *land_area) {
 	
 	int i, j, x, y, m;
 	int potveg_ind;			// the index of current cell potential vegeation; for refveg_type_area_sum and lc_agg_area
 	int potveg_val;				// the value of current pot veg; can be 0 (unknown)
-	// should probably retrieve these from the info arrays
-	int urban_ind = 0;		// index in lu_area of urban values
-	int crop_ind = 1;		// index in lu_area of cropland values; may need to find these from an array
-	int pasture_ind = 2;	// index in lu_area of pasture values
-	int intense_ind = 3;	// intense pasture
-	int range_ind = 4;		// range pasture
-	int ir_norice_ind = 5;	// irrigated non-rice
-	int rf_norice_ind = 6;	// rainfed non-rice
-	int ir_rice_ind = 7;	// irrigated rice
-	int rf_rice_ind = 8;	// rainfed rice
-	int tot_irr_ind = 9;	// total irrigated
-	int tot_rain_ind = 10;	// total rainfed
-	int tot_rice_ind = 11;	// total rice
 	
 	float lulc_scalar = 1;			// the ratio of reference veg area to input lulc non-land-use area
 	float sum_lulc_veg_area = 0;	// the total input lulc non-land-use area in this lulc cell
 	float sum_refveg_area = 0;	// the total reference veg area in this lulc cell
-	float sum_lu_land_area = 0;	// the total lu land area in this lulc cell
-	float *sum_lu_area;			// the total lu area in this lulc cell; NUM_HYDE_TYPES
-	float *lc_agg_area;		// the input lc area in this lulc cell by type, aggregated to sage pot veg
-	float *refveg_type_area_sum;	// sum of each output ref veg type within this lulc cell
+	float lc_agg_area[NUM_SAGE_PVLT];			// the input lc area in this lulc cell by type, aggregated to sage pot veg
+	float refveg_type_area_sum[NUM_SAGE_PVLT];	// sum of each output ref veg type within this lulc cell
+	float type_area_resid[NUM_SAGE_PVLT];		// array of residual areas (lulc - assigned refveg within lulc cell) for the types after the first pass
 	
 	int temp_int;					// for swapping
 	int sub_type;					// corresponding substitute ref veg type (index)
@@ -86,20 +191,13 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 	int other_ind;					// index of the other substitute ref veg
 	int max_resid_ind;				// index of the max residual area
 	int num_leftover_cells = 0;		// number of output cells not assigned a ref veg in the first pass
-	int *leftover_cell_inds;		// the indices of the output cells not assigned a ref veg in the first pass
-	int rand_order[num_lu_cells];	// the randomized array for selecting the lu cell to process
 	float sum_area_diff;			// difference between lulc area for a given type and the ref veg area for a given type within the lulc cell
 	float max_sum_area_diff;		// the maximum sum_area_diff across types
-	float *type_area_resid;			// array of residual areas (lulc - assigned refveg within lulc cell) for the types after the first pass
 	float max_resid_area;			// for finding the max resid area
-	float temp_rvt_area;			// for checking
 	
 	// for searching the lu cells
-	int ncols;
 	int nrows;
 	int current_val;
-	double temp_dbl;
-	double integer_dbl;
 	int irow;
 	int icol;
 	int count;
@@ -108,142 +206,35 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 	int leftcol;
 	int rightcol;
 	
-	// allocate some arrays
-	sum_lu_area = calloc(NUM_HYDE_TYPES, sizeof(float));
-	if(sum_lu_area == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for sum_lu_area: proc_lulc_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	lc_agg_area = calloc(NUM_SAGE_PVLT, sizeof(float));
-	if(lc_agg_area == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for lc_agg_area: proc_lulc_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	leftover_cell_inds = calloc(num_lu_cells, sizeof(float));
-	if(leftover_cell_inds == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for leftover_cell_inds: proc_lulc_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	refveg_type_area_sum = calloc(NUM_SAGE_PVLT, sizeof(float));
-	if(refveg_type_area_sum == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for refveg_type_area_sum: proc_lulc_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	type_area_resid = calloc(NUM_SAGE_PVLT, sizeof(float));
-	if(type_area_resid == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for type_area_resid: proc_lulc_area()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
+	memset(lc_agg_area, 0, NUM_SAGE_PVLT * sizeof(float));
+	memset(refveg_type_area_sum, 0, NUM_SAGE_PVLT * sizeof(float));
+	
+	// gather the hyde land area of the lu cells
+	for (i = 0; i < num_lu_cells; i++) {
+		land_area[i] = land_area_hyde[lu_indices[i]];
 	}
 	
-	// determine the reference veg area then sum the land use and ref veg area in this lulc input cell and
+	// determine the reference veg area then sum the ref veg area in this lulc input cell
 	for (i = 0; i < num_lu_cells; i++) {
-		
-		temp_dbl = land_area_hyde[lu_indices[i]];
-			// determine reference veg area
-			if (land_area_hyde[lu_indices[i]] == 0) {
-				// there may be some zero area cells, so make the land use areas consistent
-				// zero land so set land types to 0 area
-				for (j = 0; j < NUM_HYDE_TYPES; j++) {
-					lu_area[i][j] = 0;
-					temp_dbl = lu_area[i][j];
-				}
-				refveg_area_out[i] = 0;
-			} else if (land_area_hyde[lu_indices[i]] != raster_info.land_area_hyde_nodata) {
-				// check for nodata values, and set them to zero if valid land cell
-				for (j = 0; j < NUM_HYDE_TYPES; j++) {
-					if (lu_area[i][j] == raster_info.lu_nodata) {
-						lu_area[i][j] = 0;
-					}
-					temp_dbl = lu_area[i][j];
-				}
-				refveg_area_out[i] = 0;
-				// calculate reference veg area
-				refveg_area_out[i] = land_area_hyde[lu_indices[i]] -
-				lu_area[i][crop_ind] - lu_area[i][pasture_ind] - lu_area[i][urban_ind];
-				temp_dbl = refveg_area_out[i];
-				// check for negative values
-				if (refveg_area_out[i] < 0) {
-					// adjust urban area if not enough land
-					lu_area[i][urban_ind] = lu_area[i][urban_ind] + refveg_area_out[i];
-					refveg_area_out[i] = 0;
-				}
-				temp_dbl = lu_area[i][urban_ind];
-				// double-check for enough land and adjust pasture
-				if (lu_area[i][urban_ind] < 0) {
-					lu_area[i][pasture_ind] = lu_area[i][pasture_ind] + lu_area[i][urban_ind];
-					if (lu_area[i][pasture_ind] != 0) {
-						lu_area[i][intense_ind] = lu_area[i][intense_ind] + lu_area[i][urban_ind] * lu_area[i][intense_ind] / lu_area[i][pasture_ind];
-						lu_area[i][range_ind] = lu_area[i][range_ind] + lu_area[i][urban_ind] * lu_area[i][range_ind] / lu_area[i][pasture_ind];
-					} else {
-						lu_area[i][intense_ind] = 0;
-						lu_area[i][range_ind] = 0;
-					}
-					lu_area[i][urban_ind] = 0;
-				}
-				temp_dbl = lu_area[i][pasture_ind];
-				// final check for enough land and adjust crops
-				if (lu_area[i][pasture_ind] < 0) {
-					lu_area[i][crop_ind] = lu_area[i][crop_ind] + lu_area[i][pasture_ind];
-					if (lu_area[i][crop_ind] != 0) {
-						lu_area[i][ir_norice_ind] = lu_area[i][ir_norice_ind] + lu_area[i][pasture_ind] * lu_area[i][ir_norice_ind] / lu_area[i][crop_ind];
-						lu_area[i][rf_norice_ind] = lu_area[i][rf_norice_ind] + lu_area[i][pasture_ind] * lu_area[i][rf_norice_ind] / lu_area[i][crop_ind];
-						lu_area[i][ir_rice_ind] = lu_area[i][ir_rice_ind] + lu_area[i][pasture_ind] * lu_area[i][ir_rice_ind] / lu_area[i][crop_ind];
-						lu_area[i][rf_rice_ind] = lu_area[i][rf_rice_ind] + lu_area[i][pasture_ind] * lu_area[i][rf_rice_ind] / lu_area[i][crop_ind];
-						lu_area[i][tot_irr_ind] = lu_area[i][tot_irr_ind] + lu_area[i][pasture_ind] * lu_area[i][tot_irr_ind] / lu_area[i][crop_ind];
-						lu_area[i][tot_rain_ind] = lu_area[i][tot_rain_ind] + lu_area[i][pasture_ind] * lu_area[i][tot_rain_ind] / lu_area[i][crop_ind];
-						lu_area[i][tot_rice_ind] = lu_area[i][tot_rice_ind] + lu_area[i][pasture_ind] * lu_area[i][tot_rice_ind] / lu_area[i][crop_ind];
-					} else {
-						lu_area[i][ir_norice_ind] = 0;
-						lu_area[i][rf_norice_ind] = 0;
-						lu_area[i][ir_rice_ind] = 0;
-						lu_area[i][rf_rice_ind] = 0;
-						lu_area[i][tot_irr_ind] = 0;
-						lu_area[i][tot_rain_ind] = 0;
-						lu_area[i][tot_rice_ind] = 0;
-					}
-					lu_area[i][pasture_ind] = 0;
-					lu_area[i][intense_ind] = 0;
-					lu_area[i][range_ind] = 0;
-				}
-				temp_dbl = lu_area[i][crop_ind];
-				// this shouldn't happen, but check anyway
-				if (lu_area[i][crop_ind] < 0) {
-					lu_area[i][crop_ind] = 0;
-					lu_area[i][ir_norice_ind] = 0;
-					lu_area[i][rf_norice_ind] = 0;
-					lu_area[i][ir_rice_ind] = 0;
-					lu_area[i][rf_rice_ind] = 0;
-					lu_area[i][tot_irr_ind] = 0;
-					lu_area[i][tot_rain_ind] = 0;
-					lu_area[i][tot_rice_ind] = 0;
-					fprintf(fplog, "Warning: negative crop area %lf at i %i: proc_lulc_area()\n", temp_dbl, i);
-					// some small (effectively zero) negative values appear here from time to time
-					//return ERROR_CALC;
-				}
-			} else {
-				// this could be reached due to coarse resolution lulc data
-				// here, hyde land area == nodata sets all land type areas to zero for this lu cell
-				// calc_refveg_area stores nodata for the types for hyde land area == nodata
-				for (j = 0; j < NUM_HYDE_TYPES; j++) {
-					lu_area[i][j] = 0;
-				}
-				refveg_area_out[i] = 0;
-				if (in_args.diagnostics) {
-					// this will happen a lot because all lulc cells are passed to proc_lulc_area()
-					//fprintf(fplog, "Warning, hyde land area nodata found in i %i: proc_lulc_area()\n", i);
-				}
-			} // end if valid hyde land area else not
-
-		// now sum the final lu areas
-		for (j = 0; j < NUM_HYDE_TYPES; j++) {
-			if (lu_area[i][j] != raster_info.lu_nodata) {
-				sum_lu_area[j] = sum_lu_area[j] + lu_area[i][j];
+		if (land_area[i] == 0) {
+			// there may be some zero area cells, so make the land use areas consistent
+			// zero land so set land types to 0 area
+			for (j = 0; j < NUM_HYDE_TYPES; j++) {
+				lu_area[i][j] = 0;
 			}
-		}
-		// sum the lu land area within this lulc cell
-		if (land_area_hyde[lu_indices[i]] != raster_info.land_area_hyde_nodata) {
-			sum_lu_land_area = sum_lu_land_area + land_area_hyde[lu_indices[i]];
-		}
+			refveg_area_out[i] = 0;
+		} else if (land_area[i] != raster_info->land_area_hyde_nodata) {
+			refveg_area_out[i] = lulc_fix_cell(lu_area[i], land_area[i], raster_info->lu_nodata, i);
+		} else {
+			// this could be reached due to coarse resolution lulc data
+			// here, hyde land area == nodata sets all land type areas to zero for this lu cell
+			// calc_refveg_area stores nodata for the types for hyde land area == nodata
+			for (j = 0; j < NUM_HYDE_TYPES; j++) {
+				lu_area[i][j] = 0;
+			}
+			refveg_area_out[i] = 0;
+		} // end if valid hyde land area else not
+		
 		// sum the ref veg area
 		sum_refveg_area = sum_refveg_area + refveg_area_out[i];
 		
@@ -251,10 +242,10 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 		rand_order[i] = i;
 		
 	} // end i loop over the lu cells to determine total areas
-
+	
 	// aggregate the lulc land cover type areas to pot veg types
 	for (i = 0; i < NUM_LULC_LC_TYPES; i++) {
-		if (lulc_area[i] != raster_info.lulc_input_nodata && lulc2sagecodes[i] != -1) {
+		if (lulc_area[i] != raster_info->lulc_input_nodata && lulc2sagecodes[i] != -1) {
 			lc_agg_area[lulc2sagecodes[i]-1] = lc_agg_area[lulc2sagecodes[i]-1] + lulc_area[i];
 		}
 	}
@@ -286,29 +277,26 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 		i = rand_order[m];
 		
 		// do this only for cells with land area
-		if (land_area_hyde[lu_indices[i]] != raster_info.land_area_hyde_nodata) {
+		if (land_area[i] != raster_info->land_area_hyde_nodata) {
 			
 			// set the reference veg and sum the ref veg area per land cover type
 			// if the lulc limit is reached then move area to different cover type
 			// unassigned cells are 0 in refveg_them
 			
 			// use potential veg if available
-			if (potveg_thematic[lu_indices[i]] != raster_info.potveg_nodata) {
+			if (THM8_VAL(potveg_thematic, lu_indices[i], raster_info->potveg_nodata) != raster_info->potveg_nodata) {
 				potveg_ind = potveg_thematic[lu_indices[i]] - 1;
 				potveg_val = potveg_thematic[lu_indices[i]];
 			} else {
 				// find a nearby pot veg type
-				// assume symmetric cell size right now
-				ncols = (int) round(sqrt((double)num_lu_cells));
+				// assume symmetric cell size right now; ncols is the split factor
 				nrows = ncols;
-				potveg_val = raster_info.potveg_nodata;
-				temp_dbl = i / ncols;
-				modf(temp_dbl, &integer_dbl);
-				irow = (int) integer_dbl;
+				potveg_val = raster_info->potveg_nodata;
+				irow = i / ncols;
 				icol = i - irow * ncols;
 				// search vicinity for nearest valid pot veg value
 				count = 1;
-				while (potveg_val == raster_info.potveg_nodata) {
+				while (potveg_val == raster_info->potveg_nodata) {
 					// determine rows and cols to search
 					toprow = irow - count;
 					if (toprow < 0) {
@@ -331,25 +319,25 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 						if (x == toprow || x == botrow) {
 							// loop over columns if at top or bottom of search ring
 							for (y = leftcol; y <= rightcol; y++) {
-								current_val = potveg_thematic[x * nrows + y];
+								current_val = THM8_VAL(potveg_thematic, x * nrows + y, raster_info->potveg_nodata);
 								// grab the first found value
-								if (current_val != raster_info.potveg_nodata) {
+								if (current_val != raster_info->potveg_nodata) {
 									potveg_val = current_val;
 									//fprintf(fplog, "Found potveg value for index %i at index %i\n", i, x * nrows + y);
 									break; // don't need to search this row anymore
 								}
 							}	// end for y loop over columns
 						} else {	// end if top or bottom of search ring
-							current_val = potveg_thematic[x * nrows + leftcol];
+							current_val = THM8_VAL(potveg_thematic, x * nrows + leftcol, raster_info->potveg_nodata);
 							// grab the first found value
-							if (current_val != raster_info.potveg_nodata) {
+							if (current_val != raster_info->potveg_nodata) {
 								potveg_val = current_val;
 								//fprintf(fplog, "Found potveg value for index %i at index %i\n", i, x * nrows + leftcol);
 								break; // don't need to search this row anymore
 							}
-							current_val = potveg_thematic[x * nrows + rightcol];
+							current_val = THM8_VAL(potveg_thematic, x * nrows + rightcol, raster_info->potveg_nodata);
 							// grab the first found value
-							if (current_val != raster_info.potveg_nodata) {
+							if (current_val != raster_info->potveg_nodata) {
 								potveg_val = current_val;
 								//fprintf(fplog, "Found potveg value for index %i at index %i\n", i, x * nrows + rightcol);
 								break; // don't need to search this row anymore
@@ -600,8 +588,6 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 					for (j = 0; j < NUM_SAGE_PVLT; j++) {
 						sum_area_diff = lulc_scalar * lc_agg_area[j] - refveg_type_area_sum[j];
 						// check zero area thresh here also
-						temp_rvt_area = refveg_type_area_sum[j];
-						temp_dbl = lc_agg_area[j];
 						if (sum_area_diff >= refveg_area_out[i] && sum_area_diff > 0 && lc_agg_area[j] > ZERO_THRESH) {
 							if (sum_area_diff > max_sum_area_diff) {
 								other_ind = j;
@@ -652,7 +638,7 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 	// calc lulc and ref veg area discrepancies
 	for (j = 0; j < NUM_SAGE_PVLT; j++) {
 		type_area_resid[j] = lulc_scalar * lc_agg_area[j] - refveg_type_area_sum[j];
-		if (type_area_resid[j] < 0 && in_args.diagnostics) {
+		if (type_area_resid[j] < 0 && in_args->diagnostics) {
 			//fprintf(fplog, "Warning, resid area for pot veg type %i is < 0 (%f): proc_lulc_area()\n", j+1, type_area_resid[j]);
 		}
 	} // end for j loop over pot veg types
@@ -685,7 +671,7 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 		if (max_resid_ind != NOMATCH) {
 			refveg_them[leftover_cell_inds[i]] = landtypecodes_sage[max_resid_ind];
 			type_area_resid[max_resid_ind] = type_area_resid[max_resid_ind] - refveg_type_area_sum[max_resid_ind];
-			if (in_args.diagnostics && type_area_resid[max_resid_ind] < 0) {
+			if (in_args->diagnostics && type_area_resid[max_resid_ind] < 0) {
 				//fprintf(fplog, "Extra lulc cell area for ref veg type %i is %f: proc_lulc_area()\n", max_resid_ind+1, type_area_resid[max_resid_ind]);
 			}
 		} else {
@@ -694,17 +680,68 @@ int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_ar
 
 	} // end for i loop over cells to deal with unassigned cells and residual area
 	
-	//if (in_args.diagnostics) {
+	//if (in_args->diagnostics) {
 	//	for (j = 0; j < NUM_SAGE_PVLT; j++) {
 	//		fprintf(fplog,"pvlt %i:\tlc_agg_area = %f;\trv_sum = %f\n", j+1, lulc_scalar * lc_agg_area[j], refveg_type_area_sum[j]);
 	//	}
 	//}
 	
-	free(sum_lu_area);
-	free(lc_agg_area);
-	free(leftover_cell_inds);
-	free(refveg_type_area_sum);
-	free(type_area_resid);
-	
 	return OK;
-}
\ No newline at end of file
+}
+
+/********
+ static int lulc_area_5min(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them)
+ proc_lulc_area() for LULC_SPLIT_5MIN x LULC_SPLIT_5MIN lu cells
+ ********/
+static int lulc_area_5min(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them)
+{
+	int rand_order[LULC_SPLIT_5MIN * LULC_SPLIT_5MIN];
+	int leftover_cell_inds[LULC_SPLIT_5MIN * LULC_SPLIT_5MIN];
+	float land_area[LULC_SPLIT_5MIN * LULC_SPLIT_5MIN];
+	
+	return lulc_area_kernel(in_args, raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them,
+							LULC_SPLIT_5MIN * LULC_SPLIT_5MIN, LULC_SPLIT_5MIN, rand_order, leftover_cell_inds, land_area);
+}
+
+/********
+ static int lulc_area_30sec(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them)
+ proc_lulc_area() for LULC_SPLIT_30SEC x LULC_SPLIT_30SEC lu cells
+ ********/
+static int lulc_area_30sec(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them)
+{
+	int rand_order[LULC_SPLIT_30SEC * LULC_SPLIT_30SEC];
+	int leftover_cell_inds[LULC_SPLIT_30SEC * LULC_SPLIT_30SEC];
+	float land_area[LULC_SPLIT_30SEC * LULC_SPLIT_30SEC];
+	
+	return lulc_area_kernel(in_args, raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them,
+							LULC_SPLIT_30SEC * LULC_SPLIT_30SEC, LULC_SPLIT_30SEC, rand_order, leftover_cell_inds, land_area);
+}
+
+/********
+ static int lulc_area_generic(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them, int num_lu_cells)
+ proc_lulc_area() for any other number of lu cells
+ ********/
+static int lulc_area_generic(args_struct *in_args, rinfo_struct *raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them, int num_lu_cells)
+{
+	int rand_order[num_lu_cells];
+	int leftover_cell_inds[num_lu_cells];
+	float land_area[num_lu_cells];
+	// assume symmetric cell size right now
+	int ncols = (int) round(sqrt((double)num_lu_cells));
+	
+	return lulc_area_kernel(in_args, raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them,
+							num_lu_cells, ncols, rand_order, leftover_cell_inds, land_area);
+}
+
+int proc_lulc_area(args_struct in_args, rinfo_struct raster_info, float *lulc_area, int *lu_indices, float **lu_area, float *refveg_area_out, int *refveg_them, int num_lu_cells) {
+	
+	// select the kernel for the split factor
+	switch (num_lu_cells) {
+		case LULC_SPLIT_5MIN * LULC_SPLIT_5MIN:
+			return lulc_area_5min(&in_args, &raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them);
+		case LULC_SPLIT_30SEC * LULC_SPLIT_30SEC:
+			return lulc_area_30sec(&in_args, &raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them);
+		default:
+			return lulc_area_generic(&in_args, &raster_info, lulc_area, lu_indices, lu_area, refveg_area_out, refveg_them, num_lu_cells);
+	}
+}
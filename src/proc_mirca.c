@@ -16,12 +16,16 @@
     country iso mapping
  
  units are hectares - outputs are rounded to hectares
- file names are built here and passed to read_mirca()
+ file names are built here and passed to open_mirca()
+ the files are read in latitude bands of in_args.band_rows rows (see get_band_rows()), so only a band of each
+    file is in memory at a time, and each band of the working grids is released when it is done (see grid_store.c)
  the crop # has 1 digit for #<10, and 2 digits for #>=10
  
  process only valid sage land cells, as that is where the crop data comes from
  
  serbia and montenegro data are merged
+ the cells of each band are added to their country X glu zones in parallel (see zone_accum.c); the sums are in double
+    precision and do not depend on the number of threads
  
  arguments:
  args_struct in_args: the input file arguments
@@ -54,6 +58,28 @@
 
 #include "moirai.h"
 
+// the current latitude band of the two mirca files
+typedef struct {
+    float *irr_grid;        // irrigated area of the band
+    float *rfd_grid;        // rainfed area of the band
+    int band_start;         // grid index of the first cell of the band
+} mirca_band_struct;
+
+/********
+ static int mirca_cell_value(int pos, void *ctx, int *offset, double *vals)
+ the irrigated and rainfed area of the sage land cell at pos in land_cells_sage, for zone_accum()
+ ********/
+static int mirca_cell_value(int pos, void *ctx, int *offset, double *vals)
+{
+    mirca_band_struct *band = (mirca_band_struct *) ctx;
+    int band_ind = land_cells_sage[pos] - band->band_start;
+    
+    *offset = 0;
+    vals[0] = band->irr_grid[band_ind];
+    vals[1] = band->rfd_grid[band_ind];
+    return OK;
+}
+
 int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
     
     // valid values in the sage land area data set determine the land cells to process
@@ -62,20 +88,27 @@ int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
     int crop_index;             // the index for looping over mirca crops
     int err = OK;				// store error code from the write functions
     
-    int scg_code = 186;         // fao code for serbia and montenegro
-    int srb_code = 272;         // fao code for serbia
-    int mne_code = 273;         // fao code for montenegro
+    float *irr_grid;  // 1d array to store the current band of the mirca raster file; start up left corner, row by row; lon varies faster
+    float *rfd_grid;  // 1d array to store the current band of the mirca raster file; start up left corner, row by row; lon varies faster
+    FILE *fp_irr;     // the current irrigated mirca file
+    FILE *fp_rfd;     // the current rainfed mirca file
     
-    float *irr_grid;  // 1d array to store current mirca raster file; start up left corner, row by row; lon varies faster
-    float *rfd_grid;  // 1d array to store current mirca raster file; start up left corner, row by row; lon varies faster
-
+    int band_rows = get_band_rows(in_args);   // rows per latitude band
+    int row_start;          // first row of the current band
+    int nrows;              // number of rows in the current band
+    int band_start;         // grid index of the first cell of the current band
+    int band_end;           // grid index after the last cell of the current band
+    
+    zonemap_struct zones;       // the country X glu zone of each sage land cell
+    double *zone_acc;           // irrigated and rainfed area of the current crop in each zone; [zone][2]
+    mirca_band_struct band_ctx; // the current band, for mirca_cell_value()
+    int pos_start;              // first position in land_cells_sage of the current band
+    int zone;                   // current zone
     
     // output tables as 3-d arrays; ctry, glu, crop; crop varies fastest
     float ***irr_out;		// the irrigated crop area in ha
     float ***rfd_out;		// the rainfed crop area in ha
     
-    int aez_val;            // current glu value
-    int ctry_code;          // current fao country code
     int aez_ind;            // current glu index in ctry_aez_list[ctry_ind]
     int ctry_ind;           // current country index in ctry_aez_list
     float outval;             // rounded value to write
@@ -86,8 +119,12 @@ int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
     char fname2[MAXCHAR];       // file name to write rainfed
     char tmp_str[MAXCHAR];		// stores a temporary string
     
-    FILE *fpout;                // out file pointer for irrigation
-    FILE *fpout2;               // out file pointer for rainfed
+    csvout_struct out;          // buffered output file for irrigation
+    coltab_struct tab;          // columnar copy of the table, if out_columnar
+    int tab_keys[3];            // keys of one record for the columnar copy
+    csvout_struct out2;         // buffered output file for rainfed
+    coltab_struct tab2;         // columnar copy of the rainfed table, if out_columnar
+    int tab2_keys[3];           // keys of one record for the columnar copy
 
     // mirca file names
     const char irr_base[] = "ANNUAL_AREA_HARVESTED_IRC_CROP";   // mirca irrigated file base; 5 arcmin
@@ -96,13 +133,13 @@ int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
     
     // allocate arrays
     
-    irr_grid = calloc(NUM_CELLS, sizeof(float));
+    irr_grid = calloc((size_t) band_rows * NUM_LON, sizeof(float));
     if(irr_grid == NULL) {
         fprintf(fplog,"Failed to allocate memory for irr_grid: proc_mirca()\n");
         return ERROR_MEM;
     }
     
-    rfd_grid = calloc(NUM_CELLS, sizeof(float));
+    rfd_grid = calloc((size_t) band_rows * NUM_LON, sizeof(float));
     if(rfd_grid == NULL) {
         fprintf(fplog,"Failed to allocate memory for rfd_grid: proc_mirca()\n");
         return ERROR_MEM;
@@ -143,88 +180,89 @@ int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
         } // end for j loop over aezs
     } // end for i loop over fao country
     
+    // the country X glu zone of each sage land cell
+    if ((err = zonemap_init(&zones, in_args, land_cells_sage, num_land_cells_sage, raster_info)) != OK) {
+        fprintf(fplog, "Failed to map the sage land cells to zones: proc_mirca()\n");
+        return err;
+    }
+    zone_acc = calloc((size_t) zones.num_zones * 2 + 1, sizeof(double));
+    if(zone_acc == NULL) {
+        fprintf(fplog,"Failed to allocate memory for zone_acc: proc_mirca()\n");
+        return ERROR_MEM;
+    }
+    
     // loop over the MIRCA crops
     for (crop_index = 0; crop_index < NUM_MIRCA_CROPS; crop_index++) {
         
-        // read the irrigated crop file
+        // open the irrigated crop file
         strcpy(fname, in_args.mircapath);
         strcat(fname, irr_base);
         sprintf(tmp_str, "%i%s", (crop_index+1), mirca_tag);
         strcat(fname, tmp_str);
-        if((err = read_mirca(fname, irr_grid)) != OK)
+        if((err = open_mirca(fname, &fp_irr)) != OK)
         {
             fprintf(fplog, "Failed to read file %s for input: proc_mirca()\n",fname);
             return err;
         }
         
-        // read the rainfed crop file
-        strcpy(fname, in_args.mircapath);
-        strcat(fname, rfd_base);
+        // open the rainfed crop file
+        strcpy(fname2, in_args.mircapath);
+        strcat(fname2, rfd_base);
         sprintf(tmp_str, "%i%s", (crop_index+1), mirca_tag);
-        strcat(fname, tmp_str);
-        if((err = read_mirca(fname, rfd_grid)) != OK)
+        strcat(fname2, tmp_str);
+        if((err = open_mirca(fname2, &fp_rfd)) != OK)
         {
-            fprintf(fplog, "Failed to read file %s for input: proc_mirca()\n",fname);
+            fprintf(fplog, "Failed to read file %s for input: proc_mirca()\n",fname2);
+            fclose(fp_irr);
             return err;
         }
         
-        // loop over the valid sage land cells
-        //  and skip it if no valid glu value or country value
-        for (j = 0; j < num_land_cells_sage; j++) {
-            aez_val = aez_bounds_new[land_cells_sage[j]];
-            ctry_code = country_fao[land_cells_sage[j]];
+        memset(zone_acc, 0, (size_t) zones.num_zones * 2 * sizeof(double));
+        
+        // stream the files through latitude bands
+        // the ascii files are read from the top, but there is nothing to read after the processing window rows
+        j = 0;
+        for (row_start = 0; row_start <= win_row_max; row_start = row_start + band_rows) {
+            nrows = (row_start + band_rows <= NUM_LAT) ? band_rows : NUM_LAT - row_start;
+            band_start = row_start * NUM_LON;
+            band_end = band_start + nrows * NUM_LON;
             
-            if (aez_val != raster_info.aez_new_nodata) {
-                // get the fao country index
-                ctry_ind = NOMATCH;
-                for (i = 0; i < NUM_FAO_CTRY; i++) {
-                    if (countrycodes_fao[i] == ctry_code) {
-                        ctry_ind = i;
-                        break;
-                    }
-                } // end for i loop to get ctry index
-                
-                // merge serbia and montenegro for scg record
-                if (ctry_code == mne_code || ctry_code == srb_code) {
-                    ctry_code = scg_code;
-                    ctry_ind = NOMATCH;
-                    for (i = 0; i < NUM_FAO_CTRY; i++) {
-                        if (countrycodes_fao[i] == ctry_code) {
-                            ctry_ind = i;
-                            break;
-                        }
-                    }
-                    if (ctry_ind == NOMATCH) {
-                        // this should never happen
-                        fprintf(fplog, "Error finding scg ctry index: proc_mirca()\n");
-                        return ERROR_IND;
-                    }
-                } // end if serbia or montenegro
-				
-				if (ctry_ind == NOMATCH || ctry2ctry87codes_gtap[ctry_ind] == NOMATCH) {
-					continue;
-				}
-				
-                // get the aez index within the country aez list
-                aez_ind = NOMATCH;
-                for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-                    if (ctry_aez_list[ctry_ind][i] == aez_val) {
-                        aez_ind = i;
-                        break;
-                    }
-                } // end for i loop to get aez index
-                
-                // this shouldn't happen because the countryXglu list has been made already
-                if (aez_ind == NOMATCH) {
-                    fprintf(fplog, "Failed to match aez %i to country %i: proc_mirca()\n",aez_val,ctry_code);
-                    return ERROR_IND;
-                }
-
-                irr_out[ctry_ind][aez_ind][crop_index] = irr_out[ctry_ind][aez_ind][crop_index] + irr_grid[land_cells_sage[j]];
-                rfd_out[ctry_ind][aez_ind][crop_index] = rfd_out[ctry_ind][aez_ind][crop_index] + rfd_grid[land_cells_sage[j]];
-                
-            }	// end if valid aez cell
-        }	// end for j loop over valid sage land cells
+            // read the next band of each file
+            if((err = read_mirca(fp_irr, fname, nrows * NUM_LON, irr_grid)) != OK ||
+               (err = read_mirca(fp_rfd, fname2, nrows * NUM_LON, rfd_grid)) != OK)
+            {
+                fprintf(fplog, "Failed to read files %s and %s for input: proc_mirca()\n",fname, fname2);
+                fclose(fp_irr);
+                fclose(fp_rfd);
+                return err;
+            }
+            
+            // add the valid sage land cells in this band to their country X glu zones
+            // land_cells_sage is in grid order, so the band cells follow the previous band
+            band_ctx.irr_grid = irr_grid;
+            band_ctx.rfd_grid = rfd_grid;
+            band_ctx.band_start = band_start;
+            pos_start = j;
+            while (j < num_land_cells_sage && land_cells_sage[j] < band_end) {
+                j++;
+            }
+            if ((err = zone_accum(&zones, pos_start, j, 2, 2, mirca_cell_value, &band_ctx, zone_acc)) != OK) {
+                fprintf(fplog, "Failed to accumulate the band at row %i: proc_mirca()\n", row_start);
+                return err;
+            }
+            grid_release_rows(row_start, nrows);
+        }   // end for row_start loop over the latitude bands
+        
+        fclose(fp_irr);
+        fclose(fp_rfd);
+        
+        for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY; ctry_ind++) {
+            for (aez_ind = 0; aez_ind < ctry_aez_num[ctry_ind]; aez_ind++) {
+                zone = zones.zone_start[ctry_ind] + aez_ind;
+                irr_out[ctry_ind][aez_ind][crop_index] = (float) zone_acc[2 * zone];
+                rfd_out[ctry_ind][aez_ind][crop_index] = (float) zone_acc[2 * zone + 1];
+            }
+        }
     }   // end for loop over the mirca crops
     
     // write the output files
@@ -232,36 +270,54 @@ int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
     // irrigated
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.mirca_irr_fname);
-    fpout = fopen(fname,"w"); //float
-    if(fpout == NULL)
+    if((err = csvout_open(fname, &out)) != OK)
     {
         fprintf(fplog,"Failed to open file  %s for write:  proc_mirca()\n", fname);
-        return ERROR_FILE;
+        return err;
     }
     // write header lines
-    fprintf(fpout,"# File: %s\n", fname);
-    fprintf(fpout,"# Author: %s\n", CODENAME);
-    fprintf(fpout,"# Description: mirca irrigated harvested area (ha) for sage land cells in country X glu\n");
-    fprintf(fpout,"# Original source: MIRCA2000; country raster; new glu raster\n");
-    fprintf(fpout,"# ----------\n");
-    fprintf(fpout,"iso,glu_code,mirca_crop,value");
+    csvout_printf(&out,"# File: %s\n", fname);
+    csvout_printf(&out,"# Author: %s\n", CODENAME);
+    csvout_str(&out,"# Description: mirca irrigated harvested area (ha) for sage land cells in country X glu\n");
+    csvout_str(&out,"# Original source: MIRCA2000; country raster; new glu raster\n");
+    csvout_str(&out,"# ----------\n");
+    csvout_str(&out,"iso,glu_code,mirca_crop,value");
+    
+    if (in_args.out_columnar) {
+        if ((err = coltab_init(&tab, fname, "mirca irrigated harvested area (ha) for sage land cells in country X glu", "value", "ha", 3)) != OK) {
+            fprintf(fplog,"Failed to initialize columnar table for %s: proc_mirca()\n", fname);
+            return err;
+        }
+        coltab_key(&tab, 0, "iso", countryabbrs_iso, NUM_FAO_CTRY);
+        coltab_key(&tab, 1, "glu_code", NULL, 0);
+        coltab_key(&tab, 2, "mirca_crop", NULL, 0);
+    }
     
     // rainfed
     strcpy(fname2, in_args.outpath);
     strcat(fname2, in_args.mirca_rfd_fname);
-    fpout2 = fopen(fname2,"w"); //float
-    if(fpout2 == NULL)
+    if((err = csvout_open(fname2, &out2)) != OK)
     {
         fprintf(fplog,"Failed to open file  %s for write:  proc_mirca()\n", fname2);
-        return ERROR_FILE;
+        return err;
     }
     // write header lines
-    fprintf(fpout2,"# File: %s\n", fname2);
-    fprintf(fpout2,"# Author: %s\n", CODENAME);
-    fprintf(fpout2,"# Description: mirca rainfed havested area (ha) for sage land cells in country X glu\n");
-    fprintf(fpout2,"# Original source: MIRCA2000; country raster; new glu raster\n");
-    fprintf(fpout2,"# ----------\n");
-    fprintf(fpout2,"iso,glu_code,mirca_crop,value");
+    csvout_printf(&out2,"# File: %s\n", fname2);
+    csvout_printf(&out2,"# Author: %s\n", CODENAME);
+    csvout_str(&out2,"# Description: mirca rainfed havested area (ha) for sage land cells in country X glu\n");
+    csvout_str(&out2,"# Original source: MIRCA2000; country raster; new glu raster\n");
+    csvout_str(&out2,"# ----------\n");
+    csvout_str(&out2,"iso,glu_code,mirca_crop,value");
+    
+    if (in_args.out_columnar) {
+        if ((err = coltab_init(&tab2, fname2, "mirca rainfed harvested area (ha) for sage land cells in country X glu", "value", "ha", 3)) != OK) {
+            fprintf(fplog,"Failed to initialize columnar table for %s: proc_mirca()\n", fname2);
+            return err;
+        }
+        coltab_key(&tab2, 0, "iso", countryabbrs_iso, NUM_FAO_CTRY);
+        coltab_key(&tab2, 1, "glu_code", NULL, 0);
+        coltab_key(&tab2, 2, "mirca_crop", NULL, 0);
+    }
     
     // write the records (rounded to nearest integer)
     for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY ; ctry_ind++) {
@@ -271,30 +327,70 @@ int proc_mirca(args_struct in_args, rinfo_struct raster_info) {
                 outval = (float) floor((double) 0.5 + irr_out[ctry_ind][aez_ind][crop_index]);
                 // output only positive values
                 if (outval > 0) {
-                    fprintf(fpout,"\n%s,%i,%i,%.0f", countryabbrs_iso[ctry_ind], ctry_aez_list[ctry_ind][aez_ind],
-                            crop_index+1, outval);
+                    csvout_str(&out, "\n");
+                    csvout_str(&out, countryabbrs_iso[ctry_ind]);
+                    csvout_str(&out, ",");
+                    csvout_int(&out, ctry_aez_list[ctry_ind][aez_ind]);
+                    csvout_str(&out, ",");
+                    csvout_int(&out, crop_index+1);
+                    csvout_str(&out, ",");
+                    csvout_float(&out, outval, 0);
+                    if (in_args.out_columnar) {
+                        tab_keys[0] = ctry_ind;
+                        tab_keys[1] = ctry_aez_list[ctry_ind][aez_ind];
+                        tab_keys[2] = crop_index+1;
+                        coltab_add(&tab, tab_keys, outval);
+                    }
                     nrecords_irr++;
                 } // end if value is positive
                 // rainfed
                 outval = (float) floor((double) 0.5 + rfd_out[ctry_ind][aez_ind][crop_index]);
                 // output only positive values
                 if (outval > 0) {
-                    fprintf(fpout2,"\n%s,%i,%i,%.0f", countryabbrs_iso[ctry_ind], ctry_aez_list[ctry_ind][aez_ind],
-                            crop_index+1, outval);
+                    csvout_str(&out2, "\n");
+                    csvout_str(&out2, countryabbrs_iso[ctry_ind]);
+                    csvout_str(&out2, ",");
+                    csvout_int(&out2, ctry_aez_list[ctry_ind][aez_ind]);
+                    csvout_str(&out2, ",");
+                    csvout_int(&out2, crop_index+1);
+                    csvout_str(&out2, ",");
+                    csvout_float(&out2, outval, 0);
+                    if (in_args.out_columnar) {
+                        tab2_keys[0] = ctry_ind;
+                        tab2_keys[1] = ctry_aez_list[ctry_ind][aez_ind];
+                        tab2_keys[2] = crop_index+1;
+                        coltab_add(&tab2, tab2_keys, outval);
+                    }
                     nrecords_rfd++;
                 } // end if value is positive
             } // end for crop loop
         } // end for aez loop
     } // end for country loop
     
-    fclose(fpout);
-    fclose(fpout2);
+    if ((err = csvout_close(&out)) != OK) {
+        fprintf(fplog,"Failed to write file %s: proc_mirca()\n", fname);
+        return err;
+    }
+    if (in_args.out_columnar && (err = coltab_write(&tab)) != OK) {
+        fprintf(fplog,"Failed to write columnar table for %s: proc_mirca()\n", fname);
+        return err;
+    }
+    if ((err = csvout_close(&out2)) != OK) {
+        fprintf(fplog,"Failed to write file %s: proc_mirca()\n", fname2);
+        return err;
+    }
+    if (in_args.out_columnar && (err = coltab_write(&tab2)) != OK) {
+        fprintf(fplog,"Failed to write columnar table for %s: proc_mirca()\n", fname2);
+        return err;
+    }
     
     fprintf(fplog, "Wrote file %s: proc_mirca(); records written=%i\n", fname, nrecords_irr);
     fprintf(fplog, "Wrote file %s: proc_mirca(); records written=%i\n", fname2, nrecords_rfd);
     
     free(irr_grid);
     free(rfd_grid);
+    free(zone_acc);
+    zonemap_free(&zones);
     for (i = 0; i < NUM_FAO_CTRY; i++) {
         for (j = 0; j < ctry_aez_num[i]; j++) {
             free(irr_out[i][j]);
@@ -170,13 +170,7 @@ int proc_nfert(args_struct in_args, rinfo_struct raster_info) {
 			}
 			
             // get the aez index within the country aez list
-            aez_ind = NOMATCH;
-            for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-                if (ctry_aez_list[ctry_ind][i] == aez_val) {
-                    aez_ind = i;
-                    break;
-                }
-            } // end for i loop to get aez index
+            aez_ind = glu_list_index(ctry_aez_list[ctry_ind], ctry_aez_num[ctry_ind], aez_val);
             
             // this shouldn't happen because the countryXaez list has been made already
             if (aez_ind == NOMATCH) {
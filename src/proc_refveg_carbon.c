@@ -32,6 +32,9 @@
  process only valid hyde land cells, as these are the source of land type area
  
  serbia and montenegro data are merged
+ the cells are added to their country X glu zones in parallel (see zone_accum.c); the sums are in double
+    precision and do not depend on the number of threads
+ the cells are added a latitude band at a time, and each band of the working grids is released when it is done (see grid_store.c)
  
  arguments:
  args_struct in_args: the input file arguments
@@ -64,19 +67,60 @@
 
 #include "moirai.h"
 
+// the carbon densities of the sage pot veg types
+typedef struct {
+    float *soil_carbon_sage;    // soil c of each sage pot veg type
+    float *veg_carbon_sage;     // veg c of each sage pot veg type
+    int potveg_nodata;          // nodata value of potveg_thematic and refveg_thematic
+} refveg_carbon_ctx_struct;
+
+/********
+ static int refveg_carbon_cell_value(int pos, void *ctx, int *offset, double *vals)
+ the soil c, veg c and ref veg area of the hyde land cell at pos in land_cells_hyde, for zone_accum()
+ the offset is that of the land type category of the cell; only unmanaged potential vegetation area is used here
+ ********/
+static int refveg_carbon_cell_value(int pos, void *ctx, int *offset, double *vals)
+{
+    refveg_carbon_ctx_struct *carbon = (refveg_carbon_ctx_struct *) ctx;
+    int grid_ind = land_cells_hyde[pos];
+    int rv_ind;                 // the index of the current sage reference veg land type
+    int rv_value;               // current ref veg value
+    int cur_lt_cat;             // current land type category
+    int cur_lt_cat_ind;         // current land type category index
+    
+    // nodata land area cells have already been removed, and it is ok if the land area is zero
+    
+    // get index of sage pot veg; set value to 0 if unknown
+    rv_ind = POTVEG_IND(THM8_VAL(potveg_thematic, grid_ind, carbon->potveg_nodata));
+    if (rv_ind == NOMATCH) {
+        rv_value = 0;
+    } else {
+        rv_value = THM8_VAL(refveg_thematic, grid_ind, carbon->potveg_nodata);
+    }
+    
+    // get index of land category
+    cur_lt_cat = rv_value * SCALE_POTVEG + protected_thematic[grid_ind];
+    cur_lt_cat_ind = LT_CAT_IND(cur_lt_cat);
+    if (cur_lt_cat_ind == NOMATCH) {
+        fprintf(fplog, "Failed to match lt_cat %i: proc_refveg_carbon()\n", cur_lt_cat);
+        return ERROR_IND;
+    }
+    
+    // soil c, veg c and area; an unknown pot veg type has no carbon
+    *offset = cur_lt_cat_ind * 3;     // 3 values per land type category (num_out_vals)
+    vals[0] = (rv_ind == NOMATCH) ? 0 : carbon->soil_carbon_sage[rv_ind] * refveg_area[grid_ind];
+    vals[1] = (rv_ind == NOMATCH) ? 0 : carbon->veg_carbon_sage[rv_ind] * refveg_area[grid_ind];
+    vals[2] = refveg_area[grid_ind];
+    return OK;
+}
+
 int proc_refveg_carbon(args_struct in_args, rinfo_struct raster_info) {
     
     // valid values in the hyde land area data set determine the land cells to process
     
     int i, j, k = 0;
-    int grid_ind;               // the index for looping over the raster grid
-    int rv_ind;                 // the index of the current sage reference veg land type
     int err = OK;				// store error code from the read/write functions
     
-    int scg_code = 186;         // fao code for serbia and montenegro
-    int srb_code = 272;         // fao code for serbia
-    int mne_code = 273;         // fao code for montenegro
-    
     //float* soil_carbon_grid;    // 1d array to store the soil carbon data; start up left corner, row by row; lon varies faster
     float *soil_carbon_sage;     // array to store the veg c values for the 15 sage pot veg types and 3 land use types
     float *veg_carbon_sage;     // array to store the veg c values for the 15 sage pot veg types and 3 land use types
@@ -92,18 +136,26 @@ int proc_refveg_carbon(args_struct in_args, rinfo_struct raster_info) {
     int vegc_ind = 1;                   // index in output array
     int area_ind = 2;                   // index in output array, but used only for averaging
 
-    int rv_value;           // current ref veg value
-    int aez_val;            // current glu value
-    int ctry_code;          // current fao country code
     int aez_ind;            // current glu index in ctry_aez_list[ctry_ind]
     int ctry_ind;           // current country index in ctry_aez_list
-    int cur_lt_cat;             // current land type category
     int cur_lt_cat_ind;             // current land type category index
     int num_out_vals = 3;   // the number of values to output (soil c den, veg c den, area for averaging)
     int nrecords = 0;       // count # of records written
     
+    zonemap_struct zones;       // the country X glu zone of each hyde land cell
+    double *zone_acc;           // the output values in each zone; [zone][num_lt_cats][num_out_vals]
+    refveg_carbon_ctx_struct carbon_ctx;    // the carbon densities, for refveg_carbon_cell_value()
+    int zone;                   // current zone
+    int band_rows = get_band_rows(in_args);   // rows per latitude band
+    int row_start;              // first row of the current band
+    int pos_start;              // first position in land_cells_hyde of the current band
+    int pos = 0;                // position in land_cells_hyde after the current band
+    
     char fname[MAXCHAR];        // current file name to write
-    FILE *fpout;                // out file pointer
+    csvout_struct out;          // buffered output file
+    coltab_struct tab;          // columnar copy of the table, if out_columnar
+    int tab_keys[4];            // keys of one record for the columnar copy
+    char *ctype_names[2] = {"soil_c", "veg_c"};     // c_type dictionary for the columnar copy
     
     // allocate arrays
     
@@ -162,131 +214,77 @@ int proc_refveg_carbon(args_struct in_args, rinfo_struct raster_info) {
         return err;
     }
     
-    // loop over the valid hyde land cells
-    //  and skip it if no valid glu value or country value (country has to be mapped to ctry87)
-    for (j = 0; j < num_land_cells_hyde; j++) {
-        grid_ind = land_cells_hyde[j];
-        
-        aez_val = aez_bounds_new[grid_ind];
-        ctry_code = country_fao[grid_ind];
-        
-        if (aez_val != raster_info.aez_new_nodata) {
-            // get the fao country index
-            ctry_ind = NOMATCH;
-            for (i = 0; i < NUM_FAO_CTRY; i++) {
-                if (countrycodes_fao[i] == ctry_code) {
-                    ctry_ind = i;
-                    break;
-                }
-            } // end for i loop to get ctry index
-            
-            // merge serbia and montenegro for scg record
-            if (ctry_code == mne_code || ctry_code == srb_code) {
-                ctry_code = scg_code;
-                ctry_ind = NOMATCH;
-                for (i = 0; i < NUM_FAO_CTRY; i++) {
-                    if (countrycodes_fao[i] == ctry_code) {
-                        ctry_ind = i;
-                        break;
-                    }
-                }
-                if (ctry_ind == NOMATCH) {
-                    // this should never happen
-                    fprintf(fplog, "Error finding scg ctry index: proc_refveg_carbon()\n");
-                    return ERROR_IND;
-                }
-            } // end if serbia or montenegro
-			
-			if (ctry_ind == NOMATCH || ctry2ctry87codes_gtap[ctry_ind] == NOMATCH) {
-				continue;
-			}
-			
-            // get the glu index within the country glu list
-            aez_ind = NOMATCH;
-            for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-                if (ctry_aez_list[ctry_ind][i] == aez_val) {
-                    aez_ind = i;
-                    break;
-                }
-            } // end for i loop to get aez index
-            
-            // this shouldn't happen because the countryXglu list has been made already
-            if (aez_ind == NOMATCH) {
-                fprintf(fplog, "Failed to match aez %i to country %i: proc_refveg_carbon()\n",aez_val,ctry_code);
-                return ERROR_IND;
-            }
-            
-            // nodata land area cells have already been removed, and it is ok if the land area is zero
-            
-            // generate the output land type category and add/store the values
-            // only unmanaged potential vegetation area is used here
-            
-            // get index of sage pot veg; set value to 0 if unknown
-            rv_ind = NOMATCH;
-            for (i = 0; i < NUM_SAGE_PVLT; i++) {
-                if (potveg_thematic[grid_ind] == landtypecodes_sage[i]) {
-                    rv_ind = i;
-                    break;
-                }
-            }
-            if (rv_ind == NOMATCH) {
-                rv_value = 0;
-            } else {
-                rv_value = refveg_thematic[grid_ind];
-            }
-            
-            // get index of land category
-            cur_lt_cat = rv_value * SCALE_POTVEG + protected_thematic[grid_ind];
-            cur_lt_cat_ind = NOMATCH;
-            for (i = 0; i < num_lt_cats; i++) {
-                if (lt_cats[i] == cur_lt_cat) {
-                    cur_lt_cat_ind = i;
-                    break;
+    // add the valid hyde land cells to their country X glu zones
+    //  the cells with no valid glu value or country value (country has to be mapped to ctry87) are skipped
+    // calculate an area weighted average based on ref veg area for HYDE_YEAR
+    // the unit conversion cancels out when the average is calculated, so don't do it here
+    if ((err = zonemap_init(&zones, in_args, land_cells_hyde, num_land_cells_hyde, raster_info)) != OK) {
+        fprintf(fplog, "Failed to map the hyde land cells to zones: proc_refveg_carbon()\n");
+        return err;
+    }
+    zone_acc = calloc((size_t) zones.num_zones * num_lt_cats * num_out_vals + 1, sizeof(double));
+    if(zone_acc == NULL) {
+        fprintf(fplog,"Failed to allocate memory for zone_acc: proc_refveg_carbon()\n");
+        return ERROR_MEM;
+    }
+    carbon_ctx.soil_carbon_sage = soil_carbon_sage;
+    carbon_ctx.veg_carbon_sage = veg_carbon_sage;
+    carbon_ctx.potveg_nodata = raster_info.potveg_nodata;
+    // a latitude band at a time; land_cells_hyde is in grid order, so the band cells follow the previous band
+    //  and each band of the working grids is released when it is done
+    for (row_start = win_row_min; row_start <= win_row_max; row_start = row_start + band_rows) {
+        pos_start = pos;
+        while (pos < num_land_cells_hyde && land_cells_hyde[pos] < (long) (row_start + band_rows) * NUM_LON) {
+            pos++;
+        }
+        if ((err = zone_accum(&zones, pos_start, pos, num_lt_cats * num_out_vals, num_out_vals,
+                              refveg_carbon_cell_value, &carbon_ctx, zone_acc)) != OK) {
+            fprintf(fplog, "Failed to accumulate the hyde land cells of the band at row %i: proc_refveg_carbon()\n", row_start);
+            return err;
+        }
+        grid_release_rows(row_start, band_rows);
+    }   // end for row_start loop over the latitude bands
+    for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY; ctry_ind++) {
+        for (aez_ind = 0; aez_ind < ctry_aez_num[ctry_ind]; aez_ind++) {
+            zone = zones.zone_start[ctry_ind] + aez_ind;
+            for (cur_lt_cat_ind = 0; cur_lt_cat_ind < num_lt_cats; cur_lt_cat_ind++) {
+                for (k = 0; k < num_out_vals; k++) {
+                    refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][k] =
+                        (float) zone_acc[((long) zone * num_lt_cats + cur_lt_cat_ind) * num_out_vals + k];
                 }
             }
-            if (cur_lt_cat_ind == NOMATCH) {
-                fprintf(fplog, "Failed to match lt_cat %i: proc_refveg_carbon()\n", cur_lt_cat);
-                return ERROR_IND;
-            }
-            
-            // calculate an area weighted average based on ref veg area for HYDE_YEAR
-            // the unit conversion cancels out when the average is calculated, so don't do it here
-            
-            // soil c
-            refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][soilc_ind] =
-                refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][soilc_ind] +
-                soil_carbon_sage[rv_ind] * refveg_area[grid_ind];
-            
-            // veg c
-            refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][vegc_ind] =
-                refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][vegc_ind] +
-                veg_carbon_sage[rv_ind] * refveg_area[grid_ind];
-            
-            // area
-            refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][area_ind] =
-                refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][area_ind] +
-                refveg_area[grid_ind];
-            
-        }	// end if valid aez cell
-    }	// end for j loop over valid hyde land cells
+        }
+    }
+    free(zone_acc);
+    zonemap_free(&zones);
     
     // write the output file
     
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.refveg_carbon_fname);
-    fpout = fopen(fname,"w"); //float
-    if(fpout == NULL)
+    if((err = csvout_open(fname, &out)) != OK)
     {
         fprintf(fplog,"Failed to open file  %s for write:  proc_refveg_carbon()\n", fname);
-        return ERROR_FILE;
+        return err;
     }
     // write header lines
-    fprintf(fpout,"# File: %s\n", fname);
-    fprintf(fpout,"# Author: %s\n", CODENAME);
-    fprintf(fpout,"# Description: ref veg soil and veg carbon density (Mg/ha) for hyde land cells in country X glu X land type\n");
-    fprintf(fpout,"# Original source: soil c for sage pot veg; veg c for sage pot veg; reference veg; country raster; new glu raster; hyde land area\n");
-    fprintf(fpout,"# ----------\n");
-    fprintf(fpout,"iso,glu_code,land_type,c_type,value");
+    csvout_printf(&out,"# File: %s\n", fname);
+    csvout_printf(&out,"# Author: %s\n", CODENAME);
+    csvout_str(&out,"# Description: ref veg soil and veg carbon density (Mg/ha) for hyde land cells in country X glu X land type\n");
+    csvout_str(&out,"# Original source: soil c for sage pot veg; veg c for sage pot veg; reference veg; country raster; new glu raster; hyde land area\n");
+    csvout_str(&out,"# ----------\n");
+    csvout_str(&out,"iso,glu_code,land_type,c_type,value");
+    
+    if (in_args.out_columnar) {
+        if ((err = coltab_init(&tab, fname, "ref veg soil and veg carbon density (Mg/ha) for hyde land cells in country X glu X land type", "value", "Mg/ha", 4)) != OK) {
+            fprintf(fplog,"Failed to initialize columnar table for %s: proc_refveg_carbon()\n", fname);
+            return err;
+        }
+        coltab_key(&tab, 0, "iso", countryabbrs_iso, NUM_FAO_CTRY);
+        coltab_key(&tab, 1, "glu_code", NULL, 0);
+        coltab_key(&tab, 2, "land_type", NULL, 0);
+        coltab_key(&tab, 3, "c_type", ctype_names, 2);
+    }
     
     // write the records (rounded to integer)
     for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY ; ctry_ind++) {
@@ -305,9 +303,21 @@ int proc_refveg_carbon(args_struct in_args, rinfo_struct raster_info) {
                             global_soilc = global_soilc + refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][soilc_ind];
                             // write the value
                             if (outval_soilc > 0) {
-                                fprintf(fpout,"\n%s,%i,%i,%s", countryabbrs_iso[ctry_ind], ctry_aez_list[ctry_ind][aez_ind],
-                                        lt_cats[cur_lt_cat_ind], "soil_c");
-                                fprintf(fpout,",%.0f", outval_soilc);
+                                csvout_str(&out, "\n");
+                                csvout_str(&out, countryabbrs_iso[ctry_ind]);
+                                csvout_str(&out, ",");
+                                csvout_int(&out, ctry_aez_list[ctry_ind][aez_ind]);
+                                csvout_str(&out, ",");
+                                csvout_int(&out, lt_cats[cur_lt_cat_ind]);
+                                csvout_str(&out, ",soil_c,");
+                                csvout_float(&out, outval_soilc, 0);
+                                if (in_args.out_columnar) {
+                                    tab_keys[0] = ctry_ind;
+                                    tab_keys[1] = ctry_aez_list[ctry_ind][aez_ind];
+                                    tab_keys[2] = lt_cats[cur_lt_cat_ind];
+                                    tab_keys[3] = 0;
+                                    coltab_add(&tab, tab_keys, outval_soilc);
+                                }
                                 nrecords++;
                             }
                         } else if (i == vegc_ind) {
@@ -319,9 +329,21 @@ int proc_refveg_carbon(args_struct in_args, rinfo_struct raster_info) {
                             global_vegc = global_vegc + refveg_carbon_out[ctry_ind][aez_ind][cur_lt_cat_ind][vegc_ind];
                             // write the value
                             if (outval_vegc > 0) {
-                                fprintf(fpout,"\n%s,%i,%i,%s", countryabbrs_iso[ctry_ind], ctry_aez_list[ctry_ind][aez_ind],
-                                        lt_cats[cur_lt_cat_ind], "veg_c");
-                                fprintf(fpout,",%.0f", outval_vegc);
+                                csvout_str(&out, "\n");
+                                csvout_str(&out, countryabbrs_iso[ctry_ind]);
+                                csvout_str(&out, ",");
+                                csvout_int(&out, ctry_aez_list[ctry_ind][aez_ind]);
+                                csvout_str(&out, ",");
+                                csvout_int(&out, lt_cats[cur_lt_cat_ind]);
+                                csvout_str(&out, ",veg_c,");
+                                csvout_float(&out, outval_vegc, 0);
+                                if (in_args.out_columnar) {
+                                    tab_keys[0] = ctry_ind;
+                                    tab_keys[1] = ctry_aez_list[ctry_ind][aez_ind];
+                                    tab_keys[2] = lt_cats[cur_lt_cat_ind];
+                                    tab_keys[3] = 1;
+                                    coltab_add(&tab, tab_keys, outval_vegc);
+                                }
                                 nrecords++;
                             }
                         } // end if soil else veg
@@ -331,7 +353,14 @@ int proc_refveg_carbon(args_struct in_args, rinfo_struct raster_info) {
         } // end for glu loop
     } // end for country loop
     
-    fclose(fpout);
+    if ((err = csvout_close(&out)) != OK) {
+        fprintf(fplog,"Failed to write file %s: proc_refveg_carbon()\n", fname);
+        return err;
+    }
+    if (in_args.out_columnar && (err = coltab_write(&tab)) != OK) {
+        fprintf(fplog,"Failed to write columnar table for %s: proc_refveg_carbon()\n", fname);
+        return err;
+    }
     
     fprintf(fplog, "Wrote file %s: proc_refveg_carbon(); records written=%i\n", fname, nrecords);
     
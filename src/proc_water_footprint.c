@@ -28,9 +28,16 @@
  process only valid sage land cells, as that is where the crop data comes from
     so use the calculated cell area to get water volume, rather than the hyde cell area
  
+ the grids are read in latitude bands of in_args.band_rows rows (see get_band_rows()), so only a band of each
+    water type is in memory at a time, and each band of the working grids is released when it is done (see grid_store.c)
+ 
  serbia and montenegro data are merged
+ the cells of each band are added to their country X glu zones in parallel (see zone_accum.c); the sums are in double
+    precision and do not depend on the number of threads
  
- file names are constructed here, and passed to read_water_footprint()
+ file names are constructed here, and passed to read_water_footprint(), which queues the band reads on a batched reader (raster_io.c)
+ with in_args.io_uring the reads of the next band (of this crop or the next one) go to an io_uring while the current band is processed,
+    so the reader holds two sets of band buffers; otherwise each band is read just before it is processed
  
  the diagnostic outputs are simple binary files of the input data
  these are hardcoded to not output because they require a subdirectory and a fair amount of space
@@ -67,6 +74,58 @@
 
 #include "moirai.h"
 
+// the current latitude band of the four water footprint files
+typedef struct {
+    float *grids[NUM_WF_TYPES];     // blue, green, gray and total depth (mm) of the band
+    int band_start;                 // grid index of the first cell of the band
+} wf_band_struct;
+
+/********
+ static int wf_cell_value(int pos, void *ctx, int *offset, double *vals)
+ the water volumes (m^3) of the sage land cell at pos in land_cells_sage, for zone_accum()
+ a nodata depth adds nothing
+ ********/
+static int wf_cell_value(int pos, void *ctx, int *offset, double *vals)
+{
+    wf_band_struct *band = (wf_band_struct *) ctx;
+    int grid_ind = land_cells_sage[pos];
+    int band_ind = grid_ind - band->band_start;
+    float wf_nodata = NODATA;  // wf binary file nodata value
+    float CONV2M3 = 1000;            // mm * 1km/1000000mm * km2 * 1000000000m3/1km3 so conversion is *1000
+    int i;
+    
+    // multiply the mm depth by the km^2 grid cell area
+    *offset = 0;
+    for (i = 0; i < NUM_WF_TYPES; i++) {
+        vals[i] = (band->grids[i][band_ind] != wf_nodata) ? CONV2M3 * band->grids[i][band_ind] * cell_area[grid_ind] : 0;
+    }
+    return OK;
+}
+
+/********
+ static int wf_queue_band(rio_struct *rio, char *wfpath, const char *crop_name, const char **wf_bases, int row_start, int nrows, int set)
+ queue the reads of a latitude band of the four water footprint files of a crop into a set of band buffers
+ return:    error code
+ ********/
+static int wf_queue_band(rio_struct *rio, char *wfpath, const char *crop_name, const char **wf_bases, int row_start, int nrows, int set)
+{
+    char fname[MAXCHAR];        // current file name to read
+    int err = OK;
+    int i;
+    
+    for (i = 0; i < NUM_WF_TYPES; i++) {
+        strcpy(fname, wfpath);
+        strcat(fname, crop_name);
+        strcat(fname, wf_bases[i]);
+        if ((err = read_water_footprint(fname, row_start, nrows, rio, set * NUM_WF_TYPES + i)) != OK) {
+            fprintf(fplog, "Failed to read file %s for input: proc_water_footprint()\n", fname);
+            return err;
+        }
+    }
+    
+    return OK;
+}
+
 int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
     
     // valid values in the sage land area data set determine the land cells to process
@@ -75,40 +134,46 @@ int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
     int crop_index;             // the index for looping over wf crops
     int err = OK;				// store error code from the write functions
     
-    int scg_code = 186;         // fao code for serbia and montenegro
-    int srb_code = 272;         // fao code for serbia
-    int mne_code = 273;         // fao code for montenegro
     
-    float *bl_grid;  // 1d array to store current blue raster file; start up left corner, row by row; lon varies faster
-    float *gn_grid;  // 1d array to store current green raster file; start up left corner, row by row; lon varies faster
-    float *gy_grid;  // 1d array to store current gray raster file; start up left corner, row by row; lon varies faster
-    float *tot_grid;  // 1d array to store current total raster file; start up left corner, row by row; lon varies faster
+    rio_struct rio;             // reader of the bands; buffer set * NUM_WF_TYPES + water type, in the order of wf_bases
+    int num_sets;               // 2 sets of band buffers when the next band is read during the current one; else 1
+    int set = 0;                // buffer set of the current band
+    int next_crop;              // crop of the next band
+    int next_row;               // first row of the next band
+    
+    int band_rows = get_band_rows(in_args);   // rows per latitude band
+    int row_start;          // first row of the current band
+    int nrows;              // number of rows in the current band
+    int band_start;         // grid index of the first cell of the current band
+    int band_end;           // grid index after the last cell of the current band
+    
+    zonemap_struct zones;       // the country X glu zone of each sage land cell
+    double *zone_acc;           // water volume of the current crop in each zone; [zone][NUM_WF_TYPES]
+    wf_band_struct band_ctx;    // the current band, for wf_cell_value()
+    int pos_start;              // first position in land_cells_sage of the current band
+    int zone;                   // current zone
     
     // output table as 4-d array; ctry, glu, crop, water type; water type varies fastest
     float ****wf_out;		// the water volume data, in m^3, dim order: blue, green gray, total
     
-    int glu_val;            // current glu value
-    int ctry_code;          // current fao country code
     int glu_ind;            // current glu index in ctry_aez_list[ctry_ind]
     int ctry_ind;           // current country index in ctry_aez_list
     float outval;             // rounded value to write
     int nrecords_wf = 0;           // count # of irrigation records written
     
     char fname[MAXCHAR];        // current file name to read, or write
-    char tmp_str[MAXCHAR];		// stores a temporary string
-    char diag_name[MAXCHAR];	// for diagnostic output names
     
-    FILE *fpout;                // out file pointer
+    csvout_struct out;          // buffered output file
+    coltab_struct tab;          // columnar copy of the table, if out_columnar
+    int tab_keys[4];            // keys of one record for the columnar copy
     
-    float wf_nodata = NODATA;  // wf binary file nodata value
-    float CONV2M3 = 1000;            // mm * 1km/1000000mm * km2 * 1000000000m3/1km3 so conversion is *1000
-    double tmp_dbl = 0;
     
     // wf file names
     const char bl_base[] = "/wfbl_mmyr.gri";   // blue base; 5 arcmin
     const char gn_base[] = "/wfgn_mmyr.gri";   // green base; 5 arcmin
     const char gy_base[] = "/wfgy_mmyr.gri";   // gray base; 5 arcmin
     const char tot_base[] = "/wftot_mmyr.gri";   // total base; 5 arcmin
+    const char *wf_bases[NUM_WF_TYPES] = {bl_base, gn_base, gy_base, tot_base};
     
     // wf crops (these are the data directory names)
     const char *crop_names[NUM_WF_CROPS] = {"Barley", "Cassava", "Coconuts", "Coffee", "Cotton", "Groundnut", "Maize", "Millet", "Oilpalm", "Olives", "Potatoes", "Rapeseed", "Rice", "Sorghum", "Soybean", "Sugarcane", "Sunflower", "Wheat"};
@@ -118,29 +183,12 @@ int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
     
     // allocate arrays
     
-    bl_grid = calloc(NUM_CELLS, sizeof(float));
-    if(bl_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for bl_grid: proc_water_footprint()\n");
-        return ERROR_MEM;
-    }
-    
-    gn_grid = calloc(NUM_CELLS, sizeof(float));
-    if(gn_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for gn_grid: proc_water_footprint()\n");
-        return ERROR_MEM;
-    }
-    
-    gy_grid = calloc(NUM_CELLS, sizeof(float));
-    if(gy_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for gy_grid: proc_water_footprint()\n");
-        return ERROR_MEM;
-    }
-    
-    tot_grid = calloc(NUM_CELLS, sizeof(float));
-    if(tot_grid == NULL) {
-        fprintf(fplog,"Failed to allocate memory for tot_grid: proc_water_footprint()\n");
-        return ERROR_MEM;
+    // the band buffers; the second set is only used with io_uring
+    if ((err = rio_init(&rio, in_args.io_uring, (in_args.io_uring ? 2 : 1) * NUM_WF_TYPES, (size_t) band_rows * NUM_LON * sizeof(float))) != OK) {
+        fprintf(fplog,"Failed to set up the band reader: proc_water_footprint()\n");
+        return err;
     }
+    num_sets = (rio.uring != NULL) ? 2 : 1;
     
     wf_out = calloc(NUM_FAO_CTRY, sizeof(float***));
     if(wf_out == NULL) {
@@ -169,172 +217,90 @@ int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
         } // end for j loop over glus
     } // end for i loop over fao country
     
+    // the country X glu zone of each sage land cell
+    if ((err = zonemap_init(&zones, in_args, land_cells_sage, num_land_cells_sage, raster_info)) != OK) {
+        fprintf(fplog, "Failed to map the sage land cells to zones: proc_water_footprint()\n");
+        return err;
+    }
+    zone_acc = calloc((size_t) zones.num_zones * NUM_WF_TYPES + 1, sizeof(double));
+    if(zone_acc == NULL) {
+        fprintf(fplog,"Failed to allocate memory for zone_acc: proc_water_footprint()\n");
+        return ERROR_MEM;
+    }
+    
+    // queue the first band
+    nrows = (win_row_min + band_rows <= win_row_max + 1) ? band_rows : win_row_max + 1 - win_row_min;
+    if ((err = wf_queue_band(&rio, in_args.wfpath, crop_names[0], wf_bases, win_row_min, nrows, set)) != OK) {
+        return err;
+    }
+    
     // loop over the wf crops
     for (crop_index = 0; crop_index < NUM_WF_CROPS; crop_index++) {
         
-        // read the blue water file
-        strcpy(fname, in_args.wfpath);
-        strcat(fname, crop_names[crop_index]);
-        strcat(fname, bl_base);
-        if((err = read_water_footprint(fname, bl_grid)) != OK)
-        {
-            fprintf(fplog, "Failed to read file %s for input: proc_water_footprint()\n",fname);
-            return err;
-        }
+        memset(zone_acc, 0, (size_t) zones.num_zones * NUM_WF_TYPES * sizeof(double));
         
-        // read the green water file
-        strcpy(fname, in_args.wfpath);
-        strcat(fname, crop_names[crop_index]);
-        strcat(fname, gn_base);
-        if((err = read_water_footprint(fname, gn_grid)) != OK)
-        {
-            fprintf(fplog, "Failed to read file %s for input: proc_water_footprint()\n",fname);
-            return err;
-        }
-        
-        // read the gray water file
-        strcpy(fname, in_args.wfpath);
-        strcat(fname, crop_names[crop_index]);
-        strcat(fname, gy_base);
-        if((err = read_water_footprint(fname, gy_grid)) != OK)
-        {
-            fprintf(fplog, "Failed to read file %s for input: proc_water_footprint()\n",fname);
-            return err;
-        }
-        
-        // read the total water file
-        strcpy(fname, in_args.wfpath);
-        strcat(fname, crop_names[crop_index]);
-        strcat(fname, tot_base);
-        if((err = read_water_footprint(fname, tot_grid)) != OK)
-        {
-            fprintf(fplog, "Failed to read file %s for input: proc_water_footprint()\n",fname);
-            return err;
-        }
-        
-        // loop over the valid sage land cells
-        //  and skip it if no valid glu value or country value
-        for (j = 0; j < num_land_cells_sage; j++) {
-            glu_val = aez_bounds_new[land_cells_sage[j]];
-            ctry_code = country_fao[land_cells_sage[j]];
+        // stream the grids through latitude bands, reading only the processing window rows
+        j = 0;
+        for (row_start = win_row_min; row_start <= win_row_max; row_start = row_start + band_rows) {
+            nrows = (row_start + band_rows <= win_row_max + 1) ? band_rows : win_row_max + 1 - row_start;
+            band_start = row_start * NUM_LON;
+            band_end = band_start + nrows * NUM_LON;
             
-            if (glu_val != raster_info.aez_new_nodata) {
-                // get the fao country index
-                ctry_ind = NOMATCH;
-                for (i = 0; i < NUM_FAO_CTRY; i++) {
-                    if (countrycodes_fao[i] == ctry_code) {
-                        ctry_ind = i;
-                        break;
-                    }
-                } // end for i loop to get ctry index
-                
-                // merge serbia and montenegro for scg record
-                if (ctry_code == mne_code || ctry_code == srb_code) {
-                    ctry_code = scg_code;
-                    ctry_ind = NOMATCH;
-                    for (i = 0; i < NUM_FAO_CTRY; i++) {
-                        if (countrycodes_fao[i] == ctry_code) {
-                            ctry_ind = i;
-                            break;
-                        }
-                    }
-                    if (ctry_ind == NOMATCH) {
-                        // this should never happen
-                        fprintf(fplog, "Error finding scg ctry index: proc_water_footprint()\n");
-                        return ERROR_IND;
-                    }
-                } // end if serbia or montenegro
-				
-				if (ctry_ind == NOMATCH || ctry2ctry87codes_gtap[ctry_ind] == NOMATCH) {
-					continue;
-				}
-				
-                // get the glu index within the country glu list
-                glu_ind = NOMATCH;
-                for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-                    if (ctry_aez_list[ctry_ind][i] == glu_val) {
-                        glu_ind = i;
-                        break;
-                    }
-                } // end for i loop to get glu index
-                
-                // this shouldn't happen because the countryXglu list has been made already
-                if (glu_ind == NOMATCH) {
-                    fprintf(fplog, "Failed to match glu %i to country %i: proc_water_footprint()\n",glu_val,ctry_code);
-                    return ERROR_IND;
-                }
-                
-                //if(ctry_code == 103 && glu_val == 84) {
-                if(0) {
-                    printf("grid_ind = %i; x = %f, y = %i\n", land_cells_sage[j], modf(land_cells_sage[j]/NUM_LON, &tmp_dbl) + 1, land_cells_sage[j]/NUM_LON + 1);
-                    printf("blue = %f\nwf_out_blu = %f\n", bl_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][0]);
-                    printf("green = %f\nwf_out_grn = %f\n", gn_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][1]);
-                    printf("gray = %f\nwf_out_gry = %f\n", gy_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][2]);
-                    printf("tot = %f\nwf_out_tot = %f\n", tot_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][3]);
-                }
-                
-                // multiply the mm depth by the km^2 grid cell area and add it to the total for this country/glu/crop/wftype
-                // check for valid values first
-                
-                if (bl_grid[land_cells_sage[j]] != wf_nodata) {
-                    wf_out[ctry_ind][glu_ind][crop_index][0] = wf_out[ctry_ind][glu_ind][crop_index][0] +
-                        CONV2M3 * bl_grid[land_cells_sage[j]] * cell_area[land_cells_sage[j]];
-                }
-                if (gn_grid[land_cells_sage[j]] != wf_nodata) {
-                    wf_out[ctry_ind][glu_ind][crop_index][1] = wf_out[ctry_ind][glu_ind][crop_index][1] +
-                        CONV2M3 * gn_grid[land_cells_sage[j]] * cell_area[land_cells_sage[j]];
-                }
-                if (gy_grid[land_cells_sage[j]] != wf_nodata) {
-                    wf_out[ctry_ind][glu_ind][crop_index][2] = wf_out[ctry_ind][glu_ind][crop_index][2] +
-                        CONV2M3 * gy_grid[land_cells_sage[j]] * cell_area[land_cells_sage[j]];
-                }
-                if (tot_grid[land_cells_sage[j]] != wf_nodata) {
-                    wf_out[ctry_ind][glu_ind][crop_index][3] = wf_out[ctry_ind][glu_ind][crop_index][3] +
-                        CONV2M3 * tot_grid[land_cells_sage[j]] * cell_area[land_cells_sage[j]];
-                }
-                
-                //if(ctry_code == 103 && glu_val == 84) {
-                if(0) {
-                    printf("blue = %f\nwf_out_blu = %f\n", bl_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][0]);
-                    printf("green = %f\nwf_out_grn = %f\n", gn_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][1]);
-                    printf("gray = %f\nwf_out_gry = %f\n", gy_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][2]);
-                    printf("tot = %f\nwf_out_tot = %f\n", tot_grid[land_cells_sage[j]], wf_out[ctry_ind][glu_ind][crop_index][3]);
-                }
-                
-            }	// end if valid glu cell
-        }	// end for j loop over valid sage land cells
-        
-        if (0) {
-            // blue
-            sprintf(tmp_str, "%s%s_%s%s", "wf_grids/", crop_names[crop_index], wftype_names[0], ".bil");
-            strcpy(diag_name, tmp_str);
-            if ((err = write_raster_float(bl_grid, NUM_CELLS, diag_name, in_args))) {
-                fprintf(fplog, "Error writing file %s: proc_water_footprint()\n", diag_name);
+            // wait for the blue, green, gray and total water files of this band
+            if ((err = rio_wait(&rio)) != OK) {
+                fprintf(fplog, "Failed to read the %s band at row %i for input: proc_water_footprint()\n", crop_names[crop_index], row_start);
                 return err;
             }
-            // green
-            sprintf(tmp_str, "%s%s_%s%s", "wf_grids/", crop_names[crop_index], wftype_names[1], ".bil");
-            strcpy(diag_name, tmp_str);
-            if ((err = write_raster_float(gn_grid, NUM_CELLS, diag_name, in_args))) {
-                fprintf(fplog, "Error writing file %s: proc_water_footprint()\n", diag_name);
+            
+            // the next band is in this crop or at the start of the next one
+            next_crop = crop_index;
+            next_row = row_start + band_rows;
+            if (next_row > win_row_max) {
+                next_crop++;
+                next_row = win_row_min;
+            }
+            
+            // with two buffer sets, read the next band while this one is processed
+            if (num_sets == 2 && next_crop < NUM_WF_CROPS &&
+                (err = wf_queue_band(&rio, in_args.wfpath, crop_names[next_crop], wf_bases, next_row,
+                                     (next_row + band_rows <= win_row_max + 1) ? band_rows : win_row_max + 1 - next_row, 1 - set)) != OK) {
                 return err;
             }
-            // gray
-            sprintf(tmp_str, "%s%s_%s%s", "wf_grids/", crop_names[crop_index], wftype_names[2], ".bil");
-            strcpy(diag_name, tmp_str);
-            if ((err = write_raster_float(gy_grid, NUM_CELLS, diag_name, in_args))) {
-                fprintf(fplog, "Error writing file %s: proc_water_footprint()\n", diag_name);
+            
+            // add the valid sage land cells in this band to their country X glu zones
+            // land_cells_sage is in grid order, so the band cells follow the previous band
+            for (i = 0; i < NUM_WF_TYPES; i++) {
+                band_ctx.grids[i] = (float *) rio.bufs[set * NUM_WF_TYPES + i];
+            }
+            band_ctx.band_start = band_start;
+            pos_start = j;
+            while (j < num_land_cells_sage && land_cells_sage[j] < band_end) {
+                j++;
+            }
+            if ((err = zone_accum(&zones, pos_start, j, NUM_WF_TYPES, NUM_WF_TYPES, wf_cell_value, &band_ctx, zone_acc)) != OK) {
+                fprintf(fplog, "Failed to accumulate the band at row %i: proc_water_footprint()\n", row_start);
                 return err;
             }
-            // total
-            sprintf(tmp_str, "%s%s_%s%s", "wf_grids/", crop_names[crop_index], wftype_names[3], ".bil");
-            strcpy(diag_name, tmp_str);
-            if ((err = write_raster_float(tot_grid, NUM_CELLS, diag_name, in_args))) {
-                fprintf(fplog, "Error writing file %s: proc_water_footprint()\n", diag_name);
+            grid_release_rows(row_start, nrows);
+            
+            // with one buffer set, read the next band now that this one is done
+            if (num_sets == 1 && next_crop < NUM_WF_CROPS &&
+                (err = wf_queue_band(&rio, in_args.wfpath, crop_names[next_crop], wf_bases, next_row,
+                                     (next_row + band_rows <= win_row_max + 1) ? band_rows : win_row_max + 1 - next_row, set)) != OK) {
                 return err;
             }
-        }
+            set = (set + 1) % num_sets;
+        }   // end for row_start loop over the latitude bands
+        
         
+        for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY; ctry_ind++) {
+            for (glu_ind = 0; glu_ind < ctry_aez_num[ctry_ind]; glu_ind++) {
+                zone = zones.zone_start[ctry_ind] + glu_ind;
+                for (i = 0; i < NUM_WF_TYPES; i++) {
+                    wf_out[ctry_ind][glu_ind][crop_index][i] = (float) zone_acc[NUM_WF_TYPES * zone + i];
+                }
+            }
+        }
     }   // end for loop over the wf crops
     
     // write the output file
@@ -342,19 +308,29 @@ int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
     // water footprint
     strcpy(fname, in_args.outpath);
     strcat(fname, in_args.wf_fname);
-    fpout = fopen(fname,"w"); //float
-    if(fpout == NULL)
+    if((err = csvout_open(fname, &out)) != OK)
     {
         fprintf(fplog,"Failed to open file  %s for write:  proc_water_footprint()\n", fname);
-        return ERROR_FILE;
+        return err;
     }
     // write header lines
-    fprintf(fpout,"# File: %s\n", fname);
-    fprintf(fpout,"# Author: %s\n", CODENAME);
-    fprintf(fpout,"# Description: crop average annual water volume consumed (m^3) for land cells in country X glu\n");
-    fprintf(fpout,"# Original source: water footprint network; country raster; glu raster\n");
-    fprintf(fpout,"# ----------\n");
-    fprintf(fpout,"iso,glu_code,SAGE_crop,water_type,value");
+    csvout_printf(&out,"# File: %s\n", fname);
+    csvout_printf(&out,"# Author: %s\n", CODENAME);
+    csvout_str(&out,"# Description: crop average annual water volume consumed (m^3) for land cells in country X glu\n");
+    csvout_str(&out,"# Original source: water footprint network; country raster; glu raster\n");
+    csvout_str(&out,"# ----------\n");
+    csvout_str(&out,"iso,glu_code,SAGE_crop,water_type,value");
+    
+    if (in_args.out_columnar) {
+        if ((err = coltab_init(&tab, fname, "crop average annual water volume consumed (m^3) for land cells in country X glu", "value", "m^3", 4)) != OK) {
+            fprintf(fplog,"Failed to initialize columnar table for %s: proc_water_footprint()\n", fname);
+            return err;
+        }
+        coltab_key(&tab, 0, "iso", countryabbrs_iso, NUM_FAO_CTRY);
+        coltab_key(&tab, 1, "glu_code", NULL, 0);
+        coltab_key(&tab, 2, "SAGE_crop", (char **) crop_names, NUM_WF_CROPS);
+        coltab_key(&tab, 3, "water_type", (char **) wftype_names, NUM_WF_TYPES);
+    }
     
     // write the records (rounded to nearest integer)
     for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY ; ctry_ind++) {
@@ -365,8 +341,23 @@ int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
                     outval = (float) floor((double) 0.5 + wf_out[ctry_ind][glu_ind][crop_index][i]);
                     // output only positive values
                     if (outval > 0) {
-                        fprintf(fpout,"\n%s,%i,%s,%s,%.0f", countryabbrs_iso[ctry_ind], ctry_aez_list[ctry_ind][glu_ind],
-                                crop_names[crop_index], wftype_names[i], outval);
+                        csvout_str(&out, "\n");
+                        csvout_str(&out, countryabbrs_iso[ctry_ind]);
+                        csvout_str(&out, ",");
+                        csvout_int(&out, ctry_aez_list[ctry_ind][glu_ind]);
+                        csvout_str(&out, ",");
+                        csvout_str(&out, crop_names[crop_index]);
+                        csvout_str(&out, ",");
+                        csvout_str(&out, wftype_names[i]);
+                        csvout_str(&out, ",");
+                        csvout_float(&out, outval, 0);
+                        if (in_args.out_columnar) {
+                            tab_keys[0] = ctry_ind;
+                            tab_keys[1] = ctry_aez_list[ctry_ind][glu_ind];
+                            tab_keys[2] = crop_index;
+                            tab_keys[3] = i;
+                            coltab_add(&tab, tab_keys, outval);
+                        }
                         nrecords_wf++;
                     } // end if value is positive
                 } // end for water type loop
@@ -374,14 +365,20 @@ int proc_water_footprint(args_struct in_args, rinfo_struct raster_info) {
         } // end for glu loop
     } // end for country loop
     
-    fclose(fpout);
+    if ((err = csvout_close(&out)) != OK) {
+        fprintf(fplog,"Failed to write file %s: proc_water_footprint()\n", fname);
+        return err;
+    }
+    if (in_args.out_columnar && (err = coltab_write(&tab)) != OK) {
+        fprintf(fplog,"Failed to write columnar table for %s: proc_water_footprint()\n", fname);
+        return err;
+    }
     
     fprintf(fplog, "Wrote file %s: proc_water_footprint(); records written=%i\n", fname, nrecords_wf);
     
-    free(bl_grid);
-    free(gn_grid);
-    free(gy_grid);
-    free(tot_grid);
+    rio_free(&rio);
+    free(zone_acc);
+    zonemap_free(&zones);
     for (i = 0; i < NUM_FAO_CTRY; i++) {
         for (j = 0; j < ctry_aez_num[i]; j++) {
             for (k = 0; k < NUM_WF_CROPS; k++) {
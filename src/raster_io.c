@@ -0,0 +1,472 @@
+/**********
+ raster_io.c
+
+ contains the following functions for batched reads of binary raster data:
+	rio_init()
+	rio_read()
+	rio_wait()
+	rio_free()
+
+ a reader owns a set of buffers; rio_read() queues a read of part of a file into one of them and rio_wait() waits
+  for all of the queued reads, so the caller can queue the reads of the next band and process the current one meanwhile
+ with in_args.io_uring set and a build with USE_IO_URING (see the makefile), the reads go to a linux io_uring:
+  rio_read() submits the read at once, and the buffers are registered with the ring so the kernel does not map them each time
+ otherwise, or if the ring cannot be set up (an old kernel, or one that does not allow it), rio_read() reads the data
+  with pread() before it returns, and rio_wait() only reports the result
+ the ring system calls are made directly, so no library is needed
+ the files are not opened with O_DIRECT, because the bands are not aligned to the disk blocks, and reruns read from the page cache
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#define _DEFAULT_SOURCE
+
+#include "moirai.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(USE_IO_URING) && defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+// the mapped rings of an io_uring
+typedef struct {
+	int ring_fd;					// the ring file descriptor
+	void *sq_ptr;					// mapped submission ring
+	size_t sq_len;
+	void *cq_ptr;					// mapped completion ring; the same as sq_ptr with IORING_FEAT_SINGLE_MMAP
+	size_t cq_len;
+	struct io_uring_sqe *sqes;		// mapped submission entries
+	size_t sqes_len;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+} uring_struct;
+
+/********
+ static void uring_close(uring_struct *ring)
+ unmap the rings and close the ring
+ ********/
+static void uring_close(uring_struct *ring)
+{
+	if (ring->sqes != NULL) {
+		munmap(ring->sqes, ring->sqes_len);
+	}
+	if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr) {
+		munmap(ring->cq_ptr, ring->cq_len);
+	}
+	if (ring->sq_ptr != NULL) {
+		munmap(ring->sq_ptr, ring->sq_len);
+	}
+	if (ring->ring_fd >= 0) {
+		close(ring->ring_fd);
+	}
+	free(ring);
+}
+
+/********
+ static uring_struct *uring_open(unsigned entries, void **bufs, int num_bufs, size_t buf_bytes)
+ set up a ring and register the buffers with it
+ return:	the ring, or NULL if io_uring cannot be used
+ ********/
+static uring_struct *uring_open(unsigned entries, void **bufs, int num_bufs, size_t buf_bytes)
+{
+	uring_struct *ring;
+	struct io_uring_params params;
+	struct iovec *iov;
+	int i;
+	int rv;
+
+	ring = calloc(1, sizeof(uring_struct));
+	iov = calloc(num_bufs, sizeof(struct iovec));
+	if (ring == NULL || iov == NULL) {
+		free(ring);
+		free(iov);
+		return NULL;
+	}
+
+	memset(&params, 0, sizeof(params));
+	ring->ring_fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+	if (ring->ring_fd < 0) {
+		free(ring);
+		free(iov);
+		return NULL;
+	}
+
+	// map the submission and completion rings, which share one mapping on newer kernels
+	ring->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->sq_len = (ring->cq_len > ring->sq_len) ? ring->cq_len : ring->sq_len;
+		ring->cq_len = ring->sq_len;
+	}
+	ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED) {
+		ring->sq_ptr = NULL;
+		uring_close(ring);
+		free(iov);
+		return NULL;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ptr == MAP_FAILED) {
+			ring->cq_ptr = NULL;
+			uring_close(ring);
+			free(iov);
+			return NULL;
+		}
+	}
+	ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		uring_close(ring);
+		free(iov);
+		return NULL;
+	}
+
+	ring->sq_tail = (unsigned *) ((char *) ring->sq_ptr + params.sq_off.tail);
+	ring->sq_mask = (unsigned *) ((char *) ring->sq_ptr + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned *) ((char *) ring->sq_ptr + params.sq_off.array);
+	ring->cq_head = (unsigned *) ((char *) ring->cq_ptr + params.cq_off.head);
+	ring->cq_tail = (unsigned *) ((char *) ring->cq_ptr + params.cq_off.tail);
+	ring->cq_mask = (unsigned *) ((char *) ring->cq_ptr + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_ptr + params.cq_off.cqes);
+
+	// register the buffers, for IORING_OP_READ_FIXED
+	for (i = 0; i < num_bufs; i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = buf_bytes;
+	}
+	rv = (int) syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_BUFFERS, iov, num_bufs);
+	free(iov);
+	if (rv < 0) {
+		uring_close(ring);
+		return NULL;
+	}
+
+	return ring;
+}
+
+/********
+ static int uring_cancel(uring_struct *ring, rio_struct *rio)
+ ask the ring to cancel the reads that are still pending
+ each cancel request has the user data RIO_MAX_READS + req, so it is not taken for a read when it completes
+ return:	the number of cancel requests submitted, or -1 if the ring does not take them
+ ********/
+static int uring_cancel(uring_struct *ring, rio_struct *rio)
+{
+	int req;
+	int num_cancel = 0;
+	unsigned tail = *ring->sq_tail;
+	unsigned ind;
+	struct io_uring_sqe *sqe;
+
+	for (req = 0; req < rio->num_queued; req++) {
+		if (rio->result[req] != RIO_PENDING) {
+			continue;
+		}
+		ind = tail & *ring->sq_mask;
+		sqe = &ring->sqes[ind];
+		memset(sqe, 0, sizeof(struct io_uring_sqe));
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->addr = (unsigned long long) req;
+		sqe->user_data = (unsigned long long) (RIO_MAX_READS + req);
+		ring->sq_array[ind] = ind;
+		tail++;
+		num_cancel++;
+	}
+	__atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+	if (num_cancel > 0 && syscall(__NR_io_uring_enter, ring->ring_fd, num_cancel, 0, 0, NULL, 0) < 0) {
+		return -1;
+	}
+
+	return num_cancel;
+}
+#endif
+
+/********
+ int rio_init(rio_struct *rio, int use_uring, int num_bufs, size_t buf_bytes)
+ allocate the zeroed buffers of a reader, and set up the io_uring if it is requested and available
+ use_uring:	1 to read through io_uring (in_args.io_uring)
+ num_bufs:	number of buffers; at most RIO_MAX_READS
+ buf_bytes:	size of each buffer, in bytes
+ return:	error code
+ ********/
+int rio_init(rio_struct *rio, int use_uring, int num_bufs, size_t buf_bytes)
+{
+	int i;
+
+	memset(rio, 0, sizeof(rio_struct));
+	if (num_bufs > RIO_MAX_READS) {
+		fprintf(fplog, "Error: %i buffers is more than %i: rio_init()\n", num_bufs, RIO_MAX_READS);
+		return ERROR_IND;
+	}
+	rio->num_bufs = num_bufs;
+	rio->buf_bytes = buf_bytes;
+
+	rio->bufs = calloc(num_bufs, sizeof(void*));
+	if (rio->bufs == NULL) {
+		fprintf(fplog, "Failed to allocate memory for bufs: rio_init()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i < num_bufs; i++) {
+		rio->bufs[i] = calloc(buf_bytes, 1);
+		if (rio->bufs[i] == NULL) {
+			fprintf(fplog, "Failed to allocate memory for bufs[%i]: rio_init()\n", i);
+			return ERROR_MEM;
+		}
+	}
+
+	if (use_uring) {
+#if defined(USE_IO_URING) && defined(__linux__)
+		rio->uring = uring_open(RIO_MAX_READS, rio->bufs, num_bufs, buf_bytes);
+		if (rio->uring == NULL) {
+			fprintf(fplog, "io_uring is not available (%s); the rasters are read with pread: rio_init()\n", strerror(errno));
+		}
+#else
+		fprintf(fplog, "This build does not include io_uring (USE_IO_URING); the rasters are read with pread: rio_init()\n");
+#endif
+	}
+
+	return OK;
+}
+
+/********
+ static int pread_all(int fd, char *buf, size_t nbytes, long offset)
+ read nbytes at offset, continuing after short reads
+ return:	the number of bytes read, or -1 on error
+ ********/
+static long pread_all(int fd, char *buf, size_t nbytes, long offset)
+{
+	size_t done = 0;
+	ssize_t nread;
+
+	while (done < nbytes) {
+		nread = pread(fd, buf + done, nbytes - done, (off_t) (offset + done));
+		if (nread < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		if (nread == 0) {
+			break;
+		}
+		done = done + nread;
+	}
+
+	return (long) done;
+}
+
+/********
+ int rio_read(rio_struct *rio, char *fname, long offset, size_t nbytes, int buf_ind)
+ queue a read of nbytes at offset of a file into a buffer
+ the data are in rio->bufs[buf_ind] after the next rio_wait(); the buffer must not be used before then
+ fname:		the file name with path
+ offset:	the first byte to read
+ nbytes:	number of bytes to read; at most rio->buf_bytes
+ buf_ind:	the buffer to read into
+ return:	error code
+ ********/
+int rio_read(rio_struct *rio, char *fname, long offset, size_t nbytes, int buf_ind)
+{
+	int req = rio->num_queued;
+	long nread;
+
+	if (req >= RIO_MAX_READS || buf_ind < 0 || buf_ind >= rio->num_bufs || nbytes > rio->buf_bytes) {
+		fprintf(fplog, "Error: cannot queue read %i of %zu bytes into buffer %i of file %s: rio_read()\n", req, nbytes, buf_ind, fname);
+		return ERROR_IND;
+	}
+
+	if ((rio->fd[req] = open(fname, O_RDONLY)) < 0) {
+		fprintf(fplog, "Failed to open file %s: rio_read()\n", fname);
+		return ERROR_FILE;
+	}
+	strcpy(rio->fname[req], fname);
+	rio->offset[req] = offset;
+	rio->nbytes[req] = nbytes;
+	rio->buf_ind[req] = buf_ind;
+	rio->num_queued++;
+
+#if defined(USE_IO_URING) && defined(__linux__)
+	// after a ring failure (rio->num_lost) the later reads use pread
+	if (rio->uring != NULL && rio->num_lost == 0) {
+		uring_struct *ring = (uring_struct *) rio->uring;
+		unsigned tail = *ring->sq_tail;
+		unsigned ind = tail & *ring->sq_mask;
+		struct io_uring_sqe *sqe = &ring->sqes[ind];
+
+		memset(sqe, 0, sizeof(struct io_uring_sqe));
+		sqe->opcode = IORING_OP_READ_FIXED;
+		sqe->fd = rio->fd[req];
+		sqe->off = (unsigned long long) offset;
+		sqe->addr = (unsigned long long) (uintptr_t) rio->bufs[buf_ind];
+		sqe->len = (unsigned) nbytes;
+		sqe->buf_index = (unsigned short) buf_ind;
+		sqe->user_data = (unsigned long long) req;
+		ring->sq_array[ind] = ind;
+		__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+		// submit now, so the read runs while the caller works
+		if (syscall(__NR_io_uring_enter, ring->ring_fd, 1, 0, 0, NULL, 0) == 1) {
+			rio->result[req] = RIO_PENDING;
+			return OK;
+		}
+		// the entry was not taken; it is overwritten by the next one, and this read is done below instead
+		__atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+	}
+#endif
+
+	nread = pread_all(rio->fd[req], (char *) rio->bufs[buf_ind], nbytes, offset);
+	rio->result[req] = (nread < 0) ? -errno : nread;
+
+	return OK;
+}
+
+/********
+ int rio_wait(rio_struct *rio)
+ wait for all of the queued reads, and close their files
+ a read that returned less than it asked for, or failed, is an error
+ return:	error code
+ ********/
+int rio_wait(rio_struct *rio)
+{
+	int req;
+	long nread;
+	int err = OK;
+
+#if defined(USE_IO_URING) && defined(__linux__)
+	if (rio->uring != NULL) {
+		uring_struct *ring = (uring_struct *) rio->uring;
+		unsigned head, tail;
+		int num_pending = 0;
+
+		for (req = 0; req < rio->num_queued; req++) {
+			if (rio->result[req] == RIO_PENDING) {
+				num_pending++;
+			}
+		}
+		// the buffers and files must not be released while the kernel may still read into them
+		// so if waiting fails, the pending reads are cancelled and their completions are still waited for
+		// only if the ring cannot be waited on at all are they left in flight (rio->num_lost), and rio_free() keeps their buffers
+		while (num_pending > 0) {
+			head = *ring->cq_head;
+			tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+			if (head == tail) {
+				if (syscall(__NR_io_uring_enter, ring->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR) {
+					fprintf(fplog, "Error waiting for io_uring reads: rio_wait(); %s\n", strerror(errno));
+					if (err == OK) {
+						err = ERROR_FILE;
+						if (uring_cancel(ring, rio) >= 0) {
+							continue;
+						}
+					}
+					fprintf(fplog, "Error: %i io_uring reads cannot be cancelled or waited for; their buffers and files are left open: rio_wait()\n",
+							num_pending);
+					rio->num_lost = num_pending;
+					break;
+				}
+				continue;
+			}
+			for ( ; head != tail; head++) {
+				struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+				req = (int) cqe->user_data;
+				if (req >= 0 && req < rio->num_queued && rio->result[req] == RIO_PENDING) {
+					rio->result[req] = cqe->res;
+					num_pending--;
+				}
+			}
+			__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+		}
+	}
+#endif
+
+	for (req = 0; req < rio->num_queued; req++) {
+		// a read still in flight keeps its file
+		if (rio->result[req] == RIO_PENDING) {
+			continue;
+		}
+		// finish a short read
+		if (err == OK && rio->result[req] >= 0 && (size_t) rio->result[req] < rio->nbytes[req]) {
+			nread = pread_all(rio->fd[req], (char *) rio->bufs[rio->buf_ind[req]] + rio->result[req],
+							  rio->nbytes[req] - rio->result[req], rio->offset[req] + rio->result[req]);
+			rio->result[req] = (nread < 0) ? -errno : rio->result[req] + nread;
+		}
+		if (err == OK && (rio->result[req] < 0 || (size_t) rio->result[req] != rio->nbytes[req])) {
+			fprintf(fplog, "Error reading file %s: rio_wait(); read %li of %zu bytes at %li; %s\n", rio->fname[req],
+					(rio->result[req] < 0) ? 0 : rio->result[req], rio->nbytes[req], rio->offset[req],
+					(rio->result[req] < 0) ? strerror((int) -rio->result[req]) : "end of file");
+			err = ERROR_FILE;
+		}
+		close(rio->fd[req]);
+	}
+	rio->num_queued = 0;
+
+	return err;
+}
+
+/********
+ void rio_free(rio_struct *rio)
+ free the buffers and close the io_uring; any queued reads are waited for first
+ if reads were left in flight by a failed ring (rio->num_lost), closing the ring cancels them,
+  but their buffers are not freed, because the kernel may still write to them
+ ********/
+void rio_free(rio_struct *rio)
+{
+	int i;
+
+	if (rio->num_queued > 0) {
+		rio_wait(rio);
+	}
+#if defined(USE_IO_URING) && defined(__linux__)
+	if (rio->uring != NULL) {
+		uring_close((uring_struct *) rio->uring);
+		rio->uring = NULL;
+	}
+#endif
+	if (rio->num_lost > 0) {
+		fprintf(fplog, "Warning: the buffers of %i lost io_uring reads are not freed: rio_free()\n", rio->num_lost);
+		return;
+	}
+	if (rio->bufs != NULL) {
+		for (i = 0; i < rio->num_bufs; i++) {
+			free(rio->bufs[i]);
+		}
+		free(rio->bufs);
+		rio->bufs = NULL;
+	}
+}
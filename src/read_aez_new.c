@@ -48,12 +48,12 @@ int read_aez_new(args_struct in_args, rinfo_struct *raster_info) {
 	// 4 byte signed integers
 	// 5 arcmin resolution, extent = (-180,180, -90, 90), WGS84
 	
-	int nrows = 2160;				// num input lats
-	int ncols = 4320;				// num input lons
+	int nrows = NUM_LAT;				// num input lats
+	int ncols = NUM_LON;				// num input lons
 	int ncells = nrows * ncols;		// number of input grid cells
 	int nodata = -9999;             // nodata value
 	int insize = 4;					// 4 byte integers for input
-	double res = 5.0 / 60.0;		// resolution
+	double res = GRID_RES;		// resolution
 	double xmin = -180.0;			// longitude min grid boundary
 	double xmax = 180.0;			// longitude max grid boundary
 	double ymin = -90.0;			// latitude min grid boundary
@@ -82,18 +82,24 @@ int read_aez_new(args_struct in_args, rinfo_struct *raster_info) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.aez_new_fname);
 	
+	// the file must be on the working grid
+	if (check_grid_file(fname, insize) != OK) {
+		fprintf(fplog,"Input file %s is not on the working grid:  read_aez_new()\n", fname);
+		return ERROR_FILE;
+	}
+	
 	if((fpin = fopen(fname, "rb")) == NULL)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_aez_new()\n", fname);
 		return ERROR_FILE;
 	}
 	
-	// read the data
+	// read the data; the glu codes stay 4-byte ints, because a glu set may have more codes than 16 bits can hold
 	num_read = fread(aez_bounds_new, insize, ncells, fpin);
 	fclose(fpin);
 	if(num_read != ncells)
 	{
-		fprintf(fplog, "Error reading file %s: read_aez_new(); num_read=%i != overlap_cols=%i\n",
+		fprintf(fplog, "Error reading file %s: read_aez_new(); num_read=%i != ncells=%i\n",
 					fname, num_read, ncells);
 		return ERROR_FILE;
 	}
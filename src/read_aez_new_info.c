@@ -2,7 +2,7 @@
   read_aez_new_info.c
 
   ids and names corresponding to aez_bounds_new
-  the number ids must range from 1 to NUM_NEW_AEZ
+  the number ids must be unique and non-negative, but need not be contiguous; see init_glu_index()
 
   arguments:
   args_struct in_args: the input file arguments
@@ -45,11 +45,9 @@ int read_aez_new_info(args_struct in_args) {
     // the second column is the name of the aez
     
     int i;
-    int nrecords = 0;               // count number of new AEZs
     
     char fname[MAXCHAR];			// file name to open
-    FILE *fpin;						// file pointer
-    char rec_str[MAXRECSIZE];		// string to hold one record
+    csvfile_struct csv;				// the csv file, indexed by record
     const char* delim = ",";		// delimiter string for csv file
     int err = OK;					// error code for the string parsing function
     int out_index = 0;				// the index of the arrays to fill
@@ -58,26 +56,15 @@ int read_aez_new_info(args_struct in_args) {
     strcpy(fname, in_args.inpath);
     strcat(fname, in_args.aez_new_info_fname);
     
-    if((fpin = fopen(fname, "r")) == NULL)
+    // skip the header line and index the records
+    if((err = csv_open(fname, delim, 1, &csv)) != OK)
     {
         fprintf(fplog,"Failed to open file %s:  read_aez_new_info()\n", fname);
-        return ERROR_FILE;
-    }
-    
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_aez_new_info()\n", fname);
-        return ERROR_FILE;
-    }
-    
-    // count the records
-    while (fscanf(fpin, "%*[^\n]\n") != EOF) {
-        nrecords++;
+        return err;
     }
     
     // set the number of new aezs
-    NUM_NEW_AEZ = nrecords;
+    NUM_NEW_AEZ = csv.num_recs;
     
     // allocate the arrays
     aez_codes_new = calloc(NUM_NEW_AEZ, sizeof(int));
@@ -98,43 +85,33 @@ int read_aez_new_info(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_aez_new_info()\n", fname);
-        return ERROR_FILE;
-    }
-    
     // read the aez new info records
     for (i = 0; i < NUM_NEW_AEZ; i++) {
-        if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+        if ((err = csv_get_record(&csv, i)) == OK) {
             // get the intger code
-            if((err = get_int_field(rec_str, delim, 1, &aez_codes_new[out_index])) != OK) {
+            if((err = csv_get_int(&csv, 1, &aez_codes_new[out_index])) != OK) {
                 fprintf(fplog, "Error processing file %s: read_aez_new_info(); record=%i, column=1\n",
                         fname, i + 1);
                 return err;
             }
             // get the name
-            if((err = get_text_field(rec_str, delim, 2, &aez_names_new[out_index++][0])) != OK) {
+            if((err = csv_get_text(&csv, 2, &aez_names_new[out_index++][0])) != OK) {
                 fprintf(fplog, "Error processing file %s: read_aez_new_info(); record=%i, column=2\n",
                         fname, i + 1);
                 return err;
             }
         }else {
             fprintf(fplog, "Error reading file %s: read_aez_new_info(); record=%i\n", fname, i + 1);
-            return ERROR_FILE;
+            return err;
         }
     } // end for loop over records
     
-    fclose(fpin);
+    csv_close(&csv);
     
-    if(i != NUM_NEW_AEZ)
-    {
-        fprintf(fplog, "Error reading file %s: read_aez_new_info(); records read=%i != expected=%i\n",
-                fname, i, nrecords);
-        return ERROR_FILE;
+    // the compact glu index and the zone id multiplier
+    if ((err = init_glu_index()) != OK) {
+        fprintf(fplog, "Error indexing the glu codes in file %s: read_aez_new_info()\n", fname);
+        return err;
     }
     
     if (in_args.diagnostics) {
@@ -49,20 +49,18 @@ int read_aez_orig(args_struct in_args, rinfo_struct *raster_info) {
 	// 5 arcmin resolution, extent = (-180,180, -90, 90), WGS84
 	// values are 1 - 18 global climate aezs
 	
-	int nrows = 2160;				// num input lats
-	int ncols = 4320;				// num input lons
+	int nrows = NUM_LAT;				// num input lats
+	int ncols = NUM_LON;				// num input lons
 	int ncells = nrows * ncols;		// number of input grid cells
 	int nodata = -9999;			// nodata value
 	int insize = 4;					// 4 byte integers for input
-	double res = 5.0 / 60.0;		// resolution
+	double res = GRID_RES;		// resolution
 	double xmin = -180.0;			// longitude min grid boundary
 	double xmax = 180.0;			// longitude max grid boundary
 	double ymin = -90.0;			// latitude min grid boundary
 	double ymax = 90.0;				// latitude max grid boundary
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	int num_read;					// how many values read in
 	
 	int err = OK;								// store error code from the write file
 	char out_name[] = "aez_bounds_orig.bil";	// diagnositic output raster file name
@@ -83,24 +81,20 @@ int read_aez_orig(args_struct in_args, rinfo_struct *raster_info) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.aez_orig_fname);
 	
-	if((fpin = fopen(fname, "rb")) == NULL)
-	{
-		fprintf(fplog,"Failed to open file %s:  read_aez_orig()\n", fname);
+	// the file must be on the working grid
+	if (check_grid_file(fname, insize) != OK) {
+		fprintf(fplog,"Input file %s is not on the working grid:  read_aez_orig()\n", fname);
 		return ERROR_FILE;
 	}
 	
-	// read the data
-	num_read = fread(aez_bounds_orig, insize, ncells, fpin);
-	fclose(fpin);
-	if(num_read != ncells)
-	{
-		fprintf(fplog, "Error reading file %s: read_aez_orig(); num_read=%i != overlap_cols=%i\n",
-				fname, num_read, ncells);
-		return ERROR_FILE;
+	// read the data; the aez codes are stored as 8-bit values
+	if ((err = read_raster_thm8(fname, ncells, nodata, aez_bounds_orig))) {
+		fprintf(fplog, "Error reading file %s: read_aez_orig()\n", fname);
+		return err;
 	}
 		
 	if (in_args.diagnostics) {
-		if ((err = write_raster_int(aez_bounds_orig, ncells, out_name, in_args))) {
+		if ((err = write_raster_thm8(aez_bounds_orig, ncells, nodata, out_name, in_args))) {
 			fprintf(fplog, "Error writing file %s: read_aez_orig()\n", out_name);
 			return err;
 		}
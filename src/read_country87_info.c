@@ -64,11 +64,9 @@ int read_country87_info(args_struct in_args) {
 	//  fifth column: ctry87 3-letter abbreviation
 	
 	int i = 0;
-	int nrecords_reg_rent = 0;          // count number of records in region land rent file
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 	
@@ -78,26 +76,15 @@ int read_country87_info(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.country87_gtap_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_country87_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_country87_info()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 	
-	// first count the records
-    while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-        nrecords_reg_rent++;
-    }
-    
     // set the number of gtap87 countries
-    NUM_GTAP_CTRY87 = nrecords_reg_rent;
+    NUM_GTAP_CTRY87 = csv.num_recs;
     
     // now allocate the arrays to hold the data
     country87codes_gtap = calloc(NUM_GTAP_CTRY87, sizeof(int));
@@ -128,51 +115,35 @@ int read_country87_info(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_country87_info()\n", fname);
-        return ERROR_FILE;
-    }
-    
     // now read the records
     for (i = 0; i < NUM_GTAP_CTRY87; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			
 			// get the ctry87 integer code first
-			if((err = get_int_field(rec_str, delim, 1, &country87codes_gtap[i])) != OK) {
+			if((err = csv_get_int(&csv, 1, &country87codes_gtap[i])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country87_info(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the ctry87 abbreviation
-			if((err = get_text_field(rec_str, delim, 2, &country87abbrs_gtap[i][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &country87abbrs_gtap[i][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country87_info(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the ctry87 name
-			if((err = get_text_field(rec_str, delim, 3, &country87names_gtap[i][0])) != OK) {
+			if((err = csv_get_text(&csv, 3, &country87names_gtap[i][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country87_info(); record=%i, column=3\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_country87_info(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over read records
     
-	fclose(fpin);
-	
-    if(i != NUM_GTAP_CTRY87)
-    {
-        fprintf(fplog, "Error reading file %s: read_country87_info(); records read=%i != expected=%i\n",
-                fname, i, NUM_GTAP_CTRY87);
-        return ERROR_FILE;
-    }
+	csv_close(&csv);
 	
 	//////////
 	// read in the fao ctry to ctry87 mapping
@@ -200,52 +171,46 @@ int read_country87_info(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.country87map_fao_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_country87_info()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
+	
+	if(csv.num_recs < NUM_FAO_CTRY)
 	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_country87_info()\n", fname);
+		fprintf(fplog, "Error reading file %s: read_country87_info(); records=%li < expected=%i\n",
+				fname, csv.num_recs, NUM_FAO_CTRY);
 		return ERROR_FILE;
 	}
 	
 	// read all the records
 	for (i = 0; i < NUM_FAO_CTRY; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			
 			// do not need to retrieve the fao code, the iso abbr, or the fao name
             // these have already been stored, and the length and order of the columns match
 			
 			// get the matching ctry87 code
-			if((err = get_int_field(rec_str, delim, 4, &ctry2ctry87codes_gtap[i])) != OK) {
+			if((err = csv_get_int(&csv, 4, &ctry2ctry87codes_gtap[i])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country87_info(); record=%i, column=4\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the matching ctry87 abbr
-			if((err = get_text_field(rec_str, delim, 5, &ctry2ctry87abbrs_gtap[i][0])) != OK) {
+			if((err = csv_get_text(&csv, 5, &ctry2ctry87abbrs_gtap[i][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country87_info(); record=%i, column=5\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_country87_info(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_FAO_CTRY)
-	{
-		fprintf(fplog, "Error reading file %s: read_country87_info(); records read=%i != expected=%i\n",
-				fname, i, NUM_FAO_CTRY);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 
 	if (in_args.diagnostics) {
 		// country to country 87 mapping codes
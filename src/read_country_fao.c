@@ -47,12 +47,12 @@ int read_country_fao(args_struct in_args, rinfo_struct *raster_info) {
 	// 5 arcmin resolution, extent = (-180,180, -90, 90), WGS84
 	// values are integers
 	
-	int nrows = 2160;				// num input lats
-	int ncols = 4320;				// num input lons
+	int nrows = NUM_LAT;				// num input lats
+	int ncols = NUM_LON;				// num input lons
 	int ncells = nrows * ncols;		// number of input grid cells
 	short nodata = -9999;			// nodata value
 	int insize = 2;					// 2 byte integers for input
-	double res = 5.0 / 60.0;		// resolution
+	double res = GRID_RES;		// resolution
 	double xmin = -180.0;			// longitude min grid boundary
 	double xmax = 180.0;			// longitude max grid boundary
 	double ymin = -90.0;			// latitude min grid boundary
@@ -81,6 +81,12 @@ int read_country_fao(args_struct in_args, rinfo_struct *raster_info) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.country_fao_fname);
 	
+	// the file must be on the working grid
+	if (check_grid_file(fname, insize) != OK) {
+		fprintf(fplog,"Input file %s is not on the working grid:  read_country_fao()\n", fname);
+		return ERROR_FILE;
+	}
+	
 	if((fpin = fopen(fname, "rb")) == NULL)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_country_fao()\n", fname);
@@ -65,11 +65,9 @@ int read_country_info_all(args_struct in_args) {
 	//  fifth column: VMAP0 country name - includes regions that were mapped to "owner" countries
 	
 	int i = 0;
-	int nrecords = 0;               // number of records
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 	int out_index = 0;				// the index of the arrays to fill
@@ -78,26 +76,15 @@ int read_country_info_all(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.country_all_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_country_info_all()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 	
-	// skip the header line
-	if(fscanf(fpin, "%[^\n]\n", rec_str) == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_country_info_all()\n", fname);
-		return ERROR_FILE;
-	}
-	
-    // count the records
-    while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-        nrecords++;
-    }
-    
     // set the number of fao/vmap0 countries
-    NUM_FAO_CTRY = nrecords;
+    NUM_FAO_CTRY = csv.num_recs;
     
     // now allocate the arrays
     countrycodes_fao = calloc(NUM_FAO_CTRY, sizeof(int));
@@ -128,52 +115,35 @@ int read_country_info_all(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header line
-    if(fscanf(fpin, "%[^\n]\n", rec_str) == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_country_info_all()\n", fname);
-        return ERROR_FILE;
-    }
-    
 	// read all the records
 	for (i = 0; i < NUM_FAO_CTRY; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			// get the FAO integer code
-			if((err = get_int_field(rec_str, delim, 1, &countrycodes_fao[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 1, &countrycodes_fao[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country_info_all(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
             // get the iso3 abbreviation
-            if((err = get_text_field(rec_str, delim, 2, &countryabbrs_iso[out_index][0])) != OK) {
+            if((err = csv_get_text(&csv, 2, &countryabbrs_iso[out_index][0])) != OK) {
                 fprintf(fplog, "Error processing file %s: read_country_info_all(); record=%i, column=2\n",
                         fname, i + 1);
                 return err;
             }
 			// get the FAO name
-			if((err = get_text_field(rec_str, delim, 3, &countrynames_fao[out_index++][0])) != OK) {
+			if((err = csv_get_text(&csv, 3, &countrynames_fao[out_index++][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country_info_all(); record=%i, column=3\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_country_info_all(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
-
-    
-	fclose(fpin);
 	
-    if(i != NUM_FAO_CTRY)
-    {
-        fprintf(fplog, "Error reading file %s: read_country_info_all(); records read=%i != expected = %i\n",
-                fname, i, NUM_FAO_CTRY);
-        return ERROR_FILE;
-    }
-    
+	csv_close(&csv);
+	
 	if (in_args.diagnostics) {
 		// country codes
 		if ((err = write_text_int(countrycodes_fao, NUM_FAO_CTRY, "countrycodes_fao.txt", in_args))) {
@@ -59,11 +59,9 @@ int read_crop_info(args_struct in_args) {
 	//	eigth column: FAO crop name
 	
 	int i;
-	int nrecords = 0;               // count number of records in file
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 	int out_index = 0;				// the index of the arrays to fill
@@ -72,28 +70,15 @@ int read_crop_info(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.crop_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_crop_info()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-	
-	// read the data
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_crop_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-    // count the records
-    while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-        nrecords++;
-    }
     
     // set the number of SAGE crops
-    NUM_SAGE_CROP = nrecords;
+    NUM_SAGE_CROP = csv.num_recs;
     
     // allocate arrays
     cropcodes_sage = calloc(NUM_SAGE_CROP, sizeof(int));
@@ -154,74 +139,58 @@ int read_crop_info(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_crop_info()\n", fname);
-        return ERROR_FILE;
-    }
-    
 	// read all the records
 	for (i = 0; i < NUM_SAGE_CROP; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			// get the SAGE crop integer code
-			if((err = get_int_field(rec_str, delim, 1, &cropcodes_sage[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 1, &cropcodes_sage[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the SAGE file name base
-			if((err = get_text_field(rec_str, delim, 2, &cropfilebase_sage[out_index][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &cropfilebase_sage[out_index][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the SAGE crop description
-			if((err = get_text_field(rec_str, delim, 3, &cropdescr_sage[out_index][0])) != OK) {
+			if((err = csv_get_text(&csv, 3, &cropdescr_sage[out_index][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=3\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the GTAP crop name
-			if((err = get_text_field(rec_str, delim, 4, &cropnames_gtap[out_index][0])) != OK) {
+			if((err = csv_get_text(&csv, 4, &cropnames_gtap[out_index][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=4\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the GTAP use code
-			if((err = get_int_field(rec_str, delim, 5, &crop_sage2gtap_use[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 5, &crop_sage2gtap_use[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=5\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the FAO crop codes
-			if((err = get_int_field(rec_str, delim, 7, &cropcodes_sage2fao[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 7, &cropcodes_sage2fao[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=7\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the FAO crop names
-			if((err = get_text_field(rec_str, delim, 8, &cropnames_sage2fao[out_index++][0])) != OK) {
+			if((err = csv_get_text(&csv, 8, &cropnames_sage2fao[out_index++][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_crop_info(); record=%i, column=8\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_crop_info(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_SAGE_CROP)
-	{
-		fprintf(fplog, "Error reading file %s: read_crop_info(); records read=%i != expected=%i\n",
-				fname, i, NUM_SAGE_CROP);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	if (in_args.diagnostics) {
 		// sage crop codes
@@ -51,11 +51,11 @@ int read_cropland_sage(args_struct in_args, rinfo_struct *raster_info) {
 	// convert to working units of_sage km^2, based on sage land area data
 	
 	int i;							// loop variable
-	int nrows = 2160;				// num input lats
-	int ncols = 4320;				// num input lons
+	int nrows = NUM_LAT;				// num input lats
+	int ncols = NUM_LON;				// num input lons
 	int ncells = nrows * ncols;		// number of input grid cells
 	float nodata = 9E20;			// nodata value
-	double res = 5.0 / 60.0;		// resolution
+	double res = GRID_RES;		// resolution
 	double xmin = -180.0;			// longitude min grid boundary
 	double xmax = 180.0;			// longitude max grid boundary
 	double ymin = -90.0;			// latitude min grid boundary
@@ -66,6 +66,9 @@ int read_cropland_sage(args_struct in_args, rinfo_struct *raster_info) {
 	int ncvarid;					// variable id returned by nc_inq_varid()
 	int ncerr;						// error return value; 0 = ok
 	char *varname = "farea";		// name of the variable to read
+	int ndims;						// number of dimensions of the variable
+	size_t start[NC_MAX_VAR_DIMS];	// start indices of the window
+	size_t count[NC_MAX_VAR_DIMS];	// lengths of the window
 	
 	double sage_cropland_lost = 0;		// number of sage cropland cells lost due to no sage land area
 	
@@ -87,22 +90,52 @@ int read_cropland_sage(args_struct in_args, rinfo_struct *raster_info) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.cropland_sage_fname);
 	
+	// the netcdf library is not thread safe, so its calls are serialized (nc_lock.c)
+	nc_lock();
 	if ((ncerr = nc_open(fname, NC_NOWRITE, &ncid))) {
 		fprintf(fplog,"Failed to open %s for reading: read_cropland_sage(); ncerr = %i\n", fname, ncerr);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 	
 	if ((ncerr = nc_inq_varid(ncid, varname, &ncvarid))) {
 		fprintf(fplog,"Error %i when getting netcdf var id for %s: read_cropland_sage()\n", ncerr, varname);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 	
-	if ((ncerr = nc_get_var_float(ncid, ncvarid, cropland_area_sage))) {
+	// the variable must be on the working grid
+	if (check_grid_nc(fname, ncid, ncvarid) != OK) {
+		fprintf(fplog,"Input file %s is not on the working grid: read_cropland_sage()\n", fname);
+		nc_close(ncid);
+		nc_unlock();
+		return ERROR_FILE;
+	}
+	
+	// read only the processing window box (the whole grid by default) and move it into place
+	if ((ncerr = nc_inq_varndims(ncid, ncvarid, &ndims))) {
+		fprintf(fplog,"Error %i when getting netcdf var dims for %s: read_cropland_sage()\n", ncerr, varname);
+		nc_unlock();
+		return ERROR_FILE;
+	}
+	for (i = 0; i < ndims; i++) {
+		start[i] = 0;
+		count[i] = 1;
+	}
+	start[ndims - 2] = win_row_min;
+	start[ndims - 1] = win_col_min;
+	count[ndims - 2] = win_row_max - win_row_min + 1;
+	count[ndims - 1] = win_col_max - win_col_min + 1;
+	
+	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start, count, cropland_area_sage))) {
 		fprintf(fplog,"Error %i when reading netcdf var %s: read_cropland_sage()\n", ncerr, varname);
+		nc_unlock();
 		return ERROR_FILE;
 	}
+	window_spread_float(cropland_area_sage, nodata);
 	
 	nc_close(ncid);
+	nc_unlock();
 	
 	// convert fraction to area
 	// also count any cells that are sage cropland but not sage land area
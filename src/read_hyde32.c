@@ -7,6 +7,7 @@
  area is in km^2
  
  the input files are individual year arc ascii files
+ the files are read only down to the end of the last lulc row of the processing window; the cells below it are nodata
  47 years available: 1700 - 2000 every 10 years, 2001-2016 each year
  the input file names are determined from the hyde input type file
  the first 3 files are the total crop, total pasture, and total urban area
@@ -83,6 +84,8 @@ int read_hyde32(args_struct in_args, rinfo_struct *raster_info, int year, float*
 	double ymax;			// latitude max grid boundary
 	
 	int i, k;
+	int num_split = NUM_LON / NUM_LON_LULC;	// number of working grid rows in one lulc row
+	int last_cell;			// the cells after this one are below the processing window
 	int sysrv;						// system return value
 	
 	char fname[MAXCHAR];            // file name to open
@@ -141,7 +144,20 @@ int read_hyde32(args_struct in_args, rinfo_struct *raster_info, int year, float*
 		return ERROR_FILE;
 	}
 	
+	// the hyde grids must be on the working grid
+	if (check_grid_dims(fname, nrows, ncols) != OK) {
+		fprintf(fplog,"File %s dims do not match the working grid:  read_hyde32()\n", fname);
+		fclose(fpin);
+		return ERROR_FILE;
+	}
+	
 	ncells = nrows * ncols;
+	// stop at the end of the last lulc row of the processing window (set_window())
+	//  so that every lulc cell with window land has all of its working grid cells
+	last_cell = (win_row_max / num_split + 1) * num_split * ncols;
+	if (last_cell > ncells) {
+		last_cell = ncells;
+	}
 	xmax = xmin + 360;
 	ymax = ymin + 180;
 	
@@ -208,8 +224,9 @@ int read_hyde32(args_struct in_args, rinfo_struct *raster_info, int year, float*
 		// if crop, pasture, or urban totals, put into explicit arrays
 		// otherwise put into lu_detail_area
 		
-		// loop over all values in file
-		for(i = 0; i < ncells; i++)
+		// loop over the values in file, down to the end of the window
+		// the text has to be parsed from the top, so the rows above the window are read too
+		for(i = 0; i < last_cell; i++)
 		{
 			if (k == 0) {
 				// read single value
@@ -241,6 +258,19 @@ int read_hyde32(args_struct in_args, rinfo_struct *raster_info, int year, float*
 				}
 			}
 		} // end i loop over ncells
+		// the cells below the window are nodata
+		for(i = last_cell; i < ncells; i++)
+		{
+			if (k == 0) {
+				urban_grid[i] = nodata;
+			} else if (k == 1) {
+				crop_grid[i] = nodata;
+			} else if (k == 2) {
+				pasture_grid[i] = nodata;
+			} else {
+				lu_detail_area[k - NUM_HYDE_TYPES_MAIN][i] = nodata;
+			}
+		}
 		
 		fclose(fpin);
 	} // end k loop over hyde files
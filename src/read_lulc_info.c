@@ -91,11 +91,9 @@ int read_lulc_info(args_struct in_args) {
  	// fourth column - corresponding sage or hyde32 name
 	
 	int i;
-	int nrecords = 0;               // count number of records
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 	int out_index = 0;				// the index of the arrays to fill
@@ -107,27 +105,15 @@ int read_lulc_info(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.lt_sage_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header lines and index the records
+	if((err = csv_open(fname, delim, 4, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-	
-	// skip the header lines
-	if(fscanf(fpin, "%*[^\n]\n%*[^\n]\n%*[^\n]\n%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-    // count the records
-	nrecords = 0;
-    while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-        nrecords++;
-    }
     
     // set the number of SAGE land types
-    NUM_SAGE_PVLT = nrecords;
+    NUM_SAGE_PVLT = csv.num_recs;
     
     // allocate the arrays
     landtypecodes_sage = calloc(NUM_SAGE_PVLT, sizeof(int));
@@ -148,45 +134,29 @@ int read_lulc_info(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header lines
-    if(fscanf(fpin, "%*[^\n]\n%*[^\n]\n%*[^\n]\n%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_lulc_info()\n", fname);
-        return ERROR_FILE;
-    }
-    
 	// read the SAGE records
 	out_index = 0;
 	for (i = 0; i < NUM_SAGE_PVLT; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
             // get the integer code
-            if((err = get_int_field(rec_str, delim, 1, &landtypecodes_sage[out_index])) != OK) {
+            if((err = csv_get_int(&csv, 1, &landtypecodes_sage[out_index])) != OK) {
                 fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=1\n",
                         fname, i + 1);
                 return err;
             }
 			// get the name
-			if((err = get_text_field(rec_str, delim, 2, &landtypenames_sage[out_index++][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &landtypenames_sage[out_index++][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_lulc_info(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_SAGE_PVLT)
-	{
-		fprintf(fplog, "Error reading file %s: read_lulc_info(); records read=%i != expected=%i\n",
-				fname, i, NUM_SAGE_PVLT);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	////////////////// HYDE land use info
 	
@@ -194,27 +164,15 @@ int read_lulc_info(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.lu_hyde_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-	// count the records
-	nrecords = 0;
-	while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-		nrecords++;
+		return err;
 	}
 	
 	// set the number of HYDE land types
-	NUM_HYDE_TYPES = nrecords;
+	NUM_HYDE_TYPES = csv.num_recs;
 	
 	// allocate the arrays
 	lutypecodes_hyde = calloc(NUM_HYDE_TYPES, sizeof(int));
@@ -235,45 +193,29 @@ int read_lulc_info(args_struct in_args) {
 		}
 	}
 	
-	rewind(fpin);
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
 	// read the HYDE records
 	out_index = 0;
 	for (i = 0; i < NUM_HYDE_TYPES; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			// get the integer code
-			if((err = get_int_field(rec_str, delim, 1, &lutypecodes_hyde[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 1, &lutypecodes_hyde[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the name
-			if((err = get_text_field(rec_str, delim, 2, &lutypenames_hyde[out_index++][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &lutypenames_hyde[out_index++][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_lulc_info(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_HYDE_TYPES)
-	{
-		fprintf(fplog, "Error reading file %s: read_lulc_info(); records read=%i != expected=%i\n",
-				fname, i, NUM_HYDE_TYPES);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	////////////////// ISAM lulc info and mapping
 	
@@ -281,27 +223,15 @@ int read_lulc_info(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.lulc_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
-	// count the records
-	nrecords = 0;
-	while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-		nrecords++;
+		return err;
 	}
 	
 	// set the number of HYDE land types
-	NUM_LULC_TYPES = nrecords;
+	NUM_LULC_TYPES = csv.num_recs;
 	
 	// allocate the arrays
 	lulccodes = calloc(NUM_LULC_TYPES, sizeof(int));
@@ -334,34 +264,25 @@ int read_lulc_info(args_struct in_args) {
 		return ERROR_MEM;
 	}
 	
-	rewind(fpin);
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_lulc_info()\n", fname);
-		return ERROR_FILE;
-	}
-	
 	// read the HYDE records
 	out_index = 0;
 	for (i = 0; i < NUM_LULC_TYPES; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			// get the lulc integer code
-			if((err = get_int_field(rec_str, delim, 1, &lulccodes[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 1, &lulccodes[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the lulc name
-			if((err = get_text_field(rec_str, delim, 2, &lulcnames[out_index][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &lulcnames[out_index][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 			if (i < num_lulc_lctypes) {
 				// get the sage integer code for mapping
-				if((err = get_int_field(rec_str, delim, 3, &lulc2sagecodes[out_index])) != OK) {
+				if((err = csv_get_int(&csv, 3, &lulc2sagecodes[out_index])) != OK) {
 					fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=1\n",
 							fname, i + 1);
 					return err;
@@ -369,7 +290,7 @@ int read_lulc_info(args_struct in_args) {
 				lulc2hydecodes[out_index++] = NOMATCH;
 			} else {
 				// get the hyde integer code for mapping
-				if((err = get_int_field(rec_str, delim, 3, &lulc2hydecodes[out_index])) != OK) {
+				if((err = csv_get_int(&csv, 3, &lulc2hydecodes[out_index])) != OK) {
 					fprintf(fplog, "Error processing file %s: read_lulc_info(); record=%i, column=1\n",
 							fname, i + 1);
 					return err;
@@ -378,18 +299,11 @@ int read_lulc_info(args_struct in_args) {
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_lulc_info(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_LULC_TYPES)
-	{
-		fprintf(fplog, "Error reading file %s: read_lulc_info(); records read=%i != expected=%i\n",
-				fname, i, NUM_LULC_TYPES);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	
 	
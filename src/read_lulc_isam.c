@@ -25,6 +25,14 @@
     float longitude; center of pixel
     short time; year
  
+ each type is read directly into its output grid and then flipped north-south and rolled by 180 degrees of longitude
+  in place, one pair of rows at a time with memcpy, and the fraction is converted to area in a separate pass over the
+  cells, with the cell area already in the output orientation
+ the cell area buffer is kept between calls, so this function must not be called by two threads at once
+  (the hyde/lulc read-ahead has one reader thread; see lu_readahead.c)
+only the input rows of the processing window rows are read (set_window()); the other rows are zero
+  (read_hyde32 stops at the same row, but has to parse the text rows above the window)
+ 
  arguments:
  args_struct in_args:   the input file arguments
  int year
@@ -60,12 +68,36 @@
 
 #include "moirai.h"
 
+/********
+ static void flip_roll_lulc(float *grid, float *row_buf)
+ reorient an isam grid in place: the input origin is the lower left corner at -90 lat and 0 lon,
+  and the output origin is the upper left corner at 90 lat and -180 lon
+ so row r becomes row NUM_LAT_LULC - 1 - r, and the two halves of each row are swapped
+ row_buf:	scratch row of NUM_LON_LULC values
+ ********/
+static void flip_roll_lulc(float *grid, float *row_buf)
+{
+	int r;
+	int half = NUM_LON_LULC / 2;
+	size_t half_bytes = half * sizeof(float);
+	size_t row_bytes = NUM_LON_LULC * sizeof(float);
+	float *row_a;		// a row in the north half
+	float *row_b;		// its mirror row in the south half
+
+	for (r = 0; r < NUM_LAT_LULC / 2; r++) {
+		row_a = &grid[(size_t) r * NUM_LON_LULC];
+		row_b = &grid[(size_t) (NUM_LAT_LULC - 1 - r) * NUM_LON_LULC];
+		memcpy(row_buf, row_a, row_bytes);
+		memcpy(row_a, row_b + half, half_bytes);
+		memcpy(row_a + half, row_b, half_bytes);
+		memcpy(row_b, row_buf + half, half_bytes);
+		memcpy(row_b + half, row_buf, half_bytes);
+	}
+}
+
 int read_lulc_isam(args_struct in_args, int year, float **lulc_input_grid) {
     
-    int i, j;
-    int nrows = NUM_LAT_LULC;				// num input lats
-    int ncols = NUM_LON_LULC;				// num input lons
-    int ncells = nrows * ncols;		// number of input grid cells
+    int i, k;
     //float nodata = -99.0;             // nodata value - appears to be only in Dominant_type and Grid_area
     //double res = 30.0 / 60.0;		// resolution
     //double xmin = 0.0;			// longitude min grid boundary
@@ -84,41 +116,28 @@ int read_lulc_isam(args_struct in_args, int year, float **lulc_input_grid) {
     const char lcfrac_name[] = "LC_fraction";         // the lc frac variable to read
     const char cell_area_name[] = "Grid_area";        // the grid cell area variable to read
     size_t start_lcfrac[] = {0, 0, 0};              // start indices for lc fraction - the first value will change for each lc type
-    static size_t start_grid[] = {0, 0};            // start indices for other data variables
-    static size_t count_lcfrac[] = {1, 360, 720};   // lengths for reading lc fraction
-    static size_t count_grid[] = {360, 720};        // lengths for reading other data variables
+    size_t start_grid[] = {0, 0};                   // start indices for other data variables
+    size_t count_lcfrac[] = {1, NUM_LAT_LULC, NUM_LON_LULC};   // lengths for reading lc fraction
+    size_t count_grid[] = {NUM_LAT_LULC, NUM_LON_LULC};        // lengths for reading other data variables
+	int num_split = NUM_LON / NUM_LON_LULC;	// number of working grid rows in one lulc row
+	int row_start;							// first input (south up) row of the window
+	int nrows;								// number of input rows in the window
+	size_t row_offset;						// offset of the first window row in a grid
 	
-	int grid_y;				// row for ul corner working grid cell in input cell
-	int grid_x;				// col for ul corner working grid cell in input cell
-	int grid_index;					// index of working grid cell to set
-	double rem_dbl;				// used to get the remainder of a decimal number
-	double int_dbl;				// used to get the integer of a decimal number
-	
-	float *lulc_cell_area;			// needed to get the area
-	float **temp_grid;				// needed for reading in so can shift the data
+	static float *lulc_cell_area = NULL;	// the grid cell area (m^2), in the output orientation; kept between calls
+	float row_buf[NUM_LON_LULC];			// scratch row for reorienting the grids
+	float *out;								// the output grid of the current type
 	
     // some input data file name prefixes and suffixes
     const char basename[] = "ISAM_HYDE32_LANDCOVER_";		// base file name
     const char nctag[] = ".nc";					// suffix for file names, netcdf, unzipped
     const char ncgztag[] = ".nc.gz";			// suffix for file names, netcdf, gzipped
 	
-	// allcate array for the grid cell area
-	lulc_cell_area = calloc(ncells, sizeof(float));
-	if(lulc_cell_area == NULL) {
-		fprintf(fplog,"Failed to allocate memory for lulc_cell_area: read_lulc_isam()\n");
-		return ERROR_MEM;
-	}
-	
-	// allocate temp array for the data
-	temp_grid = calloc(NUM_LULC_TYPES, sizeof(float*));
-	if(temp_grid == NULL) {
-		fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for temp_grid: main()\n", get_systime(), ERROR_MEM);
-		return ERROR_MEM;
-	}
-	for (i = 0; i < NUM_LULC_TYPES; i++) {
-		temp_grid[i] = calloc(NUM_CELLS_LULC, sizeof(float));
-		if(temp_grid[i] == NULL) {
-			fprintf(fplog,"\nProgram terminated at %s with error_code = %i\nFailed to allocate memory for temp_grid[%i]: main()\n", get_systime(), ERROR_MEM, i);
+	// allcate array for the grid cell area, once
+	if (lulc_cell_area == NULL) {
+		lulc_cell_area = calloc(NUM_CELLS_LULC, sizeof(float));
+		if(lulc_cell_area == NULL) {
+			fprintf(fplog,"Failed to allocate memory for lulc_cell_area: read_lulc_isam()\n");
 			return ERROR_MEM;
 		}
 	}
@@ -147,66 +166,65 @@ int read_lulc_isam(args_struct in_args, int year, float **lulc_input_grid) {
 	sprintf(tmp_str, "%i%s", year, nctag);
     strcat(lname, tmp_str);
     
+	// read only the lulc rows of the processing window; the input rows run south to north
+	// the rows outside the window are zero, so these cells have no area
+	// all the columns are read, because the longitude roll can split a window box across the input edge
+	nrows = win_row_max / num_split - win_row_min / num_split + 1;
+	row_start = NUM_LAT_LULC - 1 - win_row_max / num_split;
+	row_offset = (size_t) row_start * NUM_LON_LULC;
+	start_grid[0] = row_start;
+	count_grid[0] = nrows;
+	start_lcfrac[1] = row_start;
+	count_lcfrac[1] = nrows;
+	
+    // the netcdf calls are serialized with nc_lock(), because this may run in the read-ahead thread (lu_readahead.c)
+    nc_lock();
     if ((ncerr = nc_open(lname, NC_NOWRITE, &ncid))) {
         fprintf(fplog,"Failed to open %s for reading: read_lulc_isam(); ncerr = %i\n", lname, ncerr);
+        nc_unlock();
         return ERROR_FILE;
     }
     
-    // get the grid cell area
+    // get the grid cell area and shift it to start at upper left
 	if ((ncerr = nc_inq_varid(ncid, cell_area_name, &ncvarid))) {
 		fprintf(fplog,"Error %i when getting netcdf var id for %s: read_lulc_isam()\n", ncerr, cell_area_name);
+		nc_unlock();
 		return ERROR_FILE;
 	}
-	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_grid, count_grid, lulc_cell_area))) {
+	memset(lulc_cell_area, 0, NUM_CELLS_LULC * sizeof(float));
+	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_grid, count_grid, &lulc_cell_area[row_offset]))) {
 		fprintf(fplog,"Error %i when reading netcdf var %s: read_lulc_isam()\n", ncerr, cell_area_name);
+		nc_unlock();
 		return ERROR_FILE;
 	}
+	flip_roll_lulc(lulc_cell_area, row_buf);
 	
     // loop over the land cover types to read them in
+    // shift each to start at upper left, then convert the values to working units
+    // do the land type aggregation and the grid disaggregation in a different function
+	//	because eventually they may not be necessary
 	if ((ncerr = nc_inq_varid(ncid, lcfrac_name, &ncvarid))) {
 		fprintf(fplog,"Error %i when getting netcdf var id for %s: read_lulc_isam()\n", ncerr, lcfrac_name);
+		nc_unlock();
 		return ERROR_FILE;
 	}
-	for (i = 0; i < NUM_LULC_TYPES; i++) {
-		start_lcfrac[0] = i;
-		if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_lcfrac, count_lcfrac, &temp_grid[i][0]))) {
+	for (k = 0; k < NUM_LULC_TYPES; k++) {
+		out = lulc_input_grid[k];
+		start_lcfrac[0] = k;
+		memset(out, 0, NUM_CELLS_LULC * sizeof(float));
+		if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_lcfrac, count_lcfrac, &out[row_offset]))) {
 			fprintf(fplog,"Error %i when reading netcdf var %s: read_lulc_isam()\n", ncerr, lcfrac_name);
+			nc_unlock();
 			return ERROR_FILE;
 		}
-	} // end for i loop over the lulc types
-	
-    // loop over all the data to convert the values to working units and shift the data to start at upper left
-    // do the land type aggregation and the grid disaggregation in a different function
-	//	because eventually they may not be necessary
-    for (i = 0; i < ncells; i++) {
-		// loop over the land types
-		for (j = 0; j < NUM_LULC_TYPES; j++) {
-			
-			rem_dbl = fmod((double) i, (double) ncols);
-			modf((double) (i / ncols), &int_dbl);
-			grid_y = NUM_LAT_LULC - (int) int_dbl - 1;
-			if (rem_dbl < ncols / 2) {
-				grid_x = (int) rem_dbl + NUM_LON_LULC / 2;
-			} else {
-				grid_x = ((int) rem_dbl - ncols / 2);
-			}
-			grid_index = grid_y * NUM_LON_LULC + grid_x;
-			if (lulc_cell_area[i] > 0) {
-				lulc_input_grid[j][grid_index] = temp_grid[j][i] * frac_scalar * MSQ2KMSQ * lulc_cell_area[i];
-			} else {
-				lulc_input_grid[j][grid_index] = 0;
-			}
-		} // end j loop over the land types
-    }	// end for i loop over all grid cells
+		flip_roll_lulc(out, row_buf);
+		for (i = 0; i < NUM_CELLS_LULC; i++) {
+			out[i] = (lulc_cell_area[i] > 0) ? out[i] * frac_scalar * MSQ2KMSQ * lulc_cell_area[i] : 0;
+		}
+	} // end for k loop over the lulc types
     
     nc_close(ncid);
-	
-	free(lulc_cell_area);
-	
-	for (i = 0; i < NUM_LULC_TYPES; i++) {
-		free(temp_grid[i]);
-	}
-	free(temp_grid);
+    nc_unlock();
 	
     return OK;
 }
@@ -140,21 +140,26 @@ int read_lulc_land(args_struct in_args, int year, rinfo_struct *raster_info, int
 	sprintf(tmp_str, "%i%s", year, nctag);
 	strcat(lname, tmp_str);
 	
+	// the netcdf library is not thread safe, and this may run alongside other startup loads (load_static_inputs.c)
+	nc_lock();
 	if ((ncerr = nc_open(lname, NC_NOWRITE, &ncid))) {
 		fprintf(fplog,"Failed to open %s for reading: read_lulc_land(); ncerr = %i\n", lname, ncerr);
-		return ERROR_FILE;
-	}
-	
-	// get the land mask
-	if ((ncerr = nc_inq_varid(ncid, varname, &ncvarid))) {
-		fprintf(fplog,"Error %i when getting netcdf var id for %s: read_lulc_land()\n", ncerr, varname);
-		return ERROR_FILE;
+		err = ERROR_FILE;
+	} else {
+		// get the land mask
+		if ((ncerr = nc_inq_varid(ncid, varname, &ncvarid))) {
+			fprintf(fplog,"Error %i when getting netcdf var id for %s: read_lulc_land()\n", ncerr, varname);
+			err = ERROR_FILE;
+		} else if ((ncerr = nc_get_vara_int(ncid, ncvarid, start_grid, count_grid, lulc_input_mask))) {
+			fprintf(fplog,"Error %i when reading netcdf var %s: read_lulc_land()\n", ncerr, varname);
+			err = ERROR_FILE;
+		}
+		nc_close(ncid);
 	}
-	if ((ncerr = nc_get_vara_int(ncid, ncvarid, start_grid, count_grid, lulc_input_mask))) {
-		fprintf(fplog,"Error %i when reading netcdf var %s: read_lulc_land()\n", ncerr, varname);
-		return ERROR_FILE;
+	nc_unlock();
+	if (err != OK) {
+		return err;
 	}
-	nc_close(ncid);
 	
 	// loop over all the data to convert the values to working grid
 	num_split = NUM_LON / ncols;
@@ -1,9 +1,14 @@
 /**********
  read_mirca.c
  
- read one file of the mirca 2000 irragated/rainfed area into irr_grid[NUM_CELLS] and rfd_grid[NUM_CELLS]
+ read the mirca 2000 irrigated/rainfed area files into irr_grid and rfd_grid
     the stored data are in the working grid, but without unit conversion
  
+ contains the following functions:
+    open_mirca(): open one file and read and check its header
+    read_mirca(): read the next rows of an open file
+ so a file can be read in latitude bands (see proc_mirca()), or all at once with ncells = NUM_CELLS
+ 
  there are separate files for irrigated and rainfed data
  
  there is a file for each of 26 crops, with the files labelled with crop numbers
@@ -17,8 +22,14 @@
  
  also store hectares - no unit conversion
  
- arguments:
+ arguments of open_mirca():
   char* fname:          file name to open, with path
+  FILE** fpin:          returns the open file, positioned at the first value
+ 
+ arguments of read_mirca():
+  FILE* fpin:           the file opened by open_mirca()
+  char* fname:          file name, for the log
+  int ncells:           the number of values to read; whole rows of the working grid
   float* mirca_grid:    the array to load the data into
  
  return value:
@@ -51,7 +62,7 @@
 
 #include "moirai.h"
 
-int read_mirca(char *fname, float *mirca_grid) {
+int open_mirca(char *fname, FILE **fpin) {
     
     // use this function to input data to the working grid
     
@@ -60,10 +71,8 @@ int read_mirca(char *fname, float *mirca_grid) {
     // 5 arcmin resolution, extent = (-180,180, -90, 90), ?WGS84?
     // read in double values
     
-    int i;
     int nrows = 0;			// num input lats = 2160
     int ncols = 0;			// num input lons = 4320
-    int ncells = 0;         // number of input grid cells = nrows*ncols
     int nodata = 0;			// nodata value = -9
     double res = 0;         // resolution = 5.0 / 60.0 = 0.083333333333333
     double xmin = 0;		// longitude min grid boundary = xllcorner = -180
@@ -71,49 +80,48 @@ int read_mirca(char *fname, float *mirca_grid) {
     double ymin = 0;		// latitude min grid boundary = yllcorner = -90
     //double ymax = 90.0;		// latitude max grid boundary
     
-    FILE *fpin;						// file pointer
-    float value;						// each value read in
-    
-    if((fpin = fopen(fname, "r")) == NULL)
+    if((*fpin = fopen(fname, "r")) == NULL)
     {
-        fprintf(fplog,"Failed to open file %s:  read_mirca()\r\n", fname);
+        fprintf(fplog,"Failed to open file %s:  open_mirca()\r\n", fname);
         return ERROR_FILE;
     }
     
     // read the header lines
-    if(fscanf(fpin,"%*s%i%*s%i%*s%lf%*s%lf%*s%lf%*s%i%*[^\r\n]\r\n", &ncols, &nrows, &xmin, &ymin, &res, &nodata) == EOF)
+    if(fscanf(*fpin,"%*s%i%*s%i%*s%lf%*s%lf%*s%lf%*s%i%*[^\r\n]\r\n", &ncols, &nrows, &xmin, &ymin, &res, &nodata) == EOF)
     {
-        fprintf(fplog, "Failed to read file %s header:  read_mirca()\n", fname);
+        fprintf(fplog, "Failed to read file %s header:  open_mirca()\n", fname);
+        fclose(*fpin);
         return ERROR_FILE;
     }
     
     // check the res
-    if (ncols != NUM_LON || nrows != NUM_LAT) {
-        printf("File %s dims do not match expected values:  read_mirca()\n", fname);
+    if (check_grid_dims(fname, nrows, ncols) != OK) {
+        fprintf(fplog, "File %s dims do not match expected values:  open_mirca()\n", fname);
+        fclose(*fpin);
         return ERROR_FILE;
     }
     
+    return OK;
+}
+
+int read_mirca(FILE *fpin, char *fname, int ncells, float *mirca_grid) {
+    
+    int i;
+    float value;						// each value read in
+    
     //fprintf(fplog,"Start reading mirca at %s :  read_mirca()\n", get_systime());
     
     // read the data
-    ncells = nrows * ncols;
     for (i = 0; i < ncells; i++) {
-        if (fscanf(fpin, "%f", &value) != EOF) {
+        if (fscanf(fpin, "%f", &value) == 1) {
             // no need to convert units
             mirca_grid[i] = value;
         } else {
-            if (i == ncells) {
-                //fprintf(fplog,"Finished reading mirca at %s:  read_mirca()\n", get_systime());
-            } else {
-                fprintf(fplog, "Failed to read mirca at %s:  read_mirca()\n", get_systime());
-                return ERROR_FILE;
-            }	// end if all data read in else error
-            
-        }	// end if read and set value else check for end of file or error
+            fprintf(fplog, "Failed to read mirca file %s at value %i of %i at %s:  read_mirca()\n", fname, i, ncells, get_systime());
+            return ERROR_FILE;
+        }	// end if read and set value else error
         
     }	// end for i loop to read the data
     
-    fclose(fpin);
-    
     return OK;
-}
\ No newline at end of file
+}
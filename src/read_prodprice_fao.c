@@ -63,8 +63,7 @@ int read_prodprice_fao(args_struct in_args) {
 	
 	// all reported crops listed by country with years 1and year flags
 	// one header row
-	// each line now ends with a newline ('\n')
-	// there can't be any blank lines for this to work properly
+	// blank lines are skipped
 	//  first column: FAO country code
 	//  second column: FAO country nme
 	//  third column: FAO crop code
@@ -79,11 +78,13 @@ int read_prodprice_fao(args_struct in_args) {
 	int nhead = 1;					// number of header lines
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
-	char temp_str[MAXRECSIZE];		// string to test for blank line
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
+	// per-record diagnostic warnings are rate-limited (log_utils.c)
+	static logsite_struct no_crop_site = {"Warning: no sage crop match: read_prodprice_fao()", 0, NULL};
+	static logsite_struct no_ctry_site = {"Warning: no fao country code match: read_prodprice_fao()", 0, NULL};
+	static logsite_struct no_region_site = {"Warning: FAO country has no economic region: read_prodprice_fao()", 0, NULL};
 	int out_index = -1;				// the index of the price array to fill
 	int prod_index = -1;			// the index of the production array to read
 	int ctry_ind = -1;				// the FAO country index with respect to countrycodes_fao[]
@@ -102,13 +103,8 @@ int read_prodprice_fao(args_struct in_args) {
 	int start_recalib_year = 0;			// the first year of recalibration average
 	int fao_start_year_index = NOMATCH;		// the fao year index of the starting year for averaging
 	
-	long flen = 0;					// length of file in bytes
-	long count_lines = 0;			// count the number of lines to skip the header
+	long rec_ind = 0;				// the index of the record to tokenize
 	long count_recs = 0;			// count the number of records read
-	long rec_index = -1;			// the index of the record string to fill
-	int is_newrec = 0;				// flag to denote end of record
-	char *sptr;						// dynamically allocated buffer for whole file as a string
-	char *cptr;						// pointer to traverse the file string
 	
 	// file info for the usd conversion factors
 	// one header line
@@ -193,34 +189,33 @@ int read_prodprice_fao(args_struct in_args) {
 	// read the cpi values
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.convert_usd_fname);
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, nhead, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_prodprice_fao()\n", fname);
-		return ERROR_FILE;
-	}
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_prodprice_fao()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 
-	while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-			// get the input year
-			if((err = get_int_field(rec_str, delim, 1, &cpi_year[cpi_index])) != OK) {
-				fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%i, column=1\n",
-						fname, num_cpi_years + 1);
-				return err;
-			}
-			// get the corresponding value
-			if((err = get_float_field(rec_str, delim, 2, &cpi_val[cpi_index++])) != OK) {
-				fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%i, column=2\n",
-						fname, num_cpi_years + 1);
-				return err;
-			}
+	for (rec_ind = 0; rec_ind < csv.num_recs && cpi_index < 100; rec_ind++) {
+		if((err = csv_get_record(&csv, rec_ind)) != OK) {
+			fprintf(fplog, "Error reading file %s: read_prodprice_fao(); record=%li\n", fname, rec_ind + 1);
+			return err;
+		}
+		// get the input year
+		if((err = csv_get_int(&csv, 1, &cpi_year[cpi_index])) != OK) {
+			fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%i, column=1\n",
+					fname, num_cpi_years + 1);
+			return err;
+		}
+		// get the corresponding value
+		if((err = csv_get_float(&csv, 2, &cpi_val[cpi_index++])) != OK) {
+			fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%i, column=2\n",
+					fname, num_cpi_years + 1);
+			return err;
+		}
 		num_cpi_years++;
-	} // end while loop for reading cpi file
-	fclose(fpin);
+	} // end for loop for reading cpi file
+	csv_close(&csv);
 	
 	// get the cpi value for the output price data
 	for (i = 0; i < num_cpi_years; i++) {
@@ -239,152 +234,117 @@ int read_prodprice_fao(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.prodprice_fao_fname);
 	
-	// read the whole file at once in binary mode using fread
-	if((fpin = fopen(fname, "rb")) == NULL)
+	// skip the header line and index the records; blank lines are skipped and not counted
+	if((err = csv_open(fname, delim, nhead, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_prodprice_fao()\n", fname);
-		return ERROR_FILE;
-	}
-	fseek(fpin, 0L, SEEK_END);
-	flen = ftell(fpin);
-	rewind(fpin);
-	// calloc initializes the values to zero, which is the termination character
-	sptr = calloc(flen + 1, sizeof(char));
-	if(sptr == NULL) {
-		fprintf(fplog,"Failed to allocate memory for file %s:  read_prodprice_fao()\n", fname);
-		return ERROR_MEM;
+		return err;
 	}
 	
-	fread(sptr, flen, 1, fpin);
-	fclose(fpin);
-	cptr = sptr;	// set the moving pointer to the beginning of the file
-	
-	// while loop is probably faster than for loop
-	// the terminating character is zero, which will stop the while loops
-	// this is the loop over the whole file
-	// this reads in and skips whitespace lines, rather than throwing an error, but doesn't count them as records 
-	while (*cptr) {
-		rec_index = 0;
-		is_newrec = 0;
-		// this is the loop to obtain each record string
-		while (*cptr) {
-			if (!is_newrec) {
-				if (*cptr == '\n') {
-					is_newrec = 1;
-				}
-			} else {
+	for (rec_ind = 0; rec_ind < csv.num_recs; rec_ind++) {
+		if((err = csv_get_record(&csv, rec_ind)) != OK) {
+			fprintf(fplog, "Error reading file %s: read_prodprice_fao(); record=%li\n", fname, rec_ind + 1);
+			return err;
+		}
+		count_recs++;
+		
+		// get the country code
+		if((err = csv_get_int(&csv, 1, &temp_ctry)) != OK) {
+			fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%li, column=2\n",
+					fname, count_recs);
+			return err;
+		}
+		
+		// get the crop code
+		if((err = csv_get_int(&csv, 3, &temp_crop)) != OK) {
+			fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%li, column=4\n",
+					fname, count_recs);
+			return err;
+		}
+		
+		// determine the output index for this record in the local temp price storage array
+		ctry_ind = -1;
+		for (j = 0; j < NUM_FAO_CTRY; j++) {
+			if (countrycodes_fao[j] == temp_ctry) {
+				ctry_ind = j;
 				break;
 			}
-			
-			// store the current character in the record string
-			rec_str[rec_index++] = *cptr++;
-		} // end while loop over record
-		rec_str[rec_index] = '\0';	// terminate the record string
+		}
 		
-		// process this record if it is not a header and it is not a blank record
-		rm_whitesp(temp_str, rec_str);
-		if (!(count_lines++ < nhead) && strlen(temp_str)) {
-			count_recs++;
-			
-			// get the country code
-			if((err = get_int_field(rec_str, delim, 1, &temp_ctry)) != OK) {
-				fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%li, column=2\n",
-						fname, count_recs);
-				return err;
-			}
-			
-			// get the crop code
-			if((err = get_int_field(rec_str, delim, 3, &temp_crop)) != OK) {
-				fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%li, column=4\n",
-						fname, count_recs);
-				return err;
-			}
-			
-			// determine the output index for this record in the local temp price storage array
-			ctry_ind = -1;
-			for (j = 0; j < NUM_FAO_CTRY; j++) {
-				if (countrycodes_fao[j] == temp_ctry) {
-					ctry_ind = j;
+		// process record only if there is an fao country match
+		if (ctry_ind != -1) {
+			crop_ind = -1;
+			for (j = 0; j < NUM_SAGE_CROP; j++) {
+				if (cropcodes_sage2fao[j] == temp_crop) {
+					crop_ind = j;
+					out_index = ctry_ind * NUM_SAGE_CROP + crop_ind;
 					break;
 				}
 			}
 			
-			// process record only if there is an fao country match
-			if (ctry_ind != -1) {
-				crop_ind = -1;
-				for (j = 0; j < NUM_SAGE_CROP; j++) {
-					if (cropcodes_sage2fao[j] == temp_crop) {
-						crop_ind = j;
-						out_index = ctry_ind * NUM_SAGE_CROP + crop_ind;
-						break;
+			// process record only if there is a sage crop match
+			if (crop_ind != -1) {
+				// get the annual data for sevaral years and average it
+				// need to weight this average by annual production
+				avg_sum = 0;
+				for (j = 0; j < num_avg; j++) {
+					if((err = csv_get_float(&csv, avg_cols[j], &temp_flt)) != OK) {
+						fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%li, column=%i\n",
+								fname, count_recs, avg_cols[j]);
+						return err;
 					}
-				}
-				
-				// process record only if there is a sage crop match
-				if (crop_ind != -1) {
-					// get the annual data for sevaral years and average it
-					// need to weight this average by annual production
-					avg_sum = 0;
-					for (j = 0; j < num_avg; j++) {
-						if((err = get_float_field(rec_str, delim, avg_cols[j], &temp_flt)) != OK) {
-							fprintf(fplog, "Error processing file %s: read_prodprice_fao(); record=%li, column=%i\n",
-									fname, count_recs, avg_cols[j]);
-							return err;
-						}
-						
-						// get the cpi index for this input year
-						for (i = 0; i < num_cpi_years; i++) {
-							if ((FAO_START_YEAR + j + fao_start_year_index) == cpi_year[i]) {
-								if (cpi_val[i] != 0) {
-									cpi_in_val = cpi_val[i];
-								}else {
-									fprintf(fplog,"Invalid in year cpi value %f for year %i:  read_prodprice_fao()\n", cpi_val[i], cpi_year[i]);
-									return ERROR_FILE;
-								}
-								break;
+					
+					// get the cpi index for this input year
+					for (i = 0; i < num_cpi_years; i++) {
+						if ((FAO_START_YEAR + j + fao_start_year_index) == cpi_year[i]) {
+							if (cpi_val[i] != 0) {
+								cpi_in_val = cpi_val[i];
+							}else {
+								fprintf(fplog,"Invalid in year cpi value %f for year %i:  read_prodprice_fao()\n", cpi_val[i], cpi_year[i]);
+								return ERROR_FILE;
 							}
+							break;
 						}
-						
-						// determine the index of the production data for this year and country and crop
-						prod_index = ctry_ind * NUM_SAGE_CROP * NUM_FAO_YRS + crop_ind * NUM_FAO_YRS + j + fao_start_year_index;
-						
-						// get the averaging sums; multiply the cpi ratio
-						prod_sum[out_index] = prod_sum[out_index] + production_fao[prod_index];
-						avg_sum = avg_sum + production_fao[prod_index] * temp_flt * cpi_out_val / cpi_in_val;
 					}
 					
-					// make the conversion to output USD year after the temporal average is calculated
-					// prod_sum could be zero, but cpi factor is non-zero by definition
-					// might not need to divide by prod_sum here, because of later multiplication
-					//	but keep it for now because this is the temporal average
-					if (prod_sum[out_index] == 0) {
-						prodprice_temp[out_index] = 0;
-					}else {
-						prodprice_temp[out_index] = avg_sum / prod_sum[out_index];
-						float_out[out_index] = (float) prodprice_temp[out_index]; // for diagnostic output
-						//if(float_out[out_index] != 0) {
-						//	fprintf(stderr, "found non-zero float_out\n");
-						//}
-					}
+					// determine the index of the production data for this year and country and crop
+					prod_index = ctry_ind * NUM_SAGE_CROP * NUM_FAO_YRS + crop_ind * NUM_FAO_YRS + j + fao_start_year_index;
 					
+					// get the averaging sums; multiply the cpi ratio
+					prod_sum[out_index] = prod_sum[out_index] + production_fao[prod_index];
+					avg_sum = avg_sum + production_fao[prod_index] * temp_flt * cpi_out_val / cpi_in_val;
+				}
+				
+				// make the conversion to output USD year after the temporal average is calculated
+				// prod_sum could be zero, but cpi factor is non-zero by definition
+				// might not need to divide by prod_sum here, because of later multiplication
+				//	but keep it for now because this is the temporal average
+				if (prod_sum[out_index] == 0) {
+					prodprice_temp[out_index] = 0;
 				}else {
-					// there are a fair amount of these
-					if (in_args.diagnostics){
-						fprintf(fplog, "Warning: processing file %s: read_prodprice_fao(); record=%li, no sage crop match\n",
-							fname, count_recs);
-					}
-				}	// end if sage crop match else don't process record
+					prodprice_temp[out_index] = avg_sum / prod_sum[out_index];
+					float_out[out_index] = (float) prodprice_temp[out_index]; // for diagnostic output
+					//if(float_out[out_index] != 0) {
+					//	fprintf(stderr, "found non-zero float_out\n");
+					//}
+				}
+				
 			}else {
-				if (in_args.diagnostics){
-					fprintf(fplog, "Warning: processing file %s: read_prodprice_fao(); record=%li, no fao country code match\n",
+				// there are a fair amount of these
+				if (in_args.diagnostics && log_sample(&no_crop_site)){
+					fprintf(fplog, "Warning: processing file %s: read_prodprice_fao(); record=%li, no sage crop match\n",
 						fname, count_recs);
 				}
-			}	// end if fao country match else don't process record
-		}	// end if process record
-		
-	} // end while loop over file
+			}	// end if sage crop match else don't process record
+		}else {
+			if (in_args.diagnostics && log_sample(&no_ctry_site)){
+				fprintf(fplog, "Warning: processing file %s: read_prodprice_fao(); record=%li, no fao country code match\n",
+					fname, count_recs);
+			}
+		}	// end if fao country match else don't process record
+	} // end for loop over records
 	
-	free(sptr);
+	csv_close(&csv);
 	
 	/* this no longer applies because the fao data includes extra records
 	if(count_recs != nrecords)
@@ -404,7 +364,7 @@ int read_prodprice_fao(args_struct in_args) {
             // aggregate if fao country has an economic region
             temp_ctry = ctry2ctry87codes_gtap[ctry_ind];
             if (temp_ctry == NOMATCH) {
-				if (in_args.diagnostics){
+				if (in_args.diagnostics && log_sample(&no_region_site)){
                 	fprintf(fplog, "Warning: FAO country %i has no economic region: read_prodprice_fao()\n", countrycodes_fao[ctry_ind]);
 				}
                 continue;
@@ -53,11 +53,11 @@ int read_protected(args_struct in_args, rinfo_struct *raster_info) {
     // values are integers
     
     int i;
-    int nrows = 2160;				// num input lats
-    int ncols = 4320;				// num input lons
+    int nrows = NUM_LAT;				// num input lats
+    int ncols = NUM_LON;				// num input lons
     int ncells = nrows * ncols;		// number of input grid cells
     int insize = 1;					// 1 byte unsigned char for input
-    double res = 5.0 / 60.0;		// resolution
+    double res = GRID_RES;		// resolution
     double xmin = -180.0;			// longitude min grid boundary
     double xmax = 180.0;			// longitude max grid boundary
     double ymin = -90.0;			// latitude min grid boundary
@@ -67,7 +67,7 @@ int read_protected(args_struct in_args, rinfo_struct *raster_info) {
     FILE *fpin;						// file pointer
     int num_read;					// how many values read in
     
-    unsigned char *in_array;       // temporary array for input
+    short *out_array;              // temporary array for diagnostic output
     
     int err = OK;								// store error code from the write file
     char out_name[] = "protected.bil";		// diagnositic output raster file name
@@ -83,18 +83,16 @@ int read_protected(args_struct in_args, rinfo_struct *raster_info) {
     raster_info->protected_ymin = ymin;
     raster_info->protected_ymax = ymax;
     
-    // allocate the temp array
-    in_array = calloc(ncells, sizeof(unsigned char));
-    if(in_array == NULL) {
-        fprintf(fplog,"Failed to allocate memory for in_array: read_protected()\n");
-        return ERROR_MEM;
-    }
-    
-    
     // create file name and open it
     strcpy(fname, in_args.inpath);
     strcat(fname, in_args.protected_fname);
     
+    // the file must be on the working grid
+    if (check_grid_file(fname, insize) != OK) {
+        fprintf(fplog,"Input file %s is not on the working grid:  read_protected()\n", fname);
+        return ERROR_FILE;
+    }
+    
     if((fpin = fopen(fname, "rb")) == NULL)
     {
         fprintf(fplog,"Failed to open file %s:  read_protected()\n", fname);
@@ -102,7 +100,8 @@ int read_protected(args_struct in_args, rinfo_struct *raster_info) {
     }
     
     // read the data and check for same size as the working grid
-    num_read = fread(in_array, insize, ncells, fpin);
+    // the file values are read directly into the 8-bit raster
+    num_read = fread(protected_thematic, insize, ncells, fpin);
     fclose(fpin);
     if(num_read != NUM_CELLS)
     {
@@ -111,24 +110,30 @@ int read_protected(args_struct in_args, rinfo_struct *raster_info) {
         return ERROR_FILE;
     }
     
-    // put the data in a short array for storage and further processing
-    // also change the values to match the output land categories generation scheme
+    // change the values to match the output land categories generation scheme
     for (i = 0; i < ncells; i++) {
-        if (in_array[i] == 1) {
-            protected_thematic[i] = 1;
-        } else {
+        if (protected_thematic[i] != 1) {
             protected_thematic[i] = 2;
         }
     }
     
+    // the diagnostic raster is written as short
     if (in_args.diagnostics) {
-        if ((err = write_raster_short(protected_thematic, ncells, out_name, in_args))) {
+        out_array = grid_calloc(ncells, sizeof(short));
+        if(out_array == NULL) {
+            fprintf(fplog,"Failed to allocate memory for out_array: read_protected()\n");
+            return ERROR_MEM;
+        }
+        for (i = 0; i < ncells; i++) {
+            out_array[i] = protected_thematic[i];
+        }
+        err = write_raster_short(out_array, ncells, out_name, in_args);
+        grid_free(out_array);
+        if (err) {
             fprintf(fplog, "Error writing file %s: read_protected()\n", out_name);
             return err;
         }
     }
     
-    free(in_array);
-    
     return OK;
 }
@@ -66,11 +66,8 @@ int read_region_info_gcam(args_struct in_args) {
 	//  second column: gcam region code
 	
 	int i,j;
-    int nrecords_reg = 0;           // count the records in the region list
-    int nrecords_iso = 0;           // count the records in the iso mapping list
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 
@@ -81,27 +78,15 @@ int read_region_info_gcam(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.regionlist_gcam_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header lines and index the records
+	if((err = csv_open(fname, delim, 4, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_country_info_gcam()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-	
-	// skip the header lines
-	if(fscanf(fpin, "%*[^\n\r]\n\r%*[^\n\r]\n%*[^\n\r]\n%*[^\n\r]\n\r") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_country_info_gcam()\n", fname);
-		return ERROR_FILE;
-	}
-	
-    // count the records
-    
-    while (fscanf(fpin, "%[^\n\r]\r\n", rec_str) != EOF) {
-        nrecords_reg++;
-    }
     
     // set the number of gcam regions
-    NUM_GCAM_RGN = nrecords_reg;
+    NUM_GCAM_RGN = csv.num_recs;
     
     // allocate the arrays
     regioncodes_gcam = calloc(NUM_GTAP_CTRY87, sizeof(int));
@@ -122,45 +107,29 @@ int read_region_info_gcam(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header lines
-    if(fscanf(fpin, "%*[^\n\r]\n\r%*[^\n\r]\n%*[^\n\r]\n%*[^\n\r]\n\r") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_country_info_gcam()\n", fname);
-        return ERROR_FILE;
-    }
-    
 	// read the expected number of records
 	for (i = 0; i < NUM_GCAM_RGN; i++) {
-		if (fscanf(fpin, "%[^\n\r]\r\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			
 			// get the gcam region integer code
-			if((err = get_int_field(rec_str, delim, 1, &regioncodes_gcam[i])) != OK) {
+			if((err = csv_get_int(&csv, 1, &regioncodes_gcam[i])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country_info_gcam(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the gcam region name
-			if((err = get_text_field(rec_str, delim, 2, &regionnames_gcam[i][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &regionnames_gcam[i][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country_info_gcam(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_country_info_gcam(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_GCAM_RGN)
-	{
-		fprintf(fplog, "Error reading file %s: read_country_info_gcam(); records read=%i != expected=%i\n",
-				fname, i, NUM_GCAM_RGN);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	//////////
 	// read in the iso country to gcam region mapping - just the iso code and region code
@@ -169,26 +138,15 @@ int read_region_info_gcam(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.countrymap_iso_gcam_region_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header lines and index the records
+	if((err = csv_open(fname, delim, 4, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_country_info_gcam()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-	
-	// skip the header lines
-	if(fscanf(fpin, "%*[^\r\n]\r\n%*[^\r\n]\r\n%*[^\r\n]\n%*[^\r\n]\r\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_country_info_gcam()\n", fname);
-		return ERROR_FILE;
-	}
-	
-    // count the records
-    while (fscanf(fpin, "%[^\n\r]\r\n", rec_str) != EOF) {
-        nrecords_iso++;
-    }
     
     // set the number of gcam iso countries
-    NUM_GCAM_ISO_CTRY = nrecords_iso;
+    NUM_GCAM_ISO_CTRY = csv.num_recs;
     
     // allocate the arrays
     ctry2regioncodes_gcam = calloc(NUM_FAO_CTRY, sizeof(int));
@@ -217,28 +175,19 @@ int read_region_info_gcam(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header lines
-    if(fscanf(fpin, "%*[^\r\n]\r\n%*[^\r\n]\r\n%*[^\r\n]\n%*[^\r\n]\r\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_country_info_gcam()\n", fname);
-        return ERROR_FILE;
-    }
-    
 	// read the expected number of records
 	// should change this to read the whole file then double-check the number (or set it here)
 	for (i = 0; i < NUM_GCAM_ISO_CTRY; i++) {
-		if (fscanf(fpin, "%[^\n\r]\r\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			
 			// get the iso abbreviation
-			if((err = get_text_field(rec_str, delim, 1, &countryabbrs_gcam_iso[i][0])) != OK) {
+			if((err = csv_get_text(&csv, 1, &countryabbrs_gcam_iso[i][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country_info_gcam(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the gcam region integer code
-			if((err = get_int_field(rec_str, delim, 4, &country_gcamiso2regioncodes_gcam[i])) != OK) {
+			if((err = csv_get_int(&csv, 4, &country_gcamiso2regioncodes_gcam[i])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_country_info_gcam(); record=%i, column=4\n",
 						fname, i + 1);
 				return err;
@@ -261,18 +210,11 @@ int read_region_info_gcam(args_struct in_args) {
 			}	// end for j loop over fao countries to find matches with gcam iso abbrevs
 		}else {
 			fprintf(fplog, "Error reading file %s: read_country_info_gcam(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for i loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_GCAM_ISO_CTRY)
-	{
-		fprintf(fplog, "Error reading file %s: read_country_info_gcam(); records read=%i != expected=%i\n",
-				fname, i, NUM_GCAM_ISO_CTRY);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	if (in_args.diagnostics) {
 		// gcam region codes
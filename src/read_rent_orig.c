@@ -45,8 +45,7 @@ int read_rent_orig(args_struct in_args) {
 
 	// the original GTAP land rent data formatted for GCAM
 	// csv file with 6 header lines
-	// each line ends with a carraige return and then a newline ('\r\n')
-	// there can't be any blank lines for this to work properly
+	// blank lines are skipped
 	// first column: ctry87
 	// second column: GTAP_use (13 aggregate use categories)
 	// next 18 columns are the 18 AEZs in order
@@ -60,21 +59,11 @@ int read_rent_orig(args_struct in_args) {
 	int nhead = 6;					// number of header lines to skip
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
-	char temp_str[MAXRECSIZE];		// string to test for blank line
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char *delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 	int out_index = 0;				// the index of the rent_orig_aez[] array to fill
 	
-	long flen = 0;					// length of file in bytes
-	long count_lines = 0;			// count the number of lines to skip the header
-	long count_recs = 0;			// count the number of records read
-	long rec_index = 0;				// the index of the record string to fill
-	int is_newrec = 0;				// flag to denote end of record
-	char *sptr;						// dynamically allocated buffer for whole file as a string
-	char *cptr;						// pointer to traverse the file string
-	
 	// file info for the usd conversion factors
 	// one header line
 	int num_cpi_years = 0;			// number of cpi years read
@@ -98,34 +87,33 @@ int read_rent_orig(args_struct in_args) {
 	// read the cpi values
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.convert_usd_fname);
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_rent_orig()\n", fname);
-		return ERROR_FILE;
-	}
-	// skip the header line
-	if(fscanf(fpin, "%[^\n]\n", rec_str) == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_rent_orig()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 
-	while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+	for (i = 0; i < csv.num_recs && cpi_index < 100; i++) {
+		if((err = csv_get_record(&csv, i)) != OK) {
+			fprintf(fplog, "Error reading file %s: read_rent_orig(); record=%i\n", fname, i + 1);
+			return err;
+		}
 		// get the input year
-		if((err = get_int_field(rec_str, delim, 1, &cpi_year[cpi_index])) != OK) {
+		if((err = csv_get_int(&csv, 1, &cpi_year[cpi_index])) != OK) {
 			fprintf(fplog, "Error processing file %s: read_rent_orig(); record=%i, column=1\n",
 					fname, num_cpi_years + 1);
 			return err;
 		}
 		// get the corresponding value
-		if((err = get_float_field(rec_str, delim, 2, &cpi_val[cpi_index++])) != OK) {
+		if((err = csv_get_float(&csv, 2, &cpi_val[cpi_index++])) != OK) {
 			fprintf(fplog, "Error processing file %s: read_rent_orig(); record=%i, column=2\n",
 					fname, num_cpi_years + 1);
 			return err;
 		}
 		num_cpi_years++;
-	} // end while loop for reading cpi file
-	fclose(fpin);
+	} // end for loop for reading cpi file
+	csv_close(&csv);
 	
 	// get the cpi value for the output price data
 	for (i = 0; i < num_cpi_years; i++) {
@@ -156,83 +144,40 @@ int read_rent_orig(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.rent_orig_fname);
 	
-	// read the whole file at once in binary mode using fread
-	if((fpin = fopen(fname, "rb")) == NULL)
+	// skip the header lines and index the records; blank lines are skipped and not counted
+	if((err = csv_open(fname, delim, nhead, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_rent_orig()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-	fseek(fpin, 0L, SEEK_END);
-	flen = ftell(fpin);
-	rewind(fpin);
-	// calloc initializes the values to zero, which is the termination character
-	sptr = calloc(flen + 1, sizeof(char));
-	if(sptr == NULL) {
-		fprintf(fplog,"Failed to allocate memory for file %s:  read_rent_orig()\n", fname);
-		return ERROR_MEM;
-	}
-	
-	fread(sptr, flen, 1, fpin);
-	fclose(fpin);
-	cptr = sptr;	// set the moving pointer to the beginning of the file
 	
-	// while loop is probably faster than for loop
-	// the terminating character is zero, which will stop the while loops
-	// this is the loop over the whole file
-	// this reads in and skips whitespace lines, rather than throwing an error, but doesn't count them as records 
-	while (*cptr) {
-		rec_index = 0;
-		is_newrec = 0;
-		// this is the loop over each record
-		while (*cptr) {
-			if (!is_newrec) {
-				if (*cptr == '\n') {
-					is_newrec = 1;
-				}
-			} else {
-				break;
-			}
-			// store the current character in the record string
-			rec_str[rec_index++] = *cptr++;
-		} // end while loop over record
-		rec_str[rec_index] = '\0';	// terminate the record string
-		
-		// process this record if it is not a header and it is not a blank record
-		rm_whitesp(temp_str, rec_str);
-		if (!(count_lines++ < nhead) && strlen(temp_str)) {
-			count_recs++;
-			// loop over the values and fill the array (skip the first two columns)
-			// note that field index starts at 1 for get_float_field
-			for (j = 3; j <= ncols; j++) {
-				if((err = get_float_field(rec_str, delim, j, &rent_orig_aez[out_index++])) != OK) {
-					fprintf(fplog, "Error processing file %s: read_rent_orig(); record=%li, column=%i\n",
-							fname, count_recs, j);
-					return err;
-				}
-				// convert to desired year USD for diagnostic output
-				lrout[out_index - 1] = MIL2ONE * cpi_factor * rent_orig_aez[out_index - 1];
-			}
-		
-		if((j-1) != ncols)
-		{
-			fprintf(fplog, "Error processing file %s: read_rent_orig(); cols processed=%i != ncols=%i\n",
-					fname, j, ncols);
-			return ERROR_FILE;
-		}
-			
-		}	// end if(!header) process record
-		
-	} // end while loop over file
-	
-	free(sptr);
-	
-	if(count_recs != nrecords)
+	if(csv.num_recs != nrecords)
 	{
 		fprintf(fplog, "Error reading file %s: read_rent_orig(); records read=%li != nrecords=%i\n",
-				fname, count_recs, nrecords);
+				fname, csv.num_recs, nrecords);
 		return ERROR_FILE;
 	}
 	
+	for (i = 0; i < nrecords; i++) {
+		if((err = csv_get_record(&csv, i)) != OK) {
+			fprintf(fplog, "Error reading file %s: read_rent_orig(); record=%i\n", fname, i + 1);
+			return err;
+		}
+		// loop over the values and fill the array (skip the first two columns)
+		// note that field index starts at 1 for csv_get_float
+		for (j = 3; j <= ncols; j++) {
+			if((err = csv_get_float(&csv, j, &rent_orig_aez[out_index++])) != OK) {
+				fprintf(fplog, "Error processing file %s: read_rent_orig(); record=%i, column=%i\n",
+						fname, i + 1, j);
+				return err;
+			}
+			// convert to desired year USD for diagnostic output
+			lrout[out_index - 1] = MIL2ONE * cpi_factor * rent_orig_aez[out_index - 1];
+		}
+	} // end for loop over records
+	
+	csv_close(&csv);
+	
 	if (in_args.diagnostics) {
 		if ((err = write_csv_float3d(lrout, country87codes_gtap, usecodes_gtap,
 									NUM_GTAP_CTRY87, NUM_GTAP_USE, NUM_ORIG_AEZ, out_name, in_args))) {
@@ -42,8 +42,16 @@
  	this treshold is  0.01 t / km^2, or 0.0001 t / ha is 2 orders of magnitude less than the min fao value of ~0.02 t / ha
  The abnormal values less than these thresholds are filtered out in this function. This has a negligible difference on the outputs.
 
+ the work is split so that the consolidated sage store (see sage_store.c) can share the conversion:
+	read_sage_crop_raw() reads the four fields of one crop file in file units, for the processing window box
+	convert_sage_crop() converts the fields in yield_in and harvestarea_in to working units, as described above
+	read_sage_crop() does both for one crop file
+
  arguments:
  char *fname:	path and base filename for sage crop file to read
+ char *sagepath:	path to the sage crop files, for unzipping
+ char *cropfilebase_sage:	base name of the crop; the variable name prefix
+ float *qual_yield, *qual_harv:	working grid arrays for the quality fields (read_sage_crop_raw() and convert_sage_crop())
  rinfo_struct raster_info:	raster info structure
 
  return value:
@@ -78,19 +86,41 @@
 
 int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_struct raster_info) {
 
-	int i;
-	int nrows = 2160;				// num input lats
-	int ncols = 4320;				// num input lons
-	int ncells = nrows * ncols;		// number of input grid cells
-	float nodata = 9E20;			// nodata value
+	int err = OK;					// error code
+	float *qual_yield;				// quality field for yield
+	float *qual_harv;				// quality field for area
+
+	// allocate arrays for the quality fields
+	qual_harv = grid_calloc(NUM_CELLS, sizeof(float));
+	if(qual_harv == NULL) {
+		fprintf(fplog,"Failed to allocate memory for qual_harv:  read_sage_crop()\n");
+		return ERROR_MEM;
+	}
+	qual_yield = grid_calloc(NUM_CELLS, sizeof(float));
+	if(qual_yield == NULL) {
+		fprintf(fplog,"Failed to allocate memory for qual_yield:  read_sage_crop()\n");
+		grid_free(qual_harv);
+		return ERROR_MEM;
+	}
+
+	if ((err = read_sage_crop_raw(fname, sagepath, cropfilebase_sage, qual_yield, qual_harv)) == OK) {
+		err = convert_sage_crop(fname, qual_yield, qual_harv, raster_info);
+	}
+
+	grid_free(qual_harv);
+	grid_free(qual_yield);
+
+	return err;
+}
+
+int read_sage_crop_raw(char *fname, char *sagepath, char *cropfilebase_sage, float *qual_yield, float *qual_harv) {
+
+	float nodata = SAGE_CROP_NODATA;	// nodata value
 	//double res = 5.0 / 60.0;		// resolution
 	//double xmin = -180.0;			// longitude min grid boundary
 	//double xmax = 180.0;			// longitude max grid boundary
 	//double ymin = -90.0;			// latitude min grid boundary
 	//double ymax = 90.0;				// latitude max grid boundary
-	float temp_flt;
-	float *qual_yield;				// quality field for yield
-	float *qual_harv;				// quality field for area
 
 	char lname[MAXCHAR];			// file name to open
 	FILE *fpin;						// file pointer
@@ -100,31 +130,16 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 	int ncerr;						// error return value; 0 = ok
 	// char *varname = "cropdata";		// name of the variable to read
 	char varname[MAXCHAR];  // name of the variable to read
-	static size_t start_yield[] = {0, 1, 0, 0};		// start indices for yield
-	static size_t start_harv[] = {0, 0, 0, 0};		// start indices for harvest area
-	static size_t start_qual_yield[] = {0, 3, 0, 0};		// start indices for yield
-	static size_t start_qual_harv[] = {0, 2, 0, 0};		// start indices for harvest area
-	static size_t count[] = {1, 1, 2160, 4320};		// lengths for reading yield
+	size_t start_yield[] = {0, 1, 0, 0};		// start indices for yield; the window corner is set below
+	size_t start_harv[] = {0, 0, 0, 0};		// start indices for harvest area
+	size_t start_qual_yield[] = {0, 3, 0, 0};		// start indices for yield
+	size_t start_qual_harv[] = {0, 2, 0, 0};		// start indices for harvest area
+	size_t count[] = {1, 1, 0, 0};		// lengths for reading yield; the window dims are set below
 
 	// some input data file name suffixes
 	const char sage_crop_nctag[] = "_AreaYieldProduction.nc";					// suffix for sage base file names, netcdf, unzipped
 	const char sage_crop_ncztag[] = "_HarvAreaYield2000_NetCDF.zip";				// suffix for sage base file names, netcdf, zipped
-
-	float harvest_thresh = 1e-8;
-	float yield_thresh = 0.0001;
 	
-	// allocate arrays for the quality fields
-	qual_harv = calloc(ncells, sizeof(float));
-	if(qual_harv == NULL) {
-		fprintf(fplog,"Failed to allocate memory for qual_harv:  read_sage_crop()\n");
-		return ERROR_MEM;
-	}
-	qual_yield = calloc(ncells, sizeof(float));
-	if(qual_yield == NULL) {
-		fprintf(fplog,"Failed to allocate memory for qual_yield:  read_sage_crop()\n");
-		return ERROR_MEM;
-	}
-
 	// finish file name and try to open it; if it fails, then it has not been unzipped
 	strcpy(lname, fname);
 	strcat(lname, sage_crop_nctag);
@@ -145,8 +160,11 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 	strcpy(lname, fname);
 	strcat(lname, sage_crop_nctag);
 
+	// the netcdf library is not thread safe, so its calls are serialized (nc_lock.c)
+	nc_lock();
 	if ((ncerr = nc_open(lname, NC_NOWRITE, &ncid))) {
-		fprintf(fplog,"Failed to open %s for reading: read_sage_crop(); ncerr = %i\n", lname, ncerr);
+		fprintf(fplog,"Failed to open %s for reading: read_sage_crop_raw(); ncerr = %i\n", lname, ncerr);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 
@@ -154,30 +172,71 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
   strcat(varname,"Data");
 
 	if ((ncerr = nc_inq_varid(ncid, varname, &ncvarid))) {
-		fprintf(fplog,"Error %i when getting netcdf var id for %s: read_sage_crop()\n", ncerr, varname);
+		fprintf(fplog,"Error %i when getting netcdf var id for %s: read_sage_crop_raw()\n", ncerr, varname);
+		nc_unlock();
+		return ERROR_FILE;
+	}
+	
+	// the variable must be on the working grid
+	if (check_grid_nc(lname, ncid, ncvarid) != OK) {
+		fprintf(fplog,"Input file %s is not on the working grid: read_sage_crop_raw()\n", lname);
+		nc_close(ncid);
+		nc_unlock();
 		return ERROR_FILE;
 	}
+	
+	// read only the processing window box (the whole grid by default); it is moved into place below
+	start_yield[2] = start_harv[2] = start_qual_yield[2] = start_qual_harv[2] = win_row_min;
+	start_yield[3] = start_harv[3] = start_qual_yield[3] = start_qual_harv[3] = win_col_min;
+	count[2] = win_row_max - win_row_min + 1;
+	count[3] = win_col_max - win_col_min + 1;
 
 	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_yield, count, yield_in))) {
-		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop()\n", ncerr, varname);
+		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop_raw()\n", ncerr, varname);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 
 	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_qual_yield, count, qual_yield))) {
-		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop()\n", ncerr, varname);
+		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop_raw()\n", ncerr, varname);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 
 	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_harv, count, harvestarea_in))) {
-		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop()\n", ncerr, varname);
+		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop_raw()\n", ncerr, varname);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 
 	if ((ncerr = nc_get_vara_float(ncid, ncvarid, start_qual_harv, count, qual_harv))) {
-		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop()\n", ncerr, varname);
+		fprintf(fplog,"Error %i when reading netcdf var %s: read_sage_crop_raw()\n", ncerr, varname);
+		nc_unlock();
 		return ERROR_FILE;
 	}
 
+	// the cells outside the window box are nodata
+	window_spread_float(yield_in, nodata);
+	window_spread_float(qual_yield, nodata);
+	window_spread_float(harvestarea_in, nodata);
+	window_spread_float(qual_harv, nodata);
+
+	nc_close(ncid);
+	nc_unlock();
+
+	return OK;
+}
+
+int convert_sage_crop(char *fname, float *qual_yield, float *qual_harv, rinfo_struct raster_info) {
+
+	int i;
+	int ncells = NUM_CELLS;			// number of input grid cells
+	float nodata = SAGE_CROP_NODATA;	// nodata value
+	float temp_flt = 0;
+
+	float harvest_thresh = 1e-8;
+	float yield_thresh = 0.0001;
+
 	// loop over all the data to convert the values to working units
 	//  and to make sure that valid crop values exist for sage land cells
 	for (i = 0; i < ncells; i++) {
@@ -198,7 +257,7 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 				//  (max sage cell land area is ~86 km^2)
 				// remove these very small values from processing
 				if (harvestarea_in[i] < harvest_thresh && harvestarea_in[i] != nodata && harvestarea_in[i] !=0) {
-					//fprintf(fplog,"Warning: fraction in[%i] = %e < %f for crop %s: read_sage_crop()\n", i, harvestarea_in[i], , harvest_thresh, fname);
+					//fprintf(fplog,"Warning: fraction in[%i] = %e < %f for crop %s: convert_sage_crop()\n", i, harvestarea_in[i], , harvest_thresh, fname);
 					harvestarea_in[i] = 0;
 					// end if bad data then remove
 				} else if (qual_harv[i] != 0) {
@@ -213,13 +272,13 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 					}
 					if (qual_harv[i] == nodata && harvestarea_in[i] != 0) {
 						// this condition does not occur
-						fprintf(fplog,"Warning: qual_harv[%i] = nodata and fraction _in[%i] = %e for crop %s:  read_sage_crop()\n", i, i, harvestarea_in[i], fname);
+						fprintf(fplog,"Warning: qual_harv[%i] = nodata and fraction _in[%i] = %e for crop %s:  convert_sage_crop()\n", i, i, harvestarea_in[i], fname);
 					}
 				} else { // no valid harvest area
 					harvestarea_in[i] = 0;
 					if (qual_harv[i] == 0) {
 						// the in fraction is always zero where the quality flag is zero
-						//fprintf(fplog,"Warning: qual_harv[%i] = 0 and fraction in[%i] = %e for crop %s:  read_sage_crop()\n", i, i, harvestarea_in[i], fname);
+						//fprintf(fplog,"Warning: qual_harv[%i] = 0 and fraction in[%i] = %e for crop %s:  convert_sage_crop()\n", i, i, harvestarea_in[i], fname);
 					}
 				} // end else no valid harvestarea_in found
 			}	// end if land area sage nodata else sage land area data
@@ -240,7 +299,7 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 				// abnormal values are usually on the order of 1e-19, which is unrealistic
 				// remove these abnormal values from processing
 				if (yield_in[i] < yield_thresh && yield_in[i] != nodata && yield_in[i] !=0) {
-					//fprintf(fplog,"Warning: yield_in[%i] = %e < %f t / ha for crop %s: read_sage_crop()\n", i, yield_in[i], yield_thresh, fname);
+					//fprintf(fplog,"Warning: yield_in[%i] = %e < %f t / ha for crop %s: convert_sage_crop()\n", i, yield_in[i], yield_thresh, fname);
 					yield_in[i] = 0;
 					// end if bad data then remove
 				} else if (qual_yield[i] != 0) {
@@ -248,14 +307,14 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 					yield_in[i] = yield_in[i] / HA2KMSQ * temp_flt / harvestarea_in[i];
 					if (qual_yield[i] == nodata && yield_in[i] != 0) {
 						// this condition does not occur
-						fprintf(fplog,"Warning: qual_yield[%i] = nodata and yield_in[%i] = %e for crop %s:  read_sage_crop()\n", i, i, yield_in[i], fname);
+						fprintf(fplog,"Warning: qual_yield[%i] = nodata and yield_in[%i] = %e for crop %s:  convert_sage_crop()\n", i, i, yield_in[i], fname);
 					}
 				} else { // no valid yield
 					yield_in[i] = 0;
 					if (qual_yield[i] == 0 && yield_in[i] != 0) {
 						// qual == 0 and yield == 0 does occur
 						// but qual ==0 and yield != 0 does not occur
-						fprintf(fplog,"Warning: qual_yield[%i] = 0 and yield_in[%i] = %e for crop %s:  read_sage_crop()\n", i, i, yield_in[i], fname);
+						fprintf(fplog,"Warning: qual_yield[%i] = 0 and yield_in[%i] = %e for crop %s:  convert_sage_crop()\n", i, i, yield_in[i], fname);
 					}
 				} // end else no valid yield
 			}	// end if land area nodata else land area data
@@ -263,10 +322,5 @@ int read_sage_crop(char *fname, char *sagepath, char *cropfilebase_sage, rinfo_s
 		
 	}	// end for i loop over all grid cells
 
-	nc_close(ncid);
-
-	free(qual_harv);
-	free(qual_yield);
-
 	return OK;
 }
@@ -71,42 +71,36 @@ int read_soil_carbon(char *fname, float *soil_carbon_sage, args_struct in_args)
     //double ymax = 90.0;				// latitude max grid boundary
     
     int i;
-    char rec_str[MAXRECSIZE];		// string to hold one record
     const char *delim = ",";		// delimiter string for space separated file
-    FILE *fpin;
+    csvfile_struct csv;				// the csv file, indexed by record
     //int num_read;					// how many values read in
     
     int err = OK;								// store error code from the dignostic write file
     //char out_name[] = "soil_carbon.bil";		// file name for output diagnostics raster file
     
     // use the text table for now
-    if((fpin = fopen(fname, "r")) == NULL)
+    // skip the header line and index the records
+    if((err = csv_open(fname, delim, 1, &csv)) != OK)
     {
         fprintf(fplog,"Failed to open file %s:  read_soil_carbon()\n", fname);
-        return ERROR_FILE;
-    }
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_soil_carbon()\n", fname);
-        return ERROR_FILE;
+        return err;
     }
     // read the records
     for (i = 0; i < NUM_SAGE_PVLT; i++) {
-        if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+        if ((err = csv_get_record(&csv, i)) == OK) {
             // get the carbon value
-            if((err = get_float_field(rec_str, delim, 2, &soil_carbon_sage[i])) != OK) {
+            if((err = csv_get_float(&csv, 2, &soil_carbon_sage[i])) != OK) {
                 fprintf(fplog, "Error processing file %s: read_soil_carbon(); record=%i, column=2\n",
                         fname, i + 1);
                 return err;
             }
         }else {
             fprintf(fplog, "Error reading file %s: read_soil_carbon(); record=%i\n", fname, i + 1);
-            return ERROR_FILE;
+            return err;
         }
     } // end for loop over records
     
-    fclose(fpin);
+    csv_close(&csv);
     
     /*
     if((fpin = fopen(fname, "rb")) == NULL)
@@ -49,11 +49,9 @@ int read_use_info_gtap(args_struct in_args) {
 	//  third column: use description
 	
 	int i;
-	int nrecords = 0;               // count number of records
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpin;						// file pointer
-	char rec_str[MAXRECSIZE];		// string to hold one record
+	csvfile_struct csv;				// the csv file, indexed by record
 	const char* delim = ",";		// delimiter string for csv file
 	int err = OK;					// error code for the string parsing function
 	int out_index = 0;				// the index of the gtap use arrays to fill
@@ -62,26 +60,15 @@ int read_use_info_gtap(args_struct in_args) {
 	strcpy(fname, in_args.inpath);
 	strcat(fname, in_args.use_gtap_fname);
 	
-	if((fpin = fopen(fname, "r")) == NULL)
+	// skip the header line and index the records
+	if((err = csv_open(fname, delim, 1, &csv)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s:  read_use_info_gtap()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
-	
-	// skip the header line
-	if(fscanf(fpin, "%*[^\n]\n") == EOF)
-	{
-		fprintf(fplog,"Failed to scan over file %s header:  read_use_info_gtap()\n", fname);
-		return ERROR_FILE;
-	}
-	
-    // count the records
-    while (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
-        nrecords++;
-    }
     
     // set the number of land rent uses
-    NUM_GTAP_USE = nrecords;
+    NUM_GTAP_USE = csv.num_recs;
     
     // allocate the arrays
     usecodes_gtap = calloc(NUM_GTAP_USE, sizeof(int));
@@ -112,51 +99,35 @@ int read_use_info_gtap(args_struct in_args) {
         }
     }
     
-    rewind(fpin);
-    
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_use_info_gtap()\n", fname);
-        return ERROR_FILE;
-    }
-    
 	// read all the records
 	for (i = 0; i < NUM_GTAP_USE; i++) {
-		if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+		if ((err = csv_get_record(&csv, i)) == OK) {
 			
 			// get the integer code
-			if((err = get_int_field(rec_str, delim, 1, &usecodes_gtap[out_index])) != OK) {
+			if((err = csv_get_int(&csv, 1, &usecodes_gtap[out_index])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_use_info_gtap(); record=%i, column=1\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the abbreviation (name)
-			if((err = get_text_field(rec_str, delim, 2, &usenames_gtap[out_index][0])) != OK) {
+			if((err = csv_get_text(&csv, 2, &usenames_gtap[out_index][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_use_info_gtap(); record=%i, column=2\n",
 						fname, i + 1);
 				return err;
 			}
 			// get the description
-			if((err = get_text_field(rec_str, delim, 3, &usedescr_gtap[out_index++][0])) != OK) {
+			if((err = csv_get_text(&csv, 3, &usedescr_gtap[out_index++][0])) != OK) {
 				fprintf(fplog, "Error processing file %s: read_use_info_gtap(); record=%i, column=3\n",
 						fname, i + 1);
 				return err;
 			}
 		}else {
 			fprintf(fplog, "Error reading file %s: read_use_info_gtap(); record=%i\n", fname, i + 1);
-			return ERROR_FILE;
+			return err;
 		}
 	} // end for loop over records
 	
-	fclose(fpin);
-	
-	if(i != NUM_GTAP_USE)
-	{
-		fprintf(fplog, "Error reading file %s: read_use_info_gtap(); records read=%i != expected=%i\n",
-				fname, i, NUM_GTAP_USE);
-		return ERROR_FILE;
-	}
+	csv_close(&csv);
 	
 	if (in_args.diagnostics) {
 		// use codes
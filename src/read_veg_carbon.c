@@ -49,40 +49,34 @@ int read_veg_carbon(char* fname, float* veg_carbon_sage) {
     // on header line
     // two columns: sage pot veg cat, carbon value (kg/m^2)
     
-    char rec_str[MAXRECSIZE];		// string to hold one record
-    FILE* fpin;
+    csvfile_struct csv;				// the csv file, indexed by record
     const char* delim = ",";		// delimiter string for space separated file
     
     int i;
     int err = OK;								// store error code from the dignostic write file
     
-    if((fpin = fopen(fname, "r")) == NULL)
+    // skip the header line and index the records
+    if((err = csv_open(fname, delim, 1, &csv)) != OK)
     {
         fprintf(fplog,"Failed to open file %s:  read_veg_carbon()\n", fname);
-        return ERROR_FILE;
-    }
-    // skip the header line
-    if(fscanf(fpin, "%*[^\n]\n") == EOF)
-    {
-        fprintf(fplog,"Failed to scan over file %s header:  read_veg_carbon()\n", fname);
-        return ERROR_FILE;
+        return err;
     }
     // read the records
     for (i = 0; i < NUM_SAGE_PVLT; i++) {
-        if (fscanf(fpin, "%[^\n]\n", rec_str) != EOF) {
+        if ((err = csv_get_record(&csv, i)) == OK) {
             // get the carbon value
-            if((err = get_float_field(rec_str, delim, 2, &veg_carbon_sage[i])) != OK) {
+            if((err = csv_get_float(&csv, 2, &veg_carbon_sage[i])) != OK) {
                 fprintf(fplog, "Error processing file %s: read_veg_carbon(); record=%i, column=2\n",
                         fname, i + 1);
                 return err;
             }
         }else {
             fprintf(fplog, "Error reading file %s: read_veg_carbon(); record=%i\n", fname, i + 1);
-            return ERROR_FILE;
+            return err;
         }
     } // end for loop over records
     
-    fclose(fpin);
+    csv_close(&csv);
     
     return OK;
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 /**********************
   read_water_footprint.c
 
-  read a single water footprint file
+  read a latitude band of a single water footprint file
   these are single band esri grid files
+  the read is queued on a batched reader (see raster_io.c), so the data are in the buffer after the next rio_wait()
+  the file size is checked only with the first band of the window (row_start = win_row_min), so once per file
 
  water footprint files (converted to simple binary files from arc grid files by an r script):
  4320 columns, 2160 rows, 5 arcmin res
@@ -21,7 +23,10 @@
 
   ARGUMENTS
       char* fname:       file name to open, with path
-      float* wf_grid:    the array to load the data into; this is the full globe, and has been initialized to the file nodata value
+      int row_start:     the first working grid row to read
+      int nrows:         the number of rows to read; NUM_LAT for the full globe
+      rio_struct* rio:   the batched reader
+      int buf_ind:       the reader buffer to load the data into; this is the latitude band of nrows rows starting at row_start
 
   so read the data into the appropriate location in the grid array
   row index: (90-83)*60/5 - 1
@@ -58,30 +63,24 @@
  
 #include "moirai.h"
 
-int read_water_footprint(char *fname, float *wf_grid) {
+int read_water_footprint(char *fname, int row_start, int nrows, rio_struct *rio, int buf_ind) {
     
-    int ncols = 4320;
-    int nrows = 2160;
-    int ncells = nrows * ncols;		// number of input grid cells
+    int ncols = NUM_LON;
+    int ncells = nrows * ncols;		// number of input grid cells in the band
     int insize = 4;					// 4 byte floats
     
-    FILE *fpin;						// file pointer
-    int num_read;					// how many values read in
+    int err = OK;					// error code
     
-    if((fpin = fopen(fname, "rb")) == NULL)
-    {
-        fprintf(fplog,"Failed to open file %s:  read_water_footprint()\n", fname);
+    // the file must be on the working grid; it is checked once, with the first band of the window
+    if (row_start == win_row_min && check_grid_file(fname, insize) != OK) {
+        fprintf(fplog,"Input file %s is not on the working grid:  read_water_footprint()\n", fname);
         return ERROR_FILE;
     }
     
-    // read the data
-    num_read = fread(wf_grid, insize, ncells, fpin);
-    fclose(fpin);
-    if(num_read != ncells)
-    {
-        fprintf(fplog, "Error reading file %s: read_water_footprint(); num_read=%i != ncells=%i\n",
-                fname, num_read, ncells);
-        return ERROR_FILE;
+    // queue the read of the data for this band
+    if ((err = rio_read(rio, fname, (long) row_start * ncols * insize, (size_t) ncells * insize, buf_ind)) != OK) {
+        fprintf(fplog, "Failed to read rows %i to %i of file %s:  read_water_footprint()\n", row_start, row_start + nrows - 1, fname);
+        return err;
     }
     
     return OK;
@@ -0,0 +1,448 @@
+/**********
+ sage_store.c
+
+ contains the following functions for the consolidated sage crop store:
+	sagestore_open()
+	sagestore_read_crop()
+	sagestore_close()
+
+ the store replaces the NUM_SAGE_CROP sage netcdf crop files (see read_sage_crop.c) with one chunked, compressed netcdf-4 file,
+  so calc_harvarea_prod_out_crop_aez() opens one file instead of one file per crop and per pass
+ it holds the four crop fields (harvested area fraction, yield, area quality, yield quality) in file units for the
+  sage land cells only, as variable sage_crop_data(crop, field, cell); the chunks are one crop X all fields X a tile of cells
+ variable sage_cell holds the working grid index of each store cell, in ascending order
+ the global attributes grid_res_sec and crops (the crop base names) identify the grid and crop list the store was built for
+
+ in_args.sage_store_fname names the store in in_args.sagepath; if it does not exist, sagestore_open() builds it from the crop files
+  under a temporary name and renames it, so this is a one-time repack; it must be built on the whole grid (no window box)
+ a store does not match a run with a different working grid, crop list or sage land area; delete it to rebuild it
+ the window cells of a crop are read as one hyperslab, and the values are converted with convert_sage_crop()
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+#define SAGE_STORE_TILE			65536		// max cells per chunk
+#define SAGE_STORE_DEFLATE		4			// deflate level
+
+/********
+ static char *sagestore_crop_list(void)
+ the crop base names joined by commas, for the crops attribute
+ return:	the allocated list; NULL if out of memory
+ ********/
+static char *sagestore_crop_list(void)
+{
+	int i;
+	size_t len = 1;
+	char *list;
+
+	for (i = 0; i < NUM_SAGE_CROP; i++) {
+		len = len + strlen(cropfilebase_sage[i]) + 1;
+	}
+	list = calloc(len, sizeof(char));
+	if (list == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < NUM_SAGE_CROP; i++) {
+		if (i > 0) {
+			strcat(list, ",");
+		}
+		strcat(list, cropfilebase_sage[i]);
+	}
+
+	return list;
+}
+
+/********
+ static int sagestore_build(sagestore_struct *store, args_struct in_args)
+ repack the sage crop files into the store file; store->cells must be set
+ return:	error code
+ ********/
+static int sagestore_build(sagestore_struct *store, args_struct in_args)
+{
+	char tmp_fname[MAXCHAR];		// the store is written under this name and then renamed
+	char fname[MAXCHAR];			// crop file name
+	char source[MAXCHAR];			// source attribute
+	char history[MAXCHAR];			// history attribute: the creation time
+	char fields[] = "harvested area fraction of land area,yield (t/ha),quality-area,quality-yield";
+	char *crops;					// crops attribute
+	int ncid;
+	int ncerr = NC_NOERR;
+	int dimids[3];					// crop, field, cell
+	int cell_varid;
+	int varid;
+	size_t chunk[3];
+	size_t start[3] = {0, 0, 0};
+	size_t count[3] = {1, SAGE_STORE_NFIELDS, 0};
+	float *buf;						// one crop [SAGE_STORE_NFIELDS][num_cells]
+	float *qual_yield;
+	float *qual_harv;
+	long n = store->num_cells;
+	long k;
+	int cropind;
+	int err = OK;
+
+	fprintf(fplog, "Building the sage crop store %s from the crop files: sagestore_build(); %s", store->fname, get_systime());
+
+	if (snprintf(tmp_fname, MAXCHAR, "%s.tmp", store->fname) >= MAXCHAR) {
+		fprintf(fplog, "Error: the temporary name of %s is longer than %i characters: sagestore_build()\n", store->fname, MAXCHAR - 1);
+		return ERROR_FILE;
+	}
+
+	crops = sagestore_crop_list();
+	buf = calloc(SAGE_STORE_NFIELDS * n + 1, sizeof(float));
+	qual_yield = grid_calloc(NUM_CELLS, sizeof(float));
+	qual_harv = grid_calloc(NUM_CELLS, sizeof(float));
+	if (crops == NULL || buf == NULL || qual_yield == NULL || qual_harv == NULL) {
+		fprintf(fplog, "Failed to allocate memory for the sage store: sagestore_build()\n");
+		free(crops);
+		free(buf);
+		grid_free(qual_yield);
+		grid_free(qual_harv);
+		return ERROR_MEM;
+	}
+
+	if ((ncerr = nc_create(tmp_fname, NC_CLOBBER | NC_NETCDF4, &ncid))) {
+		fprintf(fplog, "Failed to create %s: sagestore_build(); %s\n", tmp_fname, nc_strerror(ncerr));
+		free(crops);
+		free(buf);
+		grid_free(qual_yield);
+		grid_free(qual_harv);
+		return ERROR_FILE;
+	}
+
+	sprintf(source, "%s %s", CODENAME, VERSION);
+	strcpy(history, get_systime());
+	history[strcspn(history, "\n")] = '\0';
+	chunk[0] = 1;
+	chunk[1] = SAGE_STORE_NFIELDS;
+	chunk[2] = (n < SAGE_STORE_TILE) ? n : SAGE_STORE_TILE;
+	if (chunk[2] == 0) {
+		chunk[2] = 1;
+	}
+	if ((ncerr = nc_put_att_text(ncid, NC_GLOBAL, "title", strlen("sage crop store"), "sage crop store")) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "source", strlen(source), source)) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "history", strlen(history), history)) ||
+		(ncerr = nc_put_att_double(ncid, NC_GLOBAL, "grid_res_sec", NC_DOUBLE, 1, &GRID_RES_SEC)) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "crops", strlen(crops), crops)) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "fields", strlen(fields), fields)) ||
+		(ncerr = nc_def_dim(ncid, "crop", NUM_SAGE_CROP, &dimids[0])) ||
+		(ncerr = nc_def_dim(ncid, "field", SAGE_STORE_NFIELDS, &dimids[1])) ||
+		(ncerr = nc_def_dim(ncid, "cell", n, &dimids[2])) ||
+		(ncerr = nc_def_var(ncid, "sage_cell", NC_INT, 1, &dimids[2], &cell_varid)) ||
+		(ncerr = nc_def_var_deflate(ncid, cell_varid, 1, 1, SAGE_STORE_DEFLATE)) ||
+		(ncerr = nc_def_var(ncid, "sage_crop_data", NC_FLOAT, 3, dimids, &varid)) ||
+		(ncerr = nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunk)) ||
+		(ncerr = nc_def_var_deflate(ncid, varid, 1, 1, SAGE_STORE_DEFLATE)) ||
+		(ncerr = nc_enddef(ncid)) ||
+		(ncerr = nc_put_var_int(ncid, cell_varid, store->cells))) {
+		err = ERROR_FILE;
+	}
+
+	// gather the sage land cells of each crop file
+	count[2] = n;
+	for (cropind = 0; err == OK && cropind < NUM_SAGE_CROP; cropind++) {
+		strcpy(fname, in_args.sagepath);
+		strcat(fname, cropfilebase_sage[cropind]);
+		if ((err = read_sage_crop_raw(fname, in_args.sagepath, cropfilebase_sage[cropind], qual_yield, qual_harv)) != OK) {
+			fprintf(fplog, "Failed to read crop %s for the sage store: sagestore_build()\n", fname);
+			break;
+		}
+		for (k = 0; k < n; k++) {
+			buf[k] = harvestarea_in[store->cells[k]];
+			buf[n + k] = yield_in[store->cells[k]];
+			buf[2 * n + k] = qual_harv[store->cells[k]];
+			buf[3 * n + k] = qual_yield[store->cells[k]];
+		}
+		start[0] = cropind;
+		if ((ncerr = nc_put_vara_float(ncid, varid, start, count, buf))) {
+			err = ERROR_FILE;
+		}
+	}
+
+	free(crops);
+	free(buf);
+	grid_free(qual_yield);
+	grid_free(qual_harv);
+
+	if (err != OK) {
+		fprintf(fplog, "Error writing file %s: sagestore_build(); %s\n", tmp_fname, nc_strerror(ncerr));
+		nc_close(ncid);
+		remove(tmp_fname);
+		return err;
+	}
+	if ((ncerr = nc_close(ncid)) || rename(tmp_fname, store->fname) != 0) {
+		fprintf(fplog, "Error closing file %s: sagestore_build(); %s\n", tmp_fname, nc_strerror(ncerr));
+		remove(tmp_fname);
+		return ERROR_FILE;
+	}
+
+	fprintf(fplog, "Built the sage crop store %s with %i crops and %li cells: sagestore_build(); %s",
+			store->fname, NUM_SAGE_CROP, n, get_systime());
+
+	return OK;
+}
+
+/********
+ static int sagestore_check(sagestore_struct *store)
+ check that the open store matches this run: working grid, crop list and sage land cells
+ return:	error code
+ ********/
+static int sagestore_check(sagestore_struct *store)
+{
+	int ndims;
+	int dimids[3];
+	size_t len[3];					// crop, field and cell dimension lengths
+	size_t attlen;
+	double res_sec;
+	char *crops;					// crops of this run
+	char *store_crops;				// crops of the store
+	int *store_cells;
+	size_t start = 0;
+	size_t count;
+	int ncerr = NC_NOERR;
+	int i;
+	int err = OK;
+
+	if ((ncerr = nc_inq_varid(store->ncid, "sage_crop_data", &store->varid)) ||
+		(ncerr = nc_inq_varndims(store->ncid, store->varid, &ndims)) || ndims != 3 ||
+		(ncerr = nc_inq_vardimid(store->ncid, store->varid, dimids)) ||
+		(ncerr = nc_inq_dimlen(store->ncid, dimids[0], &len[0])) ||
+		(ncerr = nc_inq_dimlen(store->ncid, dimids[1], &len[1])) ||
+		(ncerr = nc_inq_dimlen(store->ncid, dimids[2], &len[2])) ||
+		(ncerr = nc_get_att_double(store->ncid, NC_GLOBAL, "grid_res_sec", &res_sec)) ||
+		(ncerr = nc_inq_attlen(store->ncid, NC_GLOBAL, "crops", &attlen))) {
+		fprintf(fplog, "Error reading the layout of %s: sagestore_check(); %s\n", store->fname, nc_strerror(ncerr));
+		return ERROR_FILE;
+	}
+	if (res_sec != GRID_RES_SEC || len[0] != (size_t) NUM_SAGE_CROP || len[1] != SAGE_STORE_NFIELDS || len[2] != (size_t) store->num_cells) {
+		fprintf(fplog, "Error: %s has %li crops and %li cells at %f arc-seconds, not %i crops and %i cells at %f: sagestore_check()\n",
+				store->fname, (long) len[0], (long) len[2], res_sec, NUM_SAGE_CROP, store->num_cells, GRID_RES_SEC);
+		return ERROR_FILE;
+	}
+
+	crops = sagestore_crop_list();
+	store_crops = calloc(attlen + 1, sizeof(char));
+	store_cells = calloc(store->num_cells + 1, sizeof(int));
+	if (crops == NULL || store_crops == NULL || store_cells == NULL) {
+		fprintf(fplog, "Failed to allocate memory for checking %s: sagestore_check()\n", store->fname);
+		free(crops);
+		free(store_crops);
+		free(store_cells);
+		return ERROR_MEM;
+	}
+
+	count = store->num_cells;
+	if ((ncerr = nc_get_att_text(store->ncid, NC_GLOBAL, "crops", store_crops)) ||
+		(ncerr = nc_inq_varid(store->ncid, "sage_cell", &i)) ||
+		(count > 0 && (ncerr = nc_get_vara_int(store->ncid, i, &start, &count, store_cells)))) {
+		fprintf(fplog, "Error reading %s: sagestore_check(); %s\n", store->fname, nc_strerror(ncerr));
+		err = ERROR_FILE;
+	} else if (strcmp(crops, store_crops) != 0) {
+		fprintf(fplog, "Error: the crops of %s do not match the sage crop list: sagestore_check()\n", store->fname);
+		err = ERROR_FILE;
+	} else {
+		for (i = 0; i < store->num_cells; i++) {
+			if (store_cells[i] != store->cells[i]) {
+				fprintf(fplog, "Error: store cell %i of %s is grid cell %i, not sage land cell %i: sagestore_check()\n",
+						i, store->fname, store_cells[i], store->cells[i]);
+				err = ERROR_FILE;
+				break;
+			}
+		}
+	}
+
+	free(crops);
+	free(store_crops);
+	free(store_cells);
+
+	return err;
+}
+
+/********
+ int sagestore_open(sagestore_struct *store, args_struct in_args, rinfo_struct raster_info)
+ open the store named by in_args.sage_store_fname, building it first if it does not exist
+ store->ncid is -1 if in_args.sage_store_fname is 0, and the crop files are read instead
+ return:	error code
+ ********/
+int sagestore_open(sagestore_struct *store, args_struct in_args, rinfo_struct raster_info)
+{
+	FILE *fp;
+	int ncerr;
+	int i;
+	int err = OK;
+
+	memset(store, 0, sizeof(sagestore_struct));
+	store->ncid = -1;
+	if (strcmp(in_args.sage_store_fname, "0") == 0 || in_args.sage_store_fname[0] == '\0') {
+		return OK;
+	}
+	strcpy(store->fname, in_args.sagepath);
+	strcat(store->fname, in_args.sage_store_fname);
+
+	// the store cells are all the sage land cells, independent of the processing window
+	for (i = 0; i < NUM_CELLS; i++) {
+		if (land_area_sage[i] != raster_info.land_area_sage_nodata) {
+			store->num_cells++;
+		}
+	}
+	store->cells = calloc(store->num_cells + 1, sizeof(int));
+	if (store->cells == NULL) {
+		fprintf(fplog, "Failed to allocate memory for cells: sagestore_open()\n");
+		return ERROR_MEM;
+	}
+	store->num_cells = 0;
+	for (i = 0; i < NUM_CELLS; i++) {
+		if (land_area_sage[i] != raster_info.land_area_sage_nodata) {
+			store->cells[store->num_cells++] = i;
+		}
+	}
+
+	// build the store if it does not exist
+	if ((fp = fopen(store->fname, "rb")) != NULL) {
+		fclose(fp);
+	} else if (!window_box_is_full()) {
+		fprintf(fplog, "Error: the sage store %s does not exist and must be built by a run without a window box: sagestore_open()\n",
+				store->fname);
+		sagestore_close(store);
+		return ERROR_USAGE;
+	} else {
+		// the netcdf library is not thread safe, so its calls are serialized (nc_lock.c)
+		nc_lock();
+		err = sagestore_build(store, in_args);
+		nc_unlock();
+		if (err != OK) {
+			sagestore_close(store);
+			return err;
+		}
+	}
+
+	nc_lock();
+	if ((ncerr = nc_open(store->fname, NC_NOWRITE, &store->ncid))) {
+		fprintf(fplog, "Failed to open %s for reading: sagestore_open(); %s\n", store->fname, nc_strerror(ncerr));
+		store->ncid = -1;
+		err = ERROR_FILE;
+	} else {
+		err = sagestore_check(store);
+	}
+	nc_unlock();
+	if (err != OK) {
+		sagestore_close(store);
+		return err;
+	}
+
+	// the store cells in the processing window rows are contiguous, because the cells are in grid order
+	store->cell_start = 0;
+	while (store->cell_start < store->num_cells && store->cells[store->cell_start] < win_row_min * NUM_LON) {
+		store->cell_start++;
+	}
+	store->cell_count = 0;
+	while (store->cell_start + store->cell_count < store->num_cells &&
+		   store->cells[store->cell_start + store->cell_count] < (win_row_max + 1) * NUM_LON) {
+		store->cell_count++;
+	}
+
+	store->buf = calloc((long) SAGE_STORE_NFIELDS * store->cell_count + 1, sizeof(float));
+	store->qual_yield = grid_calloc(NUM_CELLS, sizeof(float));
+	store->qual_harv = grid_calloc(NUM_CELLS, sizeof(float));
+	if (store->buf == NULL || store->qual_yield == NULL || store->qual_harv == NULL) {
+		fprintf(fplog, "Failed to allocate memory for reading %s: sagestore_open()\n", store->fname);
+		sagestore_close(store);
+		return ERROR_MEM;
+	}
+
+	fprintf(fplog, "Reading the sage crops from the store %s: sagestore_open()\n", store->fname);
+
+	return OK;
+}
+
+/********
+ int sagestore_read_crop(sagestore_struct *store, int cropind, rinfo_struct raster_info)
+ read one crop from the store into yield_in and harvestarea_in, and convert it to working units like read_sage_crop()
+ the cells that are not sage land cells in the processing window rows are nodata
+ return:	error code
+ ********/
+int sagestore_read_crop(sagestore_struct *store, int cropind, rinfo_struct raster_info)
+{
+	size_t start[3] = {0, 0, 0};
+	size_t count[3] = {1, SAGE_STORE_NFIELDS, 0};
+	long n = store->cell_count;
+	long k;
+	int cell;
+	int ncerr;
+
+	start[0] = cropind;
+	start[2] = store->cell_start;
+	count[2] = n;
+	if (n > 0) {
+		nc_lock();
+		ncerr = nc_get_vara_float(store->ncid, store->varid, start, count, store->buf);
+		nc_unlock();
+		if (ncerr) {
+			fprintf(fplog, "Error reading crop %s from %s: sagestore_read_crop(); %s\n",
+					cropfilebase_sage[cropind], store->fname, nc_strerror(ncerr));
+			return ERROR_FILE;
+		}
+	}
+
+	for (k = 0; k < NUM_CELLS; k++) {
+		harvestarea_in[k] = SAGE_CROP_NODATA;
+		yield_in[k] = SAGE_CROP_NODATA;
+		store->qual_harv[k] = SAGE_CROP_NODATA;
+		store->qual_yield[k] = SAGE_CROP_NODATA;
+	}
+	for (k = 0; k < n; k++) {
+		cell = store->cells[store->cell_start + k];
+		harvestarea_in[cell] = store->buf[k];
+		yield_in[cell] = store->buf[n + k];
+		store->qual_harv[cell] = store->buf[2 * n + k];
+		store->qual_yield[cell] = store->buf[3 * n + k];
+	}
+
+	return convert_sage_crop(cropfilebase_sage[cropind], store->qual_yield, store->qual_harv, raster_info);
+}
+
+/********
+ void sagestore_close(sagestore_struct *store)
+ close the store and free its arrays
+ ********/
+void sagestore_close(sagestore_struct *store)
+{
+	if (store->ncid >= 0) {
+		nc_lock();
+		nc_close(store->ncid);
+		nc_unlock();
+	}
+	store->ncid = -1;
+	free(store->cells);
+	free(store->buf);
+	grid_free(store->qual_yield);
+	grid_free(store->qual_harv);
+	store->cells = NULL;
+	store->buf = NULL;
+	store->qual_yield = NULL;
+	store->qual_harv = NULL;
+}
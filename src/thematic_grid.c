@@ -0,0 +1,163 @@
+/**********
+ thematic_grid.c
+
+ contains the following functions for the narrow thematic rasters:
+	thm8_narrow()
+	thm8_widen()
+	read_raster_thm8()
+	write_raster_thm8()
+
+ the thematic (code) rasters with small code sets are stored as 8 bits instead of as 4-byte ints:
+	aez_bounds_orig, potveg_thematic, refveg_thematic, country87_gtap, region_gcam, protected_thematic
+ aez_bounds_new (glu codes) stays a 4-byte int raster, because a glu set may have tens of thousands of codes
+ the nodata value of the source data is stored as THM8_NODATA,
+  and THM8_VAL() (moirai.h) widens a cell value back to an int with the source nodata value
+ a value that does not fit its width is an error when it is stored, so the codes are never silently truncated
+ the rasters are widened to int only to write them
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+#define THM_READ_CELLS		1048576		// number of cells per block for reading a raster of 4-byte ints
+
+/********
+ int thm8_narrow(int in_array[], int length, int nodata, uint8_t out_array[], char *name)
+ store int values as 8-bit values
+ nodata:	the nodata value of in_array, stored as THM8_NODATA
+ name:		name of the raster for the log file
+ return:	error code; ERROR_IND if a value is not nodata and not 0 to 254
+ ********/
+int thm8_narrow(int in_array[], int length, int nodata, uint8_t out_array[], char *name)
+{
+	int i;
+
+	for (i = 0; i < length; i++) {
+		if (!THM8_FITS(in_array[i], nodata)) {
+			fprintf(fplog, "Error: value %i of cell %i of %s does not fit 8 bits: thm8_narrow()\n", in_array[i], i, name);
+			return ERROR_IND;
+		}
+		out_array[i] = THM8_CODE(in_array[i], nodata);
+	}
+
+	return OK;
+}
+
+/********
+ void thm8_widen(uint8_t in_array[], int length, int nodata, int out_array[])
+ widen 8-bit values to int values, with nodata for THM8_NODATA
+ ********/
+void thm8_widen(uint8_t in_array[], int length, int nodata, int out_array[])
+{
+	int i;
+
+	for (i = 0; i < length; i++) {
+		out_array[i] = THM8_VAL(in_array, i, nodata);
+	}
+}
+
+/********
+ static int read_raster_narrow(char *fname, int length, int nodata, uint8_t *out8)
+ read a raster file of 4-byte ints and store it narrow, one block of cells at a time
+ ********/
+static int read_raster_narrow(char *fname, int length, int nodata, uint8_t *out8)
+{
+	FILE *fpin;					// file pointer
+	int *in_block;				// one block of file values
+	int block_start;			// first cell of the block
+	int block_cells;			// number of cells in the block
+	int num_read;				// number of values read
+	int err = OK;
+
+	in_block = calloc(THM_READ_CELLS, sizeof(int));
+	if (in_block == NULL) {
+		fprintf(fplog, "Failed to allocate memory for in_block: read_raster_narrow()\n");
+		return ERROR_MEM;
+	}
+
+	if ((fpin = fopen(fname, "rb")) == NULL) {
+		fprintf(fplog, "Failed to open file %s: read_raster_narrow()\n", fname);
+		free(in_block);
+		return ERROR_FILE;
+	}
+
+	for (block_start = 0; err == OK && block_start < length; block_start = block_start + block_cells) {
+		block_cells = (length - block_start < THM_READ_CELLS) ? length - block_start : THM_READ_CELLS;
+		num_read = fread(in_block, sizeof(int), block_cells, fpin);
+		if (num_read != block_cells) {
+			fprintf(fplog, "Error reading file %s: read_raster_narrow(); num_read=%i != ncells=%i\n",
+					fname, block_start + num_read, length);
+			err = ERROR_FILE;
+		} else {
+			err = thm8_narrow(in_block, block_cells, nodata, &out8[block_start], fname);
+		}
+		if (err == ERROR_IND) {
+			fprintf(fplog, "Error: the cell above is in the block starting at cell %i: read_raster_narrow()\n", block_start);
+		}
+	}
+
+	fclose(fpin);
+	free(in_block);
+
+	return err;
+}
+
+/********
+ int read_raster_thm8(char *fname, int length, int nodata, uint8_t out_array[])
+ read a raster file of 4-byte ints into an 8-bit raster
+ fname:		file name with path
+ length:	number of cells to read
+ nodata:	the nodata value of the file
+ return:	error code
+ ********/
+int read_raster_thm8(char *fname, int length, int nodata, uint8_t out_array[])
+{
+	return read_raster_narrow(fname, length, nodata, out_array);
+}
+
+/********
+ int write_raster_thm8(uint8_t out_array[], int length, int nodata, char *out_name, args_struct in_args)
+ write an 8-bit raster as an int raster with write_raster_int()
+ nodata:	the value to write for THM8_NODATA
+ return:	error code
+ ********/
+int write_raster_thm8(uint8_t out_array[], int length, int nodata, char *out_name, args_struct in_args)
+{
+	int *wide;			// the widened values
+	int err = OK;
+
+	wide = calloc(length, sizeof(int));
+	if (wide == NULL) {
+		fprintf(fplog, "Failed to allocate memory for %s: write_raster_thm8()\n", out_name);
+		return ERROR_MEM;
+	}
+	thm8_widen(out_array, length, nodata, wide);
+	err = write_raster_int(wide, length, out_name, in_args);
+	free(wide);
+
+	return err;
+}
+
@@ -0,0 +1,408 @@
+/**********
+ working_grid.c
+
+ contains the following functions for the working grid dimensions and the common-grid check of the input rasters:
+	set_working_grid()
+	check_grid_dims()
+	check_grid_file()
+	check_grid_nc()
+	get_band_rows()
+	set_window()
+	in_window()
+	window_overlaps()
+	window_is_full()
+	window_box_is_full()
+	window_spread_float()
+	free_window()
+
+ the working grid is a global lat-lon grid with its origin at the upper left corner (90 lat, -180 lon)
+ its resolution is in_args.grid_res_sec (arc-seconds; 300 = 5 arcmin by default), and it sets
+  NUM_LAT, NUM_LON, NUM_CELLS, GRID_RES and GRID_RES_SEC
+ all the working grid inputs must be on this grid, and each reader checks its input with one of the check functions
+  before reading it; a raw binary (.bil) file is checked by its size, and netcdf and ascii grids by their dimensions
+ the lulc input grid (NUM_LAT_LULC x NUM_LON_LULC) stays the same, so each lulc cell must hold a whole number
+  of working grid cells
+ a run can be processed in latitude bands of in_args.band_rows rows, so that its peak memory scales with the band size:
+  the stages that read a grid per crop (mirca and water footprint) stream the grid through bands,
+  and all the other working grid arrays, including the ones that moirai_main() keeps for the whole run,
+  are paged through scratch files (see grid_store.c); each cell-level stage visits the cells a band at a time
+  and releases every grid band when it is done with it
+
+ a run can be restricted to a processing window for regional work: a lon/lat bounding box (in_args.window_bbox)
+  and/or lists of fao country codes (in_args.window_ctry) and glu codes (in_args.window_glu)
+ the working grid arrays stay global, so cell indices do not change, but get_land_cells() leaves the cells outside
+  the window out of all the land cell lists and masks, so every cell-level stage skips them
+ the per-crop readers fetch only the window rows (sage and water footprint) or stop after them (mirca)
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+/********
+ int set_working_grid(args_struct in_args)
+ set the working grid dimensions from in_args.grid_res_sec
+ return:	error code
+ ********/
+int set_working_grid(args_struct in_args)
+{
+	double nlat;			// number of rows implied by the resolution
+
+	nlat = 180.0 * DEG2SEC / in_args.grid_res_sec;
+	if (in_args.grid_res_sec <= 0 || fabs(nlat - floor(nlat + 0.5)) > 1e-6 || nlat > sqrt((double) INT_MAX / 2.0)) {
+		fprintf(fplog, "Error: grid_res_sec=%f does not divide 180 degrees into a valid number of rows: set_working_grid()\n",
+				in_args.grid_res_sec);
+		return ERROR_USAGE;
+	}
+
+	NUM_LAT = (int) floor(nlat + 0.5);
+	NUM_LON = 2 * NUM_LAT;
+	NUM_CELLS = NUM_LAT * NUM_LON;
+	GRID_RES_SEC = in_args.grid_res_sec;
+	GRID_RES = GRID_RES_SEC * SEC2DEG;
+
+	if (NUM_LAT % NUM_LAT_LULC != 0) {
+		fprintf(fplog, "Error: the working grid (%i rows) does not nest in the lulc grid (%i rows): set_working_grid()\n",
+				NUM_LAT, NUM_LAT_LULC);
+		return ERROR_USAGE;
+	}
+
+	fprintf(fplog, "Working grid: %i rows x %i columns, resolution %f arc-seconds: set_working_grid()\n",
+			NUM_LAT, NUM_LON, GRID_RES_SEC);
+
+	return OK;
+}
+
+/********
+ int check_grid_dims(char *fname, int nrows, int ncols)
+ the common-grid check: an input grid must have the working grid dimensions
+ fname:		the input file name, for the log
+ nrows:		number of rows (lats) of the input grid
+ ncols:		number of columns (lons) of the input grid
+ return:	error code
+ ********/
+int check_grid_dims(char *fname, int nrows, int ncols)
+{
+	if (nrows != NUM_LAT || ncols != NUM_LON) {
+		fprintf(fplog, "Error: %s is %i rows x %i columns but the working grid is %i x %i (grid_res_sec=%f): check_grid_dims()\n",
+				fname, nrows, ncols, NUM_LAT, NUM_LON, GRID_RES_SEC);
+		return ERROR_FILE;
+	}
+
+	return OK;
+}
+
+/********
+ int check_grid_file(char *fname, int insize)
+ check a raw binary working grid file by its size
+ fname:		the input file name, with path
+ insize:	the number of bytes per value
+ return:	error code
+ ********/
+int check_grid_file(char *fname, int insize)
+{
+	FILE *fpin;				// file pointer
+	long fsize;				// file size in bytes
+	long nvals;				// number of values in the file
+	int nrows;				// number of rows of a global grid with nvals cells
+
+	if ((fpin = fopen(fname, "rb")) == NULL) {
+		fprintf(fplog, "Failed to open file %s: check_grid_file()\n", fname);
+		return ERROR_FILE;
+	}
+	fseek(fpin, 0, SEEK_END);
+	fsize = ftell(fpin);
+	fclose(fpin);
+
+	nvals = fsize / insize;
+	if (fsize % insize == 0 && nvals == (long) NUM_CELLS) {
+		return OK;
+	}
+
+	// report the grid that the file would be, if it is a global grid
+	nrows = (int) floor(sqrt((double) nvals / 2.0) + 0.5);
+	if (fsize % insize == 0 && (long) nrows * 2 * nrows == nvals) {
+		return check_grid_dims(fname, nrows, 2 * nrows);
+	}
+	fprintf(fplog, "Error: %s has %li bytes, which is not a global grid of %i-byte values; the working grid has %i cells: check_grid_file()\n",
+			fname, fsize, insize, NUM_CELLS);
+	return ERROR_FILE;
+}
+
+/********
+ int check_grid_nc(char *fname, int ncid, int varid)
+ check a netcdf working grid variable; its last two dimensions must be lat and lon
+ fname:		the input file name, for the log
+ ncid:		the open netcdf file
+ varid:		the variable to check
+ return:	error code
+ ********/
+int check_grid_nc(char *fname, int ncid, int varid)
+{
+	int ndims;						// number of variable dimensions
+	int dimids[NC_MAX_VAR_DIMS];	// the variable dimension ids
+	size_t nrows = 0;				// length of the lat dimension
+	size_t ncols = 0;				// length of the lon dimension
+	int ncerr;						// netcdf error code
+
+	if ((ncerr = nc_inq_varndims(ncid, varid, &ndims)) || ndims < 2 ||
+		(ncerr = nc_inq_vardimid(ncid, varid, dimids)) ||
+		(ncerr = nc_inq_dimlen(ncid, dimids[ndims - 2], &nrows)) ||
+		(ncerr = nc_inq_dimlen(ncid, dimids[ndims - 1], &ncols))) {
+		fprintf(fplog, "Error getting the grid dimensions of %s: check_grid_nc(); %s\n", fname, nc_strerror(ncerr));
+		return ERROR_FILE;
+	}
+
+	return check_grid_dims(fname, (int) nrows, (int) ncols);
+}
+
+/********
+ int get_band_rows(args_struct in_args)
+ the number of working grid rows per latitude band
+ in_args.band_rows <= 0 or >= NUM_LAT means the whole grid is one band
+ return:	rows per band
+ ********/
+int get_band_rows(args_struct in_args)
+{
+	if (in_args.band_rows <= 0 || in_args.band_rows >= NUM_LAT) {
+		return NUM_LAT;
+	}
+
+	return in_args.band_rows;
+}
+
+/********
+ static int compare_int(const void *a, const void *b)
+ qsort() comparison of two ints
+ ********/
+static int compare_int(const void *a, const void *b)
+{
+	int ia = *((const int *) a);
+	int ib = *((const int *) b);
+
+	return (ia > ib) - (ia < ib);
+}
+
+/********
+ static int parse_codes(char *str, int **codes)
+ parse a comma separated list of integer codes into a sorted array
+ str:		the list; "0" or an empty string is no list
+ codes:		the allocated array of codes
+ return:	the number of codes, or a negative error code
+ ********/
+static int parse_codes(char *str, int **codes)
+{
+	int num = 1;			// number of codes
+	int i;
+	char *pos;				// current position in str
+	char *end;				// end of the current code
+
+	*codes = NULL;
+	if (str[0] == '\0' || strcmp(str, "0") == 0) {
+		return 0;
+	}
+	for (pos = str; *pos != '\0'; pos++) {
+		if (*pos == ',') {
+			num++;
+		}
+	}
+	*codes = calloc(num, sizeof(int));
+	if (*codes == NULL) {
+		return -ERROR_MEM;
+	}
+
+	pos = str;
+	for (i = 0; i < num; i++) {
+		(*codes)[i] = (int) strtol(pos, &end, 10);
+		if (end == pos || (*end != ',' && *end != '\0')) {
+			free(*codes);
+			*codes = NULL;
+			return -ERROR_USAGE;
+		}
+		pos = end + 1;
+	}
+	qsort(*codes, num, sizeof(int), compare_int);
+
+	return num;
+}
+
+/********
+ int set_window(args_struct in_args)
+ set the processing window from in_args.window_bbox, window_ctry and window_glu
+ a cell is in the bounding box if its center is; the box is the whole grid if window_bbox is "0"
+ this must be called after set_working_grid()
+ return:	error code
+ ********/
+int set_window(args_struct in_args)
+{
+	double lon_min, lon_max, lat_min, lat_max;		// bounding box (degrees)
+	char extra;										// anything after the four values
+
+	win_row_min = 0;
+	win_row_max = NUM_LAT - 1;
+	win_col_min = 0;
+	win_col_max = NUM_LON - 1;
+
+	if (strcmp(in_args.window_bbox, "0") != 0 && in_args.window_bbox[0] != '\0') {
+		if (sscanf(in_args.window_bbox, "%lf,%lf,%lf,%lf%c", &lon_min, &lon_max, &lat_min, &lat_max, &extra) != 4 ||
+			lon_min >= lon_max || lat_min >= lat_max) {
+			fprintf(fplog, "Error: window_bbox=%s is not lon_min,lon_max,lat_min,lat_max: set_window()\n", in_args.window_bbox);
+			return ERROR_USAGE;
+		}
+		// rows count down from 90 lat, columns up from -180 lon
+		win_row_min = (int) ceil((90.0 - lat_max) / GRID_RES - 0.5);
+		win_row_max = (int) floor((90.0 - lat_min) / GRID_RES - 0.5);
+		win_col_min = (int) ceil((lon_min + 180.0) / GRID_RES - 0.5);
+		win_col_max = (int) floor((lon_max + 180.0) / GRID_RES - 0.5);
+		win_row_min = (win_row_min < 0) ? 0 : win_row_min;
+		win_row_max = (win_row_max > NUM_LAT - 1) ? NUM_LAT - 1 : win_row_max;
+		win_col_min = (win_col_min < 0) ? 0 : win_col_min;
+		win_col_max = (win_col_max > NUM_LON - 1) ? NUM_LON - 1 : win_col_max;
+		if (win_row_min > win_row_max || win_col_min > win_col_max) {
+			fprintf(fplog, "Error: window_bbox=%s contains no working grid cell centers: set_window()\n", in_args.window_bbox);
+			return ERROR_USAGE;
+		}
+	}
+
+	if ((win_num_ctry = parse_codes(in_args.window_ctry, &win_ctry_codes)) < 0) {
+		fprintf(fplog, "Error: window_ctry=%s is not a list of country codes: set_window()\n", in_args.window_ctry);
+		return -win_num_ctry;
+	}
+	if ((win_num_glu = parse_codes(in_args.window_glu, &win_glu_codes)) < 0) {
+		fprintf(fplog, "Error: window_glu=%s is not a list of glu codes: set_window()\n", in_args.window_glu);
+		return -win_num_glu;
+	}
+
+	if (!window_is_full()) {
+		fprintf(fplog, "Processing window: rows %i to %i, columns %i to %i, %i countries (0 = all), %i glus (0 = all): set_window()\n",
+				win_row_min, win_row_max, win_col_min, win_col_max, win_num_ctry, win_num_glu);
+	}
+
+	return OK;
+}
+
+/********
+ int in_window(int cell, int ctry_code, int glu_code)
+ whether a working grid cell is in the processing window
+ cell:		working grid cell index
+ ctry_code:	fao country code of the cell
+ glu_code:	glu code of the cell
+ return:	1 if in the window, 0 if not
+ ********/
+int in_window(int cell, int ctry_code, int glu_code)
+{
+	int row = cell / NUM_LON;
+	int col = cell % NUM_LON;
+
+	if (row < win_row_min || row > win_row_max || col < win_col_min || col > win_col_max) {
+		return 0;
+	}
+	if (win_num_ctry > 0 && glu_list_index(win_ctry_codes, win_num_ctry, ctry_code) == NOMATCH) {
+		return 0;
+	}
+	if (win_num_glu > 0 && glu_list_index(win_glu_codes, win_num_glu, glu_code) == NOMATCH) {
+		return 0;
+	}
+
+	return 1;
+}
+
+/********
+ int window_overlaps(int row_ul, int col_ul, int nrows, int ncols)
+ whether a block of working grid cells overlaps the window box, such as the cells of one lulc cell
+ row_ul, col_ul:	upper left cell of the block
+ nrows, ncols:		size of the block
+ return:	1 if it overlaps, 0 if not
+ ********/
+int window_overlaps(int row_ul, int col_ul, int nrows, int ncols)
+{
+	return (row_ul <= win_row_max && row_ul + nrows - 1 >= win_row_min &&
+			col_ul <= win_col_max && col_ul + ncols - 1 >= win_col_min);
+}
+
+/********
+ int window_is_full(void)
+ whether the processing window is the whole working grid
+ return:	1 if the whole grid, 0 if not
+ ********/
+int window_is_full(void)
+{
+	return (window_box_is_full() && win_num_ctry == 0 && win_num_glu == 0);
+}
+
+/********
+ int window_box_is_full(void)
+ whether the processing window box is the whole working grid; the country and glu lists are not considered
+ return:	1 if the whole grid, 0 if not
+ ********/
+int window_box_is_full(void)
+{
+	return (win_row_min == 0 && win_row_max == NUM_LAT - 1 && win_col_min == 0 && win_col_max == NUM_LON - 1);
+}
+
+/********
+ void window_spread_float(float *grid, float fill)
+ move the window rows and columns, read packed at the start of grid, to their place on the working grid,
+  and set the cells outside the window box to fill
+ grid:		a working grid array (NUM_CELLS) holding the packed window values
+ fill:		value for the cells outside the window box
+ ********/
+void window_spread_float(float *grid, float fill)
+{
+	long win_ncols = win_col_max - win_col_min + 1;
+	long row;
+	long i;
+
+	if (window_box_is_full()) {
+		return;
+	}
+
+	// each packed row moves to an equal or later index, so go backwards
+	for (row = win_row_max; row >= win_row_min; row--) {
+		memmove(&grid[row * NUM_LON + win_col_min], &grid[(row - win_row_min) * win_ncols],
+				win_ncols * sizeof(float));
+	}
+	for (row = 0; row < NUM_LAT; row++) {
+		for (i = 0; i < NUM_LON; i++) {
+			if (row < win_row_min || row > win_row_max || i < win_col_min || i > win_col_max) {
+				grid[row * NUM_LON + i] = fill;
+			}
+		}
+	}
+}
+
+/********
+ void free_window(void)
+ free the processing window code lists
+ ********/
+void free_window(void)
+{
+	free(win_ctry_codes);
+	free(win_glu_codes);
+	win_ctry_codes = NULL;
+	win_glu_codes = NULL;
+	win_num_ctry = 0;
+	win_num_glu = 0;
+}
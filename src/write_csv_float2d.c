@@ -51,7 +51,8 @@ int write_csv_float2d(float out_array[], int d1[], int d1_length, int d2_length,
 	
 	int i,j;
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpout;					// file pointer
+	csvout_struct out;				// buffered output file
+	int err = OK;					// error code
 	int nelements;					// the number of elements in the output array
 	int nrecords;					// the number of records to write
 	int d1_index;					// index of separate array for dimension 1
@@ -73,23 +74,27 @@ int write_csv_float2d(float out_array[], int d1[], int d1_length, int d2_length,
 	strcpy(fname, in_args.outpath);
 	strcat(fname, out_name);
 	
-	if((fpout = fopen(fname, "w")) == NULL)
+	if((err = csvout_open(fname, &out)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s: write_csv_float2d()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 	
 	for (i = 0; i < nrecords; i++) {
 		d1_index = i;
-		fprintf(fpout,"%i", d1[d1_index]);
+		csvout_int(&out, d1[d1_index]);
 		for (j = 0; j < d2_length; j++) {
 			out_index = d2_length * d1_index + j;
-			fprintf(fpout,",%.2f", out_array[out_index]);
+			csvout_str(&out, ",");
+			csvout_float(&out, out_array[out_index], 2);
 		}
-		fprintf(fpout,"\n");
+		csvout_str(&out, "\n");
 	}
 	
-	fclose(fpout);
+	if ((err = csvout_close(&out)) != OK) {
+		fprintf(fplog,"Failed to write file %s: write_csv_float2d()\n", fname);
+		return err;
+	}
 	
 	if(i != nrecords)
 	{
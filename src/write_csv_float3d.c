@@ -55,7 +55,8 @@ int write_csv_float3d(float out_array[], int d1[], int d2[], int d1_length, int
 	
 	int i,j;
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpout;					// file pointer
+	csvout_struct out;				// buffered output file
+	int err = OK;					// error code
 	int nelements;					// the number of elements in the output array
 	int nrecords;					// the number of records to write
 	int d1_index, d2_index;			// indices of the separate arrays for the first two dimensions
@@ -78,10 +79,10 @@ int write_csv_float3d(float out_array[], int d1[], int d2[], int d1_length, int
 	strcpy(fname, in_args.outpath);
 	strcat(fname, out_name);
 	
-	if((fpout = fopen(fname, "w")) == NULL)
+	if((err = csvout_open(fname, &out)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s: write_csv_float3d()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 	
 	for (i = 0; i < nrecords; i++) {		
@@ -89,7 +90,9 @@ int write_csv_float3d(float out_array[], int d1[], int d2[], int d1_length, int
 		modf(temp_dbl, &integer_dbl);
 		d1_index = (int) integer_dbl;
 		d2_index = i - d1_index * d2_length;
-		fprintf(fpout,"%i,%i", d1[d1_index], d2[d2_index]);
+		csvout_int(&out, d1[d1_index]);
+		csvout_str(&out, ",");
+		csvout_int(&out, d2[d2_index]);
 		for (j = 0; j < d3_length; j++) {
 			out_index = d2_length * d3_length * d1_index + d3_length * d2_index + j;
 			
@@ -97,12 +100,16 @@ int write_csv_float3d(float out_array[], int d1[], int d2[], int d1_length, int
 				;
 			}
 			
-			fprintf(fpout,",%.2f", out_array[out_index]);
+			csvout_str(&out, ",");
+			csvout_float(&out, out_array[out_index], 2);
 		}
-		fprintf(fpout,"\n");
+		csvout_str(&out, "\n");
 	}
 	
-	fclose(fpout);
+	if ((err = csvout_close(&out)) != OK) {
+		fprintf(fplog,"Failed to write file %s: write_csv_float3d()\n", fname);
+		return err;
+	}
 	
 	if(i != nrecords)
 	{
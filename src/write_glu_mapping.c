@@ -25,6 +25,7 @@
         land use code: 0=unmanaged, 10=cropland, 20=pasture, 30=urbanland (crop, pasture, and urban are set in moirai.h)
         protected code: 1 = protected, 2= non-protected
     corresponds with the land type area and potveg carbon output csv files
+    lt_cat_index and potveg_index are also made here, so LT_CAT_IND() and POTVEG_IND() find an index without a search
 
  write only as a diagnostic:
     MOIRAI_reglr_GLU.csv    // file name for diagnostic gcam reglr+gluid to lr region abbr mapping
@@ -33,6 +34,8 @@
  
  Serbia and Montenegro are merged for processing and output, but they are also included separately here
     serbia (272, srb) and montenegro (273, mne) are merged into (186, scg)
+ the glus of the countries and regions are found in one pass over the land cells, as a bitmap over the compact glu indices
+    (glu_index()) for each country and region, and each glu list is then made once, sorted by glu code
  
  Do not write the GCAM biocrop aez name definition per region file (needs to be done manually):
 	AgLU_Data_System/aglu-data/Assumptions/
@@ -81,11 +84,49 @@
 
 #include "moirai.h"
 
+// bit g of row r of a glu bitmap with row_bytes bytes per row
+#define GLU_BIT_SET(bits, row_bytes, r, g)	((bits)[(size_t) (r) * (row_bytes) + ((g) >> 3)] |= (unsigned char) (1 << ((g) & 7)))
+#define GLU_BIT_GET(bits, row_bytes, r, g)	(((bits)[(size_t) (r) * (row_bytes) + ((g) >> 3)] >> ((g) & 7)) & 1)
+
+/********
+ static int make_glu_lists(unsigned char *bits, int row_bytes, int num_rows, int *glu_order, int *glu_num, int **glu_list)
+ allocate and fill the glu list of each row of a glu bitmap, in increasing glu code order
+ glu_order:	the compact glu indices in increasing glu code order
+ glu_num:	set to the number of glus in each row
+ glu_list:	set to the glu codes of each row
+ return:	error code
+ ********/
+static int make_glu_lists(unsigned char *bits, int row_bytes, int num_rows, int *glu_order, int *glu_num, int **glu_list)
+{
+	int r, g, k;
+
+	for (r = 0; r < num_rows; r++) {
+		glu_num[r] = 0;
+		for (g = 0; g < NUM_NEW_AEZ; g++) {
+			glu_num[r] = glu_num[r] + GLU_BIT_GET(bits, row_bytes, r, g);
+		}
+		glu_list[r] = calloc(glu_num[r] + 1, sizeof(int));
+		if (glu_list[r] == NULL) {
+			fprintf(fplog, "Failed to allocate memory for glu_list[%i]: make_glu_lists()\n", r);
+			return ERROR_MEM;
+		}
+		k = 0;
+		for (g = 0; g < NUM_NEW_AEZ && k < glu_num[r]; g++) {
+			if (GLU_BIT_GET(bits, row_bytes, r, glu_order[g])) {
+				glu_list[r][k++] = aez_codes_new[glu_order[g]];
+			}
+		}
+	}
+
+	return OK;
+}
+
 int write_glu_mapping(args_struct in_args, rinfo_struct raster_info) {
 	
 	int i,j,k;
 	int land_cell_ind;	// the index in the new aez land cell array of the current land cell
-	int gcam_id;		// gcam country+aez id (country*10000 + AEZ value)
+	band_walk_struct walk;	// releases the bands of the working grids behind the loop over the land cells
+	long long gcam_id;	// gcam country+aez id (country*ctryglu_id_mult + AEZ value; see ZONE_ID())
 	int ctry_code;		// fao country code
 	int ctry_ind;		// fao country index
     int reglr_ind;		// land rent region index
@@ -93,7 +134,18 @@ int write_glu_mapping(args_struct in_args, rinfo_struct raster_info) {
 	int aez_val;		// new aez value
     int cur_lt_cat_ind; // for creating the land type category array
     
-	int temp_vals[NUM_NEW_AEZ];	// temp storage for the aezs and region indices
+    int glu_ind;        // compact index of the new aez value
+    int scg_ind;        // fao index of serbia and montenegro
+    int max_ctry_code;  // largest fao country code
+    int *ctry_index_of_code;    // fao country index of each fao country code
+    int *reglr_of_ctry;         // land rent region index of each fao country
+    int *reggcam_of_ctry;       // gcam region index of each fao country
+    int row_bytes;              // bytes per country or region in the glu bitmaps
+    unsigned char *glu_bits;    // glu incidence of the countries; the region bitmaps follow in the same allocation
+    unsigned char *reglr_bits;  // glu incidence of the land rent regions
+    unsigned char *reggcam_bits;    // glu incidence of the gcam regions
+    int *glu_order;             // compact glu indices in glu code order
+    int err = OK;
 	
     int scg_code = 186;         // fao code for serbia and montenegro
     int srb_code = 272;         // fao code for serbia
@@ -117,75 +169,32 @@ int write_glu_mapping(args_struct in_args, rinfo_struct raster_info) {
     strcpy(oname1, in_args.iso_map_fname);
     strcpy(oname4, in_args.lt_map_fname);
     
-	// allocate memory for the country output list
+	// allocate memory for the output lists
+	// the glu lists themselves are allocated once their lengths are known, after the incidence pass below
 	ctry_aez_num = calloc(NUM_FAO_CTRY, sizeof(int));
-	if(ctry_aez_num == NULL) {
-		fprintf(fplog,"Failed to allocate memory for ctry_aez_num:  write_glu_mapping()\n");
-		return ERROR_MEM;
-	}
-	// store the new aezs associated with the countries
 	ctry_aez_list = calloc(NUM_FAO_CTRY, sizeof(int *));
-	if(ctry_aez_list == NULL) {
-		fprintf(fplog,"Failed to allocate memory for dim1 of ctry_aez_list:  write_glu_mapping()\n");
+	if(ctry_aez_num == NULL || ctry_aez_list == NULL) {
+		fprintf(fplog,"Failed to allocate memory for ctry_aez_num and ctry_aez_list:  write_glu_mapping()\n");
 		return ERROR_MEM;
 	}
-	// the second dimension will be dynamically reallocated for each dim1 index as needed
-	// but put initial allocation here
-	for (i = 0; i < NUM_FAO_CTRY; i++) {
-		ctry_aez_list[i] = calloc(1, sizeof(int));
-		if(ctry_aez_list[i] == NULL) {
-			fprintf(fplog,"Failed to allocate initial dummy memory for ctry_aez_list[i]; i=%i:  write_glu_mapping()\n", i);
-			return ERROR_MEM;
-		}
-	}
-    
-    // allocate memory for the land rent region output list
     reglr_aez_num = calloc(NUM_GTAP_CTRY87, sizeof(int));
-    if(reglr_aez_num == NULL) {
-        fprintf(fplog,"Failed to allocate memory for reglr_aez_num:  write_glu_mapping()\n");
-        return ERROR_MEM;
-    }
-    // store the new aezs associated with the countries
     reglr_aez_list = calloc(NUM_GTAP_CTRY87, sizeof(int *));
-    if(reglr_aez_list == NULL) {
-        fprintf(fplog,"Failed to allocate memory for dim1 of reglr_aez_list:  write_glu_mapping()\n");
+    if(reglr_aez_num == NULL || reglr_aez_list == NULL) {
+        fprintf(fplog,"Failed to allocate memory for reglr_aez_num and reglr_aez_list:  write_glu_mapping()\n");
         return ERROR_MEM;
     }
-    // the second dimension will be dynamically reallocated for each dim1 index as needed
-    // but put initial allocation here
-    for (i = 0; i < NUM_GTAP_CTRY87; i++) {
-        reglr_aez_list[i] = calloc(1, sizeof(int));
-        if(reglr_aez_list[i] == NULL) {
-            fprintf(fplog,"Failed to allocate initial dummy memory for reglr_aez_list[i]; i=%i:  write_glu_mapping()\n", i);
-            return ERROR_MEM;
-        }
-    }
-    
-    // allocate memory for the gcam region output list
     reggcam_aez_num = calloc(NUM_GCAM_RGN, sizeof(int));
-    if(reggcam_aez_num == NULL) {
-        fprintf(fplog,"Failed to allocate memory for reggcam_aez_num:  write_glu_mapping()\n");
-        return ERROR_MEM;
-    }
-    // store the new aezs associated with the countries
     reggcam_aez_list = calloc(NUM_GCAM_RGN, sizeof(int *));
-    if(reggcam_aez_list == NULL) {
-        fprintf(fplog,"Failed to allocate memory for dim1 of reggcam_aez_list:  write_glu_mapping()\n");
+    if(reggcam_aez_num == NULL || reggcam_aez_list == NULL) {
+        fprintf(fplog,"Failed to allocate memory for reggcam_aez_num and reggcam_aez_list:  write_glu_mapping()\n");
         return ERROR_MEM;
     }
-    // the second dimension will be dynamically reallocated for each dim1 index as needed
-    // but put initial allocation here
-    for (i = 0; i < NUM_GCAM_RGN; i++) {
-        reggcam_aez_list[i] = calloc(1, sizeof(int));
-        if(reggcam_aez_list[i] == NULL) {
-            fprintf(fplog,"Failed to allocate initial dummy memory for reggcam_aez_list[i]; i=%i:  write_glu_mapping()\n", i);
-            return ERROR_MEM;
-        }
-    }
     
     // generate the LDS_land_types.csv array, and write it on the fly
     strcpy(fname1, in_args.outpath);
     strcat(fname1, oname4);
+    // remove an existing file first, in case it was published as a hard link (publish_file())
+    remove(fname1);
     if((fpout1 = fopen(fname1, "w")) == NULL)
     {
         fprintf(fplog,"Failed to open file %s: write_glu_mapping()\n", fname1);
@@ -224,168 +233,158 @@ int write_glu_mapping(args_struct in_args, rinfo_struct raster_info) {
     
     fclose(fpout1);
     
-    // get the aezs associated with the countries
+    // the direct lookups of the category index and the sage land type index
+    max_lt_cat = lt_cats[num_lt_cats - 1];
+    max_potveg_code = 0;
+    for (k = 0; k < NUM_SAGE_PVLT; k++) {
+        if (landtypecodes_sage[k] > max_potveg_code) {
+            max_potveg_code = landtypecodes_sage[k];
+        }
+    }
+    lt_cat_index = calloc(max_lt_cat + 1, sizeof(int));
+    potveg_index = calloc(max_potveg_code + 1, sizeof(int));
+    if(lt_cat_index == NULL || potveg_index == NULL) {
+        fprintf(fplog,"Failed to allocate memory for lt_cat_index and potveg_index: write_glu_mapping()\n");
+        return ERROR_MEM;
+    }
+    for (i = 0; i <= max_lt_cat; i++) {
+        lt_cat_index[i] = NOMATCH;
+    }
+    for (i = 0; i < num_lt_cats; i++) {
+        lt_cat_index[lt_cats[i]] = i;
+    }
+    for (i = 0; i <= max_potveg_code; i++) {
+        potveg_index[i] = NOMATCH;
+    }
+    // the first of a duplicated code is used, as in a linear search
+    for (k = NUM_SAGE_PVLT - 1; k >= 0; k--) {
+        if (landtypecodes_sage[k] >= 0) {
+            potveg_index[landtypecodes_sage[k]] = k;
+        }
+    }
+    
+    // get the aezs associated with the countries, land rent regions and gcam regions in one pass over the land cells
     // include all fao countries here
+    // the incidence is a bit per glu for each country or region: the country rows, then the land rent region rows,
+    //  then the gcam region rows; glus are addressed by their compact index (glu_index())
+    row_bytes = (NUM_NEW_AEZ + 7) / 8;
+    glu_bits = calloc((size_t) (NUM_FAO_CTRY + NUM_GTAP_CTRY87 + NUM_GCAM_RGN) * row_bytes + 1, sizeof(unsigned char));
+    if(glu_bits == NULL) {
+        fprintf(fplog,"Failed to allocate memory for glu_bits:  write_glu_mapping()\n");
+        return ERROR_MEM;
+    }
+    reglr_bits = glu_bits + (size_t) NUM_FAO_CTRY * row_bytes;
+    reggcam_bits = reglr_bits + (size_t) NUM_GTAP_CTRY87 * row_bytes;
+    
+    // country index of each fao code, and region indices of each country
+    max_ctry_code = 0;
+    for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY; ctry_ind++) {
+        if (countrycodes_fao[ctry_ind] > max_ctry_code) {
+            max_ctry_code = countrycodes_fao[ctry_ind];
+        }
+    }
+    ctry_index_of_code = calloc(max_ctry_code + 1, sizeof(int));
+    reglr_of_ctry = calloc(NUM_FAO_CTRY, sizeof(int));
+    reggcam_of_ctry = calloc(NUM_FAO_CTRY, sizeof(int));
+    if(ctry_index_of_code == NULL || reglr_of_ctry == NULL || reggcam_of_ctry == NULL) {
+        fprintf(fplog,"Failed to allocate memory for the country lookups:  write_glu_mapping()\n");
+        return ERROR_MEM;
+    }
+    for (i = 0; i <= max_ctry_code; i++) {
+        ctry_index_of_code[i] = NOMATCH;
+    }
+    // the first of a duplicated code is used, as in a linear search
+    for (ctry_ind = NUM_FAO_CTRY - 1; ctry_ind >= 0; ctry_ind--) {
+        if (countrycodes_fao[ctry_ind] >= 0) {
+            ctry_index_of_code[countrycodes_fao[ctry_ind]] = ctry_ind;
+        }
+        // a country that is not assigned to a land rent region is not output
+        reglr_of_ctry[ctry_ind] = NOMATCH;
+        for (i = 0; i < NUM_GTAP_CTRY87; i++) {
+            if (country87codes_gtap[i] == ctry2ctry87codes_gtap[ctry_ind]) {
+                reglr_of_ctry[ctry_ind] = i;
+                break;
+            }
+        }
+        // countries are only assigned to gcam regions if they are also assigned to ctry87
+        reggcam_of_ctry[ctry_ind] = NOMATCH;
+        for (i = 0; i < NUM_GCAM_RGN; i++) {
+            if (regioncodes_gcam[i] == ctry2regioncodes_gcam[ctry_ind]) {
+                reggcam_of_ctry[ctry_ind] = i;
+                break;
+            }
+        }
+    }
+    scg_ind = (scg_code <= max_ctry_code) ? ctry_index_of_code[scg_code] : NOMATCH;
+    
+	band_walk_init(&walk, in_args);
 	for (land_cell_ind = 0; land_cell_ind < num_land_cells_aez_new; land_cell_ind++) {
+		band_walk_cell(&walk, land_cells_aez_new[land_cell_ind]);
 		aez_val = aez_bounds_new[land_cells_aez_new[land_cell_ind]];
         ctry_code = country_fao[land_cells_aez_new[land_cell_ind]];
-        ctry_ind = NOMATCH;
-        for (i = 0; i < NUM_FAO_CTRY; i++) {
-            if (countrycodes_fao[i] == ctry_code) {
-                ctry_ind = i;
-                break;
-            }
-        } // end for i loop to get ctry index
-        
+        ctry_ind = (ctry_code >= 0 && ctry_code <= max_ctry_code) ? ctry_index_of_code[ctry_code] : NOMATCH;
         if (ctry_ind == NOMATCH) {
             continue;
         }
-		
-		// skip this cell if this new aez has already been stored for this country
-        for (j = 0; j < ctry_aez_num[ctry_ind]; j++) {
-			if (aez_val == ctry_aez_list[ctry_ind][j]) {
-				break;
-			}
-		}
-		if (j == ctry_aez_num[ctry_ind]) {
-			// store this aez
-			// grow the dim2 as needed, per country
-			// aez values
-			for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-				temp_vals[i] = ctry_aez_list[ctry_ind][i];
-			}
-			free(ctry_aez_list[ctry_ind]);
-			ctry_aez_list[ctry_ind] = calloc(ctry_aez_num[ctry_ind] + 1, sizeof(int));
-			if(ctry_aez_list[ctry_ind] == NULL) {
-				fprintf(fplog,"Failed to allocate memory for ctry_aez_list[ctry_ind]; ctry_ind=%i:  write_glu_mapping()\n", ctry_ind);
-				return ERROR_MEM;
-			}
-			for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-				ctry_aez_list[ctry_ind][i] = temp_vals[i];
-			}
-            ctry_aez_list[ctry_ind][ctry_aez_num[ctry_ind]++] = aez_val;
-            
-            // merge serbia and montenegro for scg record
-            if (ctry_code == mne_code || ctry_code == srb_code) {
-                ctry_code = scg_code;
-                ctry_ind = NOMATCH;
-                for (j = 0; j < NUM_FAO_CTRY; j++) {
-                    if (countrycodes_fao[j] == ctry_code) {
-                        ctry_ind = j;
-                        break;
-                    }
-                }
-                if (ctry_ind == NOMATCH) {
-                    // this should never happen
-                    fprintf(fplog, "Error finding scg ctry index: write_glu_mapping()\n");
-                    return ERROR_IND;
-                }
-                
-                // check to see if it is already stored
-                for (j = 0; j < ctry_aez_num[ctry_ind]; j++) {
-                    if (aez_val == ctry_aez_list[ctry_ind][j]) {
-                        break;
-                    }
-                }
-                if (j == ctry_aez_num[ctry_ind]) {
-                    // now store this aez for scg
-                    for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-                        temp_vals[i] = ctry_aez_list[ctry_ind][i];
-                    }
-                    free(ctry_aez_list[ctry_ind]);
-                    ctry_aez_list[ctry_ind] = calloc(ctry_aez_num[ctry_ind] + 1, sizeof(int));
-                    if(ctry_aez_list[ctry_ind] == NULL) {
-                        fprintf(fplog,"Failed to allocate memory for ctry_aez_list[ctry_ind]; ctry_ind=%i:  write_glu_mapping()\n", ctry_ind);
-                        return ERROR_MEM;
-                    }
-                    for (i = 0; i < ctry_aez_num[ctry_ind]; i++) {
-                        ctry_aez_list[ctry_ind][i] = temp_vals[i];
-                    }
-                    ctry_aez_list[ctry_ind][ctry_aez_num[ctry_ind]++] = aez_val;
-                } // end if new aez val for scg
-            } // end if serbia or montenegro
-            
-            // now store this aez for the land rent region
-            // use scg index as set above because serbia and montenegro are not separately mapped to a region
-            reglr_ind = NOMATCH;
-            for (i = 0; i < NUM_GTAP_CTRY87; i++) {
-                if (country87codes_gtap[i] == ctry2ctry87codes_gtap[ctry_ind]) {
-                    reglr_ind = i;
-                    break;
-                }
-            }
-            if (reglr_ind == NOMATCH) {
-                // this happens when a country is not assigned to a land rent region
-                // which means that it is not output
-                // so skip this cell
-                continue;
-            }
-            // now store this aez for the land rent region, if it isn't there already
-            for (j = 0; j < reglr_aez_num[reglr_ind]; j++) {
-                if (aez_val == reglr_aez_list[reglr_ind][j]) {
-                    break;
-                }
-            }
-            if (j == reglr_aez_num[reglr_ind]) {
-                for (i = 0; i < reglr_aez_num[reglr_ind]; i++) {
-                    temp_vals[i] = reglr_aez_list[reglr_ind][i];
-                }
-                free(reglr_aez_list[reglr_ind]);
-                reglr_aez_list[reglr_ind] = calloc(reglr_aez_num[reglr_ind] + 1, sizeof(int));
-                if(reglr_aez_list[reglr_ind] == NULL) {
-                    fprintf(fplog,"Failed to allocate memory for reglr_aez_list[reglr_ind]; reglr_ind=%i:  write_glu_mapping()\n", reglr_ind);
-                    return ERROR_MEM;
-                }
-                for (i = 0; i < reglr_aez_num[reglr_ind]; i++) {
-                    reglr_aez_list[reglr_ind][i] = temp_vals[i];
-                }
-                reglr_aez_list[reglr_ind][reglr_aez_num[reglr_ind]++] = aez_val;
-            } // end if new aez for a land rent region
-            
-            // now store this aez for the gcam region
-            // use scg index as set above because serbia and montenegro are not separately mapped to a region
-			// countries are only assigned to gcam regions if they are also assigned to ctry87, so no need to check here
-            reggcam_ind = NOMATCH;
-            for (i = 0; i < NUM_GCAM_RGN; i++) {
-                if (regioncodes_gcam[i] == ctry2regioncodes_gcam[ctry_ind]) {
-                    reggcam_ind = i;
-                    break;
-                }
-            }
-            if (reggcam_ind == NOMATCH) {
-                // this happens when a country is not assigned to a gcam region or ctry87
-                // which means that it is not output
-                // so skip this cell
-                continue;
-            }
-            // now store this aez for the gcam region, if it isn't there already
-            for (j = 0; j < reggcam_aez_num[reggcam_ind]; j++) {
-                if (aez_val == reggcam_aez_list[reggcam_ind][j]) {
-                    break;
-                }
+        
+        if ((glu_ind = glu_index(aez_val)) == NOMATCH) {
+            fprintf(fplog, "Error: glu %i in country %i is not in the glu list: write_glu_mapping()\n", aez_val, ctry_code);
+            return ERROR_IND;
+        }
+        GLU_BIT_SET(glu_bits, row_bytes, ctry_ind, glu_ind);
+        
+        // merge serbia and montenegro for scg record
+        // and use the scg index for the regions because serbia and montenegro are not separately mapped to a region
+        if (ctry_code == mne_code || ctry_code == srb_code) {
+            if (scg_ind == NOMATCH) {
+                // this should never happen
+                fprintf(fplog, "Error finding scg ctry index: write_glu_mapping()\n");
+                return ERROR_IND;
             }
-            if (j == reggcam_aez_num[reggcam_ind]) {
-                for (i = 0; i < reggcam_aez_num[reggcam_ind]; i++) {
-                    temp_vals[i] = reggcam_aez_list[reggcam_ind][i];
-                }
-                free(reggcam_aez_list[reggcam_ind]);
-                reggcam_aez_list[reggcam_ind] = calloc(reggcam_aez_num[reggcam_ind] + 1, sizeof(int));
-                if(reggcam_aez_list[reggcam_ind] == NULL) {
-                    fprintf(fplog,"Failed to allocate memory for reggcam_aez_list[reggcam_ind]; reggcam_ind=%i:  write_glu_mapping()\n", reggcam_ind);
-                    return ERROR_MEM;
-                }
-                for (i = 0; i < reggcam_aez_num[reggcam_ind]; i++) {
-                    reggcam_aez_list[reggcam_ind][i] = temp_vals[i];
-                }
-                reggcam_aez_list[reggcam_ind][reggcam_aez_num[reggcam_ind]++] = aez_val;
-            } // end if new aez for a gcam region
-            
-		}	// end if this cell is a new aez to be stored
+            ctry_ind = scg_ind;
+            GLU_BIT_SET(glu_bits, row_bytes, ctry_ind, glu_ind);
+        }
+        
+        // the land rent region, and then the gcam region
+        if (reglr_of_ctry[ctry_ind] == NOMATCH) {
+            continue;
+        }
+        GLU_BIT_SET(reglr_bits, row_bytes, reglr_of_ctry[ctry_ind], glu_ind);
+        if (reggcam_of_ctry[ctry_ind] == NOMATCH) {
+            continue;
+        }
+        GLU_BIT_SET(reggcam_bits, row_bytes, reggcam_of_ctry[ctry_ind], glu_ind);
 	}	// end for land_cell_ind loop over land_cells_aez_new
+	band_walk_end(&walk);
+    
+    // make the glu lists, each sorted by integer code
+    // the lists must stay sorted because glu_list_index() finds a glu by binary search
+    glu_order = calloc(NUM_NEW_AEZ + 1, sizeof(int));
+    if(glu_order == NULL) {
+        fprintf(fplog,"Failed to allocate memory for glu_order:  write_glu_mapping()\n");
+        return ERROR_MEM;
+    }
+    // glu_index_sorted is in code order
+    for (k = 0; k < NUM_NEW_AEZ; k++) {
+        glu_order[k] = glu_index_sorted[k];
+    }
+    if ((err = make_glu_lists(glu_bits, row_bytes, NUM_FAO_CTRY, glu_order, ctry_aez_num, ctry_aez_list)) != OK ||
+        (err = make_glu_lists(reglr_bits, row_bytes, NUM_GTAP_CTRY87, glu_order, reglr_aez_num, reglr_aez_list)) != OK ||
+        (err = make_glu_lists(reggcam_bits, row_bytes, NUM_GCAM_RGN, glu_order, reggcam_aez_num, reggcam_aez_list)) != OK) {
+        fprintf(fplog,"Failed to make the glu lists:  write_glu_mapping()\n");
+        return err;
+    }
+    free(glu_bits);
+    free(glu_order);
+    free(ctry_index_of_code);
+    free(reglr_of_ctry);
+    free(reggcam_of_ctry);
 	
     // write the country and aez mapping to iso gcam file
     strcpy(fname1, in_args.outpath);
     strcat(fname1, oname1);
+    // remove an existing file first, in case it was published as a hard link (publish_file())
+    remove(fname1);
     if((fpout1 = fopen(fname1, "w")) == NULL)
     {
         fprintf(fplog,"Failed to open file %s: write_glu_mapping()\n", fname1);
@@ -438,29 +437,12 @@ int write_glu_mapping(args_struct in_args, rinfo_struct raster_info) {
     } // end if diagnostic output
     
     // country file
-	// sort the aezs in each country by integer code
 	for (ctry_ind = 0; ctry_ind < NUM_FAO_CTRY; ctry_ind++) {
-		// sort the aez values first; not pretty, but it works
-		for (j = 0; j < ctry_aez_num[ctry_ind]; j++) {
-			temp_vals[j] = ctry_aez_list[ctry_ind][j];
-		}
-		for (j = 0; j < ctry_aez_num[ctry_ind]; j++) {
-			ctry_aez_list[ctry_ind][j] = temp_vals[j];
-			for (i = j + 1; i < ctry_aez_num[ctry_ind]; i++) {
-				if (temp_vals[i] < ctry_aez_list[ctry_ind][j]) {
-					ctry_aez_list[ctry_ind][j] = temp_vals[i];
-					aez_val = temp_vals[j];
-					temp_vals[j] = temp_vals[i];
-					temp_vals[i] = aez_val;
-				}
-			}	// end for i loop over remaining elements
-        }	// end for j loop to sort
-        
-        // now write the sorted values, but only if country mapped to ctry87
+        // write the sorted values, but only if country mapped to ctry87
         for (j = 0; j < ctry_aez_num[ctry_ind]; j++) {
 			if (ctry2ctry87codes_gtap[ctry_ind] != NOMATCH) {
             	// make the country+aez id
-            	gcam_id = countrycodes_fao[ctry_ind] * FAOCTRY2GCAMCTRYAEZID + ctry_aez_list[ctry_ind][j];
+            	gcam_id = ZONE_ID(countrycodes_fao[ctry_ind], ctry_aez_list[ctry_ind][j]);
             	fprintf(fpout1,"\n%i,%i,%s,%s", countrycodes_fao[ctry_ind], ctry_aez_list[ctry_ind][j],
             	        countryabbrs_iso[ctry_ind], countrynames_fao[ctry_ind]);
 			} // end if country is assigned to ctry87
@@ -469,64 +451,30 @@ int write_glu_mapping(args_struct in_args, rinfo_struct raster_info) {
 	fclose(fpout1);
     
     // land rent region file
-    // sort the aezs in each land rent region by integer code
     for (reglr_ind = 0; reglr_ind < NUM_GTAP_CTRY87; reglr_ind++) {
-        // sort the aez values first; not pretty, but it works
-        for (j = 0; j < reglr_aez_num[reglr_ind]; j++) {
-            temp_vals[j] = reglr_aez_list[reglr_ind][j];
-        }
-        for (j = 0; j < reglr_aez_num[reglr_ind]; j++) {
-            reglr_aez_list[reglr_ind][j] = temp_vals[j];
-            for (i = j + 1; i < reglr_aez_num[reglr_ind]; i++) {
-                if (temp_vals[i] < reglr_aez_list[reglr_ind][j]) {
-                    reglr_aez_list[reglr_ind][j] = temp_vals[i];
-                    aez_val = temp_vals[j];
-                    temp_vals[j] = temp_vals[i];
-                    temp_vals[i] = aez_val;
-                }
-            }	// end for i loop over remaining elements
-        }	// end for j loop to sort
-        
         if (in_args.diagnostics) {
-            // now write the sorted values
+            // write the sorted values
             for (j = 0; j < reglr_aez_num[reglr_ind]; j++) {
                 // make the reglr+aez id
-                gcam_id = country87codes_gtap[reglr_ind] * FAOCTRY2GCAMCTRYAEZID + reglr_aez_list[reglr_ind][j];
+                gcam_id = ZONE_ID(country87codes_gtap[reglr_ind], reglr_aez_list[reglr_ind][j]);
                 fprintf(fpout2,"\n%i,%i,%s,%s", country87codes_gtap[reglr_ind], reglr_aez_list[reglr_ind][j],
                         country87abbrs_gtap[reglr_ind], country87names_gtap[reglr_ind]);
             }	// end for j loop over the aezs within regions
         } // end if diagnostic output
-    }	// end for reglr_ind loop for sorting the land rent region lists
+    }	// end for reglr_ind loop over the land rent region lists
     
     // gcam region file
-    // sort the aezs in each gcam region by integer code
     for (reggcam_ind = 0; reggcam_ind < NUM_GCAM_RGN; reggcam_ind++) {
-        // sort the aez values first; not pretty, but it works
-        for (j = 0; j < reggcam_aez_num[reggcam_ind]; j++) {
-            temp_vals[j] = reggcam_aez_list[reggcam_ind][j];
-        }
-        for (j = 0; j < reggcam_aez_num[reggcam_ind]; j++) {
-            reggcam_aez_list[reggcam_ind][j] = temp_vals[j];
-            for (i = j + 1; i < reggcam_aez_num[reggcam_ind]; i++) {
-                if (temp_vals[i] < reggcam_aez_list[reggcam_ind][j]) {
-                    reggcam_aez_list[reggcam_ind][j] = temp_vals[i];
-                    aez_val = temp_vals[j];
-                    temp_vals[j] = temp_vals[i];
-                    temp_vals[i] = aez_val;
-                }
-            }	// end for i loop over remaining elements
-        }	// end for j loop to sort
-        
         if (in_args.diagnostics) {
-            // now write the sorted values
+            // write the sorted values
             for (j = 0; j < reggcam_aez_num[reggcam_ind]; j++) {
                 // make the reggcam+aez id
-                gcam_id = regioncodes_gcam[reggcam_ind] * FAOCTRY2GCAMCTRYAEZID + reggcam_aez_list[reggcam_ind][j];
+                gcam_id = ZONE_ID(regioncodes_gcam[reggcam_ind], reggcam_aez_list[reggcam_ind][j]);
                 fprintf(fpout3,"\n%i,%i,%s", regioncodes_gcam[reggcam_ind], reggcam_aez_list[reggcam_ind][j],
                         regionnames_gcam[reggcam_ind]);
             }	// end for j loop over the aezs within regions
         } // end if diagnostic output
-    }	// end for reggcam_ind loop for sorting the gcam region lists
+    }	// end for reggcam_ind loop over the gcam region lists
     
     if (in_args.diagnostics) {
         fclose(fpout2);
@@ -61,7 +61,10 @@ int write_production_crop_aez(args_struct in_args) {
 	int nrecords = 0;	// count number of records in output file
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpout;					// file pointer
+	csvout_struct out;				// buffered output file
+	coltab_struct tab;				// columnar copy of the table, if out_columnar
+	int tab_keys[3];				// keys of one record for the columnar copy
+	int err = OK;					// error code
 	int ctry_index = 0;				// the index of the country to write
     int aez_index = 0;				// the index of the aez to write
 	int crop_index = 0;				// the index of the crop to write
@@ -72,19 +75,29 @@ int write_production_crop_aez(args_struct in_args) {
 	strcpy(fname, in_args.outpath);
 	strcat(fname, in_args.production_fname);
 	
-	if((fpout = fopen(fname, "w")) == NULL)
+	if((err = csvout_open(fname, &out)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s: write_production_crop_aez()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 	
 	// write header lines
-	fprintf(fpout,"# File: %s\n", fname);
-	fprintf(fpout,"# Author: %s\n", CODENAME);
-	fprintf(fpout,"# Description: Initialization of production (t) by country/GLU/crop\n");
-	fprintf(fpout,"# Original source: many, including HYDE and SAGE\n");
-	fprintf(fpout,"# ----------\n");
-	fprintf(fpout,"ctry_iso,glu_code,SAGE_crop,value");
+	csvout_printf(&out,"# File: %s\n", fname);
+	csvout_printf(&out,"# Author: %s\n", CODENAME);
+	csvout_str(&out,"# Description: Initialization of production (t) by country/GLU/crop\n");
+	csvout_str(&out,"# Original source: many, including HYDE and SAGE\n");
+	csvout_str(&out,"# ----------\n");
+	csvout_str(&out,"ctry_iso,glu_code,SAGE_crop,value");
+	
+	if (in_args.out_columnar) {
+		if ((err = coltab_init(&tab, fname, "production (t) by country/GLU/crop", "value", "t", 3)) != OK) {
+			fprintf(fplog,"Failed to initialize columnar table for %s: write_production_crop_aez()\n", fname);
+			return err;
+		}
+		coltab_key(&tab, 0, "ctry_iso", countryabbrs_iso, NUM_FAO_CTRY);
+		coltab_key(&tab, 1, "glu_code", NULL, 0);
+		coltab_key(&tab, 2, "SAGE_crop", cropnames_gtap, NUM_SAGE_CROP);
+	}
 	
 	// write the records (round the values first)
 	for (ctry_index = 0; ctry_index < NUM_FAO_CTRY; ctry_index++) {
@@ -104,8 +117,20 @@ int write_production_crop_aez(args_struct in_args) {
                             fprintf(fplog, "Discard production due to no harvested area: prod = %.0f and ha = 0: write_production_crop_aez(); ctrycode=%i,aezcode=%i, cropcode=%i\n", outval, countrycodes_fao[ctry_index], ctry_aez_list[ctry_index][aez_index],
                                     cropcodes_sage[crop_index]);
 						} else {
-							fprintf(fpout,"\n%s,%i,%s,%.0f", countryabbrs_iso[ctry_index], ctry_aez_list[ctry_index][aez_index],
-									cropnames_gtap[crop_index], outval);
+							csvout_str(&out, "\n");
+							csvout_str(&out, countryabbrs_iso[ctry_index]);
+							csvout_str(&out, ",");
+							csvout_int(&out, ctry_aez_list[ctry_index][aez_index]);
+							csvout_str(&out, ",");
+							csvout_str(&out, cropnames_gtap[crop_index]);
+							csvout_str(&out, ",");
+							csvout_float(&out, outval, 0);
+							if (in_args.out_columnar) {
+								tab_keys[0] = ctry_index;
+								tab_keys[1] = ctry_aez_list[ctry_index][aez_index];
+								tab_keys[2] = crop_index;
+								coltab_add(&tab, tab_keys, outval);
+							}
 							nrecords++;
 						}
 						
@@ -119,7 +144,14 @@ int write_production_crop_aez(args_struct in_args) {
         } // end else write output
     } // end for ctry_index loop over number of records in output array
 
-	fclose(fpout);
+	if ((err = csvout_close(&out)) != OK) {
+		fprintf(fplog,"Failed to write file %s: write_production_crop_aez()\n", fname);
+		return err;
+	}
+	if (in_args.out_columnar && (err = coltab_write(&tab)) != OK) {
+		fprintf(fplog,"Failed to write columnar table for %s: write_production_crop_aez()\n", fname);
+		return err;
+	}
     
 	fprintf(fplog, "Wrote file %s: write_production_crop_aez(); records written=%i != countries skipped=%i\n",
 			fname, nrecords, count_skip);
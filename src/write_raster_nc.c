@@ -0,0 +1,239 @@
+/**********
+ write_raster_nc.c
+
+ write a raster image as a compressed netcdf-4 file
+ this is called by write_raster_float(), write_raster_int(), write_raster_short() and write_raster_zone_id() when in_args.out_nc_grids is set
+ the file name is out_name with its extension replaced by .nc
+
+ a working grid array (out_length = NUM_CELLS) is written as a NUM_LAT X NUM_LON variable at GRID_RES, with cf
+  coordinate variables of cell centers; lat decreases from the north, as the data are stored
+ any other length is written as a 1-d variable along a cell dimension
+ the variable is chunked and deflated with the shuffle filter; the fill value is NODATA
+ the netcdf library is not thread safe, so the file is written while holding the netcdf lock (nc_lock.c),
+  which also guards the netcdf reads that may run at the same time in other threads
+
+ arguments:
+ void *out_array:		array to write to file
+ nc_type out_type:		NC_FLOAT, NC_INT, NC_SHORT or NC_INT64 (long long), the type of out_array
+ int out_length:		length of array to write to file
+ char *out_name:		name of output file
+ args_struct in_args:	the input argument structure
+
+ return value:
+ integer error code: OK = 0, otherwise a non-zero error code
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+#define NC_GRID_DEFLATE		4		// deflate level for the grid files
+#define NC_GRID_CHUNK_LAT	240		// max rows per chunk
+#define NC_GRID_CHUNK_LON	480		// max columns per chunk
+
+static int write_raster_nc_file(void *out_array, nc_type out_type, int out_length, char *out_name, args_struct in_args);
+
+int write_raster_nc(void *out_array, nc_type out_type, int out_length, char *out_name, args_struct in_args) {
+
+	int err;
+
+	nc_lock();
+	err = write_raster_nc_file(out_array, out_type, out_length, out_name, in_args);
+	nc_unlock();
+
+	return err;
+}
+
+static int write_raster_nc_file(void *out_array, nc_type out_type, int out_length, char *out_name, args_struct in_args) {
+
+	char fname[MAXCHAR];			// file name to open
+	char var_name[MAXCHAR];			// variable name: out_name without the extension
+	char source[MAXCHAR];			// source attribute
+	char history[MAXCHAR];			// history attribute: the creation time
+	char *ext;						// extension of the file name
+	int ncid;						// netcdf file id
+	int ncerr = NC_NOERR;			// netcdf error code
+	int dimids[2];					// dimension ids; lat, lon or just cell
+	int lat_varid, lon_varid;		// coordinate variable ids
+	int varid;						// data variable id
+	int ndims = 1;					// 2 for a lat-lon grid
+	int nlat = 0;					// number of rows of a lat-lon grid
+	int nlon = 0;					// number of columns of a lat-lon grid
+	double res = 0;					// grid resolution (degrees)
+	double *coords;					// lat or lon values
+	size_t chunk[2];				// chunk sizes
+	float fill_float = NODATA;		// fill values of each type
+	int fill_int = NODATA;
+	short fill_short = NODATA;
+	long long fill_int64 = NODATA;
+	void *fill;
+	int i;
+	int err = OK;
+
+	// create file name
+	strcpy(fname, in_args.outpath);
+	strcat(fname, out_name);
+	ext = strrchr(fname, '.');
+	if (ext != NULL && strchr(ext, '/') == NULL) {
+		*ext = '\0';
+	}
+	strcat(fname, ".nc");
+	strcpy(var_name, out_name);
+	ext = strrchr(var_name, '.');
+	if (ext != NULL) {
+		*ext = '\0';
+	}
+
+	switch (out_type) {
+		case NC_FLOAT:
+			fill = &fill_float;
+			break;
+		case NC_INT:
+			fill = &fill_int;
+			break;
+		case NC_SHORT:
+			fill = &fill_short;
+			break;
+		case NC_INT64:
+			fill = &fill_int64;
+			break;
+		default:
+			fprintf(fplog, "Error: unsupported type %i for %s: write_raster_nc()\n", (int) out_type, fname);
+			return ERROR_IND;
+	}
+
+	// a working grid array is written as a lat-lon grid (set_working_grid())
+	if (out_length == NUM_CELLS) {
+		ndims = 2;
+		nlat = NUM_LAT;
+		nlon = NUM_LON;
+		res = GRID_RES;
+	}
+
+	if ((ncerr = nc_create(fname, NC_CLOBBER | NC_NETCDF4, &ncid))) {
+		fprintf(fplog, "Failed to create %s: write_raster_nc(); %s\n", fname, nc_strerror(ncerr));
+		return ERROR_FILE;
+	}
+
+	// global attributes
+	sprintf(source, "%s %s", CODENAME, VERSION);
+	strcpy(history, get_systime());
+	history[strcspn(history, "\n")] = '\0';
+	if ((ncerr = nc_put_att_text(ncid, NC_GLOBAL, "Conventions", strlen("CF-1.6"), "CF-1.6")) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "title", strlen(var_name), var_name)) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "source", strlen(source), source)) ||
+		(ncerr = nc_put_att_text(ncid, NC_GLOBAL, "history", strlen(history), history))) {
+		err = ERROR_FILE;
+	}
+
+	// dimensions and coordinate variables
+	if (err == OK && ndims == 2) {
+		if ((ncerr = nc_def_dim(ncid, "lat", nlat, &dimids[0])) ||
+			(ncerr = nc_def_dim(ncid, "lon", nlon, &dimids[1])) ||
+			(ncerr = nc_def_var(ncid, "lat", NC_DOUBLE, 1, &dimids[0], &lat_varid)) ||
+			(ncerr = nc_put_att_text(ncid, lat_varid, "standard_name", strlen("latitude"), "latitude")) ||
+			(ncerr = nc_put_att_text(ncid, lat_varid, "units", strlen("degrees_north"), "degrees_north")) ||
+			(ncerr = nc_put_att_text(ncid, lat_varid, "axis", 1, "Y")) ||
+			(ncerr = nc_def_var(ncid, "lon", NC_DOUBLE, 1, &dimids[1], &lon_varid)) ||
+			(ncerr = nc_put_att_text(ncid, lon_varid, "standard_name", strlen("longitude"), "longitude")) ||
+			(ncerr = nc_put_att_text(ncid, lon_varid, "units", strlen("degrees_east"), "degrees_east")) ||
+			(ncerr = nc_put_att_text(ncid, lon_varid, "axis", 1, "X"))) {
+			err = ERROR_FILE;
+		}
+		chunk[0] = (nlat < NC_GRID_CHUNK_LAT) ? nlat : NC_GRID_CHUNK_LAT;
+		chunk[1] = (nlon < NC_GRID_CHUNK_LON) ? nlon : NC_GRID_CHUNK_LON;
+	} else if (err == OK) {
+		if ((ncerr = nc_def_dim(ncid, "cell", out_length, &dimids[0]))) {
+			err = ERROR_FILE;
+		}
+		chunk[0] = (out_length < NC_GRID_CHUNK_LAT * NC_GRID_CHUNK_LON) ? out_length : NC_GRID_CHUNK_LAT * NC_GRID_CHUNK_LON;
+		if (chunk[0] == 0) {
+			chunk[0] = 1;
+		}
+	}
+
+	// the data variable
+	if (err == OK && ((ncerr = nc_def_var(ncid, var_name, out_type, ndims, dimids, &varid)) ||
+					  (ncerr = nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunk)) ||
+					  (ncerr = nc_def_var_deflate(ncid, varid, 1, 1, NC_GRID_DEFLATE)) ||
+					  (ncerr = nc_def_var_fill(ncid, varid, 0, fill)) ||
+					  (ncerr = nc_put_att_text(ncid, varid, "long_name", strlen(var_name), var_name)))) {
+		err = ERROR_FILE;
+	}
+
+	if (err == OK && (ncerr = nc_enddef(ncid))) {
+		err = ERROR_FILE;
+	}
+
+	// the coordinates are cell centers
+	if (err == OK && ndims == 2) {
+		coords = calloc(nlon, sizeof(double));
+		if (coords == NULL) {
+			fprintf(fplog, "Failed to allocate memory for coords: write_raster_nc()\n");
+			nc_close(ncid);
+			return ERROR_MEM;
+		}
+		for (i = 0; i < nlat; i++) {
+			coords[i] = 90.0 - (i + 0.5) * res;
+		}
+		if ((ncerr = nc_put_var_double(ncid, lat_varid, coords))) {
+			err = ERROR_FILE;
+		}
+		for (i = 0; i < nlon; i++) {
+			coords[i] = -180.0 + (i + 0.5) * res;
+		}
+		if (err == OK && (ncerr = nc_put_var_double(ncid, lon_varid, coords))) {
+			err = ERROR_FILE;
+		}
+		free(coords);
+	}
+
+	if (err == OK && out_length > 0) {
+		if (out_type == NC_FLOAT) {
+			ncerr = nc_put_var_float(ncid, varid, (float *) out_array);
+		} else if (out_type == NC_INT) {
+			ncerr = nc_put_var_int(ncid, varid, (int *) out_array);
+		} else if (out_type == NC_SHORT) {
+			ncerr = nc_put_var_short(ncid, varid, (short *) out_array);
+		} else {
+			ncerr = nc_put_var_longlong(ncid, varid, (long long *) out_array);
+		}
+		if (ncerr) {
+			err = ERROR_FILE;
+		}
+	}
+
+	if (err != OK) {
+		fprintf(fplog, "Error writing file %s: write_raster_nc(); %s\n", fname, nc_strerror(ncerr));
+		nc_close(ncid);
+		return err;
+	}
+	if ((ncerr = nc_close(ncid))) {
+		fprintf(fplog, "Error closing file %s: write_raster_nc(); %s\n", fname, nc_strerror(ncerr));
+		return ERROR_FILE;
+	}
+
+	return OK;
+}
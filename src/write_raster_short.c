@@ -4,6 +4,7 @@
  write a short raster image
  start at upper left corner and write row by row (this is how the data are stored)
  no header
+ write a compressed netcdf file instead if in_args.out_nc_grids is set (see write_raster_nc.c)
  
  arguments:
  short out_array[]:		array to write to file
@@ -47,6 +48,10 @@ int write_raster_short(short out_array[], int out_length, char *out_name, args_s
 	FILE *fpout;					// file pointer
 	int num_out;					// store the number of elements written
 	
+	if (in_args.out_nc_grids) {
+		return write_raster_nc(out_array, NC_SHORT, out_length, out_name, in_args);
+	}
+	
 	// create file name and open it
 	strcpy(fname, in_args.outpath);
 	strcat(fname, out_name);
@@ -56,7 +56,10 @@ int write_rent_use_aez(args_struct in_args) {
 	int nrecords = 0;	// count number of records in output file
 	
 	char fname[MAXCHAR];			// file name to open
-	FILE *fpout;					// file pointer
+	csvout_struct out;				// buffered output file
+	coltab_struct tab;				// columnar copy of the table, if out_columnar
+	int tab_keys[3];				// keys of one record for the columnar copy
+	int err = OK;					// error code
 	int reglr_index = 0;			// the index of the land rent region to write
     int aez_index = 0;				// the index of the aez to write
 	int use_index = 0;				// the index of the use to write
@@ -65,19 +68,29 @@ int write_rent_use_aez(args_struct in_args) {
 	strcpy(fname, in_args.outpath);
 	strcat(fname, in_args.rent_fname);
 	
-	if((fpout = fopen(fname, "w")) == NULL)
+	if((err = csvout_open(fname, &out)) != OK)
 	{
 		fprintf(fplog,"Failed to open file %s: write_rent_use_aez()\n", fname);
-		return ERROR_FILE;
+		return err;
 	}
 	
 	// write header lines
-	fprintf(fpout,"# File: %s\n", fname);
-	fprintf(fpout,"# Author: %s\n", CODENAME);
-	fprintf(fpout,"# Description: Initialization of land value (million USD) by country87/use/GLU\n");
-	fprintf(fpout,"# Original source: many, including HYDE and SAGE\n");
-	fprintf(fpout,"# ----------\n");
-	fprintf(fpout,"reglr_iso,glu_code,use_sector,value");
+	csvout_printf(&out,"# File: %s\n", fname);
+	csvout_printf(&out,"# Author: %s\n", CODENAME);
+	csvout_str(&out,"# Description: Initialization of land value (million USD) by country87/use/GLU\n");
+	csvout_str(&out,"# Original source: many, including HYDE and SAGE\n");
+	csvout_str(&out,"# ----------\n");
+	csvout_str(&out,"reglr_iso,glu_code,use_sector,value");
+	
+	if (in_args.out_columnar) {
+		if ((err = coltab_init(&tab, fname, "land value (million USD) by country87/use/GLU", "value", "million USD", 3)) != OK) {
+			fprintf(fplog,"Failed to initialize columnar table for %s: write_rent_use_aez()\n", fname);
+			return err;
+		}
+		coltab_key(&tab, 0, "reglr_iso", country87abbrs_gtap, NUM_GTAP_CTRY87);
+		coltab_key(&tab, 1, "glu_code", NULL, 0);
+		coltab_key(&tab, 2, "use_sector", usenames_gtap, NUM_GTAP_USE);
+	}
 	
 	// write the records (these are not rounded, but are output to 9 decimals)
 	for (reglr_index = 0; reglr_index < NUM_GTAP_CTRY87 ; reglr_index++) {
@@ -85,15 +98,34 @@ int write_rent_use_aez(args_struct in_args) {
             for (use_index = 0; use_index < NUM_GTAP_USE; use_index++) {
                 // output only positive values
                 if (rent_use_aez[reglr_index][aez_index][use_index] > 0) {
-                    fprintf(fpout,"\n%s,%i,%s,%11.9f", country87abbrs_gtap[reglr_index], reglr_aez_list[reglr_index][aez_index],
-                            usenames_gtap[use_index], rent_use_aez[reglr_index][aez_index][use_index]);
+                    csvout_str(&out, "\n");
+                    csvout_str(&out, country87abbrs_gtap[reglr_index]);
+                    csvout_str(&out, ",");
+                    csvout_int(&out, reglr_aez_list[reglr_index][aez_index]);
+                    csvout_str(&out, ",");
+                    csvout_str(&out, usenames_gtap[use_index]);
+                    csvout_str(&out, ",");
+                    csvout_printf(&out, "%11.9f", rent_use_aez[reglr_index][aez_index][use_index]);
+                    if (in_args.out_columnar) {
+                        tab_keys[0] = reglr_index;
+                        tab_keys[1] = reglr_aez_list[reglr_index][aez_index];
+                        tab_keys[2] = use_index;
+                        coltab_add(&tab, tab_keys, rent_use_aez[reglr_index][aez_index][use_index]);
+                    }
                     nrecords++;
                 } // end if value is positive
             } // end for use loop
 		} // end for aez loop
 	} // end for land rent region loop
 	
-	fclose(fpout);
+	if ((err = csvout_close(&out)) != OK) {
+		fprintf(fplog,"Failed to write file %s: write_rent_use_aez()\n", fname);
+		return err;
+	}
+	if (in_args.out_columnar && (err = coltab_write(&tab)) != OK) {
+		fprintf(fplog,"Failed to write columnar table for %s: write_rent_use_aez()\n", fname);
+		return err;
+	}
 	
 	fprintf(fplog, "Wrote file %s: write_rent_use_aez(); records written=%i\n", fname, nrecords);
 	
@@ -0,0 +1,225 @@
+/**********
+ zone_accum.c
+
+ contains the following functions for the parallel accumulation of land cell values into country X glu zones:
+	zonemap_init()
+	zone_accum()
+	zonemap_free()
+
+ proc_mirca(), proc_water_footprint() and proc_refveg_carbon() add the values of each land cell to the output
+  row of its country and glu
+ a zone is one country X glu pair of ctry_aez_list, numbered zone_start[ctry_ind] + glu_ind
+ zonemap_init() finds the zone of each cell of a land cell list once, so the country and glu lookups
+  (with serbia and montenegro merged into scg, and only countries with an economic region) are not repeated for each crop
+ zone_accum() groups the cells of a list range by zone and then accumulates the zones in parallel, in double precision
+ each zone is accumulated by one thread, over its cells in list order, so the threads never write the same value
+  and the sums are the same for any number of threads (including a serial build)
+
+ Created 19 October 2026
+
+ Moirai Land Data System (Moirai) Copyright (c) 2019, The
+ Regents of the University of California, through Lawrence Berkeley National
+ Laboratory (subject to receipt of any required approvals from the U.S.
+ Dept. of Energy).  All rights reserved.
+
+ If you have questions about your rights to use or distribute this software,
+ please contact Berkeley Lab's Intellectual Property Office at
+ IPO@lbl.gov.
+
+ NOTICE.  This Software was developed under funding from the U.S. Department
+ of Energy and the U.S. Government consequently retains certain rights.  As
+ such, the U.S. Government has been granted for itself and others acting on
+ its behalf a paid-up, nonexclusive, irrevocable, worldwide license in the
+ Software to reproduce, distribute copies to the public, prepare derivative
+ works, and perform publicly and display publicly, and to permit other to do
+ so.
+
+ This file is part of Moirai.
+
+ Moirai is free software: you can use it under the terms of the modified BSD-3 license (see …/moirai/license.txt)
+
+ **********/
+
+#include "moirai.h"
+
+#define ZONE_ACCUM_MAX_VALS		4		// max number of values a cell adds to its zone
+
+/********
+ int zonemap_init(zonemap_struct *map, args_struct in_args, int *cells, int num_cells, rinfo_struct raster_info)
+ find the zone of each cell of a land cell list
+ in_args:		for the latitude bands; the cells should be in grid order, so each band is released when the loop leaves it
+ cells:			working grid indices of the land cells
+ num_cells:		number of cells
+ raster_info:	for the glu nodata value
+ return:		error code
+ ********/
+int zonemap_init(zonemap_struct *map, args_struct in_args, int *cells, int num_cells, rinfo_struct raster_info)
+{
+	int i, j;
+	int scg_code = 186;         // fao code for serbia and montenegro
+	int srb_code = 272;         // fao code for serbia
+	int mne_code = 273;         // fao code for montenegro
+	int max_ctry_code = 0;		// largest fao country code
+	int *ctry_index_of_code;	// country index of each fao country code; NOMATCH if none
+	int glu_val;				// glu of the current cell
+	int ctry_code;				// fao country code of the current cell
+	int ctry_ind;				// country index of the current cell
+	int glu_ind;				// glu index of the current cell in ctry_aez_list[ctry_ind]
+	band_walk_struct walk;		// releases the bands of the working grids behind the loop
+
+	memset(map, 0, sizeof(zonemap_struct));
+	map->num_cells = num_cells;
+
+	map->zone_start = calloc(NUM_FAO_CTRY + 1, sizeof(int));
+	map->cell_zone = grid_calloc_list(num_cells + 1, sizeof(int));
+	map->zone_cells = grid_calloc_list(num_cells + 1, sizeof(int));
+	if (map->zone_start == NULL || map->cell_zone == NULL || map->zone_cells == NULL) {
+		fprintf(fplog, "Failed to allocate memory for the zone map: zonemap_init()\n");
+		return ERROR_MEM;
+	}
+	for (i = 0; i < NUM_FAO_CTRY; i++) {
+		map->zone_start[i] = map->num_zones;
+		map->num_zones = map->num_zones + ctry_aez_num[i];
+		if (countrycodes_fao[i] > max_ctry_code) {
+			max_ctry_code = countrycodes_fao[i];
+		}
+	}
+	map->zone_start[NUM_FAO_CTRY] = map->num_zones;
+
+	map->zone_first = calloc(map->num_zones + 1, sizeof(int));
+	map->zone_next = calloc(map->num_zones + 1, sizeof(int));
+	ctry_index_of_code = calloc(max_ctry_code + 1, sizeof(int));
+	if (map->zone_first == NULL || map->zone_next == NULL || ctry_index_of_code == NULL) {
+		fprintf(fplog, "Failed to allocate memory for the zone map: zonemap_init()\n");
+		free(ctry_index_of_code);
+		return ERROR_MEM;
+	}
+	for (i = 0; i <= max_ctry_code; i++) {
+		ctry_index_of_code[i] = NOMATCH;
+	}
+	// the first of a duplicated code is used, as in the old linear search
+	for (i = NUM_FAO_CTRY - 1; i >= 0; i--) {
+		if (countrycodes_fao[i] >= 0) {
+			ctry_index_of_code[countrycodes_fao[i]] = i;
+		}
+	}
+
+	band_walk_init(&walk, in_args);
+	for (j = 0; j < num_cells; j++) {
+		band_walk_cell(&walk, cells[j]);
+		map->cell_zone[j] = NOMATCH;
+		glu_val = aez_bounds_new[cells[j]];
+		ctry_code = country_fao[cells[j]];
+		if (glu_val == raster_info.aez_new_nodata) {
+			continue;
+		}
+
+		// merge serbia and montenegro for scg record
+		if (ctry_code == mne_code || ctry_code == srb_code) {
+			ctry_code = scg_code;
+			if (ctry_code > max_ctry_code || ctry_index_of_code[ctry_code] == NOMATCH) {
+				// this should never happen
+				fprintf(fplog, "Error finding scg ctry index: zonemap_init()\n");
+				free(ctry_index_of_code);
+				return ERROR_IND;
+			}
+		}
+		ctry_ind = (ctry_code >= 0 && ctry_code <= max_ctry_code) ? ctry_index_of_code[ctry_code] : NOMATCH;
+		if (ctry_ind == NOMATCH || ctry2ctry87codes_gtap[ctry_ind] == NOMATCH) {
+			continue;
+		}
+
+		// this shouldn't fail because the countryXglu list has been made already
+		glu_ind = glu_list_index(ctry_aez_list[ctry_ind], ctry_aez_num[ctry_ind], glu_val);
+		if (glu_ind == NOMATCH) {
+			fprintf(fplog, "Failed to match glu %i to country %i: zonemap_init()\n", glu_val, ctry_code);
+			free(ctry_index_of_code);
+			return ERROR_IND;
+		}
+		map->cell_zone[j] = map->zone_start[ctry_ind] + glu_ind;
+	}
+	band_walk_end(&walk);
+
+	free(ctry_index_of_code);
+	return OK;
+}
+
+/********
+ int zone_accum(zonemap_struct *map, int pos_start, int pos_end, int width, int nvals, zone_value_fn value, void *ctx, double *acc)
+ add the values of the cells at list positions pos_start to pos_end - 1 to their zones
+ width:		number of values per zone in acc
+ nvals:		number of values a cell adds, at most ZONE_ACCUM_MAX_VALS
+ value:		gets the values of the cell at a list position, and their offset within the zone;
+			 it is called from several threads, so it must not write any shared data
+ ctx:		passed to value
+ acc:		the zone values, added to [num_zones][width]
+ return:	error code; the first error returned by value
+ ********/
+int zone_accum(zonemap_struct *map, int pos_start, int pos_end, int width, int nvals, zone_value_fn value, void *ctx, double *acc)
+{
+	int i, j, z;
+	int pos;
+	int offset;					// offset of the cell values within the zone
+	double vals[ZONE_ACCUM_MAX_VALS];	// the values of a cell
+	double *zone_acc;			// the values of the current zone
+	int err = OK;
+	int cell_err;
+
+	if (nvals > ZONE_ACCUM_MAX_VALS) {
+		fprintf(fplog, "Error: %i values per cell is more than %i: zone_accum()\n", nvals, ZONE_ACCUM_MAX_VALS);
+		return ERROR_USAGE;
+	}
+
+	// group the cells of the range by zone, keeping them in list order within each zone
+	memset(map->zone_first, 0, (map->num_zones + 1) * sizeof(int));
+	for (pos = pos_start; pos < pos_end; pos++) {
+		if (map->cell_zone[pos] != NOMATCH) {
+			map->zone_first[map->cell_zone[pos] + 1]++;
+		}
+	}
+	for (z = 0; z < map->num_zones; z++) {
+		map->zone_first[z + 1] = map->zone_first[z + 1] + map->zone_first[z];
+		map->zone_next[z] = map->zone_first[z];
+	}
+	for (pos = pos_start; pos < pos_end; pos++) {
+		if (map->cell_zone[pos] != NOMATCH) {
+			map->zone_cells[map->zone_next[map->cell_zone[pos]]++] = pos;
+		}
+	}
+
+	// each zone belongs to one thread
+#pragma omp parallel for schedule(dynamic, 16) private(i, j, offset, vals, zone_acc, cell_err)
+	for (z = 0; z < map->num_zones; z++) {
+		zone_acc = &acc[(long) z * width];
+		for (i = map->zone_first[z]; i < map->zone_first[z + 1]; i++) {
+			if ((cell_err = value(map->zone_cells[i], ctx, &offset, vals)) != OK) {
+#pragma omp critical (zone_accum_err)
+				{
+					if (err == OK) {
+						err = cell_err;
+					}
+				}
+				break;
+			}
+			for (j = 0; j < nvals; j++) {
+				zone_acc[offset + j] = zone_acc[offset + j] + vals[j];
+			}
+		}
+	}
+
+	return err;
+}
+
+/********
+ void zonemap_free(zonemap_struct *map)
+ free the zone map
+ ********/
+void zonemap_free(zonemap_struct *map)
+{
+	free(map->zone_start);
+	grid_free(map->cell_zone);
+	free(map->zone_first);
+	free(map->zone_next);
+	grid_free(map->zone_cells);
+	memset(map, 0, sizeof(zonemap_struct));
+}